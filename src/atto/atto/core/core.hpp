@@ -13,9 +13,22 @@
 #define ATTO_CORE_H
 
 /**
- * @brief Define ATTO_MATH_SIMD to enable SIMD based math.
+ * @brief Define ATTO_MATH_SIMD to enable SIMD based math. The AVX
+ * specialisations need the AVX instruction set, and a build for an older
+ * baseline architecture falls back to the generic math.
  */
+#ifdef __AVX__
 #define ATTO_MATH_SIMD
+#endif
+
+/**
+ * @brief Define ATTO_MATH_SIMD512 to enable the AVX-512 specialisations of
+ * the double precision batch operations and 4x4 matrix products, set by the
+ * -mavx512f compiler option or -march=native on a processor that has it.
+ */
+#if defined(ATTO_MATH_SIMD) && defined(__AVX512F__)
+#define ATTO_MATH_SIMD512
+#endif
 
 /**
  * @brief C headers
@@ -100,6 +113,34 @@
 #define core_concat4(a,b,c,d)   a ## b ## c ## d
 #define core_concat4_x(a,b,c,d) core_concat4(a,b,c,d)
 
+/**
+ * @brief Function multiversioning. Define ATTO_DISPATCH to compile every
+ * core_dispatch function once for each x86-64 instruction set level:
+ *  x86-64-v4   AVX-512F/BW/CD/DQ/VL
+ *  x86-64-v3   AVX2, FMA
+ *  avx         AVX
+ *  default     the baseline set by the -march compiler option
+ * The dynamic loader resolves each function to the widest version the
+ * processor supports, so a single binary built for a baseline architecture
+ * runs the widest code path on every node of a heterogeneous cluster.
+ *
+ * Use core_dispatch on inline functions, not with core_inline, since an
+ * always inline function has no symbol to resolve. If the compiler has no
+ * target_clones support for the instruction set levels, elide the macro.
+ *
+ * The hand-written SIMD kernels of the batch operations are compiled once
+ * for each of avx, avx2 and avx512 with the target pragma, and selected at
+ * run time from core::cpu_dispatch, see batch-dispatch.hpp.
+ */
+#if defined(ATTO_DISPATCH) && defined(__GNUC__) && !defined(__clang__) && \
+    __GNUC__ >= 12 && defined(__ELF__) && defined(__x86_64__)
+#define ATTO_CORE_DISPATCH
+#define core_dispatch           __attribute__((target_clones( \
+    "arch=x86-64-v4", "arch=x86-64-v3", "avx", "default")))
+#else
+#define core_dispatch
+#endif
+
 /**
  * @brief Define the SIMD AVX instruction set according to the __AVX__ macro,
  * set by mavx compiler option.
@@ -113,16 +154,13 @@
  * more efficient if the memory addresses are a multiple of 16 bytes (SSE) or
  * 32 bytes(AVX). A boundary multiple of 16/32 bytes is 16/32 byte aligned.
  *
- * Alternatively, fail with the error macro:
- *  #error AVX extended instruction set required.
+ * Without the -mavx compiler option, ATTO_MATH_SIMD is left undefined. A
+ * dispatch build includes the intrinsics regardless, for the kernels it
+ * compiles with a wider target than the baseline.
  */
-#ifdef ATTO_MATH_SIMD
-#ifdef __AVX__
+#if defined(ATTO_MATH_SIMD) || defined(ATTO_CORE_DISPATCH)
 #include <x86intrin.h>
-#else
-#error AVX extended instruction set required.
-#endif  /* __AVX__ */
-#endif  /* ATTO_MATH_SIMD */
+#endif  /* ATTO_MATH_SIMD || ATTO_CORE_DISPATCH */
 
 /**
  * POSIX standard symbolic constants, types and threads
@@ -172,6 +210,7 @@ inline int omp_get_max_threads(void) { return 1; }
  * Core interface.
  */
 #include "atto/core/error.hpp"
+#include "atto/core/cpu.hpp"
 #include "atto/core/memory.hpp"
 #include "atto/core/string.hpp"
 #include "atto/core/file.hpp"
@@ -0,0 +1,152 @@
+/*
+ * cpu.hpp
+ *
+ * Copyright (c) 2020 Carlos Braga
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the MIT License.
+ *
+ * See accompanying LICENSE.md or https://opensource.org/licenses/MIT.
+ */
+
+#ifndef ATTO_CORE_CPU_H_
+#define ATTO_CORE_CPU_H_
+
+#include <string>
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <cpuid.h>
+#define ATTO_CORE_CPUID
+#endif
+
+namespace atto {
+namespace core {
+
+/** ---- CPU features ---------------------------------------------------------
+ * CpuFeatures
+ * @brief SIMD extensions supported by the processor and enabled by the
+ * operating system. The AVX and AVX-512 register states must be saved by
+ * the operating system on a context switch, so the cpuid bits are only
+ * valid if the XCR0 register enables them.
+ */
+struct CpuFeatures {
+    bool sse42;
+    bool avx;
+    bool fma;
+    bool avx2;
+    bool avx512f;
+};
+
+/**
+ * cpu_detect
+ * @brief Query the processor for its SIMD extensions.
+ */
+core_inline
+CpuFeatures cpu_detect(void)
+{
+    CpuFeatures features = {false, false, false, false, false};
+#ifdef ATTO_CORE_CPUID
+    unsigned int eax, ebx, ecx, edx;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) {
+        return features;
+    }
+    features.sse42 = (ecx & bit_SSE4_2) != 0;
+
+    /*
+     * Read the XCR0 register if the OS enabled the xgetbv instruction. Bits
+     * 1-2 are the SSE and AVX states, and bits 5-7 the AVX-512 opmask and
+     * upper zmm states.
+     */
+    unsigned int xcr0 = 0;
+    if (ecx & bit_OSXSAVE) {
+        unsigned int xcr0_hi;
+        __asm__ ("xgetbv" : "=a" (xcr0), "=d" (xcr0_hi) : "c" (0));
+    }
+    const bool os_avx = (xcr0 & 0x06) == 0x06;
+    const bool os_avx512 = (xcr0 & 0xe6) == 0xe6;
+    features.avx = os_avx && (ecx & bit_AVX) != 0;
+    features.fma = features.avx && (ecx & bit_FMA) != 0;
+
+    if (__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) {
+        features.avx2 = features.avx && (ebx & bit_AVX2) != 0;
+        features.avx512f = os_avx512 && (ebx & bit_AVX512F) != 0;
+    }
+#endif  /* ATTO_CORE_CPUID */
+    return features;
+}
+
+/**
+ * cpu_features
+ * @brief Return the SIMD extensions of the processor, detected once.
+ */
+core_inline
+const CpuFeatures &cpu_features(void)
+{
+    static const CpuFeatures features = cpu_detect();
+    return features;
+}
+
+/**
+ * cpu_dispatch
+ * @brief Return the SIMD extensions the dispatched kernels may use. They
+ * start as the extensions of the processor, and a test may clear some of
+ * them to run a narrower kernel on a wider processor.
+ */
+core_inline
+CpuFeatures &cpu_dispatch(void)
+{
+    static CpuFeatures features = cpu_features();
+    return features;
+}
+
+/**
+ * cpu_dispatch_level
+ * @brief Return the name of the widest kernel level the SIMD kernels
+ * dispatch to, avx512 (AVX-512F, AVX2 and FMA), avx2 (AVX2 and FMA), avx
+ * or default.
+ */
+core_inline
+const char *cpu_dispatch_level(void)
+{
+    const CpuFeatures &features = cpu_dispatch();
+    const bool avx2 = features.avx2 && features.fma;
+    return (features.avx512f && avx2) ? "avx512" :
+           avx2                       ? "avx2" :
+           features.avx               ? "avx" : "default";
+}
+
+/**
+ * cpu_features_str
+ * @brief Return the names of the SIMD extensions of the processor, the
+ * level the SIMD kernels dispatch to, and the widest version the
+ * multiversioned functions resolve to.
+ */
+core_inline
+std::string cpu_features_str(void)
+{
+    const CpuFeatures &features = cpu_features();
+    std::string str;
+    str += features.sse42 ? "sse4.2 " : "";
+    str += features.avx ? "avx " : "";
+    str += features.fma ? "fma " : "";
+    str += features.avx2 ? "avx2 " : "";
+    str += features.avx512f ? "avx512f " : "";
+#ifdef ATTO_CORE_DISPATCH
+    /* Query the same levels as the target_clones resolver. */
+    __builtin_cpu_init();
+    str += "(dispatch ";
+    str += cpu_dispatch_level();
+    str += ", clones ";
+    str += __builtin_cpu_supports("x86-64-v4") ? "x86-64-v4" :
+           __builtin_cpu_supports("x86-64-v3") ? "x86-64-v3" :
+           __builtin_cpu_supports("avx")       ? "avx" : "default";
+    str += ")";
+#else
+    str += "(dispatch off)";
+#endif  /* ATTO_CORE_DISPATCH */
+    return str;
+}
+
+} /* core */
+} /* atto */
+
+#endif /* ATTO_CORE_CPU_H_ */
@@ -0,0 +1,131 @@
+/*
+ * fft.hpp
+ *
+ * Copyright (c) 2020 Carlos Braga
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the MIT License.
+ *
+ * See accompanying LICENSE.md or https://opensource.org/licenses/MIT.
+ */
+
+#ifndef ATTO_MATH_FFT_H_
+#define ATTO_MATH_FFT_H_
+
+#include <cmath>
+#include <complex>
+#include <type_traits>
+#include <vector>
+#include "atto/core/core.hpp"
+
+namespace atto {
+namespace math {
+namespace fft {
+
+/** ---- Radix-2 complex fast Fourier transform -------------------------------
+ * ispow2
+ * @brief Is n a nonzero power of two?
+ */
+core_inline
+bool ispow2(const size_t n)
+{
+    return (n > 0 && (n & (n - 1)) == 0);
+}
+
+/**
+ * Plan<T>
+ * @brief Twiddle factors of a radix-2 transform of length n. A plan is
+ * created once per transform length and reused over many strided lines, so
+ * the twiddle factors are never recomputed in the inner loops.
+ */
+template<typename T>
+struct Plan {
+    static_assert(std::is_floating_point<T>::value, "non floating point");
+
+    size_t m_length;
+    std::vector<std::complex<T>> m_twiddle;
+
+    /* Transform length. */
+    size_t length(void) const { return m_length; }
+
+    /* Constructor/destructor. */
+    explicit Plan(const size_t n) : m_length(n), m_twiddle(n / 2) {
+        core_assert(ispow2(n), "transform length is not a power of two");
+        const double two_pi = 2.0 * M_PI;
+        for (size_t k = 0; k < n / 2; ++k) {
+            double arg = -two_pi * (double) k / (double) n;
+            m_twiddle[k] = std::complex<T>(
+                (T) std::cos(arg), (T) std::sin(arg));
+        }
+    }
+    ~Plan() = default;
+
+    /* Copy constructor/assignment. */
+    Plan(const Plan &other) = default;
+    Plan &operator=(const Plan &other) = default;
+};
+
+/**
+ * transform<T>
+ * @brief In-place iterative radix-2 transform of a strided line of length n,
+ * data[k*stride], k = 0..n-1. The forward transform (sign < 0) computes
+ *      F(m) = sum_k f(k) exp(-2 pi i m k / n),
+ * and the backward transform (sign > 0) the same sum with exp(+2 pi i m k/n).
+ * Neither direction is normalised, so a forward and backward transform pair
+ * scales the data by n.
+ */
+template<typename T>
+core_inline
+void transform(
+    const Plan<T> &plan,
+    std::complex<T> *data,
+    const size_t stride,
+    const int sign)
+{
+    const size_t n = plan.length();
+
+    /* Bit reversal permutation. */
+    for (size_t i = 1, j = 0; i < n; ++i) {
+        size_t bit = n >> 1;
+        for (; j & bit; bit >>= 1) {
+            j ^= bit;
+        }
+        j ^= bit;
+        if (i < j) {
+            std::swap(data[i*stride], data[j*stride]);
+        }
+    }
+
+    /* Danielson-Lanczos butterflies. */
+    for (size_t len = 2; len <= n; len <<= 1) {
+        const size_t half = len >> 1;
+        const size_t step = n / len;
+        for (size_t i = 0; i < n; i += len) {
+            for (size_t k = 0; k < half; ++k) {
+                std::complex<T> w = plan.m_twiddle[k*step];
+                if (sign > 0) {
+                    w = std::conj(w);
+                }
+                std::complex<T> &u = data[(i + k)*stride];
+                std::complex<T> &v = data[(i + k + half)*stride];
+                std::complex<T> t = w * v;
+                v = u - t;
+                u = u + t;
+            }
+        }
+    }
+}
+
+template<typename T>
+core_inline
+void transform(std::complex<T> *data, const size_t n, const int sign)
+{
+    Plan<T> plan(n);
+    transform(plan, data, 1, sign);
+}
+
+} /* fft */
+} /* math */
+} /* atto */
+
+#endif /* ATTO_MATH_FFT_H_ */
@@ -87,8 +87,11 @@
 #include "atto/math/geometry/arithmetic.hpp"
 #include "atto/math/geometry/algebra.hpp"
 #include "atto/math/geometry/transform.hpp"
+#include "atto/math/geometry/quat.hpp"
 #include "atto/math/geometry/io.hpp"
 #include "atto/math/geometry/ortho.hpp"
+#include "atto/math/geometry/box.hpp"
+#include "atto/math/geometry/batch.hpp"
 
 namespace atto {
 namespace math {
@@ -187,12 +190,26 @@ typedef mat4<uint32_t>  mat4u;
 typedef mat4<float>     mat4f;
 typedef mat4<double>    mat4d;
 
+/**
+ * @brief Quaternion type definitions.
+ */
+typedef quat<float>     quatf;
+typedef quat<double>    quatd;
+
 /**
  * @brief Ortho type definitions.
  */
 typedef Ortho<float>    Orthof;
 typedef Ortho<double>   Orthod;
 
+/**
+ * @brief Box type definitions.
+ */
+typedef Box<float, false>   OrthoBoxf;
+typedef Box<double, false>  OrthoBoxd;
+typedef Box<float, true>    TriclinicBoxf;
+typedef Box<double, true>   TriclinicBoxd;
+
 } /* math */
 } /* atto */
 
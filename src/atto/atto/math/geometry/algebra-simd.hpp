@@ -79,17 +79,11 @@ mat2<double> dot(const mat2<double> &a, const mat2<double> &b)
          */
         __m128d a0 = _mm_set1_pd(a(i,0));
         __m128d a1 = _mm_set1_pd(a(i,1));
-        /*
-         * c0 = {a_n * b0, a_n * b1}
-         * c1 = {a_m * b2, a_m * b3}
-         */
-        __m128d c0 = _mm_mul_pd(a0, b0);
-        __m128d c1 = _mm_mul_pd(a1, b1);
         /*
          * mul = {a_n * b0 + a_m * b2,
          *         a_n * b1 + a_m * b3}
          */
-        mul[i] = _mm_add_pd(c0, c1);
+        mul[i] = simd128_fmadd_(a1, b1, _mm_mul_pd(a0, b0));
     }
 
     mat2<double> result{};
@@ -128,24 +122,27 @@ vec3<double> dot(const mat3<double> &a, const vec3<double> &v)
     __m256d a2 = simd_load(a, 2);
     __m256d b  = simd_load(v);
     /*
-     * c0 = {a0*b0 + a1*b1 + a2*b2}
-     * c1 = {a3*b0 + a4*b1 + a2*b2}
-     * c2 = {a6*b0 + a7*b1 + a8*b2}
+     * Reduce the products of the rows with the vector pairwise, then add
+     * the lower and upper lanes:
      *
-     * _mm256_unpackhi_pd(__m256d a, __m256d b)
-     * dst[63:0]    := a[127:64]
-     * dst[127:64]  := b[127:64]
-     * dst[191:128] := a[255:192]
-     * dst[255:192] := b[255:192]
+     * c01 = {a0*b0 + a1*b1, a3*b0 + a4*b1, a2*b2, a5*b2}
+     * c23 = {a6*b0 + a7*b1, 0,             a8*b2, 0}
+     * mul = {a0*b0 + a1*b1 + a2*b2,
+     *        a3*b0 + a4*b1 + a5*b2,
+     *        a6*b0 + a7*b1 + a8*b2, 0}
+     *
+     * _mm256_hadd_pd(__m256d a, __m256d b)
+     * dst[63:0]    := a[127:64]  + a[63:0]
+     * dst[127:64]  := b[127:64]  + b[63:0]
+     * dst[191:128] := a[255:192] + a[191:128]
+     * dst[255:192] := b[255:192] + b[191:128]
      */
-    __m256d c0   = simd256_dot_(a0, b);
-    __m256d c1   = simd256_dot_(a1, b);
-    __m256d c2   = simd256_dot_(a2, b);
     __m256d zero = _mm256_set1_pd(0.0);
-    __m256d mul  = _mm256_permute2f128_pd(
-        _mm256_unpackhi_pd(c0, c1),
-        _mm256_unpackhi_pd(c2, zero),
-        core_extension(0b00100000));
+    __m256d c01  = _mm256_hadd_pd(_mm256_mul_pd(a0, b), _mm256_mul_pd(a1, b));
+    __m256d c23  = _mm256_hadd_pd(_mm256_mul_pd(a2, b), zero);
+    __m256d mul  = _mm256_add_pd(
+        _mm256_permute2f128_pd(c01, c23, core_extension(0b00100000)),
+        _mm256_permute2f128_pd(c01, c23, core_extension(0b00110001)));
 
     vec3<double> result{};
     simd_store(result, mul);
@@ -175,23 +172,14 @@ mat3<double> dot(const mat3<double> &a, const mat3<double> &b)
         __m256d a0 = _mm256_set1_pd(a(i, 0));
         __m256d a1 = _mm256_set1_pd(a(i, 1));
         __m256d a2 = _mm256_set1_pd(a(i, 2));
-        /*
-         * c0 = {a_n * b0, a_n * b1, a_n * b2}
-         * c1 = {a_m * b3, a_m * b4, a_m * b5}
-         * c2 = {a_l * b6, a_l * b7, a_l * b8}
-         */
-        __m256d c0 = _mm256_mul_pd(a0, b0);
-        __m256d c1 = _mm256_mul_pd(a1, b1);
-        __m256d c2 = _mm256_mul_pd(a2, b2);
         /*
          * mul = {a_n * b0 + a_m * b3 + a_l * b6,
          *         a_n * b1 + a_m * b4 + a_l * b7,
          *         a_n * b2 + a_m * b5 + a_l * b8}
          */
-         mul[i] = _mm256_set1_pd(0.0);
-         mul[i] = _mm256_add_pd(mul[i], c0);
-         mul[i] = _mm256_add_pd(mul[i], c1);
-         mul[i] = _mm256_add_pd(mul[i], c2);
+        mul[i] = _mm256_mul_pd(a0, b0);
+        mul[i] = simd256_fmadd_(a1, b1, mul[i]);
+        mul[i] = simd256_fmadd_(a2, b2, mul[i]);
     }
 
     mat3<double> result{};
@@ -231,31 +219,34 @@ vec4<double> dot(const mat4<double> &a, const vec4<double> &v)
     __m256d a3 = simd_load(a, 3);
     __m256d b  = simd_load(v);
     /*
-     * c0 = {a0*b0  + a1*b1  + a2*b2  + a3*b3}
-     * c1 = {a4*b0  + a5*b1  + a6*b2  + a7*b3}
-     * c2 = {a8*b0  + a9*b1  + a10*b2 + a11*b3}
-     * c3 = {a12*b0 + a13*b1 + a14*b2 + a15*b3}
+     * Reduce the products of the rows with the vector pairwise, then add
+     * the lower and upper lanes:
      *
-     * _mm256_unpackhi_pd(__m256d a, __m256d b)
-     * dst[63:0]    := a[127:64]
-     * dst[127:64]  := b[127:64]
-     * dst[191:128] := a[255:192]
-     * dst[255:192] := b[255:192]
+     * c01 = {a0*b0  + a1*b1,  a4*b0  + a5*b1,  a2*b2  + a3*b3,  ...}
+     * c23 = {a8*b0  + a9*b1,  a12*b0 + a13*b1, a10*b2 + a11*b3, ...}
+     * mul = {a0*b0  + a1*b1  + a2*b2  + a3*b3,
+     *        a4*b0  + a5*b1  + a6*b2  + a7*b3,
+     *        a8*b0  + a9*b1  + a10*b2 + a11*b3,
+     *        a12*b0 + a13*b1 + a14*b2 + a15*b3}
+     *
+     * _mm256_hadd_pd(__m256d a, __m256d b)
+     * dst[63:0]    := a[127:64]  + a[63:0]
+     * dst[127:64]  := b[127:64]  + b[63:0]
+     * dst[191:128] := a[255:192] + a[191:128]
+     * dst[255:192] := b[255:192] + b[191:128]
      */
-    __m256d c0  = simd256_dot_(a0, b);
-    __m256d c1  = simd256_dot_(a1, b);
-    __m256d c2  = simd256_dot_(a2, b);
-    __m256d c3  = simd256_dot_(a3, b);
-    __m256d mul = _mm256_permute2f128_pd(
-        _mm256_unpackhi_pd(c0, c1),
-        _mm256_unpackhi_pd(c2, c3),
-        core_extension(0b00100000));
+    __m256d c01 = _mm256_hadd_pd(_mm256_mul_pd(a0, b), _mm256_mul_pd(a1, b));
+    __m256d c23 = _mm256_hadd_pd(_mm256_mul_pd(a2, b), _mm256_mul_pd(a3, b));
+    __m256d mul = _mm256_add_pd(
+        _mm256_permute2f128_pd(c01, c23, core_extension(0b00100000)),
+        _mm256_permute2f128_pd(c01, c23, core_extension(0b00110001)));
 
     vec4<double> result{};
     simd_store(result, mul);
     return result;
 }
 
+#ifndef ATTO_MATH_SIMD512
 template<>
 core_inline
 mat4<double> dot(const mat4<double> &a, const mat4<double> &b)
@@ -283,27 +274,16 @@ mat4<double> dot(const mat4<double> &a, const mat4<double> &b)
         __m256d a1 = _mm256_set1_pd(a(i, 1));
         __m256d a2 = _mm256_set1_pd(a(i, 2));
         __m256d a3 = _mm256_set1_pd(a(i, 3));
-        /*
-         * c0 = {a_n * b0,  a_n * b1,  a_n * b2,  a_n * b3}
-         * c1 = {a_m * b4,  a_m * b5,  a_m * b6,  a_m * b7}
-         * c2 = {a_l * b8,  a_l * b9,  a_l * b10, a_l * b11}
-         * c3 = {a_k * b12, a_k * b13, a_k * b14, a_k * b15}
-         */
-        __m256d c0 = _mm256_mul_pd(a0, b0);
-        __m256d c1 = _mm256_mul_pd(a1, b1);
-        __m256d c2 = _mm256_mul_pd(a2, b2);
-        __m256d c3 = _mm256_mul_pd(a3, b3);
         /*
          * mul = {a_n * b0 + a_m * b4 + a_l * b8  + a_k * b12,
          *         a_n * b1 + a_m * b5 + a_l * b9  + a_k * b13,
          *         a_n * b2 + a_m * b6 + a_l * b10 + a_k * b14,
          *         a_n * b3 + a_m * b7 + a_l * b11 + a_k * b15}
          */
-         mul[i] = _mm256_set1_pd(0.0);
-         mul[i] = _mm256_add_pd(mul[i], c0);
-         mul[i] = _mm256_add_pd(mul[i], c1);
-         mul[i] = _mm256_add_pd(mul[i], c2);
-         mul[i] = _mm256_add_pd(mul[i], c3);
+        mul[i] = _mm256_mul_pd(a0, b0);
+        mul[i] = simd256_fmadd_(a1, b1, mul[i]);
+        mul[i] = simd256_fmadd_(a2, b2, mul[i]);
+        mul[i] = simd256_fmadd_(a3, b3, mul[i]);
     }
 
     mat4<double> result{};
@@ -313,6 +293,64 @@ mat4<double> dot(const mat4<double> &a, const mat4<double> &b)
     simd_store(result, 3, mul[3]);
     return result;
 }
+#else
+template<>
+core_inline
+mat4<double> dot(const mat4<double> &a, const mat4<double> &b)
+{
+    /*
+     * Hold the matrix a in two 512-bit registers, each with a pair of rows,
+     * and broadcast each row of b to both 256-bit lanes:
+     *
+     * a01 = {a0,  a1,  a2,  a3,  a4,  a5,  a6,  a7}
+     * a23 = {a8,  a9,  a10, a11, a12, a13, a14, a15}
+     * bk  = {b(k,0), b(k,1), b(k,2), b(k,3), b(k,0), b(k,1), b(k,2), b(k,3)}
+     */
+    const __m512d a01 = simd512_load(a, 0);
+    const __m512d a23 = simd512_load(a, 1);
+    const __m512d b0 = _mm512_maskz_broadcast_f64x4(0xff, simd_load(b, 0));
+    const __m512d b1 = _mm512_maskz_broadcast_f64x4(0xff, simd_load(b, 1));
+    const __m512d b2 = _mm512_maskz_broadcast_f64x4(0xff, simd_load(b, 2));
+    const __m512d b3 = _mm512_maskz_broadcast_f64x4(0xff, simd_load(b, 3));
+    /*
+     * _mm512_maskz_permutex_pd(__mmask8 k, __m512d a, int imm8) selects
+     * within each 256-bit lane, so it broadcasts the element k of both rows
+     * of a pair:
+     *
+     * _mm512_maskz_permutex_pd(0xff, a01, 0x00) = {a0, a0, a0, a0, a4, ...}
+     * _mm512_maskz_permutex_pd(0xff, a01, 0x55) = {a1, a1, a1, a1, a5, ...}
+     *
+     * mul01 = sum_k {a(0,k), a(1,k)} * bk
+     * mul23 = sum_k {a(2,k), a(3,k)} * bk
+     *
+     * The zero masked forms avoid the undefined source operand of the
+     * unmasked intrinsics, which gcc reports as uninitialized.
+     */
+    const __mmask8 all = 0xff;
+    __m512d mul01 = _mm512_mul_pd(
+        _mm512_maskz_permutex_pd(all, a01, 0x00), b0);
+    mul01 = _mm512_fmadd_pd(
+        _mm512_maskz_permutex_pd(all, a01, 0x55), b1, mul01);
+    mul01 = _mm512_fmadd_pd(
+        _mm512_maskz_permutex_pd(all, a01, 0xaa), b2, mul01);
+    mul01 = _mm512_fmadd_pd(
+        _mm512_maskz_permutex_pd(all, a01, 0xff), b3, mul01);
+
+    __m512d mul23 = _mm512_mul_pd(
+        _mm512_maskz_permutex_pd(all, a23, 0x00), b0);
+    mul23 = _mm512_fmadd_pd(
+        _mm512_maskz_permutex_pd(all, a23, 0x55), b1, mul23);
+    mul23 = _mm512_fmadd_pd(
+        _mm512_maskz_permutex_pd(all, a23, 0xaa), b2, mul23);
+    mul23 = _mm512_fmadd_pd(
+        _mm512_maskz_permutex_pd(all, a23, 0xff), b3, mul23);
+
+    mat4<double> result{};
+    simd512_store(result, 0, mul01);
+    simd512_store(result, 1, mul23);
+    return result;
+}
+#endif  /* ATTO_MATH_SIMD512 */
 
 
 /** ---------------------------------------------------------------------------
@@ -474,11 +512,7 @@ vec3<double> cross(const vec3<double> &a, const vec3<double> &b)
      * c = (a3 * b5) - (a5 * b3)
      */
     vec3<double> result{};
-    simd_store(
-        result,
-        _mm256_sub_pd(
-            _mm256_mul_pd(a3, b5),
-            _mm256_mul_pd(a5, b3)));
+    simd_store(result, simd256_fmsub_(a3, b5, _mm256_mul_pd(a5, b3)));
     return result;
 }
 
@@ -610,10 +644,9 @@ double determinant(const mat3<double> &a)
      *          a1 * m1 +
      *          a2 * m2
      */
-    __m256d det = _mm256_set1_pd(0.0);
-    det = _mm256_add_pd(det, _mm256_mul_pd(a0, m0));
-    det = _mm256_add_pd(det, _mm256_mul_pd(a1, m1));
-    det = _mm256_add_pd(det, _mm256_mul_pd(a2, m2));
+    __m256d det = _mm256_mul_pd(a0, m0);
+    det = simd256_fmadd_(a1, m1, det);
+    det = simd256_fmadd_(a2, m2, det);
 
     return _mm256_cvtsd_f64(det);
 }
@@ -675,13 +708,12 @@ double determinant(const mat4<double> &a)
      *          m8  * m9 +
      *          m10 * m11
      */
-    __m256d det = _mm256_set1_pd(0.0);
-    det = _mm256_add_pd(det, _mm256_mul_pd(m0,  m1));
-    det = _mm256_add_pd(det, _mm256_mul_pd(m2,  m3));
-    det = _mm256_add_pd(det, _mm256_mul_pd(m4,  m5));
-    det = _mm256_add_pd(det, _mm256_mul_pd(m6,  m7));
-    det = _mm256_add_pd(det, _mm256_mul_pd(m8,  m9));
-    det = _mm256_add_pd(det, _mm256_mul_pd(m10, m11));
+    __m256d det = _mm256_mul_pd(m0, m1);
+    det = simd256_fmadd_(m2,  m3,  det);
+    det = simd256_fmadd_(m4,  m5,  det);
+    det = simd256_fmadd_(m6,  m7,  det);
+    det = simd256_fmadd_(m8,  m9,  det);
+    det = simd256_fmadd_(m10, m11, det);
 
     return _mm256_cvtsd_f64(det);
 }
@@ -842,6 +874,7 @@ mat3<double> inverse(const mat3<double> &a)
     return result;
 }
 
+#ifndef ATTO_MATH_SIMD512
 template<>
 core_inline
 mat4<double> inverse(const mat4<double> &a)
@@ -932,31 +965,29 @@ mat4<double> inverse(const mat4<double> &a)
     __m256d a14 = _mm256_set1_pd(a(3,2));
     __m256d a15 = _mm256_set1_pd(a(3,3));
 
+    const __m256d zero = _mm256_set1_pd(0.0);
+
     /*
      * adj0  =  a5  * m0 + a6  * m1  + a7  * m2
      * adj1  = -a1  * m0 - a2  * m1  - a3  * m2
      * adj2  =  a13 * m6 + a14 * m7  + a15 * m8
      * adj3  = -a9  * m6 - a10 * m7  - a11 * m8
      */
-    __m256d adj0 = _mm256_set1_pd(0.0);
-    adj0 = _mm256_add_pd(adj0, _mm256_mul_pd(a5, m0));
-    adj0 = _mm256_add_pd(adj0, _mm256_mul_pd(a6, m1));
-    adj0 = _mm256_add_pd(adj0, _mm256_mul_pd(a7, m2));
+    __m256d adj0 = _mm256_mul_pd(a5, m0);
+    adj0 = simd256_fmadd_(a6, m1, adj0);
+    adj0 = simd256_fmadd_(a7, m2, adj0);
 
-    __m256d adj1 = _mm256_set1_pd(0.0);
-    adj1 = _mm256_sub_pd(adj1, _mm256_mul_pd(a1, m0));
-    adj1 = _mm256_sub_pd(adj1, _mm256_mul_pd(a2, m1));
-    adj1 = _mm256_sub_pd(adj1, _mm256_mul_pd(a3, m2));
+    __m256d adj1 = simd256_fnmadd_(a1, m0, zero);
+    adj1 = simd256_fnmadd_(a2, m1, adj1);
+    adj1 = simd256_fnmadd_(a3, m2, adj1);
 
-    __m256d adj2 = _mm256_set1_pd(0.0);
-    adj2 = _mm256_add_pd(adj2, _mm256_mul_pd(a13, m6));
-    adj2 = _mm256_add_pd(adj2, _mm256_mul_pd(a14, m7));
-    adj2 = _mm256_add_pd(adj2, _mm256_mul_pd(a15, m8));
+    __m256d adj2 = _mm256_mul_pd(a13, m6);
+    adj2 = simd256_fmadd_(a14, m7, adj2);
+    adj2 = simd256_fmadd_(a15, m8, adj2);
 
-    __m256d adj3 = _mm256_set1_pd(0.0);
-    adj3 = _mm256_sub_pd(adj3, _mm256_mul_pd(a9,  m6));
-    adj3 = _mm256_sub_pd(adj3, _mm256_mul_pd(a10, m7));
-    adj3 = _mm256_sub_pd(adj3, _mm256_mul_pd(a11, m8));
+    __m256d adj3 = simd256_fnmadd_(a9, m6, zero);
+    adj3 = simd256_fnmadd_(a10, m7, adj3);
+    adj3 = simd256_fnmadd_(a11, m8, adj3);
 
     /*
      * adj4  = -a4  * m0 - a6  * m3  - a7  * m4
@@ -964,25 +995,21 @@ mat4<double> inverse(const mat4<double> &a)
      * adj6  = -a12 * m6 - a14 * m9  - a15 * m10
      * adj7  =  a8  * m6 + a10 * m9  + a11 * m10
      */
-    __m256d adj4 = _mm256_set1_pd(0.0);
-    adj4 = _mm256_sub_pd(adj4, _mm256_mul_pd(a4, m0));
-    adj4 = _mm256_sub_pd(adj4, _mm256_mul_pd(a6, m3));
-    adj4 = _mm256_sub_pd(adj4, _mm256_mul_pd(a7, m4));
+    __m256d adj4 = simd256_fnmadd_(a4, m0, zero);
+    adj4 = simd256_fnmadd_(a6, m3, adj4);
+    adj4 = simd256_fnmadd_(a7, m4, adj4);
 
-    __m256d adj5 = _mm256_set1_pd(0.0);
-    adj5 = _mm256_add_pd(adj5, _mm256_mul_pd(a0, m0));
-    adj5 = _mm256_add_pd(adj5, _mm256_mul_pd(a2, m3));
-    adj5 = _mm256_add_pd(adj5, _mm256_mul_pd(a3, m4));
+    __m256d adj5 = _mm256_mul_pd(a0, m0);
+    adj5 = simd256_fmadd_(a2, m3, adj5);
+    adj5 = simd256_fmadd_(a3, m4, adj5);
 
-    __m256d adj6 = _mm256_set1_pd(0.0);
-    adj6 = _mm256_sub_pd(adj6, _mm256_mul_pd(a12, m6));
-    adj6 = _mm256_sub_pd(adj6, _mm256_mul_pd(a14, m9));
-    adj6 = _mm256_sub_pd(adj6, _mm256_mul_pd(a15, m10));
+    __m256d adj6 = simd256_fnmadd_(a12, m6, zero);
+    adj6 = simd256_fnmadd_(a14, m9, adj6);
+    adj6 = simd256_fnmadd_(a15, m10, adj6);
 
-    __m256d adj7 = _mm256_set1_pd(0.0);
-    adj7 = _mm256_add_pd(adj7, _mm256_mul_pd(a8,  m6));
-    adj7 = _mm256_add_pd(adj7, _mm256_mul_pd(a10, m9));
-    adj7 = _mm256_add_pd(adj7, _mm256_mul_pd(a11, m10));
+    __m256d adj7 = _mm256_mul_pd(a8, m6);
+    adj7 = simd256_fmadd_(a10, m9, adj7);
+    adj7 = simd256_fmadd_(a11, m10, adj7);
 
     /*
      * adj8  = -a4  * m1 + a5  * m3  + a7  * m5
@@ -990,25 +1017,21 @@ mat4<double> inverse(const mat4<double> &a)
      * adj10 = -a12 * m7 + a13 * m9  + a15 * m11
      * adj11 =  a8  * m7 - a9  * m9  - a11 * m11
      */
-    __m256d adj8 = _mm256_set1_pd(0.0);
-    adj8  = _mm256_sub_pd(adj8, _mm256_mul_pd(a4, m1));
-    adj8  = _mm256_add_pd(adj8, _mm256_mul_pd(a5, m3));
-    adj8  = _mm256_add_pd(adj8, _mm256_mul_pd(a7, m5));
+    __m256d adj8 = simd256_fnmadd_(a4, m1, zero);
+    adj8 = simd256_fmadd_(a5, m3, adj8);
+    adj8 = simd256_fmadd_(a7, m5, adj8);
 
-    __m256d adj9 = _mm256_set1_pd(0.0);
-    adj9  = _mm256_add_pd(adj9, _mm256_mul_pd(a0, m1));
-    adj9  = _mm256_sub_pd(adj9, _mm256_mul_pd(a1, m3));
-    adj9  = _mm256_sub_pd(adj9, _mm256_mul_pd(a3, m5));
+    __m256d adj9 = _mm256_mul_pd(a0, m1);
+    adj9 = simd256_fnmadd_(a1, m3, adj9);
+    adj9 = simd256_fnmadd_(a3, m5, adj9);
 
-    __m256d adj10 = _mm256_set1_pd(0.0);
-    adj10 = _mm256_sub_pd(adj10, _mm256_mul_pd(a12, m7));
-    adj10 = _mm256_add_pd(adj10, _mm256_mul_pd(a13, m9));
-    adj10 = _mm256_add_pd(adj10, _mm256_mul_pd(a15, m11));
+    __m256d adj10 = simd256_fnmadd_(a12, m7, zero);
+    adj10 = simd256_fmadd_(a13, m9, adj10);
+    adj10 = simd256_fmadd_(a15, m11, adj10);
 
-    __m256d adj11 = _mm256_set1_pd(0.0);
-    adj11 = _mm256_add_pd(adj11, _mm256_mul_pd(a8,  m7));
-    adj11 = _mm256_sub_pd(adj11, _mm256_mul_pd(a9,  m9));
-    adj11 = _mm256_sub_pd(adj11, _mm256_mul_pd(a11, m11));
+    __m256d adj11 = _mm256_mul_pd(a8, m7);
+    adj11 = simd256_fnmadd_(a9, m9, adj11);
+    adj11 = simd256_fnmadd_(a11, m11, adj11);
 
     /*
      * adj12 = -a4  * m2 + a5  * m4  - a6  * m5
@@ -1016,25 +1039,21 @@ mat4<double> inverse(const mat4<double> &a)
      * adj14 = -a12 * m8 + a13 * m10 - a14 * m11
      * adj15 =  a8  * m8 - a9  * m10 + a10 * m11
      */
-    __m256d adj12 = _mm256_set1_pd(0.0);
-    adj12 = _mm256_sub_pd(adj12, _mm256_mul_pd(a4, m2));
-    adj12 = _mm256_add_pd(adj12, _mm256_mul_pd(a5, m4));
-    adj12 = _mm256_sub_pd(adj12, _mm256_mul_pd(a6, m5));
+    __m256d adj12 = simd256_fnmadd_(a4, m2, zero);
+    adj12 = simd256_fmadd_(a5, m4, adj12);
+    adj12 = simd256_fnmadd_(a6, m5, adj12);
 
-    __m256d adj13 = _mm256_set1_pd(0.0);
-    adj13 = _mm256_add_pd(adj13, _mm256_mul_pd(a0, m2));
-    adj13 = _mm256_sub_pd(adj13, _mm256_mul_pd(a1, m4));
-    adj13 = _mm256_add_pd(adj13, _mm256_mul_pd(a2, m5));
+    __m256d adj13 = _mm256_mul_pd(a0, m2);
+    adj13 = simd256_fnmadd_(a1, m4, adj13);
+    adj13 = simd256_fmadd_(a2, m5, adj13);
 
-    __m256d adj14 = _mm256_set1_pd(0.0);
-    adj14 = _mm256_sub_pd(adj14, _mm256_mul_pd(a12, m8));
-    adj14 = _mm256_add_pd(adj14, _mm256_mul_pd(a13, m10));
-    adj14 = _mm256_sub_pd(adj14, _mm256_mul_pd(a14, m11));
+    __m256d adj14 = simd256_fnmadd_(a12, m8, zero);
+    adj14 = simd256_fmadd_(a13, m10, adj14);
+    adj14 = simd256_fnmadd_(a14, m11, adj14);
 
-    __m256d adj15 = _mm256_set1_pd(0.0);
-    adj15 = _mm256_add_pd(adj15, _mm256_mul_pd(a8,  m8));
-    adj15 = _mm256_sub_pd(adj15, _mm256_mul_pd(a9,  m10));
-    adj15 = _mm256_add_pd(adj15, _mm256_mul_pd(a10, m11));
+    __m256d adj15 = _mm256_mul_pd(a8, m8);
+    adj15 = simd256_fnmadd_(a9, m10, adj15);
+    adj15 = simd256_fmadd_(a10, m11, adj15);
 
     /*
      * _mm256_unpackhi_pd(__m256d a, __m256d b)
@@ -1059,7 +1078,6 @@ mat4<double> inverse(const mat4<double> &a)
      * dst[127:0]   := SELECT4(a[255:0], b[255:0], mask[3:0])
      * dst[255:128] := SELECT4(a[255:0], b[255:0], mask[7:4])
      */
-    const __m256d zero = _mm256_set1_pd(0.0);
     const __m256d one  = _mm256_set1_pd(1.0);
     __m256d det = _mm256_div_pd(one, _mm256_set1_pd(determinant(a)));
 
@@ -1117,6 +1135,762 @@ mat4<double> inverse(const mat4<double> &a)
     simd_store(result, 3, inv3);
     return result;
 }
+#else
+template<>
+core_inline
+mat4<double> inverse(const mat4<double> &a)
+{
+    /*
+     * Compute the inverse of matrix a from its adjugate,
+     *  inv(a) = adj(a) / det(a)
+     *
+     * with the 2x2 minors of the upper and lower pairs of rows:
+     *
+     *  s_pq = a(0,p)*a(1,q) - a(1,p)*a(0,q)
+     *  c_pq = a(2,p)*a(3,q) - a(3,p)*a(2,q)
+     *
+     * Given the vectors
+     *
+     *  v_k  = {a(1,k), -a(0,k), a(3,k), -a(2,k)}
+     *  C_pq = {c_pq, c_pq, s_pq, s_pq}
+     *
+     * the rows of the adjugate are
+     *
+     *  adj0 =  v1 * C_23 - v2 * C_13 + v3 * C_12
+     *  adj1 = -v0 * C_23 + v2 * C_03 - v3 * C_02
+     *  adj2 =  v0 * C_13 - v1 * C_03 + v3 * C_01
+     *  adj3 = -v0 * C_12 + v1 * C_02 - v2 * C_01
+     *
+     * and each pair of rows is computed in one 512-bit register.
+     */
+    const __m512d a01 = simd512_load(a, 0);
+    const __m512d a23 = simd512_load(a, 1);
+
+    /*
+     * x = {row 0, row 2} and y = {row 1, row 3}, so each 256-bit lane of
+     * x*y' - y*x' holds the minors s_pq in the lower lane and c_pq in the
+     * upper lane:
+     *
+     * m0 = {s_01, s_02, s_03, s_12, c_01, c_02, c_03, c_12}
+     * m1 = {s_13, s_23, s_13, s_23, c_13, c_23, c_13, c_23}
+     */
+    const __mmask8 all = 0xff;
+    const __m512d x = _mm512_maskz_shuffle_f64x2(
+        all, a01, a23, _MM_SHUFFLE(1,0,1,0));
+    const __m512d y = _mm512_maskz_shuffle_f64x2(
+        all, a01, a23, _MM_SHUFFLE(3,2,3,2));
+
+    const __m512d m0 = _mm512_fmsub_pd(
+        _mm512_maskz_permutex_pd(all, x, _MM_SHUFFLE(1,0,0,0)),
+        _mm512_maskz_permutex_pd(all, y, _MM_SHUFFLE(2,3,2,1)),
+        _mm512_mul_pd(
+            _mm512_maskz_permutex_pd(all, y, _MM_SHUFFLE(1,0,0,0)),
+            _mm512_maskz_permutex_pd(all, x, _MM_SHUFFLE(2,3,2,1))));
+    const __m512d m1 = _mm512_fmsub_pd(
+        _mm512_maskz_permutex_pd(all, x, _MM_SHUFFLE(2,1,2,1)),
+        _mm512_maskz_permutex_pd(all, y, _MM_SHUFFLE(3,3,3,3)),
+        _mm512_mul_pd(
+            _mm512_maskz_permutex_pd(all, y, _MM_SHUFFLE(2,1,2,1)),
+            _mm512_maskz_permutex_pd(all, x, _MM_SHUFFLE(3,3,3,3))));
+
+    /*
+     * Gather the minor vectors of each pair of adjugate rows from m0 and m1,
+     * with indices 0-7 into m0 and 8-15 into m1.
+     */
+    const __m512d c_23_23 = _mm512_permutex2var_pd(
+        m0, _mm512_setr_epi64(13, 13, 9, 9, 13, 13, 9, 9), m1);
+    const __m512d c_13_03 = _mm512_permutex2var_pd(
+        m0, _mm512_setr_epi64(12, 12, 8, 8, 6, 6, 2, 2), m1);
+    const __m512d c_12_02 = _mm512_permutex2var_pd(
+        m0, _mm512_setr_epi64(7, 7, 3, 3, 5, 5, 1, 1), m1);
+    const __m512d c_13_12 = _mm512_permutex2var_pd(
+        m0, _mm512_setr_epi64(12, 12, 8, 8, 7, 7, 3, 3), m1);
+    const __m512d c_03_02 = _mm512_permutex2var_pd(
+        m0, _mm512_setr_epi64(6, 6, 2, 2, 5, 5, 1, 1), m1);
+    const __m512d c_01_01 = _mm512_permutex2var_pd(
+        m0, _mm512_setr_epi64(4, 4, 0, 0, 4, 4, 0, 0), m1);
+
+    /*
+     * Gather the unsigned vectors u_k = {a(1,k), a(0,k), a(3,k), a(2,k)}
+     * from a01 and a23, with indices 0-7 into a01 and 8-15 into a23.
+     */
+    const __m512d u_1_0 = _mm512_permutex2var_pd(
+        a01, _mm512_setr_epi64(5, 1, 13, 9, 4, 0, 12, 8), a23);
+    const __m512d u_2_2 = _mm512_permutex2var_pd(
+        a01, _mm512_setr_epi64(6, 2, 14, 10, 6, 2, 14, 10), a23);
+    const __m512d u_3_3 = _mm512_permutex2var_pd(
+        a01, _mm512_setr_epi64(7, 3, 15, 11, 7, 3, 15, 11), a23);
+    const __m512d u_0_0 = _mm512_permutex2var_pd(
+        a01, _mm512_setr_epi64(4, 0, 12, 8, 4, 0, 12, 8), a23);
+    const __m512d u_1_1 = _mm512_permutex2var_pd(
+        a01, _mm512_setr_epi64(5, 1, 13, 9, 5, 1, 13, 9), a23);
+    const __m512d u_3_2 = _mm512_permutex2var_pd(
+        a01, _mm512_setr_epi64(7, 3, 15, 11, 6, 2, 14, 10), a23);
+
+    /*
+     * adj01 = sign * (u_1_0 * c_23_23 - u_2_2 * c_13_03 + u_3_3 * c_12_02)
+     * adj23 = sign * (u_0_0 * c_13_12 - u_1_1 * c_03_02 + u_3_2 * c_01_01)
+     *
+     * where sign holds the signs of v_k and of the odd rows.
+     */
+    const __m512d sign = _mm512_setr_pd(
+        1.0, -1.0, 1.0, -1.0, -1.0, 1.0, -1.0, 1.0);
+
+    __m512d adj01 = _mm512_mul_pd(u_1_0, c_23_23);
+    adj01 = _mm512_fnmadd_pd(u_2_2, c_13_03, adj01);
+    adj01 = _mm512_fmadd_pd(u_3_3, c_12_02, adj01);
+    adj01 = _mm512_mul_pd(adj01, sign);
+
+    __m512d adj23 = _mm512_mul_pd(u_0_0, c_13_12);
+    adj23 = _mm512_fnmadd_pd(u_1_1, c_03_02, adj23);
+    adj23 = _mm512_fmadd_pd(u_3_2, c_01_01, adj23);
+    adj23 = _mm512_mul_pd(adj23, sign);
+
+    /*
+     * Expand the determinant along the first row of a and the first column
+     * of the adjugate, det(a) = sum_k a(0,k) * adj(k,0).
+     */
+    const __m512d col0 = _mm512_permutex2var_pd(
+        adj01, _mm512_setr_epi64(0, 4, 8, 12, 0, 4, 8, 12), adj23);
+    const __m256d det_row = simd256_dot_(
+        _mm512_maskz_extractf64x4_pd(0x0f, a01, 0),
+        _mm512_maskz_extractf64x4_pd(0x0f, col0, 0));
+    const __m512d det = _mm512_maskz_broadcast_f64x4(all, det_row);
+
+    /*
+     * Set the inverse to zero if the determinant is null.
+     */
+    const __mmask8 mask = _mm512_cmp_pd_mask(
+        det, _mm512_setzero_pd(), _CMP_NEQ_OQ);
+    const __m512d inv_det = simd512_recip_(mask, det);
+
+    mat4<double> result{};
+    simd512_store(result, 0, _mm512_mul_pd(adj01, inv_det));
+    simd512_store(result, 1, _mm512_mul_pd(adj23, inv_det));
+    return result;
+}
+#endif  /* ATTO_MATH_SIMD512 */
+
+/** ---- Single precision ----------------------------------------------------
+ * dot
+ * @brief Return the 2-dimensional dot product.
+ */
+template<>
+core_inline
+float dot(const vec2<float> &v, const vec2<float> &w)
+{
+    const __m128 a = simd_load(v);
+    const __m128 b = simd_load(w);
+    return _mm_cvtss_f32(simd128_dot_(a, b));
+}
+
+template<>
+core_inline
+vec2<float> dot(const mat2<float> &a, const vec2<float> &v)
+{
+    /*
+     * a   = {a0, a1, a2, a3}
+     * b   = {b0, b1, b0, b1}
+     * mul = {a0*b0 + a1*b1, a2*b0 + a3*b1, ...}
+     */
+    __m128 a0 = simd_load(a);
+    __m128 b0 = simd_load(v);
+    __m128 b  = _mm_movelh_ps(b0, b0);
+    __m128 c  = _mm_mul_ps(a0, b);
+    __m128 mul = _mm_hadd_ps(c, c);
+
+    vec2<float> result{};
+    simd_store(result, mul);
+    return result;
+}
+
+template<>
+core_inline
+mat2<float> dot(const mat2<float> &a, const mat2<float> &b)
+{
+    /*
+     * a0 = {a0, a0, a2, a2}
+     * a1 = {a1, a1, a3, a3}
+     * b0 = {b0, b1, b0, b1}
+     * b1 = {b2, b3, b2, b3}
+     */
+    __m128 a_ = simd_load(a);
+    __m128 b_ = simd_load(b);
+    __m128 a0 = _mm_shuffle_ps(a_, a_, _MM_SHUFFLE(2, 2, 0, 0));
+    __m128 a1 = _mm_shuffle_ps(a_, a_, _MM_SHUFFLE(3, 3, 1, 1));
+    __m128 b0 = _mm_movelh_ps(b_, b_);
+    __m128 b1 = _mm_movehl_ps(b_, b_);
+    /*
+     * mul = {a0*b0 + a1*b2,
+     *        a0*b1 + a1*b3,
+     *        a2*b0 + a3*b2,
+     *        a2*b1 + a3*b3}
+     */
+    __m128 mul = simd128_fmadd_(a1, b1, _mm_mul_ps(a0, b0));
+
+    mat2<float> result{};
+    simd_store(result, mul);
+    return result;
+}
+
+/**
+ * dot
+ * @brief Return the 3-dimensional dot product.
+ */
+template<>
+core_inline
+float dot(const vec3<float> &v, const vec3<float> &w)
+{
+    const __m128 a = simd_load(v);
+    const __m128 b = simd_load(w);
+    return _mm_cvtss_f32(simd128_dot_(a, b));
+}
+
+template<>
+core_inline
+vec3<float> dot(const mat3<float> &a, const vec3<float> &v)
+{
+    /*
+     * c_i = {a_i0*b0, a_i1*b1, a_i2*b2, 0}
+     * mul = {sum(c0), sum(c1), sum(c2), 0}
+     */
+    __m128 b  = simd_load(v);
+    __m128 c0 = _mm_mul_ps(simd_load(a, 0), b);
+    __m128 c1 = _mm_mul_ps(simd_load(a, 1), b);
+    __m128 c2 = _mm_mul_ps(simd_load(a, 2), b);
+    __m128 mul = _mm_hadd_ps(
+        _mm_hadd_ps(c0, c1),
+        _mm_hadd_ps(c2, _mm_setzero_ps()));
+
+    vec3<float> result{};
+    simd_store(result, mul);
+    return result;
+}
+
+template<>
+core_inline
+mat3<float> dot(const mat3<float> &a, const mat3<float> &b)
+{
+    /*
+     * row_i = a_i0 * b0 + a_i1 * b1 + a_i2 * b2
+     */
+    __m128 b0 = simd_load(b, 0);
+    __m128 b1 = simd_load(b, 1);
+    __m128 b2 = simd_load(b, 2);
+
+    mat3<float> result{};
+    for (size_t i = 0; i < 3; ++i) {
+        __m128 mul = _mm_mul_ps(_mm_set1_ps(a(i,0)), b0);
+        mul = simd128_fmadd_(_mm_set1_ps(a(i,1)), b1, mul);
+        mul = simd128_fmadd_(_mm_set1_ps(a(i,2)), b2, mul);
+        simd_store(result, i, mul);
+    }
+    return result;
+}
+
+/**
+ * dot
+ * @brief Return the 4-dimensional dot product.
+ */
+template<>
+core_inline
+float dot(const vec4<float> &v, const vec4<float> &w)
+{
+    const __m128 a = simd_load(v);
+    const __m128 b = simd_load(w);
+    return _mm_cvtss_f32(simd128_dot_(a, b));
+}
+
+template<>
+core_inline
+vec4<float> dot(const mat4<float> &a, const vec4<float> &v)
+{
+    /*
+     * c_i = {a_i0*b0, a_i1*b1, a_i2*b2, a_i3*b3}
+     * mul = {sum(c0), sum(c1), sum(c2), sum(c3)}
+     */
+    __m128 b  = simd_load(v);
+    __m128 c0 = _mm_mul_ps(simd_load(a, 0), b);
+    __m128 c1 = _mm_mul_ps(simd_load(a, 1), b);
+    __m128 c2 = _mm_mul_ps(simd_load(a, 2), b);
+    __m128 c3 = _mm_mul_ps(simd_load(a, 3), b);
+    __m128 mul = _mm_hadd_ps(_mm_hadd_ps(c0, c1), _mm_hadd_ps(c2, c3));
+
+    vec4<float> result{};
+    simd_store(result, mul);
+    return result;
+}
+
+template<>
+core_inline
+mat4<float> dot(const mat4<float> &a, const mat4<float> &b)
+{
+    /*
+     * row_i = a_i0 * b0 + a_i1 * b1 + a_i2 * b2 + a_i3 * b3
+     */
+    __m128 b0 = simd_load(b, 0);
+    __m128 b1 = simd_load(b, 1);
+    __m128 b2 = simd_load(b, 2);
+    __m128 b3 = simd_load(b, 3);
+
+    mat4<float> result{};
+    for (size_t i = 0; i < 4; ++i) {
+        __m128 mul = _mm_mul_ps(_mm_set1_ps(a(i,0)), b0);
+        mul = simd128_fmadd_(_mm_set1_ps(a(i,1)), b1, mul);
+        mul = simd128_fmadd_(_mm_set1_ps(a(i,2)), b2, mul);
+        mul = simd128_fmadd_(_mm_set1_ps(a(i,3)), b3, mul);
+        simd_store(result, i, mul);
+    }
+    return result;
+}
+
+
+/** ---------------------------------------------------------------------------
+ * norm
+ * @brief Return the norm of the specified vector.
+ */
+template<>
+core_inline
+float norm(const vec2<float> &v)
+{
+    return _mm_cvtss_f32(simd128_norm_(simd_load(v)));
+}
+
+template<>
+core_inline
+float norm(const vec3<float> &v)
+{
+    return _mm_cvtss_f32(simd128_norm_(simd_load(v)));
+}
+
+template<>
+core_inline
+float norm(const vec4<float> &v)
+{
+    return _mm_cvtss_f32(simd128_norm_(simd_load(v)));
+}
+
+
+/** ---------------------------------------------------------------------------
+ * normalize
+ * @brief Return the normalized vector.
+ */
+template<>
+core_inline
+vec2<float> normalize(const vec2<float> &v)
+{
+    vec2<float> result{};
+    simd_store(result, simd128_normalize_(simd_load(v)));
+    return result;
+}
+
+template<>
+core_inline
+vec3<float> normalize(const vec3<float> &v)
+{
+    vec3<float> result{};
+    simd_store(result, simd128_normalize_(simd_load(v)));
+    return result;
+}
+
+template<>
+core_inline
+vec4<float> normalize(const vec4<float> &v)
+{
+    vec4<float> result{};
+    simd_store(result, simd128_normalize_(simd_load(v)));
+    return result;
+}
+
+
+/** ---------------------------------------------------------------------------
+ * distance
+ * @brief Return the distance between two vectors.
+ */
+template<>
+core_inline
+float distance(const vec2<float> &a, const vec2<float> &b)
+{
+    return norm(a-b);
+}
+
+template<>
+core_inline
+float distance(const vec3<float> &a, const vec3<float> &b)
+{
+    return norm(a-b);
+}
+
+template<>
+core_inline
+float distance(const vec4<float> &a, const vec4<float> &b)
+{
+    return norm(a-b);
+}
+
+
+/** ---------------------------------------------------------------------------
+ * cross
+ * @brief Return the cross product of two vectors.
+ */
+template<>
+core_inline
+vec3<float> cross(const vec3<float> &a, const vec3<float> &b)
+{
+    vec3<float> result{};
+    simd_store(result, simd128_cross_(simd_load(a), simd_load(b)));
+    return result;
+}
+
+
+/** ---------------------------------------------------------------------------
+ * transpose
+ * @brief Return the transpose matrix
+ */
+template<>
+core_inline
+mat2<float> transpose(const mat2<float> &a)
+{
+    /*
+     * {a0, a1, a2, a3} -> {a0, a2, a1, a3}
+     */
+    __m128 a0 = simd_load(a);
+
+    mat2<float> result{};
+    simd_store(result, _mm_shuffle_ps(a0, a0, _MM_SHUFFLE(3, 1, 2, 0)));
+    return result;
+}
+
+template<>
+core_inline
+mat3<float> transpose(const mat3<float> &a)
+{
+    __m128 row[4];
+    row[0] = simd_load(a, 0);
+    row[1] = simd_load(a, 1);
+    row[2] = simd_load(a, 2);
+    row[3] = _mm_setzero_ps();
+    simd128_transpose_(row);
+
+    mat3<float> result{};
+    simd_store(result, 0, row[0]);
+    simd_store(result, 1, row[1]);
+    simd_store(result, 2, row[2]);
+    return result;
+}
+
+template<>
+core_inline
+mat4<float> transpose(const mat4<float> &a)
+{
+    __m128 row[4];
+    row[0] = simd_load(a, 0);
+    row[1] = simd_load(a, 1);
+    row[2] = simd_load(a, 2);
+    row[3] = simd_load(a, 3);
+    simd128_transpose_(row);
+
+    mat4<float> result{};
+    simd_store(result, 0, row[0]);
+    simd_store(result, 1, row[1]);
+    simd_store(result, 2, row[2]);
+    simd_store(result, 3, row[3]);
+    return result;
+}
+
+
+/** ---------------------------------------------------------------------------
+ * determinant
+ * @brief Compute the determinant of the specified matrix.
+ */
+template<>
+core_inline
+float determinant(const mat2<float> &a)
+{
+    /*
+     * r0 = {a0, a1, a2, a3}
+     * r1 = {a3, a2, a1, a0}
+     * det = hsub({a0*a3, a1*a2, ...}) = {a0*a3 - a1*a2, ...}
+     */
+    __m128 r0 = simd_load(a);
+    __m128 r1 = _mm_shuffle_ps(r0, r0, _MM_SHUFFLE(0, 1, 2, 3));
+    __m128 r2 = _mm_mul_ps(r0, r1);
+    return _mm_cvtss_f32(_mm_hsub_ps(r2, r2));
+}
+
+template<>
+core_inline
+float determinant(const mat3<float> &a)
+{
+    /*
+     * det(a) = r0 . (r1 x r2)
+     */
+    __m128 r0 = simd_load(a, 0);
+    __m128 r1 = simd_load(a, 1);
+    __m128 r2 = simd_load(a, 2);
+    return _mm_cvtss_f32(simd128_dot_(r0, simd128_cross_(r1, r2)));
+}
+
+template<>
+core_inline
+float determinant(const mat4<float> &a)
+{
+    /*
+     * Laplace expansion along the first column:
+     *  det(a) = a0 * C0 + a4 * C4 + a8 * C8 + a12 * C12
+     *
+     * The cofactors of the first column are the first row of the
+     * adjugate, computed as in the inverse below.
+     */
+    const __m128 sign = _mm_setr_ps(1.0f, -1.0f, 1.0f, -1.0f);
+    __m128 r0 = simd_load(a, 0);
+    __m128 r1 = simd_load(a, 1);
+    __m128 r2 = simd_load(a, 2);
+    __m128 r3 = simd_load(a, 3);
+
+    __m128 lo = simd128_fmsub_(
+        _mm_shuffle_ps(r2, r2, _MM_SHUFFLE(3, 1, 3, 2)),
+        _mm_shuffle_ps(r3, r3, _MM_SHUFFLE(0, 2, 1, 3)),
+        _mm_mul_ps(
+            _mm_shuffle_ps(r2, r2, _MM_SHUFFLE(0, 2, 1, 3)),
+            _mm_shuffle_ps(r3, r3, _MM_SHUFFLE(3, 1, 3, 2))));
+    __m128 hi = simd128_fmsub_(
+        _mm_shuffle_ps(r0, r0, _MM_SHUFFLE(3, 1, 3, 2)),
+        _mm_shuffle_ps(r1, r1, _MM_SHUFFLE(0, 2, 1, 3)),
+        _mm_mul_ps(
+            _mm_shuffle_ps(r0, r0, _MM_SHUFFLE(0, 2, 1, 3)),
+            _mm_shuffle_ps(r1, r1, _MM_SHUFFLE(3, 1, 3, 2))));
+
+    __m128 c[4];
+    c[0] = _mm_blend_ps(
+        _mm_shuffle_ps(r1, r3, _MM_SHUFFLE(0, 0, 0, 0)),
+        _mm_shuffle_ps(r0, r2, _MM_SHUFFLE(0, 0, 0, 0)),
+        core_extension(0b1010));
+    c[1] = _mm_blend_ps(
+        _mm_shuffle_ps(r1, r3, _MM_SHUFFLE(1, 1, 1, 1)),
+        _mm_shuffle_ps(r0, r2, _MM_SHUFFLE(1, 1, 1, 1)),
+        core_extension(0b1010));
+    c[2] = _mm_blend_ps(
+        _mm_shuffle_ps(r1, r3, _MM_SHUFFLE(2, 2, 2, 2)),
+        _mm_shuffle_ps(r0, r2, _MM_SHUFFLE(2, 2, 2, 2)),
+        core_extension(0b1010));
+    c[3] = _mm_blend_ps(
+        _mm_shuffle_ps(r1, r3, _MM_SHUFFLE(3, 3, 3, 3)),
+        _mm_shuffle_ps(r0, r2, _MM_SHUFFLE(3, 3, 3, 3)),
+        core_extension(0b1010));
+
+    __m128 s[4];
+    for (size_t k = 0; k < 4; ++k) {
+        s[k] = _mm_mul_ps(sign, c[k]);
+    }
+
+    __m128 m0 = _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(0, 0, 0, 0));
+    __m128 m1 = _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(1, 1, 1, 1));
+    __m128 m2 = _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(2, 2, 2, 2));
+
+    __m128 adj = _mm_mul_ps(s[1], m0);
+    adj = simd128_fmadd_(s[2], m1, adj);
+    adj = simd128_fmadd_(s[3], m2, adj);
+
+    __m128 col = _mm_shuffle_ps(c[0], c[0], _MM_SHUFFLE(2, 3, 0, 1));
+    return _mm_cvtss_f32(simd128_dot_(col, adj));
+}
+
+
+/** ---------------------------------------------------------------------------
+ * inverse
+ * @brief Return the inverse of the matrix, or the zero matrix if the
+ * determinant is null.
+ */
+template<>
+core_inline
+mat2<float> inverse(const mat2<float> &a)
+{
+    /*
+     * adj(a) = {a3, -a1, -a2, a0}
+     */
+    const __m128 sign = _mm_setr_ps(1.0f, -1.0f, -1.0f, 1.0f);
+    __m128 a0  = simd_load(a);
+    __m128 adj = _mm_mul_ps(
+        sign, _mm_shuffle_ps(a0, a0, _MM_SHUFFLE(0, 2, 1, 3)));
+
+    __m128 det = simd128_recip_(_mm_set1_ps(determinant(a)));
+
+    mat2<float> result{};
+    simd_store(result, _mm_mul_ps(adj, det));
+    return result;
+}
+
+template<>
+core_inline
+mat3<float> inverse(const mat3<float> &a)
+{
+    /*
+     * The columns of the adjugate are the cross products of the rows,
+     *  adj(a) = {r1 x r2, r2 x r0, r0 x r1}^t
+     * and det(a) = r0 . (r1 x r2).
+     */
+    __m128 r0 = simd_load(a, 0);
+    __m128 r1 = simd_load(a, 1);
+    __m128 r2 = simd_load(a, 2);
+
+    __m128 row[4];
+    row[0] = simd128_cross_(r1, r2);
+    row[1] = simd128_cross_(r2, r0);
+    row[2] = simd128_cross_(r0, r1);
+    row[3] = _mm_setzero_ps();
+
+    __m128 det = simd128_recip_(simd128_dot_(r0, row[0]));
+    simd128_transpose_(row);
+
+    mat3<float> result{};
+    simd_store(result, 0, _mm_mul_ps(row[0], det));
+    simd_store(result, 1, _mm_mul_ps(row[1], det));
+    simd_store(result, 2, _mm_mul_ps(row[2], det));
+    return result;
+}
+
+template<>
+core_inline
+mat4<float> inverse(const mat4<float> &a)
+{
+    /*
+     * Compute the inverse of matrix:
+     *  a = {a0,  a1,  a2,  a3,
+     *       a4,  a5,  a6,  a7,
+     *       a8,  a9,  a10, a11,
+     *       a12, a13, a14, a15}
+     *
+     * from its adjugate, with the same minors m0...m11 as the double
+     * precision version, packed four at a time:
+     *  lo  = {m0,  m1,  m2,  m3},  lo2 = {m4,  m5,  m4,  m5}
+     *  hi  = {m6,  m7,  m8,  m9},  hi2 = {m10, m11, m10, m11}
+     *
+     * With the columns of a packed and signed as
+     *  c_k = {a(1,k), a(0,k), a(3,k), a(2,k)}
+     *  s_k = {a(1,k), -a(0,k), a(3,k), -a(2,k)}
+     * each row of the adjugate is a sum of three products
+     *  adj0 =  s1 * {m0, m0, m6,  m6}  + s2 * {m1, m1, m7,  m7}
+     *                                  + s3 * {m2, m2, m8,  m8}
+     *  adj1 = -s0 * {m0, m0, m6,  m6}  - s2 * {m3, m3, m9,  m9}
+     *                                  - s3 * {m4, m4, m10, m10}
+     *  adj2 = -s0 * {m1, m1, m7,  m7}  + s1 * {m3, m3, m9,  m9}
+     *                                  + s3 * {m5, m5, m11, m11}
+     *  adj3 = -s0 * {m2, m2, m8,  m8}  + s1 * {m4, m4, m10, m10}
+     *                                  - s2 * {m5, m5, m11, m11}
+     */
+    const __m128 sign = _mm_setr_ps(1.0f, -1.0f, 1.0f, -1.0f);
+    __m128 r0 = simd_load(a, 0);
+    __m128 r1 = simd_load(a, 1);
+    __m128 r2 = simd_load(a, 2);
+    __m128 r3 = simd_load(a, 3);
+
+    /*
+     * lo = {a10*a15 - a11*a14,
+     *       a11*a13 - a9*a15,
+     *       a9*a14  - a10*a13,
+     *       a11*a12 - a8*a15}
+     * lo2 = {a8*a14 - a10*a12,
+     *        a8*a13 - a9*a12, ...}
+     */
+    __m128 lo = simd128_fmsub_(
+        _mm_shuffle_ps(r2, r2, _MM_SHUFFLE(3, 1, 3, 2)),
+        _mm_shuffle_ps(r3, r3, _MM_SHUFFLE(0, 2, 1, 3)),
+        _mm_mul_ps(
+            _mm_shuffle_ps(r2, r2, _MM_SHUFFLE(0, 2, 1, 3)),
+            _mm_shuffle_ps(r3, r3, _MM_SHUFFLE(3, 1, 3, 2))));
+    __m128 lo2 = simd128_fmsub_(
+        _mm_shuffle_ps(r2, r2, _MM_SHUFFLE(0, 0, 0, 0)),
+        _mm_shuffle_ps(r3, r3, _MM_SHUFFLE(1, 2, 1, 2)),
+        _mm_mul_ps(
+            _mm_shuffle_ps(r2, r2, _MM_SHUFFLE(1, 2, 1, 2)),
+            _mm_shuffle_ps(r3, r3, _MM_SHUFFLE(0, 0, 0, 0))));
+
+    /*
+     * hi and hi2 are the same minors of the first two rows.
+     */
+    __m128 hi = simd128_fmsub_(
+        _mm_shuffle_ps(r0, r0, _MM_SHUFFLE(3, 1, 3, 2)),
+        _mm_shuffle_ps(r1, r1, _MM_SHUFFLE(0, 2, 1, 3)),
+        _mm_mul_ps(
+            _mm_shuffle_ps(r0, r0, _MM_SHUFFLE(0, 2, 1, 3)),
+            _mm_shuffle_ps(r1, r1, _MM_SHUFFLE(3, 1, 3, 2))));
+    __m128 hi2 = simd128_fmsub_(
+        _mm_shuffle_ps(r0, r0, _MM_SHUFFLE(0, 0, 0, 0)),
+        _mm_shuffle_ps(r1, r1, _MM_SHUFFLE(1, 2, 1, 2)),
+        _mm_mul_ps(
+            _mm_shuffle_ps(r0, r0, _MM_SHUFFLE(1, 2, 1, 2)),
+            _mm_shuffle_ps(r1, r1, _MM_SHUFFLE(0, 0, 0, 0))));
+
+    /*
+     * m_k = {m_k, m_k, m_(k+6), m_(k+6)}
+     */
+    __m128 m[6];
+    m[0] = _mm_shuffle_ps(lo,  hi,  _MM_SHUFFLE(0, 0, 0, 0));
+    m[1] = _mm_shuffle_ps(lo,  hi,  _MM_SHUFFLE(1, 1, 1, 1));
+    m[2] = _mm_shuffle_ps(lo,  hi,  _MM_SHUFFLE(2, 2, 2, 2));
+    m[3] = _mm_shuffle_ps(lo,  hi,  _MM_SHUFFLE(3, 3, 3, 3));
+    m[4] = _mm_shuffle_ps(lo2, hi2, _MM_SHUFFLE(0, 0, 0, 0));
+    m[5] = _mm_shuffle_ps(lo2, hi2, _MM_SHUFFLE(1, 1, 1, 1));
+
+    /*
+     * c_k = {a(1,k), a(0,k), a(3,k), a(2,k)}
+     *
+     * @fn _mm_blend_ps(__m128 a, __m128 b, const int imm8)
+     * dst[i] := imm8[i] ? b[i] : a[i]
+     */
+    __m128 c[4];
+    c[0] = _mm_blend_ps(
+        _mm_shuffle_ps(r1, r3, _MM_SHUFFLE(0, 0, 0, 0)),
+        _mm_shuffle_ps(r0, r2, _MM_SHUFFLE(0, 0, 0, 0)),
+        core_extension(0b1010));
+    c[1] = _mm_blend_ps(
+        _mm_shuffle_ps(r1, r3, _MM_SHUFFLE(1, 1, 1, 1)),
+        _mm_shuffle_ps(r0, r2, _MM_SHUFFLE(1, 1, 1, 1)),
+        core_extension(0b1010));
+    c[2] = _mm_blend_ps(
+        _mm_shuffle_ps(r1, r3, _MM_SHUFFLE(2, 2, 2, 2)),
+        _mm_shuffle_ps(r0, r2, _MM_SHUFFLE(2, 2, 2, 2)),
+        core_extension(0b1010));
+    c[3] = _mm_blend_ps(
+        _mm_shuffle_ps(r1, r3, _MM_SHUFFLE(3, 3, 3, 3)),
+        _mm_shuffle_ps(r0, r2, _MM_SHUFFLE(3, 3, 3, 3)),
+        core_extension(0b1010));
+
+    __m128 s[4];
+    for (size_t k = 0; k < 4; ++k) {
+        s[k] = _mm_mul_ps(sign, c[k]);
+    }
+
+    __m128 adj0 = _mm_mul_ps(s[1], m[0]);
+    adj0 = simd128_fmadd_(s[2], m[1], adj0);
+    adj0 = simd128_fmadd_(s[3], m[2], adj0);
+
+    __m128 adj1 = simd128_fnmadd_(s[0], m[0], _mm_setzero_ps());
+    adj1 = simd128_fnmadd_(s[2], m[3], adj1);
+    adj1 = simd128_fnmadd_(s[3], m[4], adj1);
+
+    __m128 adj2 = _mm_mul_ps(s[1], m[3]);
+    adj2 = simd128_fmadd_(s[3], m[5], adj2);
+    adj2 = simd128_fnmadd_(s[0], m[1], adj2);
+
+    __m128 adj3 = _mm_mul_ps(s[1], m[4]);
+    adj3 = simd128_fnmadd_(s[0], m[2], adj3);
+    adj3 = simd128_fnmadd_(s[2], m[5], adj3);
+
+    /*
+     * det(a) = {a0, a4, a8, a12} . adj0
+     */
+    __m128 col = _mm_shuffle_ps(c[0], c[0], _MM_SHUFFLE(2, 3, 0, 1));
+    __m128 det = simd128_recip_(simd128_dot_(col, adj0));
+
+    mat4<float> result{};
+    simd_store(result, 0, _mm_mul_ps(adj0, det));
+    simd_store(result, 1, _mm_mul_ps(adj1, det));
+    simd_store(result, 2, _mm_mul_ps(adj2, det));
+    simd_store(result, 3, _mm_mul_ps(adj3, det));
+    return result;
+}
 
 } /* math */
 } /* atto */
@@ -282,7 +282,7 @@ core_inline
 vec2<double> floor(const vec2<double> &v)
 {
     vec2<double> result{};
-    simd_store(result, _mm_floor_pd(simd_load(v)));
+    simd_store(result, simd128_floor_(simd_load(v)));
     return result;
 }
 
@@ -291,7 +291,7 @@ core_inline
 vec3<double> floor(const vec3<double> &v)
 {
     vec3<double> result{};
-    simd_store(result, _mm256_floor_pd(simd_load(v)));
+    simd_store(result, simd256_floor_(simd_load(v)));
     return result;
 }
 
@@ -300,7 +300,7 @@ core_inline
 vec4<double> floor(const vec4<double> &v)
 {
     vec4<double> result{};
-    simd_store(result, _mm256_floor_pd(simd_load(v)));
+    simd_store(result, simd256_floor_(simd_load(v)));
     return result;
 }
 
@@ -312,8 +312,8 @@ mat2<double> floor(const mat2<double> &a)
     __m128d a1 = simd_load(a, 1);
 
     mat2<double> result{};
-    simd_store(result, 0, _mm_floor_pd(a0));
-    simd_store(result, 1, _mm_floor_pd(a1));
+    simd_store(result, 0, simd128_floor_(a0));
+    simd_store(result, 1, simd128_floor_(a1));
     return result;
 }
 
@@ -326,9 +326,9 @@ mat3<double> floor(const mat3<double> &a)
     __m256d a2 = simd_load(a, 2);
 
     mat3<double> result{};
-    simd_store(result, 0, _mm256_floor_pd(a0));
-    simd_store(result, 1, _mm256_floor_pd(a1));
-    simd_store(result, 2, _mm256_floor_pd(a2));
+    simd_store(result, 0, simd256_floor_(a0));
+    simd_store(result, 1, simd256_floor_(a1));
+    simd_store(result, 2, simd256_floor_(a2));
     return result;
 }
 
@@ -342,10 +342,10 @@ mat4<double> floor(const mat4<double> &a)
     __m256d a3 = simd_load(a, 3);
 
     mat4<double> result{};
-    simd_store(result, 0, _mm256_floor_pd(a0));
-    simd_store(result, 1, _mm256_floor_pd(a1));
-    simd_store(result, 2, _mm256_floor_pd(a2));
-    simd_store(result, 3, _mm256_floor_pd(a3));
+    simd_store(result, 0, simd256_floor_(a0));
+    simd_store(result, 1, simd256_floor_(a1));
+    simd_store(result, 2, simd256_floor_(a2));
+    simd_store(result, 3, simd256_floor_(a3));
     return result;
 }
 
@@ -375,9 +375,8 @@ template<>
 core_inline
 vec2<double> round(const vec2<double> &v)
 {
-    static constexpr int rounding = _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC;
     vec2<double> result{};
-    simd_store(result, _mm_round_pd(simd_load(v), rounding));
+    simd_store(result, simd128_round_(simd_load(v)));
     return result;
 }
 
@@ -385,9 +384,8 @@ template<>
 core_inline
 vec3<double> round(const vec3<double> &v)
 {
-    static constexpr int rounding = _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC;
     vec3<double> result{};
-    simd_store(result, _mm256_round_pd(simd_load(v), rounding));
+    simd_store(result, simd256_round_(simd_load(v)));
     return result;
 }
 
@@ -395,9 +393,8 @@ template<>
 core_inline
 vec4<double> round(const vec4<double> &v)
 {
-    static constexpr int rounding = _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC;
     vec4<double> result{};
-    simd_store(result, _mm256_round_pd(simd_load(v), rounding));
+    simd_store(result, simd256_round_(simd_load(v)));
     return result;
 }
 
@@ -405,14 +402,12 @@ template<>
 core_inline
 mat2<double> round(const mat2<double> &a)
 {
-    static constexpr int rounding = _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC;
-
     __m128d a0 = simd_load(a, 0);
     __m128d a1 = simd_load(a, 1);
 
     mat2<double> result{};
-    simd_store(result, 0, _mm_round_pd(a0, rounding));
-    simd_store(result, 1, _mm_round_pd(a1, rounding));
+    simd_store(result, 0, simd128_round_(a0));
+    simd_store(result, 1, simd128_round_(a1));
     return result;
 }
 
@@ -420,16 +415,14 @@ template<>
 core_inline
 mat3<double> round(const mat3<double> &a)
 {
-    static constexpr int rounding = _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC;
-
     __m256d a0 = simd_load(a, 0);
     __m256d a1 = simd_load(a, 1);
     __m256d a2 = simd_load(a, 2);
 
     mat3<double> result{};
-    simd_store(result, 0, _mm256_round_pd(a0, rounding));
-    simd_store(result, 1, _mm256_round_pd(a1, rounding));
-    simd_store(result, 2, _mm256_round_pd(a2, rounding));
+    simd_store(result, 0, simd256_round_(a0));
+    simd_store(result, 1, simd256_round_(a1));
+    simd_store(result, 2, simd256_round_(a2));
     return result;
 }
 
@@ -437,18 +430,16 @@ template<>
 core_inline
 mat4<double> round(const mat4<double> &a)
 {
-    static constexpr int rounding = _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC;
-
     __m256d a0 = simd_load(a, 0);
     __m256d a1 = simd_load(a, 1);
     __m256d a2 = simd_load(a, 2);
     __m256d a3 = simd_load(a, 3);
 
     mat4<double> result{};
-    simd_store(result, 0, _mm256_round_pd(a0, rounding));
-    simd_store(result, 1, _mm256_round_pd(a1, rounding));
-    simd_store(result, 2, _mm256_round_pd(a2, rounding));
-    simd_store(result, 3, _mm256_round_pd(a3, rounding));
+    simd_store(result, 0, simd256_round_(a0));
+    simd_store(result, 1, simd256_round_(a1));
+    simd_store(result, 2, simd256_round_(a2));
+    simd_store(result, 3, simd256_round_(a3));
     return result;
 }
 
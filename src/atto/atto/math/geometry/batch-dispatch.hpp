@@ -0,0 +1,319 @@
+/*
+ * batch-dispatch.hpp
+ *
+ * Copyright (c) 2020 Carlos Braga
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the MIT License.
+ *
+ * See accompanying LICENSE.md or https://opensource.org/licenses/MIT.
+ */
+
+#ifndef ATTO_MATH_GEOMETRY_BATCH_DISPATCH_H_
+#define ATTO_MATH_GEOMETRY_BATCH_DISPATCH_H_
+
+#include "atto/math/geometry/simd.hpp"
+
+/** ---- Batch kernels of each instruction set --------------------------------
+ * @brief A dispatch build targets a baseline older than AVX, and compiles
+ * the SIMD kernels of batch-simd.hpp once for each instruction set with the
+ * target pragma, into the namespaces:
+ *  avx         AVX, the double precision kernels use a multiply and add
+ *  avx2        AVX2 and FMA, the multiply and add are fused
+ *  avx512      AVX-512F, the double precision kernels use 512-bit registers
+ * The AVX-512 pass defines ATTO_MATH_SIMD512 to select its kernels.
+ */
+#pragma push_macro("ATTO_MATH_SIMD512")
+#undef ATTO_MATH_SIMD512
+
+#pragma GCC push_options
+#pragma GCC target("avx")
+#define simd_isa_ avx
+#include "atto/math/geometry/batch-simd.hpp"
+#undef simd_isa_
+#pragma GCC pop_options
+
+#pragma GCC push_options
+#pragma GCC target("avx2,fma")
+#define simd_isa_ avx2
+#include "atto/math/geometry/batch-simd.hpp"
+#undef simd_isa_
+#pragma GCC pop_options
+
+#define ATTO_MATH_SIMD512
+#pragma GCC push_options
+#pragma GCC target("avx512f,avx2,fma")
+#define simd_isa_ avx512
+#include "atto/math/geometry/batch-simd.hpp"
+#undef simd_isa_
+#pragma GCC pop_options
+
+#pragma pop_macro("ATTO_MATH_SIMD512")
+
+namespace atto {
+namespace math {
+namespace batch {
+
+/** ---- Batch kernel dispatch ------------------------------------------------
+ * @brief Double and single precision batch operations call the kernel of
+ * the widest instruction set enabled in core::cpu_dispatch, or the generic
+ * multiversioned loop on a processor older than AVX. The overloads hide the
+ * generic templates for double and float arrays.
+ */
+core_inline
+void dot(
+    const size_t n,
+    const double *ax, const double *ay, const double *az,
+    const double *bx, const double *by, const double *bz,
+    double *r)
+{
+    simd_dispatch_(dot, n, ax, ay, az, bx, by, bz, r);
+}
+
+core_inline
+void dot(
+    const size_t n,
+    const double *ax, const double *ay, const double *az, const double *aw,
+    const double *bx, const double *by, const double *bz, const double *bw,
+    double *r)
+{
+    simd_dispatch_(dot, n, ax, ay, az, aw, bx, by, bz, bw, r);
+}
+
+core_inline
+void cross(
+    const size_t n,
+    const double *ax, const double *ay, const double *az,
+    const double *bx, const double *by, const double *bz,
+    double *rx, double *ry, double *rz)
+{
+    simd_dispatch_(cross, n, ax, ay, az, bx, by, bz, rx, ry, rz);
+}
+
+core_inline
+void norm(
+    const size_t n,
+    const double *ax, const double *ay, const double *az,
+    double *r)
+{
+    simd_dispatch_(norm, n, ax, ay, az, r);
+}
+
+core_inline
+void norm(
+    const size_t n,
+    const double *ax, const double *ay, const double *az, const double *aw,
+    double *r)
+{
+    simd_dispatch_(norm, n, ax, ay, az, aw, r);
+}
+
+core_inline
+void normalize(
+    const size_t n,
+    const double *ax, const double *ay, const double *az,
+    double *rx, double *ry, double *rz)
+{
+    simd_dispatch_(normalize, n, ax, ay, az, rx, ry, rz);
+}
+
+core_inline
+void normalize(
+    const size_t n,
+    const double *ax, const double *ay, const double *az, const double *aw,
+    double *rx, double *ry, double *rz, double *rw)
+{
+    simd_dispatch_(normalize, n, ax, ay, az, aw, rx, ry, rz, rw);
+}
+
+core_inline
+void distance(
+    const size_t n,
+    const double *ax, const double *ay, const double *az,
+    const double *bx, const double *by, const double *bz,
+    double *r)
+{
+    simd_dispatch_(distance, n, ax, ay, az, bx, by, bz, r);
+}
+
+core_inline
+void distance(
+    const size_t n,
+    const double *ax, const double *ay, const double *az, const double *aw,
+    const double *bx, const double *by, const double *bz, const double *bw,
+    double *r)
+{
+    simd_dispatch_(distance, n, ax, ay, az, aw, bx, by, bz, bw, r);
+}
+
+core_inline
+void dot(
+    const size_t n,
+    const mat3<double> &m,
+    const double *vx, const double *vy, const double *vz,
+    double *rx, double *ry, double *rz)
+{
+    simd_dispatch_(dot, n, m, vx, vy, vz, rx, ry, rz);
+}
+
+core_inline
+void dot(
+    const size_t n,
+    const mat4<double> &m,
+    const double *vx, const double *vy, const double *vz, const double *vw,
+    double *rx, double *ry, double *rz, double *rw)
+{
+    simd_dispatch_(dot, n, m, vx, vy, vz, vw, rx, ry, rz, rw);
+}
+
+core_inline
+void product(
+    const size_t n,
+    const double *ax, const double *ay, const double *az, const double *aw,
+    const double *bx, const double *by, const double *bz, const double *bw,
+    double *rx, double *ry, double *rz, double *rw)
+{
+    simd_dispatch_(product, n, ax, ay, az, aw, bx, by, bz, bw, rx, ry, rz, rw);
+}
+
+core_inline
+void rotate(
+    const size_t n,
+    const double *qx, const double *qy, const double *qz, const double *qw,
+    const double *vx, const double *vy, const double *vz,
+    double *rx, double *ry, double *rz)
+{
+    simd_dispatch_(rotate, n, qx, qy, qz, qw, vx, vy, vz, rx, ry, rz);
+}
+
+core_inline
+void dot(
+    const size_t n,
+    const float *ax, const float *ay, const float *az,
+    const float *bx, const float *by, const float *bz,
+    float *r)
+{
+    simd_dispatch_(dot, n, ax, ay, az, bx, by, bz, r);
+}
+
+core_inline
+void dot(
+    const size_t n,
+    const float *ax, const float *ay, const float *az, const float *aw,
+    const float *bx, const float *by, const float *bz, const float *bw,
+    float *r)
+{
+    simd_dispatch_(dot, n, ax, ay, az, aw, bx, by, bz, bw, r);
+}
+
+core_inline
+void cross(
+    const size_t n,
+    const float *ax, const float *ay, const float *az,
+    const float *bx, const float *by, const float *bz,
+    float *rx, float *ry, float *rz)
+{
+    simd_dispatch_(cross, n, ax, ay, az, bx, by, bz, rx, ry, rz);
+}
+
+core_inline
+void norm(
+    const size_t n,
+    const float *ax, const float *ay, const float *az,
+    float *r)
+{
+    simd_dispatch_(norm, n, ax, ay, az, r);
+}
+
+core_inline
+void norm(
+    const size_t n,
+    const float *ax, const float *ay, const float *az, const float *aw,
+    float *r)
+{
+    simd_dispatch_(norm, n, ax, ay, az, aw, r);
+}
+
+core_inline
+void normalize(
+    const size_t n,
+    const float *ax, const float *ay, const float *az,
+    float *rx, float *ry, float *rz)
+{
+    simd_dispatch_(normalize, n, ax, ay, az, rx, ry, rz);
+}
+
+core_inline
+void normalize(
+    const size_t n,
+    const float *ax, const float *ay, const float *az, const float *aw,
+    float *rx, float *ry, float *rz, float *rw)
+{
+    simd_dispatch_(normalize, n, ax, ay, az, aw, rx, ry, rz, rw);
+}
+
+core_inline
+void distance(
+    const size_t n,
+    const float *ax, const float *ay, const float *az,
+    const float *bx, const float *by, const float *bz,
+    float *r)
+{
+    simd_dispatch_(distance, n, ax, ay, az, bx, by, bz, r);
+}
+
+core_inline
+void distance(
+    const size_t n,
+    const float *ax, const float *ay, const float *az, const float *aw,
+    const float *bx, const float *by, const float *bz, const float *bw,
+    float *r)
+{
+    simd_dispatch_(distance, n, ax, ay, az, aw, bx, by, bz, bw, r);
+}
+
+core_inline
+void dot(
+    const size_t n,
+    const mat3<float> &m,
+    const float *vx, const float *vy, const float *vz,
+    float *rx, float *ry, float *rz)
+{
+    simd_dispatch_(dot, n, m, vx, vy, vz, rx, ry, rz);
+}
+
+core_inline
+void dot(
+    const size_t n,
+    const mat4<float> &m,
+    const float *vx, const float *vy, const float *vz, const float *vw,
+    float *rx, float *ry, float *rz, float *rw)
+{
+    simd_dispatch_(dot, n, m, vx, vy, vz, vw, rx, ry, rz, rw);
+}
+
+core_inline
+void product(
+    const size_t n,
+    const float *ax, const float *ay, const float *az, const float *aw,
+    const float *bx, const float *by, const float *bz, const float *bw,
+    float *rx, float *ry, float *rz, float *rw)
+{
+    simd_dispatch_(product, n, ax, ay, az, aw, bx, by, bz, bw, rx, ry, rz, rw);
+}
+
+core_inline
+void rotate(
+    const size_t n,
+    const float *qx, const float *qy, const float *qz, const float *qw,
+    const float *vx, const float *vy, const float *vz,
+    float *rx, float *ry, float *rz)
+{
+    simd_dispatch_(rotate, n, qx, qy, qz, qw, vx, vy, vz, rx, ry, rz);
+}
+
+} /* batch */
+} /* math */
+} /* atto */
+
+#endif /* ATTO_MATH_GEOMETRY_BATCH_DISPATCH_H_ */
@@ -0,0 +1,1322 @@
+/*
+ * batch-simd.hpp
+ *
+ * Copyright (c) 2020 Carlos Braga
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the MIT License.
+ *
+ * See accompanying LICENSE.md or https://opensource.org/licenses/MIT.
+ */
+
+#include "atto/math/geometry/simd.hpp"
+
+namespace atto {
+namespace math {
+namespace batch {
+
+/*
+ * A dispatch build includes this file once for each instruction set, with
+ * simd_isa_ naming the namespace of its kernels, see batch-dispatch.hpp.
+ * Otherwise the kernels specialise the generic templates of batch.hpp.
+ */
+#ifdef simd_isa_
+#define simd_kernel_ inline
+namespace simd_isa_ {
+#else
+#define simd_kernel_ template<> core_inline
+#endif
+
+#ifndef ATTO_MATH_SIMD512
+/** ---------------------------------------------------------------------------
+ * @brief Double precision batch operations process four vectors per
+ * instruction, with unaligned loads and stores of each component array.
+ * The remaining n % 4 vectors are processed one at a time.
+ */
+
+/**
+ * dot
+ * @brief Compute the dot products r = a.b of n pairs of vectors.
+ */
+simd_kernel_
+void dot(
+    const size_t n,
+    const double *ax, const double *ay, const double *az,
+    const double *bx, const double *by, const double *bz,
+    double *r)
+{
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256d d = _mm256_mul_pd(
+            _mm256_loadu_pd(ax + i), _mm256_loadu_pd(bx + i));
+        d = _mm256_add_pd(d, _mm256_mul_pd(
+            _mm256_loadu_pd(ay + i), _mm256_loadu_pd(by + i)));
+        d = _mm256_add_pd(d, _mm256_mul_pd(
+            _mm256_loadu_pd(az + i), _mm256_loadu_pd(bz + i)));
+        _mm256_storeu_pd(r + i, d);
+    }
+    for (; i < n; ++i) {
+        r[i] = ax[i] * bx[i] + ay[i] * by[i] + az[i] * bz[i];
+    }
+}
+
+simd_kernel_
+void dot(
+    const size_t n,
+    const double *ax, const double *ay, const double *az, const double *aw,
+    const double *bx, const double *by, const double *bz, const double *bw,
+    double *r)
+{
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256d d = _mm256_mul_pd(
+            _mm256_loadu_pd(ax + i), _mm256_loadu_pd(bx + i));
+        d = _mm256_add_pd(d, _mm256_mul_pd(
+            _mm256_loadu_pd(ay + i), _mm256_loadu_pd(by + i)));
+        d = _mm256_add_pd(d, _mm256_mul_pd(
+            _mm256_loadu_pd(az + i), _mm256_loadu_pd(bz + i)));
+        d = _mm256_add_pd(d, _mm256_mul_pd(
+            _mm256_loadu_pd(aw + i), _mm256_loadu_pd(bw + i)));
+        _mm256_storeu_pd(r + i, d);
+    }
+    for (; i < n; ++i) {
+        r[i] = ax[i] * bx[i] + ay[i] * by[i] + az[i] * bz[i] + aw[i] * bw[i];
+    }
+}
+
+/**
+ * cross
+ * @brief Compute the cross products r = a x b of n pairs of vectors.
+ */
+simd_kernel_
+void cross(
+    const size_t n,
+    const double *ax, const double *ay, const double *az,
+    const double *bx, const double *by, const double *bz,
+    double *rx, double *ry, double *rz)
+{
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        const __m256d a_x = _mm256_loadu_pd(ax + i);
+        const __m256d a_y = _mm256_loadu_pd(ay + i);
+        const __m256d a_z = _mm256_loadu_pd(az + i);
+        const __m256d b_x = _mm256_loadu_pd(bx + i);
+        const __m256d b_y = _mm256_loadu_pd(by + i);
+        const __m256d b_z = _mm256_loadu_pd(bz + i);
+        _mm256_storeu_pd(rx + i, _mm256_sub_pd(
+            _mm256_mul_pd(a_y, b_z), _mm256_mul_pd(a_z, b_y)));
+        _mm256_storeu_pd(ry + i, _mm256_sub_pd(
+            _mm256_mul_pd(a_z, b_x), _mm256_mul_pd(a_x, b_z)));
+        _mm256_storeu_pd(rz + i, _mm256_sub_pd(
+            _mm256_mul_pd(a_x, b_y), _mm256_mul_pd(a_y, b_x)));
+    }
+    for (; i < n; ++i) {
+        const double x = ay[i] * bz[i] - az[i] * by[i];
+        const double y = az[i] * bx[i] - ax[i] * bz[i];
+        const double z = ax[i] * by[i] - ay[i] * bx[i];
+        rx[i] = x;
+        ry[i] = y;
+        rz[i] = z;
+    }
+}
+
+/**
+ * norm
+ * @brief Compute the norms r = |a| of n vectors.
+ */
+simd_kernel_
+void norm(
+    const size_t n,
+    const double *ax, const double *ay, const double *az,
+    double *r)
+{
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        const __m256d a_x = _mm256_loadu_pd(ax + i);
+        const __m256d a_y = _mm256_loadu_pd(ay + i);
+        const __m256d a_z = _mm256_loadu_pd(az + i);
+        __m256d d = _mm256_mul_pd(a_x, a_x);
+        d = _mm256_add_pd(d, _mm256_mul_pd(a_y, a_y));
+        d = _mm256_add_pd(d, _mm256_mul_pd(a_z, a_z));
+        _mm256_storeu_pd(r + i, _mm256_sqrt_pd(d));
+    }
+    for (; i < n; ++i) {
+        r[i] = std::sqrt(ax[i] * ax[i] + ay[i] * ay[i] + az[i] * az[i]);
+    }
+}
+
+simd_kernel_
+void norm(
+    const size_t n,
+    const double *ax, const double *ay, const double *az, const double *aw,
+    double *r)
+{
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        const __m256d a_x = _mm256_loadu_pd(ax + i);
+        const __m256d a_y = _mm256_loadu_pd(ay + i);
+        const __m256d a_z = _mm256_loadu_pd(az + i);
+        const __m256d a_w = _mm256_loadu_pd(aw + i);
+        __m256d d = _mm256_mul_pd(a_x, a_x);
+        d = _mm256_add_pd(d, _mm256_mul_pd(a_y, a_y));
+        d = _mm256_add_pd(d, _mm256_mul_pd(a_z, a_z));
+        d = _mm256_add_pd(d, _mm256_mul_pd(a_w, a_w));
+        _mm256_storeu_pd(r + i, _mm256_sqrt_pd(d));
+    }
+    for (; i < n; ++i) {
+        r[i] = std::sqrt(
+            ax[i] * ax[i] + ay[i] * ay[i] + az[i] * az[i] + aw[i] * aw[i]);
+    }
+}
+
+/**
+ * normalize
+ * @brief Compute the normalized vectors r = a / |a| of n vectors.
+ */
+simd_kernel_
+void normalize(
+    const size_t n,
+    const double *ax, const double *ay, const double *az,
+    double *rx, double *ry, double *rz)
+{
+    const __m256d one = _mm256_set1_pd(1.0);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        const __m256d a_x = _mm256_loadu_pd(ax + i);
+        const __m256d a_y = _mm256_loadu_pd(ay + i);
+        const __m256d a_z = _mm256_loadu_pd(az + i);
+        __m256d d = _mm256_mul_pd(a_x, a_x);
+        d = _mm256_add_pd(d, _mm256_mul_pd(a_y, a_y));
+        d = _mm256_add_pd(d, _mm256_mul_pd(a_z, a_z));
+        const __m256d inv = _mm256_div_pd(one, _mm256_sqrt_pd(d));
+        _mm256_storeu_pd(rx + i, _mm256_mul_pd(a_x, inv));
+        _mm256_storeu_pd(ry + i, _mm256_mul_pd(a_y, inv));
+        _mm256_storeu_pd(rz + i, _mm256_mul_pd(a_z, inv));
+    }
+    for (; i < n; ++i) {
+        const double inv = 1.0 / std::sqrt(
+            ax[i] * ax[i] + ay[i] * ay[i] + az[i] * az[i]);
+        rx[i] = ax[i] * inv;
+        ry[i] = ay[i] * inv;
+        rz[i] = az[i] * inv;
+    }
+}
+
+simd_kernel_
+void normalize(
+    const size_t n,
+    const double *ax, const double *ay, const double *az, const double *aw,
+    double *rx, double *ry, double *rz, double *rw)
+{
+    const __m256d one = _mm256_set1_pd(1.0);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        const __m256d a_x = _mm256_loadu_pd(ax + i);
+        const __m256d a_y = _mm256_loadu_pd(ay + i);
+        const __m256d a_z = _mm256_loadu_pd(az + i);
+        const __m256d a_w = _mm256_loadu_pd(aw + i);
+        __m256d d = _mm256_mul_pd(a_x, a_x);
+        d = _mm256_add_pd(d, _mm256_mul_pd(a_y, a_y));
+        d = _mm256_add_pd(d, _mm256_mul_pd(a_z, a_z));
+        d = _mm256_add_pd(d, _mm256_mul_pd(a_w, a_w));
+        const __m256d inv = _mm256_div_pd(one, _mm256_sqrt_pd(d));
+        _mm256_storeu_pd(rx + i, _mm256_mul_pd(a_x, inv));
+        _mm256_storeu_pd(ry + i, _mm256_mul_pd(a_y, inv));
+        _mm256_storeu_pd(rz + i, _mm256_mul_pd(a_z, inv));
+        _mm256_storeu_pd(rw + i, _mm256_mul_pd(a_w, inv));
+    }
+    for (; i < n; ++i) {
+        const double inv = 1.0 / std::sqrt(
+            ax[i] * ax[i] + ay[i] * ay[i] + az[i] * az[i] + aw[i] * aw[i]);
+        rx[i] = ax[i] * inv;
+        ry[i] = ay[i] * inv;
+        rz[i] = az[i] * inv;
+        rw[i] = aw[i] * inv;
+    }
+}
+
+/**
+ * distance
+ * @brief Compute the distances r = |a - b| between n pairs of points.
+ */
+simd_kernel_
+void distance(
+    const size_t n,
+    const double *ax, const double *ay, const double *az,
+    const double *bx, const double *by, const double *bz,
+    double *r)
+{
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        const __m256d d_x = _mm256_sub_pd(
+            _mm256_loadu_pd(ax + i), _mm256_loadu_pd(bx + i));
+        const __m256d d_y = _mm256_sub_pd(
+            _mm256_loadu_pd(ay + i), _mm256_loadu_pd(by + i));
+        const __m256d d_z = _mm256_sub_pd(
+            _mm256_loadu_pd(az + i), _mm256_loadu_pd(bz + i));
+        __m256d d = _mm256_mul_pd(d_x, d_x);
+        d = _mm256_add_pd(d, _mm256_mul_pd(d_y, d_y));
+        d = _mm256_add_pd(d, _mm256_mul_pd(d_z, d_z));
+        _mm256_storeu_pd(r + i, _mm256_sqrt_pd(d));
+    }
+    for (; i < n; ++i) {
+        const double dx = ax[i] - bx[i];
+        const double dy = ay[i] - by[i];
+        const double dz = az[i] - bz[i];
+        r[i] = std::sqrt(dx * dx + dy * dy + dz * dz);
+    }
+}
+
+simd_kernel_
+void distance(
+    const size_t n,
+    const double *ax, const double *ay, const double *az, const double *aw,
+    const double *bx, const double *by, const double *bz, const double *bw,
+    double *r)
+{
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        const __m256d d_x = _mm256_sub_pd(
+            _mm256_loadu_pd(ax + i), _mm256_loadu_pd(bx + i));
+        const __m256d d_y = _mm256_sub_pd(
+            _mm256_loadu_pd(ay + i), _mm256_loadu_pd(by + i));
+        const __m256d d_z = _mm256_sub_pd(
+            _mm256_loadu_pd(az + i), _mm256_loadu_pd(bz + i));
+        const __m256d d_w = _mm256_sub_pd(
+            _mm256_loadu_pd(aw + i), _mm256_loadu_pd(bw + i));
+        __m256d d = _mm256_mul_pd(d_x, d_x);
+        d = _mm256_add_pd(d, _mm256_mul_pd(d_y, d_y));
+        d = _mm256_add_pd(d, _mm256_mul_pd(d_z, d_z));
+        d = _mm256_add_pd(d, _mm256_mul_pd(d_w, d_w));
+        _mm256_storeu_pd(r + i, _mm256_sqrt_pd(d));
+    }
+    for (; i < n; ++i) {
+        const double dx = ax[i] - bx[i];
+        const double dy = ay[i] - by[i];
+        const double dz = az[i] - bz[i];
+        const double dw = aw[i] - bw[i];
+        r[i] = std::sqrt(dx * dx + dy * dy + dz * dz + dw * dw);
+    }
+}
+
+/** ---------------------------------------------------------------------------
+ * dot
+ * @brief Compute the products r = m v of a matrix with n vectors. The
+ * matrix elements are broadcast once and each row is a sum of products
+ * with the component registers.
+ */
+simd_kernel_
+void dot(
+    const size_t n,
+    const mat3<double> &m,
+    const double *vx, const double *vy, const double *vz,
+    double *rx, double *ry, double *rz)
+{
+    __m256d a[3][3];
+    for (size_t k = 0; k < 3; ++k) {
+        for (size_t j = 0; j < 3; ++j) {
+            a[k][j] = _mm256_set1_pd(m(k,j));
+        }
+    }
+
+    double *r[3] = {rx, ry, rz};
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        const __m256d x = _mm256_loadu_pd(vx + i);
+        const __m256d y = _mm256_loadu_pd(vy + i);
+        const __m256d z = _mm256_loadu_pd(vz + i);
+        __m256d s[3];
+        for (size_t k = 0; k < 3; ++k) {
+            s[k] = _mm256_mul_pd(a[k][0], x);
+            s[k] = _mm256_add_pd(s[k], _mm256_mul_pd(a[k][1], y));
+            s[k] = _mm256_add_pd(s[k], _mm256_mul_pd(a[k][2], z));
+        }
+        for (size_t k = 0; k < 3; ++k) {
+            _mm256_storeu_pd(r[k] + i, s[k]);
+        }
+    }
+    for (; i < n; ++i) {
+        const double x = vx[i];
+        const double y = vy[i];
+        const double z = vz[i];
+        rx[i] = m(0,0) * x + m(0,1) * y + m(0,2) * z;
+        ry[i] = m(1,0) * x + m(1,1) * y + m(1,2) * z;
+        rz[i] = m(2,0) * x + m(2,1) * y + m(2,2) * z;
+    }
+}
+
+simd_kernel_
+void dot(
+    const size_t n,
+    const mat4<double> &m,
+    const double *vx, const double *vy, const double *vz, const double *vw,
+    double *rx, double *ry, double *rz, double *rw)
+{
+    __m256d a[4][4];
+    for (size_t k = 0; k < 4; ++k) {
+        for (size_t j = 0; j < 4; ++j) {
+            a[k][j] = _mm256_set1_pd(m(k,j));
+        }
+    }
+
+    double *r[4] = {rx, ry, rz, rw};
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        const __m256d x = _mm256_loadu_pd(vx + i);
+        const __m256d y = _mm256_loadu_pd(vy + i);
+        const __m256d z = _mm256_loadu_pd(vz + i);
+        const __m256d w = _mm256_loadu_pd(vw + i);
+        __m256d s[4];
+        for (size_t k = 0; k < 4; ++k) {
+            s[k] = _mm256_mul_pd(a[k][0], x);
+            s[k] = _mm256_add_pd(s[k], _mm256_mul_pd(a[k][1], y));
+            s[k] = _mm256_add_pd(s[k], _mm256_mul_pd(a[k][2], z));
+            s[k] = _mm256_add_pd(s[k], _mm256_mul_pd(a[k][3], w));
+        }
+        for (size_t k = 0; k < 4; ++k) {
+            _mm256_storeu_pd(r[k] + i, s[k]);
+        }
+    }
+    for (; i < n; ++i) {
+        const double x = vx[i];
+        const double y = vy[i];
+        const double z = vz[i];
+        const double w = vw[i];
+        rx[i] = m(0,0) * x + m(0,1) * y + m(0,2) * z + m(0,3) * w;
+        ry[i] = m(1,0) * x + m(1,1) * y + m(1,2) * z + m(1,3) * w;
+        rz[i] = m(2,0) * x + m(2,1) * y + m(2,2) * z + m(2,3) * w;
+        rw[i] = m(3,0) * x + m(3,1) * y + m(3,2) * z + m(3,3) * w;
+    }
+}
+
+/** ---------------------------------------------------------------------------
+ * product
+ * @brief Compute the Hamilton products r = a b of n pairs of quaternions.
+ */
+simd_kernel_
+void product(
+    const size_t n,
+    const double *ax, const double *ay, const double *az, const double *aw,
+    const double *bx, const double *by, const double *bz, const double *bw,
+    double *rx, double *ry, double *rz, double *rw)
+{
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        const __m256d a_x = _mm256_loadu_pd(ax + i);
+        const __m256d a_y = _mm256_loadu_pd(ay + i);
+        const __m256d a_z = _mm256_loadu_pd(az + i);
+        const __m256d a_w = _mm256_loadu_pd(aw + i);
+        const __m256d b_x = _mm256_loadu_pd(bx + i);
+        const __m256d b_y = _mm256_loadu_pd(by + i);
+        const __m256d b_z = _mm256_loadu_pd(bz + i);
+        const __m256d b_w = _mm256_loadu_pd(bw + i);
+        _mm256_storeu_pd(rx + i, simd256_fmadd_(a_w, b_x, simd256_fmadd_(
+            a_x, b_w, simd256_fmsub_(a_y, b_z, _mm256_mul_pd(a_z, b_y)))));
+        _mm256_storeu_pd(ry + i, simd256_fmadd_(a_w, b_y, simd256_fmadd_(
+            a_y, b_w, simd256_fmsub_(a_z, b_x, _mm256_mul_pd(a_x, b_z)))));
+        _mm256_storeu_pd(rz + i, simd256_fmadd_(a_w, b_z, simd256_fmadd_(
+            a_z, b_w, simd256_fmsub_(a_x, b_y, _mm256_mul_pd(a_y, b_x)))));
+        _mm256_storeu_pd(rw + i, simd256_fnmadd_(a_z, b_z, simd256_fnmadd_(
+            a_y, b_y, simd256_fnmadd_(a_x, b_x, _mm256_mul_pd(a_w, b_w)))));
+    }
+    for (; i < n; ++i) {
+        const double x = aw[i] * bx[i] + ax[i] * bw[i] +
+                         ay[i] * bz[i] - az[i] * by[i];
+        const double y = aw[i] * by[i] - ax[i] * bz[i] +
+                         ay[i] * bw[i] + az[i] * bx[i];
+        const double z = aw[i] * bz[i] + ax[i] * by[i] -
+                         ay[i] * bx[i] + az[i] * bw[i];
+        const double w = aw[i] * bw[i] - ax[i] * bx[i] -
+                         ay[i] * by[i] - az[i] * bz[i];
+        rx[i] = x;
+        ry[i] = y;
+        rz[i] = z;
+        rw[i] = w;
+    }
+}
+
+/**
+ * rotate
+ * @brief Rotate n vectors v by n unit quaternions q, with t = 2 u x v and
+ * r = v + w t + u x t.
+ */
+simd_kernel_
+void rotate(
+    const size_t n,
+    const double *qx, const double *qy, const double *qz, const double *qw,
+    const double *vx, const double *vy, const double *vz,
+    double *rx, double *ry, double *rz)
+{
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        const __m256d q_x = _mm256_loadu_pd(qx + i);
+        const __m256d q_y = _mm256_loadu_pd(qy + i);
+        const __m256d q_z = _mm256_loadu_pd(qz + i);
+        const __m256d q_w = _mm256_loadu_pd(qw + i);
+        const __m256d v_x = _mm256_loadu_pd(vx + i);
+        const __m256d v_y = _mm256_loadu_pd(vy + i);
+        const __m256d v_z = _mm256_loadu_pd(vz + i);
+        __m256d t_x = simd256_fmsub_(q_y, v_z, _mm256_mul_pd(q_z, v_y));
+        __m256d t_y = simd256_fmsub_(q_z, v_x, _mm256_mul_pd(q_x, v_z));
+        __m256d t_z = simd256_fmsub_(q_x, v_y, _mm256_mul_pd(q_y, v_x));
+        t_x = _mm256_add_pd(t_x, t_x);
+        t_y = _mm256_add_pd(t_y, t_y);
+        t_z = _mm256_add_pd(t_z, t_z);
+        _mm256_storeu_pd(rx + i, _mm256_add_pd(v_x, simd256_fmadd_(
+            q_w, t_x, simd256_fmsub_(q_y, t_z, _mm256_mul_pd(q_z, t_y)))));
+        _mm256_storeu_pd(ry + i, _mm256_add_pd(v_y, simd256_fmadd_(
+            q_w, t_y, simd256_fmsub_(q_z, t_x, _mm256_mul_pd(q_x, t_z)))));
+        _mm256_storeu_pd(rz + i, _mm256_add_pd(v_z, simd256_fmadd_(
+            q_w, t_z, simd256_fmsub_(q_x, t_y, _mm256_mul_pd(q_y, t_x)))));
+    }
+    for (; i < n; ++i) {
+        const double tx = 2.0 * (qy[i] * vz[i] - qz[i] * vy[i]);
+        const double ty = 2.0 * (qz[i] * vx[i] - qx[i] * vz[i]);
+        const double tz = 2.0 * (qx[i] * vy[i] - qy[i] * vx[i]);
+        const double x = vx[i] + qw[i] * tx + (qy[i] * tz - qz[i] * ty);
+        const double y = vy[i] + qw[i] * ty + (qz[i] * tx - qx[i] * tz);
+        const double z = vz[i] + qw[i] * tz + (qx[i] * ty - qy[i] * tx);
+        rx[i] = x;
+        ry[i] = y;
+        rz[i] = z;
+    }
+}
+
+#else
+/** ---------------------------------------------------------------------------
+ * @brief With AVX-512, double precision batch operations process eight
+ * vectors per instruction. The last n % 8 vectors are processed in one more
+ * pass with masked loads and stores, so there is no scalar remainder loop.
+ */
+
+/**
+ * dot
+ * @brief Compute the dot products r = a.b of n pairs of vectors.
+ */
+simd_kernel_
+void dot(
+    const size_t n,
+    const double *ax, const double *ay, const double *az,
+    const double *bx, const double *by, const double *bz,
+    double *r)
+{
+    for (size_t i = 0; i < n; i += 8) {
+        const __mmask8 m = simd512_mask_(n - i);
+        __m512d d = _mm512_mul_pd(
+            _mm512_maskz_loadu_pd(m, ax + i), _mm512_maskz_loadu_pd(m, bx + i));
+        d = _mm512_fmadd_pd(
+            _mm512_maskz_loadu_pd(m, ay + i),
+            _mm512_maskz_loadu_pd(m, by + i), d);
+        d = _mm512_fmadd_pd(
+            _mm512_maskz_loadu_pd(m, az + i),
+            _mm512_maskz_loadu_pd(m, bz + i), d);
+        _mm512_mask_storeu_pd(r + i, m, d);
+    }
+}
+
+simd_kernel_
+void dot(
+    const size_t n,
+    const double *ax, const double *ay, const double *az, const double *aw,
+    const double *bx, const double *by, const double *bz, const double *bw,
+    double *r)
+{
+    for (size_t i = 0; i < n; i += 8) {
+        const __mmask8 m = simd512_mask_(n - i);
+        __m512d d = _mm512_mul_pd(
+            _mm512_maskz_loadu_pd(m, ax + i), _mm512_maskz_loadu_pd(m, bx + i));
+        d = _mm512_fmadd_pd(
+            _mm512_maskz_loadu_pd(m, ay + i),
+            _mm512_maskz_loadu_pd(m, by + i), d);
+        d = _mm512_fmadd_pd(
+            _mm512_maskz_loadu_pd(m, az + i),
+            _mm512_maskz_loadu_pd(m, bz + i), d);
+        d = _mm512_fmadd_pd(
+            _mm512_maskz_loadu_pd(m, aw + i),
+            _mm512_maskz_loadu_pd(m, bw + i), d);
+        _mm512_mask_storeu_pd(r + i, m, d);
+    }
+}
+
+/**
+ * cross
+ * @brief Compute the cross products r = a x b of n pairs of vectors.
+ */
+simd_kernel_
+void cross(
+    const size_t n,
+    const double *ax, const double *ay, const double *az,
+    const double *bx, const double *by, const double *bz,
+    double *rx, double *ry, double *rz)
+{
+    for (size_t i = 0; i < n; i += 8) {
+        const __mmask8 m = simd512_mask_(n - i);
+        const __m512d a_x = _mm512_maskz_loadu_pd(m, ax + i);
+        const __m512d a_y = _mm512_maskz_loadu_pd(m, ay + i);
+        const __m512d a_z = _mm512_maskz_loadu_pd(m, az + i);
+        const __m512d b_x = _mm512_maskz_loadu_pd(m, bx + i);
+        const __m512d b_y = _mm512_maskz_loadu_pd(m, by + i);
+        const __m512d b_z = _mm512_maskz_loadu_pd(m, bz + i);
+        _mm512_mask_storeu_pd(rx + i, m, _mm512_fmsub_pd(
+            a_y, b_z, _mm512_mul_pd(a_z, b_y)));
+        _mm512_mask_storeu_pd(ry + i, m, _mm512_fmsub_pd(
+            a_z, b_x, _mm512_mul_pd(a_x, b_z)));
+        _mm512_mask_storeu_pd(rz + i, m, _mm512_fmsub_pd(
+            a_x, b_y, _mm512_mul_pd(a_y, b_x)));
+    }
+}
+
+/**
+ * norm
+ * @brief Compute the norms r = |a| of n vectors.
+ */
+simd_kernel_
+void norm(
+    const size_t n,
+    const double *ax, const double *ay, const double *az,
+    double *r)
+{
+    for (size_t i = 0; i < n; i += 8) {
+        const __mmask8 m = simd512_mask_(n - i);
+        const __m512d a_x = _mm512_maskz_loadu_pd(m, ax + i);
+        const __m512d a_y = _mm512_maskz_loadu_pd(m, ay + i);
+        const __m512d a_z = _mm512_maskz_loadu_pd(m, az + i);
+        __m512d d = _mm512_mul_pd(a_x, a_x);
+        d = _mm512_fmadd_pd(a_y, a_y, d);
+        d = _mm512_fmadd_pd(a_z, a_z, d);
+        _mm512_mask_storeu_pd(r + i, m, _mm512_maskz_sqrt_pd(m, d));
+    }
+}
+
+simd_kernel_
+void norm(
+    const size_t n,
+    const double *ax, const double *ay, const double *az, const double *aw,
+    double *r)
+{
+    for (size_t i = 0; i < n; i += 8) {
+        const __mmask8 m = simd512_mask_(n - i);
+        const __m512d a_x = _mm512_maskz_loadu_pd(m, ax + i);
+        const __m512d a_y = _mm512_maskz_loadu_pd(m, ay + i);
+        const __m512d a_z = _mm512_maskz_loadu_pd(m, az + i);
+        const __m512d a_w = _mm512_maskz_loadu_pd(m, aw + i);
+        __m512d d = _mm512_mul_pd(a_x, a_x);
+        d = _mm512_fmadd_pd(a_y, a_y, d);
+        d = _mm512_fmadd_pd(a_z, a_z, d);
+        d = _mm512_fmadd_pd(a_w, a_w, d);
+        _mm512_mask_storeu_pd(r + i, m, _mm512_maskz_sqrt_pd(m, d));
+    }
+}
+
+/**
+ * normalize
+ * @brief Compute the normalized vectors r = a / |a| of n vectors. The
+ * inverse norm is the rsqrt14 estimate refined by Newton-Raphson steps,
+ * instead of a square root and a division.
+ */
+simd_kernel_
+void normalize(
+    const size_t n,
+    const double *ax, const double *ay, const double *az,
+    double *rx, double *ry, double *rz)
+{
+    for (size_t i = 0; i < n; i += 8) {
+        const __mmask8 m = simd512_mask_(n - i);
+        const __m512d a_x = _mm512_maskz_loadu_pd(m, ax + i);
+        const __m512d a_y = _mm512_maskz_loadu_pd(m, ay + i);
+        const __m512d a_z = _mm512_maskz_loadu_pd(m, az + i);
+        __m512d d = _mm512_mul_pd(a_x, a_x);
+        d = _mm512_fmadd_pd(a_y, a_y, d);
+        d = _mm512_fmadd_pd(a_z, a_z, d);
+        const __m512d inv = simd512_rsqrt_(m, d);
+        _mm512_mask_storeu_pd(rx + i, m, _mm512_mul_pd(a_x, inv));
+        _mm512_mask_storeu_pd(ry + i, m, _mm512_mul_pd(a_y, inv));
+        _mm512_mask_storeu_pd(rz + i, m, _mm512_mul_pd(a_z, inv));
+    }
+}
+
+simd_kernel_
+void normalize(
+    const size_t n,
+    const double *ax, const double *ay, const double *az, const double *aw,
+    double *rx, double *ry, double *rz, double *rw)
+{
+    for (size_t i = 0; i < n; i += 8) {
+        const __mmask8 m = simd512_mask_(n - i);
+        const __m512d a_x = _mm512_maskz_loadu_pd(m, ax + i);
+        const __m512d a_y = _mm512_maskz_loadu_pd(m, ay + i);
+        const __m512d a_z = _mm512_maskz_loadu_pd(m, az + i);
+        const __m512d a_w = _mm512_maskz_loadu_pd(m, aw + i);
+        __m512d d = _mm512_mul_pd(a_x, a_x);
+        d = _mm512_fmadd_pd(a_y, a_y, d);
+        d = _mm512_fmadd_pd(a_z, a_z, d);
+        d = _mm512_fmadd_pd(a_w, a_w, d);
+        const __m512d inv = simd512_rsqrt_(m, d);
+        _mm512_mask_storeu_pd(rx + i, m, _mm512_mul_pd(a_x, inv));
+        _mm512_mask_storeu_pd(ry + i, m, _mm512_mul_pd(a_y, inv));
+        _mm512_mask_storeu_pd(rz + i, m, _mm512_mul_pd(a_z, inv));
+        _mm512_mask_storeu_pd(rw + i, m, _mm512_mul_pd(a_w, inv));
+    }
+}
+
+/**
+ * distance
+ * @brief Compute the distances r = |a - b| between n pairs of points.
+ */
+simd_kernel_
+void distance(
+    const size_t n,
+    const double *ax, const double *ay, const double *az,
+    const double *bx, const double *by, const double *bz,
+    double *r)
+{
+    for (size_t i = 0; i < n; i += 8) {
+        const __mmask8 m = simd512_mask_(n - i);
+        const __m512d d_x = _mm512_sub_pd(
+            _mm512_maskz_loadu_pd(m, ax + i), _mm512_maskz_loadu_pd(m, bx + i));
+        const __m512d d_y = _mm512_sub_pd(
+            _mm512_maskz_loadu_pd(m, ay + i), _mm512_maskz_loadu_pd(m, by + i));
+        const __m512d d_z = _mm512_sub_pd(
+            _mm512_maskz_loadu_pd(m, az + i), _mm512_maskz_loadu_pd(m, bz + i));
+        __m512d d = _mm512_mul_pd(d_x, d_x);
+        d = _mm512_fmadd_pd(d_y, d_y, d);
+        d = _mm512_fmadd_pd(d_z, d_z, d);
+        _mm512_mask_storeu_pd(r + i, m, _mm512_maskz_sqrt_pd(m, d));
+    }
+}
+
+simd_kernel_
+void distance(
+    const size_t n,
+    const double *ax, const double *ay, const double *az, const double *aw,
+    const double *bx, const double *by, const double *bz, const double *bw,
+    double *r)
+{
+    for (size_t i = 0; i < n; i += 8) {
+        const __mmask8 m = simd512_mask_(n - i);
+        const __m512d d_x = _mm512_sub_pd(
+            _mm512_maskz_loadu_pd(m, ax + i), _mm512_maskz_loadu_pd(m, bx + i));
+        const __m512d d_y = _mm512_sub_pd(
+            _mm512_maskz_loadu_pd(m, ay + i), _mm512_maskz_loadu_pd(m, by + i));
+        const __m512d d_z = _mm512_sub_pd(
+            _mm512_maskz_loadu_pd(m, az + i), _mm512_maskz_loadu_pd(m, bz + i));
+        const __m512d d_w = _mm512_sub_pd(
+            _mm512_maskz_loadu_pd(m, aw + i), _mm512_maskz_loadu_pd(m, bw + i));
+        __m512d d = _mm512_mul_pd(d_x, d_x);
+        d = _mm512_fmadd_pd(d_y, d_y, d);
+        d = _mm512_fmadd_pd(d_z, d_z, d);
+        d = _mm512_fmadd_pd(d_w, d_w, d);
+        _mm512_mask_storeu_pd(r + i, m, _mm512_maskz_sqrt_pd(m, d));
+    }
+}
+
+/** ---------------------------------------------------------------------------
+ * dot
+ * @brief Compute the products r = m v of a matrix with n vectors. The
+ * matrix elements are broadcast once and each row is a sum of fused
+ * multiply-adds with the component registers.
+ */
+simd_kernel_
+void dot(
+    const size_t n,
+    const mat3<double> &m,
+    const double *vx, const double *vy, const double *vz,
+    double *rx, double *ry, double *rz)
+{
+    __m512d a[3][3];
+    for (size_t k = 0; k < 3; ++k) {
+        for (size_t j = 0; j < 3; ++j) {
+            a[k][j] = _mm512_set1_pd(m(k,j));
+        }
+    }
+
+    double *r[3] = {rx, ry, rz};
+    for (size_t i = 0; i < n; i += 8) {
+        const __mmask8 mask = simd512_mask_(n - i);
+        const __m512d x = _mm512_maskz_loadu_pd(mask, vx + i);
+        const __m512d y = _mm512_maskz_loadu_pd(mask, vy + i);
+        const __m512d z = _mm512_maskz_loadu_pd(mask, vz + i);
+        __m512d s[3];
+        for (size_t k = 0; k < 3; ++k) {
+            s[k] = _mm512_mul_pd(a[k][0], x);
+            s[k] = _mm512_fmadd_pd(a[k][1], y, s[k]);
+            s[k] = _mm512_fmadd_pd(a[k][2], z, s[k]);
+        }
+        for (size_t k = 0; k < 3; ++k) {
+            _mm512_mask_storeu_pd(r[k] + i, mask, s[k]);
+        }
+    }
+}
+
+simd_kernel_
+void dot(
+    const size_t n,
+    const mat4<double> &m,
+    const double *vx, const double *vy, const double *vz, const double *vw,
+    double *rx, double *ry, double *rz, double *rw)
+{
+    __m512d a[4][4];
+    for (size_t k = 0; k < 4; ++k) {
+        for (size_t j = 0; j < 4; ++j) {
+            a[k][j] = _mm512_set1_pd(m(k,j));
+        }
+    }
+
+    double *r[4] = {rx, ry, rz, rw};
+    for (size_t i = 0; i < n; i += 8) {
+        const __mmask8 mask = simd512_mask_(n - i);
+        const __m512d x = _mm512_maskz_loadu_pd(mask, vx + i);
+        const __m512d y = _mm512_maskz_loadu_pd(mask, vy + i);
+        const __m512d z = _mm512_maskz_loadu_pd(mask, vz + i);
+        const __m512d w = _mm512_maskz_loadu_pd(mask, vw + i);
+        __m512d s[4];
+        for (size_t k = 0; k < 4; ++k) {
+            s[k] = _mm512_mul_pd(a[k][0], x);
+            s[k] = _mm512_fmadd_pd(a[k][1], y, s[k]);
+            s[k] = _mm512_fmadd_pd(a[k][2], z, s[k]);
+            s[k] = _mm512_fmadd_pd(a[k][3], w, s[k]);
+        }
+        for (size_t k = 0; k < 4; ++k) {
+            _mm512_mask_storeu_pd(r[k] + i, mask, s[k]);
+        }
+    }
+}
+
+/** ---------------------------------------------------------------------------
+ * product
+ * @brief Compute the Hamilton products r = a b of n pairs of quaternions.
+ */
+simd_kernel_
+void product(
+    const size_t n,
+    const double *ax, const double *ay, const double *az, const double *aw,
+    const double *bx, const double *by, const double *bz, const double *bw,
+    double *rx, double *ry, double *rz, double *rw)
+{
+    for (size_t i = 0; i < n; i += 8) {
+        const __mmask8 m = simd512_mask_(n - i);
+        const __m512d a_x = _mm512_maskz_loadu_pd(m, ax + i);
+        const __m512d a_y = _mm512_maskz_loadu_pd(m, ay + i);
+        const __m512d a_z = _mm512_maskz_loadu_pd(m, az + i);
+        const __m512d a_w = _mm512_maskz_loadu_pd(m, aw + i);
+        const __m512d b_x = _mm512_maskz_loadu_pd(m, bx + i);
+        const __m512d b_y = _mm512_maskz_loadu_pd(m, by + i);
+        const __m512d b_z = _mm512_maskz_loadu_pd(m, bz + i);
+        const __m512d b_w = _mm512_maskz_loadu_pd(m, bw + i);
+        _mm512_mask_storeu_pd(rx + i, m, _mm512_fmadd_pd(a_w, b_x,
+            _mm512_fmadd_pd(a_x, b_w,
+                _mm512_fmsub_pd(a_y, b_z, _mm512_mul_pd(a_z, b_y)))));
+        _mm512_mask_storeu_pd(ry + i, m, _mm512_fmadd_pd(a_w, b_y,
+            _mm512_fmadd_pd(a_y, b_w,
+                _mm512_fmsub_pd(a_z, b_x, _mm512_mul_pd(a_x, b_z)))));
+        _mm512_mask_storeu_pd(rz + i, m, _mm512_fmadd_pd(a_w, b_z,
+            _mm512_fmadd_pd(a_z, b_w,
+                _mm512_fmsub_pd(a_x, b_y, _mm512_mul_pd(a_y, b_x)))));
+        _mm512_mask_storeu_pd(rw + i, m, _mm512_fnmadd_pd(a_z, b_z,
+            _mm512_fnmadd_pd(a_y, b_y,
+                _mm512_fnmadd_pd(a_x, b_x, _mm512_mul_pd(a_w, b_w)))));
+    }
+}
+
+/**
+ * rotate
+ * @brief Rotate n vectors v by n unit quaternions q, with t = 2 u x v and
+ * r = v + w t + u x t.
+ */
+simd_kernel_
+void rotate(
+    const size_t n,
+    const double *qx, const double *qy, const double *qz, const double *qw,
+    const double *vx, const double *vy, const double *vz,
+    double *rx, double *ry, double *rz)
+{
+    for (size_t i = 0; i < n; i += 8) {
+        const __mmask8 m = simd512_mask_(n - i);
+        const __m512d q_x = _mm512_maskz_loadu_pd(m, qx + i);
+        const __m512d q_y = _mm512_maskz_loadu_pd(m, qy + i);
+        const __m512d q_z = _mm512_maskz_loadu_pd(m, qz + i);
+        const __m512d q_w = _mm512_maskz_loadu_pd(m, qw + i);
+        const __m512d v_x = _mm512_maskz_loadu_pd(m, vx + i);
+        const __m512d v_y = _mm512_maskz_loadu_pd(m, vy + i);
+        const __m512d v_z = _mm512_maskz_loadu_pd(m, vz + i);
+        __m512d t_x = _mm512_fmsub_pd(q_y, v_z, _mm512_mul_pd(q_z, v_y));
+        __m512d t_y = _mm512_fmsub_pd(q_z, v_x, _mm512_mul_pd(q_x, v_z));
+        __m512d t_z = _mm512_fmsub_pd(q_x, v_y, _mm512_mul_pd(q_y, v_x));
+        t_x = _mm512_add_pd(t_x, t_x);
+        t_y = _mm512_add_pd(t_y, t_y);
+        t_z = _mm512_add_pd(t_z, t_z);
+        _mm512_mask_storeu_pd(rx + i, m, _mm512_add_pd(v_x,
+            _mm512_fmadd_pd(q_w, t_x,
+                _mm512_fmsub_pd(q_y, t_z, _mm512_mul_pd(q_z, t_y)))));
+        _mm512_mask_storeu_pd(ry + i, m, _mm512_add_pd(v_y,
+            _mm512_fmadd_pd(q_w, t_y,
+                _mm512_fmsub_pd(q_z, t_x, _mm512_mul_pd(q_x, t_z)))));
+        _mm512_mask_storeu_pd(rz + i, m, _mm512_add_pd(v_z,
+            _mm512_fmadd_pd(q_w, t_z,
+                _mm512_fmsub_pd(q_x, t_y, _mm512_mul_pd(q_y, t_x)))));
+    }
+}
+#endif  /* ATTO_MATH_SIMD512 */
+
+/** ---------------------------------------------------------------------------
+ * @brief Single precision batch operations process eight vectors per
+ * instruction. The remaining n % 8 vectors are processed one at a time.
+ */
+
+/**
+ * dot
+ * @brief Compute the dot products r = a.b of n pairs of vectors.
+ */
+simd_kernel_
+void dot(
+    const size_t n,
+    const float *ax, const float *ay, const float *az,
+    const float *bx, const float *by, const float *bz,
+    float *r)
+{
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256 d = _mm256_mul_ps(
+            _mm256_loadu_ps(ax + i), _mm256_loadu_ps(bx + i));
+        d = _mm256_add_ps(d, _mm256_mul_ps(
+            _mm256_loadu_ps(ay + i), _mm256_loadu_ps(by + i)));
+        d = _mm256_add_ps(d, _mm256_mul_ps(
+            _mm256_loadu_ps(az + i), _mm256_loadu_ps(bz + i)));
+        _mm256_storeu_ps(r + i, d);
+    }
+    for (; i < n; ++i) {
+        r[i] = ax[i] * bx[i] + ay[i] * by[i] + az[i] * bz[i];
+    }
+}
+
+simd_kernel_
+void dot(
+    const size_t n,
+    const float *ax, const float *ay, const float *az, const float *aw,
+    const float *bx, const float *by, const float *bz, const float *bw,
+    float *r)
+{
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256 d = _mm256_mul_ps(
+            _mm256_loadu_ps(ax + i), _mm256_loadu_ps(bx + i));
+        d = _mm256_add_ps(d, _mm256_mul_ps(
+            _mm256_loadu_ps(ay + i), _mm256_loadu_ps(by + i)));
+        d = _mm256_add_ps(d, _mm256_mul_ps(
+            _mm256_loadu_ps(az + i), _mm256_loadu_ps(bz + i)));
+        d = _mm256_add_ps(d, _mm256_mul_ps(
+            _mm256_loadu_ps(aw + i), _mm256_loadu_ps(bw + i)));
+        _mm256_storeu_ps(r + i, d);
+    }
+    for (; i < n; ++i) {
+        r[i] = ax[i] * bx[i] + ay[i] * by[i] + az[i] * bz[i] + aw[i] * bw[i];
+    }
+}
+
+/**
+ * cross
+ * @brief Compute the cross products r = a x b of n pairs of vectors.
+ */
+simd_kernel_
+void cross(
+    const size_t n,
+    const float *ax, const float *ay, const float *az,
+    const float *bx, const float *by, const float *bz,
+    float *rx, float *ry, float *rz)
+{
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        const __m256 a_x = _mm256_loadu_ps(ax + i);
+        const __m256 a_y = _mm256_loadu_ps(ay + i);
+        const __m256 a_z = _mm256_loadu_ps(az + i);
+        const __m256 b_x = _mm256_loadu_ps(bx + i);
+        const __m256 b_y = _mm256_loadu_ps(by + i);
+        const __m256 b_z = _mm256_loadu_ps(bz + i);
+        _mm256_storeu_ps(rx + i, _mm256_sub_ps(
+            _mm256_mul_ps(a_y, b_z), _mm256_mul_ps(a_z, b_y)));
+        _mm256_storeu_ps(ry + i, _mm256_sub_ps(
+            _mm256_mul_ps(a_z, b_x), _mm256_mul_ps(a_x, b_z)));
+        _mm256_storeu_ps(rz + i, _mm256_sub_ps(
+            _mm256_mul_ps(a_x, b_y), _mm256_mul_ps(a_y, b_x)));
+    }
+    for (; i < n; ++i) {
+        const float x = ay[i] * bz[i] - az[i] * by[i];
+        const float y = az[i] * bx[i] - ax[i] * bz[i];
+        const float z = ax[i] * by[i] - ay[i] * bx[i];
+        rx[i] = x;
+        ry[i] = y;
+        rz[i] = z;
+    }
+}
+
+/**
+ * norm
+ * @brief Compute the norms r = |a| of n vectors.
+ */
+simd_kernel_
+void norm(
+    const size_t n,
+    const float *ax, const float *ay, const float *az,
+    float *r)
+{
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        const __m256 a_x = _mm256_loadu_ps(ax + i);
+        const __m256 a_y = _mm256_loadu_ps(ay + i);
+        const __m256 a_z = _mm256_loadu_ps(az + i);
+        __m256 d = _mm256_mul_ps(a_x, a_x);
+        d = _mm256_add_ps(d, _mm256_mul_ps(a_y, a_y));
+        d = _mm256_add_ps(d, _mm256_mul_ps(a_z, a_z));
+        _mm256_storeu_ps(r + i, _mm256_sqrt_ps(d));
+    }
+    for (; i < n; ++i) {
+        r[i] = std::sqrt(ax[i] * ax[i] + ay[i] * ay[i] + az[i] * az[i]);
+    }
+}
+
+simd_kernel_
+void norm(
+    const size_t n,
+    const float *ax, const float *ay, const float *az, const float *aw,
+    float *r)
+{
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        const __m256 a_x = _mm256_loadu_ps(ax + i);
+        const __m256 a_y = _mm256_loadu_ps(ay + i);
+        const __m256 a_z = _mm256_loadu_ps(az + i);
+        const __m256 a_w = _mm256_loadu_ps(aw + i);
+        __m256 d = _mm256_mul_ps(a_x, a_x);
+        d = _mm256_add_ps(d, _mm256_mul_ps(a_y, a_y));
+        d = _mm256_add_ps(d, _mm256_mul_ps(a_z, a_z));
+        d = _mm256_add_ps(d, _mm256_mul_ps(a_w, a_w));
+        _mm256_storeu_ps(r + i, _mm256_sqrt_ps(d));
+    }
+    for (; i < n; ++i) {
+        r[i] = std::sqrt(
+            ax[i] * ax[i] + ay[i] * ay[i] + az[i] * az[i] + aw[i] * aw[i]);
+    }
+}
+
+/**
+ * normalize
+ * @brief Compute the normalized vectors r = a / |a| of n vectors.
+ */
+simd_kernel_
+void normalize(
+    const size_t n,
+    const float *ax, const float *ay, const float *az,
+    float *rx, float *ry, float *rz)
+{
+    const __m256 one = _mm256_set1_ps(1.0f);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        const __m256 a_x = _mm256_loadu_ps(ax + i);
+        const __m256 a_y = _mm256_loadu_ps(ay + i);
+        const __m256 a_z = _mm256_loadu_ps(az + i);
+        __m256 d = _mm256_mul_ps(a_x, a_x);
+        d = _mm256_add_ps(d, _mm256_mul_ps(a_y, a_y));
+        d = _mm256_add_ps(d, _mm256_mul_ps(a_z, a_z));
+        const __m256 inv = _mm256_div_ps(one, _mm256_sqrt_ps(d));
+        _mm256_storeu_ps(rx + i, _mm256_mul_ps(a_x, inv));
+        _mm256_storeu_ps(ry + i, _mm256_mul_ps(a_y, inv));
+        _mm256_storeu_ps(rz + i, _mm256_mul_ps(a_z, inv));
+    }
+    for (; i < n; ++i) {
+        const float inv = 1.0f / std::sqrt(
+            ax[i] * ax[i] + ay[i] * ay[i] + az[i] * az[i]);
+        rx[i] = ax[i] * inv;
+        ry[i] = ay[i] * inv;
+        rz[i] = az[i] * inv;
+    }
+}
+
+simd_kernel_
+void normalize(
+    const size_t n,
+    const float *ax, const float *ay, const float *az, const float *aw,
+    float *rx, float *ry, float *rz, float *rw)
+{
+    const __m256 one = _mm256_set1_ps(1.0f);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        const __m256 a_x = _mm256_loadu_ps(ax + i);
+        const __m256 a_y = _mm256_loadu_ps(ay + i);
+        const __m256 a_z = _mm256_loadu_ps(az + i);
+        const __m256 a_w = _mm256_loadu_ps(aw + i);
+        __m256 d = _mm256_mul_ps(a_x, a_x);
+        d = _mm256_add_ps(d, _mm256_mul_ps(a_y, a_y));
+        d = _mm256_add_ps(d, _mm256_mul_ps(a_z, a_z));
+        d = _mm256_add_ps(d, _mm256_mul_ps(a_w, a_w));
+        const __m256 inv = _mm256_div_ps(one, _mm256_sqrt_ps(d));
+        _mm256_storeu_ps(rx + i, _mm256_mul_ps(a_x, inv));
+        _mm256_storeu_ps(ry + i, _mm256_mul_ps(a_y, inv));
+        _mm256_storeu_ps(rz + i, _mm256_mul_ps(a_z, inv));
+        _mm256_storeu_ps(rw + i, _mm256_mul_ps(a_w, inv));
+    }
+    for (; i < n; ++i) {
+        const float inv = 1.0f / std::sqrt(
+            ax[i] * ax[i] + ay[i] * ay[i] + az[i] * az[i] + aw[i] * aw[i]);
+        rx[i] = ax[i] * inv;
+        ry[i] = ay[i] * inv;
+        rz[i] = az[i] * inv;
+        rw[i] = aw[i] * inv;
+    }
+}
+
+/**
+ * distance
+ * @brief Compute the distances r = |a - b| between n pairs of points.
+ */
+simd_kernel_
+void distance(
+    const size_t n,
+    const float *ax, const float *ay, const float *az,
+    const float *bx, const float *by, const float *bz,
+    float *r)
+{
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        const __m256 d_x = _mm256_sub_ps(
+            _mm256_loadu_ps(ax + i), _mm256_loadu_ps(bx + i));
+        const __m256 d_y = _mm256_sub_ps(
+            _mm256_loadu_ps(ay + i), _mm256_loadu_ps(by + i));
+        const __m256 d_z = _mm256_sub_ps(
+            _mm256_loadu_ps(az + i), _mm256_loadu_ps(bz + i));
+        __m256 d = _mm256_mul_ps(d_x, d_x);
+        d = _mm256_add_ps(d, _mm256_mul_ps(d_y, d_y));
+        d = _mm256_add_ps(d, _mm256_mul_ps(d_z, d_z));
+        _mm256_storeu_ps(r + i, _mm256_sqrt_ps(d));
+    }
+    for (; i < n; ++i) {
+        const float dx = ax[i] - bx[i];
+        const float dy = ay[i] - by[i];
+        const float dz = az[i] - bz[i];
+        r[i] = std::sqrt(dx * dx + dy * dy + dz * dz);
+    }
+}
+
+simd_kernel_
+void distance(
+    const size_t n,
+    const float *ax, const float *ay, const float *az, const float *aw,
+    const float *bx, const float *by, const float *bz, const float *bw,
+    float *r)
+{
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        const __m256 d_x = _mm256_sub_ps(
+            _mm256_loadu_ps(ax + i), _mm256_loadu_ps(bx + i));
+        const __m256 d_y = _mm256_sub_ps(
+            _mm256_loadu_ps(ay + i), _mm256_loadu_ps(by + i));
+        const __m256 d_z = _mm256_sub_ps(
+            _mm256_loadu_ps(az + i), _mm256_loadu_ps(bz + i));
+        const __m256 d_w = _mm256_sub_ps(
+            _mm256_loadu_ps(aw + i), _mm256_loadu_ps(bw + i));
+        __m256 d = _mm256_mul_ps(d_x, d_x);
+        d = _mm256_add_ps(d, _mm256_mul_ps(d_y, d_y));
+        d = _mm256_add_ps(d, _mm256_mul_ps(d_z, d_z));
+        d = _mm256_add_ps(d, _mm256_mul_ps(d_w, d_w));
+        _mm256_storeu_ps(r + i, _mm256_sqrt_ps(d));
+    }
+    for (; i < n; ++i) {
+        const float dx = ax[i] - bx[i];
+        const float dy = ay[i] - by[i];
+        const float dz = az[i] - bz[i];
+        const float dw = aw[i] - bw[i];
+        r[i] = std::sqrt(dx * dx + dy * dy + dz * dz + dw * dw);
+    }
+}
+
+/** ---------------------------------------------------------------------------
+ * dot
+ * @brief Compute the products r = m v of a matrix with n vectors. The
+ * matrix elements are broadcast once and each row is a sum of products
+ * with the component registers.
+ */
+simd_kernel_
+void dot(
+    const size_t n,
+    const mat3<float> &m,
+    const float *vx, const float *vy, const float *vz,
+    float *rx, float *ry, float *rz)
+{
+    __m256 a[3][3];
+    for (size_t k = 0; k < 3; ++k) {
+        for (size_t j = 0; j < 3; ++j) {
+            a[k][j] = _mm256_set1_ps(m(k,j));
+        }
+    }
+
+    float *r[3] = {rx, ry, rz};
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        const __m256 x = _mm256_loadu_ps(vx + i);
+        const __m256 y = _mm256_loadu_ps(vy + i);
+        const __m256 z = _mm256_loadu_ps(vz + i);
+        __m256 s[3];
+        for (size_t k = 0; k < 3; ++k) {
+            s[k] = _mm256_mul_ps(a[k][0], x);
+            s[k] = _mm256_add_ps(s[k], _mm256_mul_ps(a[k][1], y));
+            s[k] = _mm256_add_ps(s[k], _mm256_mul_ps(a[k][2], z));
+        }
+        for (size_t k = 0; k < 3; ++k) {
+            _mm256_storeu_ps(r[k] + i, s[k]);
+        }
+    }
+    for (; i < n; ++i) {
+        const float x = vx[i];
+        const float y = vy[i];
+        const float z = vz[i];
+        rx[i] = m(0,0) * x + m(0,1) * y + m(0,2) * z;
+        ry[i] = m(1,0) * x + m(1,1) * y + m(1,2) * z;
+        rz[i] = m(2,0) * x + m(2,1) * y + m(2,2) * z;
+    }
+}
+
+simd_kernel_
+void dot(
+    const size_t n,
+    const mat4<float> &m,
+    const float *vx, const float *vy, const float *vz, const float *vw,
+    float *rx, float *ry, float *rz, float *rw)
+{
+    __m256 a[4][4];
+    for (size_t k = 0; k < 4; ++k) {
+        for (size_t j = 0; j < 4; ++j) {
+            a[k][j] = _mm256_set1_ps(m(k,j));
+        }
+    }
+
+    float *r[4] = {rx, ry, rz, rw};
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        const __m256 x = _mm256_loadu_ps(vx + i);
+        const __m256 y = _mm256_loadu_ps(vy + i);
+        const __m256 z = _mm256_loadu_ps(vz + i);
+        const __m256 w = _mm256_loadu_ps(vw + i);
+        __m256 s[4];
+        for (size_t k = 0; k < 4; ++k) {
+            s[k] = _mm256_mul_ps(a[k][0], x);
+            s[k] = _mm256_add_ps(s[k], _mm256_mul_ps(a[k][1], y));
+            s[k] = _mm256_add_ps(s[k], _mm256_mul_ps(a[k][2], z));
+            s[k] = _mm256_add_ps(s[k], _mm256_mul_ps(a[k][3], w));
+        }
+        for (size_t k = 0; k < 4; ++k) {
+            _mm256_storeu_ps(r[k] + i, s[k]);
+        }
+    }
+    for (; i < n; ++i) {
+        const float x = vx[i];
+        const float y = vy[i];
+        const float z = vz[i];
+        const float w = vw[i];
+        rx[i] = m(0,0) * x + m(0,1) * y + m(0,2) * z + m(0,3) * w;
+        ry[i] = m(1,0) * x + m(1,1) * y + m(1,2) * z + m(1,3) * w;
+        rz[i] = m(2,0) * x + m(2,1) * y + m(2,2) * z + m(2,3) * w;
+        rw[i] = m(3,0) * x + m(3,1) * y + m(3,2) * z + m(3,3) * w;
+    }
+}
+
+/** ---------------------------------------------------------------------------
+ * product
+ * @brief Compute the Hamilton products r = a b of n pairs of quaternions.
+ */
+simd_kernel_
+void product(
+    const size_t n,
+    const float *ax, const float *ay, const float *az, const float *aw,
+    const float *bx, const float *by, const float *bz, const float *bw,
+    float *rx, float *ry, float *rz, float *rw)
+{
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        const __m256 a_x = _mm256_loadu_ps(ax + i);
+        const __m256 a_y = _mm256_loadu_ps(ay + i);
+        const __m256 a_z = _mm256_loadu_ps(az + i);
+        const __m256 a_w = _mm256_loadu_ps(aw + i);
+        const __m256 b_x = _mm256_loadu_ps(bx + i);
+        const __m256 b_y = _mm256_loadu_ps(by + i);
+        const __m256 b_z = _mm256_loadu_ps(bz + i);
+        const __m256 b_w = _mm256_loadu_ps(bw + i);
+        _mm256_storeu_ps(rx + i, simd256_fmadd_(a_w, b_x, simd256_fmadd_(
+            a_x, b_w, simd256_fmsub_(a_y, b_z, _mm256_mul_ps(a_z, b_y)))));
+        _mm256_storeu_ps(ry + i, simd256_fmadd_(a_w, b_y, simd256_fmadd_(
+            a_y, b_w, simd256_fmsub_(a_z, b_x, _mm256_mul_ps(a_x, b_z)))));
+        _mm256_storeu_ps(rz + i, simd256_fmadd_(a_w, b_z, simd256_fmadd_(
+            a_z, b_w, simd256_fmsub_(a_x, b_y, _mm256_mul_ps(a_y, b_x)))));
+        _mm256_storeu_ps(rw + i, simd256_fnmadd_(a_z, b_z, simd256_fnmadd_(
+            a_y, b_y, simd256_fnmadd_(a_x, b_x, _mm256_mul_ps(a_w, b_w)))));
+    }
+    for (; i < n; ++i) {
+        const float x = aw[i] * bx[i] + ax[i] * bw[i] +
+                         ay[i] * bz[i] - az[i] * by[i];
+        const float y = aw[i] * by[i] - ax[i] * bz[i] +
+                         ay[i] * bw[i] + az[i] * bx[i];
+        const float z = aw[i] * bz[i] + ax[i] * by[i] -
+                         ay[i] * bx[i] + az[i] * bw[i];
+        const float w = aw[i] * bw[i] - ax[i] * bx[i] -
+                         ay[i] * by[i] - az[i] * bz[i];
+        rx[i] = x;
+        ry[i] = y;
+        rz[i] = z;
+        rw[i] = w;
+    }
+}
+
+/**
+ * rotate
+ * @brief Rotate n vectors v by n unit quaternions q, with t = 2 u x v and
+ * r = v + w t + u x t.
+ */
+simd_kernel_
+void rotate(
+    const size_t n,
+    const float *qx, const float *qy, const float *qz, const float *qw,
+    const float *vx, const float *vy, const float *vz,
+    float *rx, float *ry, float *rz)
+{
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        const __m256 q_x = _mm256_loadu_ps(qx + i);
+        const __m256 q_y = _mm256_loadu_ps(qy + i);
+        const __m256 q_z = _mm256_loadu_ps(qz + i);
+        const __m256 q_w = _mm256_loadu_ps(qw + i);
+        const __m256 v_x = _mm256_loadu_ps(vx + i);
+        const __m256 v_y = _mm256_loadu_ps(vy + i);
+        const __m256 v_z = _mm256_loadu_ps(vz + i);
+        __m256 t_x = simd256_fmsub_(q_y, v_z, _mm256_mul_ps(q_z, v_y));
+        __m256 t_y = simd256_fmsub_(q_z, v_x, _mm256_mul_ps(q_x, v_z));
+        __m256 t_z = simd256_fmsub_(q_x, v_y, _mm256_mul_ps(q_y, v_x));
+        t_x = _mm256_add_ps(t_x, t_x);
+        t_y = _mm256_add_ps(t_y, t_y);
+        t_z = _mm256_add_ps(t_z, t_z);
+        _mm256_storeu_ps(rx + i, _mm256_add_ps(v_x, simd256_fmadd_(
+            q_w, t_x, simd256_fmsub_(q_y, t_z, _mm256_mul_ps(q_z, t_y)))));
+        _mm256_storeu_ps(ry + i, _mm256_add_ps(v_y, simd256_fmadd_(
+            q_w, t_y, simd256_fmsub_(q_z, t_x, _mm256_mul_ps(q_x, t_z)))));
+        _mm256_storeu_ps(rz + i, _mm256_add_ps(v_z, simd256_fmadd_(
+            q_w, t_z, simd256_fmsub_(q_x, t_y, _mm256_mul_ps(q_y, t_x)))));
+    }
+    for (; i < n; ++i) {
+        const float tx = 2.0f * (qy[i] * vz[i] - qz[i] * vy[i]);
+        const float ty = 2.0f * (qz[i] * vx[i] - qx[i] * vz[i]);
+        const float tz = 2.0f * (qx[i] * vy[i] - qy[i] * vx[i]);
+        const float x = vx[i] + qw[i] * tx + (qy[i] * tz - qz[i] * ty);
+        const float y = vy[i] + qw[i] * ty + (qz[i] * tx - qx[i] * tz);
+        const float z = vz[i] + qw[i] * tz + (qx[i] * ty - qy[i] * tx);
+        rx[i] = x;
+        ry[i] = y;
+        rz[i] = z;
+    }
+}
+
+#ifdef simd_isa_
+} /* simd_isa_ */
+#endif
+#undef simd_kernel_
+
+} /* batch */
+} /* math */
+} /* atto */
+
@@ -0,0 +1,409 @@
+/*
+ * batch.hpp
+ *
+ * Copyright (c) 2020 Carlos Braga
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the MIT License.
+ *
+ * See accompanying LICENSE.md or https://opensource.org/licenses/MIT.
+ */
+
+#ifndef ATTO_MATH_GEOMETRY_BATCH_H_
+#define ATTO_MATH_GEOMETRY_BATCH_H_
+
+#include "atto/math/geometry/vec3.hpp"
+#include "atto/math/geometry/vec4.hpp"
+#include "atto/math/geometry/mat3.hpp"
+#include "atto/math/geometry/mat4.hpp"
+
+namespace atto {
+namespace math {
+namespace batch {
+
+/** ---- Batch vector operations ----------------------------------------------
+ * @brief Vector operations over arrays of n vectors in structure of arrays
+ * layout, with each vector component in its own array. A SIMD register
+ * holds the same component of consecutive vectors, so every lane does
+ * useful work and no horizontal shuffles are needed, unlike the operations
+ * on a single vec3 that leave one lane of a 256-bit register idle.
+ *
+ * The arrays need no particular alignment. The output arrays may alias the
+ * input arrays of the same component.
+ *
+ * With ATTO_MATH_SIMD, the AVX specialisations replace the loops for
+ * double and float arrays, see batch-simd.hpp. With ATTO_DISPATCH, the
+ * loops are multiversioned and vectorized by the compiler for each
+ * instruction set level, and the SIMD kernels are compiled for each of
+ * AVX, AVX2 and AVX-512 and selected at run time, see batch-dispatch.hpp.
+ */
+
+/**
+ * dot
+ * @brief Compute the dot products r = a.b of n pairs of vectors.
+ */
+template<typename Type>
+inline core_dispatch
+void dot(
+    const size_t n,
+    const Type *ax, const Type *ay, const Type *az,
+    const Type *bx, const Type *by, const Type *bz,
+    Type *r)
+{
+    static_assert(std::is_floating_point<Type>::value, "non floating point");
+    for (size_t i = 0; i < n; ++i) {
+        r[i] = ax[i] * bx[i] + ay[i] * by[i] + az[i] * bz[i];
+    }
+}
+
+template<typename Type>
+inline core_dispatch
+void dot(
+    const size_t n,
+    const Type *ax, const Type *ay, const Type *az, const Type *aw,
+    const Type *bx, const Type *by, const Type *bz, const Type *bw,
+    Type *r)
+{
+    static_assert(std::is_floating_point<Type>::value, "non floating point");
+    for (size_t i = 0; i < n; ++i) {
+        r[i] = ax[i] * bx[i] + ay[i] * by[i] + az[i] * bz[i] + aw[i] * bw[i];
+    }
+}
+
+/**
+ * cross
+ * @brief Compute the cross products r = a x b of n pairs of vectors.
+ */
+template<typename Type>
+inline core_dispatch
+void cross(
+    const size_t n,
+    const Type *ax, const Type *ay, const Type *az,
+    const Type *bx, const Type *by, const Type *bz,
+    Type *rx, Type *ry, Type *rz)
+{
+    static_assert(std::is_floating_point<Type>::value, "non floating point");
+    for (size_t i = 0; i < n; ++i) {
+        const Type x = ay[i] * bz[i] - az[i] * by[i];
+        const Type y = az[i] * bx[i] - ax[i] * bz[i];
+        const Type z = ax[i] * by[i] - ay[i] * bx[i];
+        rx[i] = x;
+        ry[i] = y;
+        rz[i] = z;
+    }
+}
+
+/**
+ * norm
+ * @brief Compute the norms r = |a| of n vectors.
+ */
+template<typename Type>
+inline core_dispatch
+void norm(
+    const size_t n,
+    const Type *ax, const Type *ay, const Type *az,
+    Type *r)
+{
+    static_assert(std::is_floating_point<Type>::value, "non floating point");
+    for (size_t i = 0; i < n; ++i) {
+        r[i] = std::sqrt(ax[i] * ax[i] + ay[i] * ay[i] + az[i] * az[i]);
+    }
+}
+
+template<typename Type>
+inline core_dispatch
+void norm(
+    const size_t n,
+    const Type *ax, const Type *ay, const Type *az, const Type *aw,
+    Type *r)
+{
+    static_assert(std::is_floating_point<Type>::value, "non floating point");
+    for (size_t i = 0; i < n; ++i) {
+        r[i] = std::sqrt(
+            ax[i] * ax[i] + ay[i] * ay[i] + az[i] * az[i] + aw[i] * aw[i]);
+    }
+}
+
+/**
+ * normalize
+ * @brief Compute the normalized vectors r = a / |a| of n vectors.
+ */
+template<typename Type>
+inline core_dispatch
+void normalize(
+    const size_t n,
+    const Type *ax, const Type *ay, const Type *az,
+    Type *rx, Type *ry, Type *rz)
+{
+    static_assert(std::is_floating_point<Type>::value, "non floating point");
+    for (size_t i = 0; i < n; ++i) {
+        const Type inv = (Type) 1 / std::sqrt(
+            ax[i] * ax[i] + ay[i] * ay[i] + az[i] * az[i]);
+        rx[i] = ax[i] * inv;
+        ry[i] = ay[i] * inv;
+        rz[i] = az[i] * inv;
+    }
+}
+
+template<typename Type>
+inline core_dispatch
+void normalize(
+    const size_t n,
+    const Type *ax, const Type *ay, const Type *az, const Type *aw,
+    Type *rx, Type *ry, Type *rz, Type *rw)
+{
+    static_assert(std::is_floating_point<Type>::value, "non floating point");
+    for (size_t i = 0; i < n; ++i) {
+        const Type inv = (Type) 1 / std::sqrt(
+            ax[i] * ax[i] + ay[i] * ay[i] + az[i] * az[i] + aw[i] * aw[i]);
+        rx[i] = ax[i] * inv;
+        ry[i] = ay[i] * inv;
+        rz[i] = az[i] * inv;
+        rw[i] = aw[i] * inv;
+    }
+}
+
+/**
+ * distance
+ * @brief Compute the distances r = |a - b| between n pairs of points.
+ */
+template<typename Type>
+inline core_dispatch
+void distance(
+    const size_t n,
+    const Type *ax, const Type *ay, const Type *az,
+    const Type *bx, const Type *by, const Type *bz,
+    Type *r)
+{
+    static_assert(std::is_floating_point<Type>::value, "non floating point");
+    for (size_t i = 0; i < n; ++i) {
+        const Type dx = ax[i] - bx[i];
+        const Type dy = ay[i] - by[i];
+        const Type dz = az[i] - bz[i];
+        r[i] = std::sqrt(dx * dx + dy * dy + dz * dz);
+    }
+}
+
+template<typename Type>
+inline core_dispatch
+void distance(
+    const size_t n,
+    const Type *ax, const Type *ay, const Type *az, const Type *aw,
+    const Type *bx, const Type *by, const Type *bz, const Type *bw,
+    Type *r)
+{
+    static_assert(std::is_floating_point<Type>::value, "non floating point");
+    for (size_t i = 0; i < n; ++i) {
+        const Type dx = ax[i] - bx[i];
+        const Type dy = ay[i] - by[i];
+        const Type dz = az[i] - bz[i];
+        const Type dw = aw[i] - bw[i];
+        r[i] = std::sqrt(dx * dx + dy * dy + dz * dz + dw * dw);
+    }
+}
+
+/** ---- Batch matrix operations ----------------------------------------------
+ * dot
+ * @brief Compute the products r = m v of a matrix with n vectors.
+ */
+template<typename Type>
+inline core_dispatch
+void dot(
+    const size_t n,
+    const mat3<Type> &m,
+    const Type *vx, const Type *vy, const Type *vz,
+    Type *rx, Type *ry, Type *rz)
+{
+    static_assert(std::is_floating_point<Type>::value, "non floating point");
+    for (size_t i = 0; i < n; ++i) {
+        const Type x = vx[i];
+        const Type y = vy[i];
+        const Type z = vz[i];
+        rx[i] = m(0,0) * x + m(0,1) * y + m(0,2) * z;
+        ry[i] = m(1,0) * x + m(1,1) * y + m(1,2) * z;
+        rz[i] = m(2,0) * x + m(2,1) * y + m(2,2) * z;
+    }
+}
+
+template<typename Type>
+inline core_dispatch
+void dot(
+    const size_t n,
+    const mat4<Type> &m,
+    const Type *vx, const Type *vy, const Type *vz, const Type *vw,
+    Type *rx, Type *ry, Type *rz, Type *rw)
+{
+    static_assert(std::is_floating_point<Type>::value, "non floating point");
+    for (size_t i = 0; i < n; ++i) {
+        const Type x = vx[i];
+        const Type y = vy[i];
+        const Type z = vz[i];
+        const Type w = vw[i];
+        rx[i] = m(0,0) * x + m(0,1) * y + m(0,2) * z + m(0,3) * w;
+        ry[i] = m(1,0) * x + m(1,1) * y + m(1,2) * z + m(1,3) * w;
+        rz[i] = m(2,0) * x + m(2,1) * y + m(2,2) * z + m(2,3) * w;
+        rw[i] = m(3,0) * x + m(3,1) * y + m(3,2) * z + m(3,3) * w;
+    }
+}
+
+/** ---- Batch quaternion operations ------------------------------------------
+ * @brief Quaternion operations over arrays of n quaternions q = (x, y, z, w)
+ * in structure of arrays layout. The norms and the normalization of the
+ * quaternions are the 4d-vector operations.
+ */
+
+/**
+ * product
+ * @brief Compute the Hamilton products r = a b of n pairs of quaternions.
+ */
+template<typename Type>
+inline core_dispatch
+void product(
+    const size_t n,
+    const Type *ax, const Type *ay, const Type *az, const Type *aw,
+    const Type *bx, const Type *by, const Type *bz, const Type *bw,
+    Type *rx, Type *ry, Type *rz, Type *rw)
+{
+    static_assert(std::is_floating_point<Type>::value, "non floating point");
+    for (size_t i = 0; i < n; ++i) {
+        const Type x = aw[i] * bx[i] + ax[i] * bw[i] +
+                       ay[i] * bz[i] - az[i] * by[i];
+        const Type y = aw[i] * by[i] - ax[i] * bz[i] +
+                       ay[i] * bw[i] + az[i] * bx[i];
+        const Type z = aw[i] * bz[i] + ax[i] * by[i] -
+                       ay[i] * bx[i] + az[i] * bw[i];
+        const Type w = aw[i] * bw[i] - ax[i] * bx[i] -
+                       ay[i] * by[i] - az[i] * bz[i];
+        rx[i] = x;
+        ry[i] = y;
+        rz[i] = z;
+        rw[i] = w;
+    }
+}
+
+/**
+ * rotate
+ * @brief Rotate n vectors v by n unit quaternions q, with t = 2 u x v and
+ * r = v + w t + u x t, where u is the vector part of q.
+ */
+template<typename Type>
+inline core_dispatch
+void rotate(
+    const size_t n,
+    const Type *qx, const Type *qy, const Type *qz, const Type *qw,
+    const Type *vx, const Type *vy, const Type *vz,
+    Type *rx, Type *ry, Type *rz)
+{
+    static_assert(std::is_floating_point<Type>::value, "non floating point");
+    for (size_t i = 0; i < n; ++i) {
+        const Type tx = (Type) 2 * (qy[i] * vz[i] - qz[i] * vy[i]);
+        const Type ty = (Type) 2 * (qz[i] * vx[i] - qx[i] * vz[i]);
+        const Type tz = (Type) 2 * (qx[i] * vy[i] - qy[i] * vx[i]);
+        const Type x = vx[i] + qw[i] * tx + (qy[i] * tz - qz[i] * ty);
+        const Type y = vy[i] + qw[i] * ty + (qz[i] * tx - qx[i] * tz);
+        const Type z = vz[i] + qw[i] * tz + (qx[i] * ty - qy[i] * tx);
+        rx[i] = x;
+        ry[i] = y;
+        rz[i] = z;
+    }
+}
+
+/**
+ * nosquish_permute_
+ * @brief Compute r = P_k a, the permutation of the quaternion a = (x, y, z, w)
+ * associated with the k-th principal axis of a rigid body.
+ */
+template<typename Type>
+core_inline
+void nosquish_permute_(const size_t k, const Type (&a)[4], Type (&r)[4])
+{
+    if (k == 0) {
+        r[0] =  a[3]; r[1] =  a[2]; r[2] = -a[1]; r[3] = -a[0];
+    } else if (k == 1) {
+        r[0] = -a[2]; r[1] =  a[3]; r[2] =  a[0]; r[3] = -a[1];
+    } else {
+        r[0] =  a[1]; r[1] = -a[0]; r[2] =  a[3]; r[3] = -a[2];
+    }
+}
+
+/**
+ * nosquish_rotate_
+ * @brief Exact free rotation of a rigid body around its k-th principal axis,
+ * with moment of inertia ik, over a time step dt. The quaternion q and its
+ * conjugate momentum p rotate by the same angle zeta in the planes spanned
+ * by q, P_k q and by p, P_k p,
+ *  zeta = dt (p . P_k q) / (4 ik).
+ */
+template<typename Type>
+core_inline
+void nosquish_rotate_(
+    const size_t k,
+    const Type dt,
+    const Type ik,
+    Type (&q)[4],
+    Type (&p)[4])
+{
+    Type pq[4], pp[4];
+    nosquish_permute_(k, q, pq);
+    nosquish_permute_(k, p, pp);
+
+    const Type zeta = dt * (p[0] * pq[0] + p[1] * pq[1] +
+                            p[2] * pq[2] + p[3] * pq[3]) / ((Type) 4 * ik);
+    const Type c = std::cos(zeta);
+    const Type s = std::sin(zeta);
+    for (size_t j = 0; j < 4; ++j) {
+        q[j] = c * q[j] + s * pq[j];
+        p[j] = c * p[j] + s * pp[j];
+    }
+}
+
+/**
+ * nosquish
+ * @brief Integrate the free rotation of n rigid bodies over a time step dt
+ * with the NO_SQUISH symplectic splitting,
+ *  R_3(dt/2) R_2(dt/2) R_1(dt) R_2(dt/2) R_3(dt/2),
+ * where each R_k is the exact rotation around the k-th principal axis.
+ * Each body has an orientation quaternion q and its conjugate momentum
+ * p = 2 q (I w, 0), with w the angular velocity in the body frame, and
+ * the principal moments of inertia (i1, i2, i3) are common to all bodies.
+ * The step preserves |q| and the orthonormality of the rotation matrix.
+ * The torques are applied separately, as a kick of p by 2 q (t, 0) dt/2
+ * with t the torque in the body frame.
+ *
+ * @see Miller et al., J. Chem. Phys. 116, 8649 (2002).
+ */
+template<typename Type>
+inline core_dispatch
+void nosquish(
+    const size_t n,
+    const Type dt,
+    const Type i1, const Type i2, const Type i3,
+    Type *qx, Type *qy, Type *qz, Type *qw,
+    Type *px, Type *py, Type *pz, Type *pw)
+{
+    static_assert(std::is_floating_point<Type>::value, "non floating point");
+    const Type half = (Type) 0.5 * dt;
+    for (size_t i = 0; i < n; ++i) {
+        Type q[4] = {qx[i], qy[i], qz[i], qw[i]};
+        Type p[4] = {px[i], py[i], pz[i], pw[i]};
+        nosquish_rotate_(2, half, i3, q, p);
+        nosquish_rotate_(1, half, i2, q, p);
+        nosquish_rotate_(0, dt, i1, q, p);
+        nosquish_rotate_(1, half, i2, q, p);
+        nosquish_rotate_(2, half, i3, q, p);
+        qx[i] = q[0]; qy[i] = q[1]; qz[i] = q[2]; qw[i] = q[3];
+        px[i] = p[0]; py[i] = p[1]; pz[i] = p[2]; pw[i] = p[3];
+    }
+}
+
+} /* batch */
+} /* math */
+} /* atto */
+
+#if defined(ATTO_CORE_DISPATCH)
+#include "atto/math/geometry/batch-dispatch.hpp"
+#elif defined(ATTO_MATH_SIMD)
+#include "atto/math/geometry/batch-simd.hpp"
+#endif
+
+#endif /* ATTO_MATH_GEOMETRY_BATCH_H_ */
@@ -0,0 +1,141 @@
+/*
+ * box-dispatch.hpp
+ *
+ * Copyright (c) 2020 Carlos Braga
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the MIT License.
+ *
+ * See accompanying LICENSE.md or https://opensource.org/licenses/MIT.
+ */
+
+#ifndef ATTO_MATH_GEOMETRY_BOX_DISPATCH_H_
+#define ATTO_MATH_GEOMETRY_BOX_DISPATCH_H_
+
+#include "atto/math/geometry/simd.hpp"
+
+/** ---- Box kernels of each instruction set ----------------------------------
+ * @brief A dispatch build compiles the SIMD kernels of box-simd.hpp once for
+ * each instruction set with the target pragma, into the namespaces avx,
+ * avx2 and avx512 of the batch namespace, as batch-dispatch.hpp does. The
+ * box kernels use 256-bit registers on every instruction set.
+ */
+#pragma push_macro("ATTO_MATH_SIMD512")
+#undef ATTO_MATH_SIMD512
+
+#pragma GCC push_options
+#pragma GCC target("avx")
+#define simd_isa_ avx
+#include "atto/math/geometry/box-simd.hpp"
+#undef simd_isa_
+#pragma GCC pop_options
+
+#pragma GCC push_options
+#pragma GCC target("avx2,fma")
+#define simd_isa_ avx2
+#include "atto/math/geometry/box-simd.hpp"
+#undef simd_isa_
+#pragma GCC pop_options
+
+#define ATTO_MATH_SIMD512
+#pragma GCC push_options
+#pragma GCC target("avx512f,avx2,fma")
+#define simd_isa_ avx512
+#include "atto/math/geometry/box-simd.hpp"
+#undef simd_isa_
+#pragma GCC pop_options
+
+#pragma pop_macro("ATTO_MATH_SIMD512")
+
+namespace atto {
+namespace math {
+namespace batch {
+
+/** ---- Box kernel dispatch --------------------------------------------------
+ * @brief Double precision box operations call the kernel of the widest
+ * instruction set enabled in core::cpu_dispatch, or the generic loop on a
+ * processor older than AVX.
+ */
+core_inline
+void min_image(
+    const Box<double, false> &box,
+    const size_t n,
+    double *x,
+    double *y,
+    double *z)
+{
+    simd_dispatch_(min_image, box, n, x, y, z);
+}
+
+core_inline
+void wrap(
+    const Box<double, false> &box,
+    const size_t n,
+    double *x,
+    double *y,
+    double *z,
+    double *ix,
+    double *iy,
+    double *iz)
+{
+    simd_dispatch_(wrap, box, n, x, y, z, ix, iy, iz);
+}
+
+core_inline
+void unwrap(
+    const Box<double, false> &box,
+    const size_t n,
+    double *x,
+    double *y,
+    double *z,
+    const double *ix,
+    const double *iy,
+    const double *iz)
+{
+    simd_dispatch_(unwrap, box, n, x, y, z, ix, iy, iz);
+}
+
+core_inline
+void min_image(
+    const Box<double, true> &box,
+    const size_t n,
+    double *x,
+    double *y,
+    double *z)
+{
+    simd_dispatch_(min_image, box, n, x, y, z);
+}
+
+core_inline
+void wrap(
+    const Box<double, true> &box,
+    const size_t n,
+    double *x,
+    double *y,
+    double *z,
+    double *ix,
+    double *iy,
+    double *iz)
+{
+    simd_dispatch_(wrap, box, n, x, y, z, ix, iy, iz);
+}
+
+core_inline
+void unwrap(
+    const Box<double, true> &box,
+    const size_t n,
+    double *x,
+    double *y,
+    double *z,
+    const double *ix,
+    const double *iy,
+    const double *iz)
+{
+    simd_dispatch_(unwrap, box, n, x, y, z, ix, iy, iz);
+}
+
+} /* batch */
+} /* math */
+} /* atto */
+
+#endif /* ATTO_MATH_GEOMETRY_BOX_DISPATCH_H_ */
@@ -0,0 +1,325 @@
+/*
+ * box-simd.hpp
+ *
+ * Copyright (c) 2020 Carlos Braga
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the MIT License.
+ *
+ * See accompanying LICENSE.md or https://opensource.org/licenses/MIT.
+ */
+
+#include "atto/math/geometry/simd.hpp"
+
+namespace atto {
+namespace math {
+namespace batch {
+
+/*
+ * A dispatch build includes this file once for each instruction set, with
+ * simd_isa_ naming the namespace of its kernels, see box-dispatch.hpp.
+ * Otherwise the kernels specialise the generic templates of box.hpp.
+ */
+#ifdef simd_isa_
+#define simd_kernel_ inline
+namespace simd_isa_ {
+#else
+#define simd_kernel_ template<> core_inline
+#endif
+
+/** ---------------------------------------------------------------------------
+ * min_image<double, false>
+ * @brief Replace the n displacements (x,y,z) by their minimum images, four
+ * elements of each component at a time:
+ *
+ *  x = x - L_x round(x / L_x)
+ *
+ * The rounding is a single instruction with no branches, with ties to
+ * even. The remaining elements use the vector operation, which rounds the
+ * same way. The products use the fused multiply-add helpers, see simd.hpp.
+ */
+simd_kernel_
+void min_image(
+    const Box<double, false> &box,
+    const size_t n,
+    double *x,
+    double *y,
+    double *z)
+{
+    double *v[3] = {x, y, z};
+    const size_t n_simd = n - n % 4;
+    for (size_t k = 0; k < 3; ++k) {
+        const __m256d len = _mm256_set1_pd(box.length(k));
+        const __m256d inv = _mm256_set1_pd(box.inv_length(k));
+        double *p = v[k];
+        for (size_t i = 0; i < n_simd; i += 4) {
+            __m256d d = _mm256_loadu_pd(p + i);
+            __m256d s = simd256_round_(_mm256_mul_pd(d, inv));
+            _mm256_storeu_pd(p + i, simd256_fnmadd_(len, s, d));
+        }
+    }
+    for (size_t i = n_simd; i < n; ++i) {
+        vec3<double> d = box.min_image(vec3<double>(x[i], y[i], z[i]));
+        x[i] = d(0);
+        y[i] = d(1);
+        z[i] = d(2);
+    }
+}
+
+/**
+ * wrap<double, false>
+ * @brief Wrap the n positions (x,y,z) inside the cell, four elements of
+ * each component at a time, and add the cell counts to (ix,iy,iz).
+ */
+simd_kernel_
+void wrap(
+    const Box<double, false> &box,
+    const size_t n,
+    double *x,
+    double *y,
+    double *z,
+    double *ix,
+    double *iy,
+    double *iz)
+{
+    double *v[3] = {x, y, z};
+    double *w[3] = {ix, iy, iz};
+    const size_t n_simd = n - n % 4;
+    for (size_t k = 0; k < 3; ++k) {
+        const __m256d org = _mm256_set1_pd(box.origin(k));
+        const __m256d len = _mm256_set1_pd(box.length(k));
+        const __m256d inv = _mm256_set1_pd(box.inv_length(k));
+        double *p = v[k];
+        double *q = w[k];
+        for (size_t i = 0; i < n_simd; i += 4) {
+            __m256d r = _mm256_loadu_pd(p + i);
+            __m256d c = simd256_floor_(
+                _mm256_mul_pd(_mm256_sub_pd(r, org), inv));
+            _mm256_storeu_pd(p + i, simd256_fnmadd_(len, c, r));
+            _mm256_storeu_pd(q + i, _mm256_add_pd(_mm256_loadu_pd(q + i), c));
+        }
+    }
+    for (size_t i = n_simd; i < n; ++i) {
+        vec3<double> image(ix[i], iy[i], iz[i]);
+        vec3<double> r = box.wrap(vec3<double>(x[i], y[i], z[i]), image);
+        x[i] = r(0);
+        y[i] = r(1);
+        z[i] = r(2);
+        ix[i] = image(0);
+        iy[i] = image(1);
+        iz[i] = image(2);
+    }
+}
+
+/**
+ * unwrap<double, false>
+ * @brief Shift the n wrapped positions (x,y,z) back by their image counts,
+ * four elements of each component at a time.
+ */
+simd_kernel_
+void unwrap(
+    const Box<double, false> &box,
+    const size_t n,
+    double *x,
+    double *y,
+    double *z,
+    const double *ix,
+    const double *iy,
+    const double *iz)
+{
+    double *v[3] = {x, y, z};
+    const double *w[3] = {ix, iy, iz};
+    const size_t n_simd = n - n % 4;
+    for (size_t k = 0; k < 3; ++k) {
+        const __m256d len = _mm256_set1_pd(box.length(k));
+        double *p = v[k];
+        const double *q = w[k];
+        for (size_t i = 0; i < n_simd; i += 4) {
+            __m256d r = _mm256_loadu_pd(p + i);
+            __m256d c = _mm256_loadu_pd(q + i);
+            _mm256_storeu_pd(p + i, simd256_fmadd_(len, c, r));
+        }
+    }
+    for (size_t i = n_simd; i < n; ++i) {
+        vec3<double> r = box.unwrap(
+            vec3<double>(x[i], y[i], z[i]),
+            vec3<double>(ix[i], iy[i], iz[i]));
+        x[i] = r(0);
+        y[i] = r(1);
+        z[i] = r(2);
+    }
+}
+
+/** ---------------------------------------------------------------------------
+ * min_image<double, true>
+ * @brief Replace the n displacements (x,y,z) by their minimum images, four
+ * displacements at a time. Each register holds one component of four
+ * displacements, and the matrix elements are broadcast:
+ *
+ *  s = h^-1 d,  s = s - round(s),  d = h s
+ */
+simd_kernel_
+void min_image(
+    const Box<double, true> &box,
+    const size_t n,
+    double *x,
+    double *y,
+    double *z)
+{
+    __m256d a[3][3];
+    __m256d b[3][3];
+    for (size_t i = 0; i < 3; ++i) {
+        for (size_t j = 0; j < 3; ++j) {
+            a[i][j] = _mm256_set1_pd(box.h_inv(i,j));
+            b[i][j] = _mm256_set1_pd(box.h(i,j));
+        }
+    }
+
+    const size_t n_simd = n - n % 4;
+    for (size_t i = 0; i < n_simd; i += 4) {
+        __m256d d[3] = {
+            _mm256_loadu_pd(x + i),
+            _mm256_loadu_pd(y + i),
+            _mm256_loadu_pd(z + i)};
+        __m256d s[3];
+        for (size_t k = 0; k < 3; ++k) {
+            s[k] = simd256_fmadd_(a[k][0], d[0], simd256_fmadd_(
+                a[k][1], d[1], _mm256_mul_pd(a[k][2], d[2])));
+            s[k] = _mm256_sub_pd(s[k], simd256_round_(s[k]));
+        }
+        for (size_t k = 0; k < 3; ++k) {
+            d[k] = simd256_fmadd_(b[k][0], s[0], simd256_fmadd_(
+                b[k][1], s[1], _mm256_mul_pd(b[k][2], s[2])));
+        }
+        _mm256_storeu_pd(x + i, d[0]);
+        _mm256_storeu_pd(y + i, d[1]);
+        _mm256_storeu_pd(z + i, d[2]);
+    }
+    for (size_t i = n_simd; i < n; ++i) {
+        vec3<double> d = box.min_image(vec3<double>(x[i], y[i], z[i]));
+        x[i] = d(0);
+        y[i] = d(1);
+        z[i] = d(2);
+    }
+}
+
+/**
+ * wrap<double, true>
+ * @brief Wrap the n positions (x,y,z) inside the cell, four positions at a
+ * time, and add the cell counts to (ix,iy,iz):
+ *
+ *  s = h^-1 (r - o),  c = floor(s),  r = o + h (s - c)
+ */
+simd_kernel_
+void wrap(
+    const Box<double, true> &box,
+    const size_t n,
+    double *x,
+    double *y,
+    double *z,
+    double *ix,
+    double *iy,
+    double *iz)
+{
+    __m256d a[3][3];
+    __m256d b[3][3];
+    __m256d o[3];
+    for (size_t i = 0; i < 3; ++i) {
+        for (size_t j = 0; j < 3; ++j) {
+            a[i][j] = _mm256_set1_pd(box.h_inv(i,j));
+            b[i][j] = _mm256_set1_pd(box.h(i,j));
+        }
+        o[i] = _mm256_set1_pd(box.origin(i));
+    }
+
+    double *v[3] = {x, y, z};
+    double *w[3] = {ix, iy, iz};
+    const size_t n_simd = n - n % 4;
+    for (size_t i = 0; i < n_simd; i += 4) {
+        __m256d r[3];
+        for (size_t k = 0; k < 3; ++k) {
+            r[k] = _mm256_sub_pd(_mm256_loadu_pd(v[k] + i), o[k]);
+        }
+        __m256d s[3];
+        for (size_t k = 0; k < 3; ++k) {
+            s[k] = simd256_fmadd_(a[k][0], r[0], simd256_fmadd_(
+                a[k][1], r[1], _mm256_mul_pd(a[k][2], r[2])));
+            __m256d c = simd256_floor_(s[k]);
+            s[k] = _mm256_sub_pd(s[k], c);
+            _mm256_storeu_pd(w[k] + i,
+                _mm256_add_pd(_mm256_loadu_pd(w[k] + i), c));
+        }
+        for (size_t k = 0; k < 3; ++k) {
+            r[k] = simd256_fmadd_(b[k][0], s[0], simd256_fmadd_(
+                b[k][1], s[1], _mm256_mul_pd(b[k][2], s[2])));
+            _mm256_storeu_pd(v[k] + i, _mm256_add_pd(o[k], r[k]));
+        }
+    }
+    for (size_t i = n_simd; i < n; ++i) {
+        vec3<double> image(ix[i], iy[i], iz[i]);
+        vec3<double> r = box.wrap(vec3<double>(x[i], y[i], z[i]), image);
+        x[i] = r(0);
+        y[i] = r(1);
+        z[i] = r(2);
+        ix[i] = image(0);
+        iy[i] = image(1);
+        iz[i] = image(2);
+    }
+}
+
+/**
+ * unwrap<double, true>
+ * @brief Shift the n wrapped positions (x,y,z) back by the cell vectors of
+ * their image counts, four positions at a time.
+ */
+simd_kernel_
+void unwrap(
+    const Box<double, true> &box,
+    const size_t n,
+    double *x,
+    double *y,
+    double *z,
+    const double *ix,
+    const double *iy,
+    const double *iz)
+{
+    __m256d b[3][3];
+    for (size_t i = 0; i < 3; ++i) {
+        for (size_t j = 0; j < 3; ++j) {
+            b[i][j] = _mm256_set1_pd(box.h(i,j));
+        }
+    }
+
+    double *v[3] = {x, y, z};
+    const size_t n_simd = n - n % 4;
+    for (size_t i = 0; i < n_simd; i += 4) {
+        __m256d c[3] = {
+            _mm256_loadu_pd(ix + i),
+            _mm256_loadu_pd(iy + i),
+            _mm256_loadu_pd(iz + i)};
+        for (size_t k = 0; k < 3; ++k) {
+            __m256d t = simd256_fmadd_(b[k][0], c[0], simd256_fmadd_(
+                b[k][1], c[1], _mm256_mul_pd(b[k][2], c[2])));
+            _mm256_storeu_pd(v[k] + i,
+                _mm256_add_pd(_mm256_loadu_pd(v[k] + i), t));
+        }
+    }
+    for (size_t i = n_simd; i < n; ++i) {
+        vec3<double> r = box.unwrap(
+            vec3<double>(x[i], y[i], z[i]),
+            vec3<double>(ix[i], iy[i], iz[i]));
+        x[i] = r(0);
+        y[i] = r(1);
+        z[i] = r(2);
+    }
+}
+
+#ifdef simd_isa_
+} /* simd_isa_ */
+#endif
+#undef simd_kernel_
+
+} /* batch */
+} /* math */
+} /* atto */
+
@@ -0,0 +1,399 @@
+/*
+ * box.hpp
+ *
+ * Copyright (c) 2020 Carlos Braga
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the MIT License.
+ *
+ * See accompanying LICENSE.md or https://opensource.org/licenses/MIT.
+ */
+
+#ifndef ATTO_MATH_BOX_H_
+#define ATTO_MATH_BOX_H_
+
+#include "atto/math/geometry/vec3.hpp"
+#include "atto/math/geometry/mat3.hpp"
+#include "atto/math/geometry/arithmetic.hpp"
+#include "atto/math/geometry/algebra.hpp"
+
+namespace atto {
+namespace math {
+
+/** ---------------------------------------------------------------------------
+ * Box
+ * @brief Box is a plain class representing a periodic simulation cell.
+ * The cell matrix h holds the cell vectors a, b and c in its columns, so a
+ * position r = origin + h s has fractional coordinates s in [0,1) inside
+ * the cell. The inverse of h is cached when the box is created.
+ *
+ * The shape is a compile-time parameter. A triclinic box maps through the
+ * fractional coordinates with the full cell matrix. An orthorhombic box has
+ * a diagonal cell matrix and only scales each component by the cell length
+ * and its inverse, so the minimum image reduces to d - L round(d / L) with
+ * no branches.
+ *
+ * The batch operations work on structure of arrays components and keep the
+ * periodic image counts as floating point numbers. With ATTO_DISPATCH, the
+ * generic loops are multiversioned, see core_dispatch, and the SIMD kernels
+ * are selected at run time, see box-dispatch.hpp.
+ *
+ * The minimum image of a triclinic box is the image with the nearest
+ * fractional coordinates, which is the nearest image when the displacement
+ * is within half the smallest distance between opposite cell faces.
+ */
+template<typename Type, bool Triclinic>
+struct Box {
+    static_assert(std::is_floating_point<Type>::value, "non floating point");
+
+    /* Cell origin, cell matrix and its inverse. */
+    vec3<Type> origin;
+    mat3<Type> h;
+    mat3<Type> h_inv;
+
+    /* Cell lengths and their inverse along the diagonal of h. */
+    vec3<Type> length;
+    vec3<Type> inv_length;
+
+    /* Create a box from its origin and cell matrix. */
+    static Box<Type, Triclinic> create(
+        const vec3<Type> &o,
+        const mat3<Type> &m);
+
+    /* Create a box from its lower and upper bounds. */
+    static Box<Type, Triclinic> create_from_bounds(
+        const vec3<Type> &lo,
+        const vec3<Type> &hi);
+
+    /* Return the nearest integers to s, with ties to even. */
+    static vec3<Type> nearest(const vec3<Type> &s);
+
+    /* Return the volume of the cell. */
+    Type volume(void) const;
+
+    /* Return the minimum image of a displacement. */
+    vec3<Type> min_image(const vec3<Type> &d) const;
+
+    /*
+     * Return the position wrapped inside the cell, and add the number of
+     * cell vectors removed from it to the image counts.
+     */
+    vec3<Type> wrap(const vec3<Type> &r) const;
+    vec3<Type> wrap(const vec3<Type> &r, vec3<Type> &image) const;
+
+    /* Return the unwrapped position of a wrapped position. */
+    vec3<Type> unwrap(const vec3<Type> &r, const vec3<Type> &image) const;
+
+    /* Batch operations over n elements in structure of arrays layout. */
+    void min_image(const size_t n, Type *x, Type *y, Type *z) const;
+    void wrap(
+        const size_t n,
+        Type *x,
+        Type *y,
+        Type *z,
+        Type *ix,
+        Type *iy,
+        Type *iz) const;
+    void unwrap(
+        const size_t n,
+        Type *x,
+        Type *y,
+        Type *z,
+        const Type *ix,
+        const Type *iy,
+        const Type *iz) const;
+};
+
+/** ---- Box factory functions ------------------------------------------------
+ * Box<Type, Triclinic>::create
+ * @brief Create a box with origin o and cell matrix m. The cell matrix of
+ * an orthorhombic box must be diagonal.
+ */
+template<typename Type, bool Triclinic>
+core_inline
+Box<Type, Triclinic> Box<Type, Triclinic>::create(
+    const vec3<Type> &o,
+    const mat3<Type> &m)
+{
+    Box<Type, Triclinic> box;
+    box.origin = o;
+    box.h = m;
+    box.h_inv = inverse(m);
+    for (size_t i = 0; i < 3; ++i) {
+        box.length(i) = m(i,i);
+        box.inv_length(i) = (Type) 1 / m(i,i);
+    }
+    if (!Triclinic) {
+        core_assert(
+            m(0,1) == (Type) 0 && m(0,2) == (Type) 0 &&
+            m(1,0) == (Type) 0 && m(1,2) == (Type) 0 &&
+            m(2,0) == (Type) 0 && m(2,1) == (Type) 0,
+            "orthorhombic cell matrix is not diagonal");
+    }
+    return box;
+}
+
+/**
+ * Box<Type, Triclinic>::create_from_bounds
+ * @brief Create a box spanning the bounds lo and hi along the coordinate
+ * axes.
+ */
+template<typename Type, bool Triclinic>
+core_inline
+Box<Type, Triclinic> Box<Type, Triclinic>::create_from_bounds(
+    const vec3<Type> &lo,
+    const vec3<Type> &hi)
+{
+    return create(lo, mat3<Type>(
+        hi(0) - lo(0), (Type) 0, (Type) 0,
+        (Type) 0, hi(1) - lo(1), (Type) 0,
+        (Type) 0, (Type) 0, hi(2) - lo(2)));
+}
+
+/**
+ * Box<Type, Triclinic>::volume
+ * @brief Return the volume of the cell, the determinant of h.
+ */
+template<typename Type, bool Triclinic>
+core_inline
+Type Box<Type, Triclinic>::volume(void) const
+{
+    if (!Triclinic) {
+        return length(0) * length(1) * length(2);
+    }
+    return std::fabs(determinant(h));
+}
+
+/** ---- Box single vector operations -----------------------------------------
+ * Box<Type, Triclinic>::nearest
+ * @brief Return the nearest integers to the fractional coordinates s, with
+ * ties to even. The batch operations and the OpenCL kernels round the same
+ * way, so every path picks the same image at exactly half a cell vector.
+ */
+template<typename Type, bool Triclinic>
+core_inline
+vec3<Type> Box<Type, Triclinic>::nearest(const vec3<Type> &s)
+{
+    return vec3<Type>(
+        std::nearbyint(s(0)),
+        std::nearbyint(s(1)),
+        std::nearbyint(s(2)));
+}
+
+/**
+ * Box<Type, Triclinic>::min_image
+ * @brief Return the minimum image of the displacement d, using the matrix
+ * products of the geometry module.
+ */
+template<typename Type, bool Triclinic>
+core_inline
+vec3<Type> Box<Type, Triclinic>::min_image(const vec3<Type> &d) const
+{
+    if (!Triclinic) {
+        return d - length * nearest(d * inv_length);
+    }
+    vec3<Type> s = dot(h_inv, d);
+    return dot(h, s - nearest(s));
+}
+
+/**
+ * Box<Type, Triclinic>::wrap
+ * @brief Return the position r wrapped inside the cell.
+ */
+template<typename Type, bool Triclinic>
+core_inline
+vec3<Type> Box<Type, Triclinic>::wrap(const vec3<Type> &r) const
+{
+    vec3<Type> image((Type) 0);
+    return wrap(r, image);
+}
+
+template<typename Type, bool Triclinic>
+core_inline
+vec3<Type> Box<Type, Triclinic>::wrap(
+    const vec3<Type> &r,
+    vec3<Type> &image) const
+{
+    if (!Triclinic) {
+        vec3<Type> n = floor((r - origin) * inv_length);
+        image += n;
+        return r - length * n;
+    }
+    vec3<Type> s = dot(h_inv, r - origin);
+    vec3<Type> n = floor(s);
+    image += n;
+    return origin + dot(h, s - n);
+}
+
+/**
+ * Box<Type, Triclinic>::unwrap
+ * @brief Return the position r shifted back by its image counts.
+ */
+template<typename Type, bool Triclinic>
+core_inline
+vec3<Type> Box<Type, Triclinic>::unwrap(
+    const vec3<Type> &r,
+    const vec3<Type> &image) const
+{
+    if (!Triclinic) {
+        return r + length * image;
+    }
+    return r + dot(h, image);
+}
+
+/** ---- Box batch operations -------------------------------------------------
+ * @brief The batch operations of a box are free functions of the batch
+ * namespace, so the SIMD kernels can specialise them, or overload them for
+ * each instruction set in a dispatch build, see box-dispatch.hpp.
+ */
+namespace batch {
+
+/**
+ * min_image
+ * @brief Replace the n displacements (x,y,z) by their minimum images in
+ * the box.
+ */
+template<typename Type, bool Triclinic>
+inline core_dispatch
+void min_image(
+    const Box<Type, Triclinic> &box,
+    const size_t n,
+    Type *x,
+    Type *y,
+    Type *z)
+{
+    for (size_t i = 0; i < n; ++i) {
+        vec3<Type> d = box.min_image(vec3<Type>(x[i], y[i], z[i]));
+        x[i] = d(0);
+        y[i] = d(1);
+        z[i] = d(2);
+    }
+}
+
+/**
+ * wrap
+ * @brief Wrap the n positions (x,y,z) inside the box and add the number
+ * of cell vectors removed from each to its image counts (ix,iy,iz).
+ */
+template<typename Type, bool Triclinic>
+inline core_dispatch
+void wrap(
+    const Box<Type, Triclinic> &box,
+    const size_t n,
+    Type *x,
+    Type *y,
+    Type *z,
+    Type *ix,
+    Type *iy,
+    Type *iz)
+{
+    for (size_t i = 0; i < n; ++i) {
+        vec3<Type> image(ix[i], iy[i], iz[i]);
+        vec3<Type> r = box.wrap(vec3<Type>(x[i], y[i], z[i]), image);
+        x[i] = r(0);
+        y[i] = r(1);
+        z[i] = r(2);
+        ix[i] = image(0);
+        iy[i] = image(1);
+        iz[i] = image(2);
+    }
+}
+
+/**
+ * unwrap
+ * @brief Replace the n wrapped positions (x,y,z) by their unwrapped
+ * positions in the box given the image counts (ix,iy,iz).
+ */
+template<typename Type, bool Triclinic>
+inline core_dispatch
+void unwrap(
+    const Box<Type, Triclinic> &box,
+    const size_t n,
+    Type *x,
+    Type *y,
+    Type *z,
+    const Type *ix,
+    const Type *iy,
+    const Type *iz)
+{
+    for (size_t i = 0; i < n; ++i) {
+        vec3<Type> r = box.unwrap(
+            vec3<Type>(x[i], y[i], z[i]),
+            vec3<Type>(ix[i], iy[i], iz[i]));
+        x[i] = r(0);
+        y[i] = r(1);
+        z[i] = r(2);
+    }
+}
+
+} /* batch */
+
+} /* math */
+} /* atto */
+
+#if defined(ATTO_CORE_DISPATCH)
+#include "atto/math/geometry/box-dispatch.hpp"
+#elif defined(ATTO_MATH_SIMD)
+#include "atto/math/geometry/box-simd.hpp"
+#endif
+
+namespace atto {
+namespace math {
+
+/**
+ * Box<Type, Triclinic>::min_image
+ * @brief Replace the n displacements (x,y,z) by their minimum images.
+ */
+template<typename Type, bool Triclinic>
+core_inline
+void Box<Type, Triclinic>::min_image(
+    const size_t n,
+    Type *x,
+    Type *y,
+    Type *z) const
+{
+    batch::min_image(*this, n, x, y, z);
+}
+
+/**
+ * Box<Type, Triclinic>::wrap
+ * @brief Wrap the n positions (x,y,z) inside the cell and add the number
+ * of cell vectors removed from each to its image counts (ix,iy,iz).
+ */
+template<typename Type, bool Triclinic>
+core_inline
+void Box<Type, Triclinic>::wrap(
+    const size_t n,
+    Type *x,
+    Type *y,
+    Type *z,
+    Type *ix,
+    Type *iy,
+    Type *iz) const
+{
+    batch::wrap(*this, n, x, y, z, ix, iy, iz);
+}
+
+/**
+ * Box<Type, Triclinic>::unwrap
+ * @brief Replace the n wrapped positions (x,y,z) by their unwrapped
+ * positions given the image counts (ix,iy,iz).
+ */
+template<typename Type, bool Triclinic>
+core_inline
+void Box<Type, Triclinic>::unwrap(
+    const size_t n,
+    Type *x,
+    Type *y,
+    Type *z,
+    const Type *ix,
+    const Type *iy,
+    const Type *iz) const
+{
+    batch::unwrap(*this, n, x, y, z, ix, iy, iz);
+}
+
+} /* math */
+} /* atto */
+
+#endif /* ATTO_MATH_BOX_H_ */
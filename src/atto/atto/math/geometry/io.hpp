@@ -19,6 +19,7 @@
 #include "atto/math/geometry/mat2.hpp"
 #include "atto/math/geometry/mat3.hpp"
 #include "atto/math/geometry/mat4.hpp"
+#include "atto/math/geometry/quat.hpp"
 
 namespace atto {
 namespace math {
@@ -32,6 +33,7 @@ template<typename Type> struct vec4;
 template<typename Type> struct mat2;
 template<typename Type> struct mat3;
 template<typename Type> struct mat4;
+template<typename Type> struct quat;
 
 /** ---------------------------------------------------------------------------
  * @brief Vector and matrix output stream operators.
@@ -60,6 +62,14 @@ std::ostream &operator<< (std::ostream &os, const vec4<Type> &v)
     return os;
 }
 
+template<typename Type>
+core_inline
+std::ostream &operator<< (std::ostream &os, const quat<Type> &q)
+{
+    os << q(0) << " " << q(1) << " " << q(2) << " " << q(3) << "\n";
+    return os;
+}
+
 template<typename Type>
 core_inline
 std::ostream &operator<< (std::ostream &os, const mat2<Type> &a)
@@ -168,6 +178,23 @@ std::string to_string(const vec4<Type> &v, const char *format = nullptr)
     return ss.str();
 }
 
+template<typename Type>
+core_inline
+std::string to_string(const quat<Type> &q, const char *format = nullptr)
+{
+    using namespace atto::core;
+
+    std::string write_format =
+        (format != nullptr) ? " " + std::string(format)
+                            : " " + str_write_format<Type>();
+    std::ostringstream ss;
+    ss << str_format(write_format, q(0));
+    ss << str_format(write_format, q(1));
+    ss << str_format(write_format, q(2));
+    ss << str_format(write_format, q(3));
+    return ss.str();
+}
+
 template<typename Type>
 core_inline
 std::string to_string(const mat2<Type> &a, const char *format = nullptr)
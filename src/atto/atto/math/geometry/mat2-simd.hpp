@@ -172,6 +172,115 @@ mat2<double> &mat2<double>::operator/=(const double scalar)
     return *this;
 }
 
+/** ---- Single precision ----------------------------------------------------
+ * simd_load
+ * @brief Load 128-bits (4 packed single-precision 32-bit), the whole
+ * 2d-matrix in row major order (16-byte aligned).
+ */
+core_inline
+__m128 simd_load(const mat2<float> &mat)
+{
+    return _mm_load_ps(mat.data());
+}
+
+/**
+ * simd_store
+ * @brief Store 128-bits (4 packed single-precision 32-bit) into the whole
+ * 2d-matrix in row major order (16-byte aligned).
+ */
+core_inline
+void simd_store(mat2<float> &mat, const __m128 a)
+{
+    _mm_store_ps(mat.data(), a);
+}
+
+/** ---------------------------------------------------------------------------
+ * @brief Unary arithmetic matrix operators.
+ */
+template<>
+core_inline
+mat2<float> &mat2<float>::operator+=(const mat2<float> &other)
+{
+    const __m128 a = simd_load(*this);
+    const __m128 b = simd_load(other);
+    simd_store(*this, _mm_add_ps(a, b));
+    return *this;
+}
+
+template<>
+core_inline
+mat2<float> &mat2<float>::operator-=(const mat2<float> &other)
+{
+    const __m128 a = simd_load(*this);
+    const __m128 b = simd_load(other);
+    simd_store(*this, _mm_sub_ps(a, b));
+    return *this;
+}
+
+template<>
+core_inline
+mat2<float> &mat2<float>::operator*=(const mat2<float> &other)
+{
+    const __m128 a = simd_load(*this);
+    const __m128 b = simd_load(other);
+    simd_store(*this, _mm_mul_ps(a, b));
+    return *this;
+}
+
+template<>
+core_inline
+mat2<float> &mat2<float>::operator/=(const mat2<float> &other)
+{
+    const __m128 a = simd_load(*this);
+    const __m128 b = simd_load(other);
+    simd_store(*this, _mm_div_ps(a, b));
+    return *this;
+}
+
+
+/** ---------------------------------------------------------------------------
+ * @brief Unary arithmetic scalar operators.
+ */
+template<>
+core_inline
+mat2<float> &mat2<float>::operator+=(const float scalar)
+{
+    const __m128 a = simd_load(*this);
+    const __m128 b = _mm_set1_ps(scalar);
+    simd_store(*this, _mm_add_ps(a, b));
+    return *this;
+}
+
+template<>
+core_inline
+mat2<float> &mat2<float>::operator-=(const float scalar)
+{
+    const __m128 a = simd_load(*this);
+    const __m128 b = _mm_set1_ps(scalar);
+    simd_store(*this, _mm_sub_ps(a, b));
+    return *this;
+}
+
+template<>
+core_inline
+mat2<float> &mat2<float>::operator*=(const float scalar)
+{
+    const __m128 a = simd_load(*this);
+    const __m128 b = _mm_set1_ps(scalar);
+    simd_store(*this, _mm_mul_ps(a, b));
+    return *this;
+}
+
+template<>
+core_inline
+mat2<float> &mat2<float>::operator/=(const float scalar)
+{
+    const __m128 a = simd_load(*this);
+    const __m128 b = _mm_set1_ps(scalar);
+    simd_store(*this, _mm_div_ps(a, b));
+    return *this;
+}
+
 } /* math */
 } /* atto */
 
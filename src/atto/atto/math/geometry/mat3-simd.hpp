@@ -219,6 +219,169 @@ mat3<double> &mat3<double>::operator/=(const double scalar)
     return *this;
 }
 
+/** ---- Single precision ----------------------------------------------------
+ * simd_load
+ * @brief Load 96-bits (3 packed single-precision 32-bit)
+ * from the specified row in the 3d-matrix.
+ */
+core_inline
+__m128 simd_load(const mat3<float> &mat, const size_t row)
+{
+    const __m128i mask = _mm_set_epi32(0x0, -1, -1, -1);
+    return _mm_maskload_ps(mat.data() + row*mat.dim(), mask);
+}
+
+/**
+ * simd_store
+ * @brief Store 96-bits (3 packed single-precision 32-bit)
+ * into the specified row in the 3d-matrix.
+ */
+core_inline
+void simd_store(mat3<float> &mat, const size_t row, const __m128 a)
+{
+    const __m128i mask = _mm_set_epi32(0x0, -1, -1, -1);
+    _mm_maskstore_ps(mat.data() + row*mat.dim(), mask, a);
+}
+
+/** ---------------------------------------------------------------------------
+ * @brief Unary arithmetic matrix operators.
+ */
+template<>
+core_inline
+mat3<float> &mat3<float>::operator+=(const mat3<float> &other)
+{
+    const __m128 a0 = simd_load(*this, 0);
+    const __m128 a1 = simd_load(*this, 1);
+    const __m128 a2 = simd_load(*this, 2);
+
+    const __m128 b0 = simd_load(other, 0);
+    const __m128 b1 = simd_load(other, 1);
+    const __m128 b2 = simd_load(other, 2);
+
+    simd_store(*this, 0, _mm_add_ps(a0, b0));
+    simd_store(*this, 1, _mm_add_ps(a1, b1));
+    simd_store(*this, 2, _mm_add_ps(a2, b2));
+    return *this;
+}
+
+template<>
+core_inline
+mat3<float> &mat3<float>::operator-=(const mat3<float> &other)
+{
+    const __m128 a0 = simd_load(*this, 0);
+    const __m128 a1 = simd_load(*this, 1);
+    const __m128 a2 = simd_load(*this, 2);
+
+    const __m128 b0 = simd_load(other, 0);
+    const __m128 b1 = simd_load(other, 1);
+    const __m128 b2 = simd_load(other, 2);
+
+    simd_store(*this, 0, _mm_sub_ps(a0, b0));
+    simd_store(*this, 1, _mm_sub_ps(a1, b1));
+    simd_store(*this, 2, _mm_sub_ps(a2, b2));
+    return *this;
+}
+
+template<>
+core_inline
+mat3<float> &mat3<float>::operator*=(const mat3<float> &other)
+{
+    const __m128 a0 = simd_load(*this, 0);
+    const __m128 a1 = simd_load(*this, 1);
+    const __m128 a2 = simd_load(*this, 2);
+
+    const __m128 b0 = simd_load(other, 0);
+    const __m128 b1 = simd_load(other, 1);
+    const __m128 b2 = simd_load(other, 2);
+
+    simd_store(*this, 0, _mm_mul_ps(a0, b0));
+    simd_store(*this, 1, _mm_mul_ps(a1, b1));
+    simd_store(*this, 2, _mm_mul_ps(a2, b2));
+    return *this;
+}
+
+template<>
+core_inline
+mat3<float> &mat3<float>::operator/=(const mat3<float> &other)
+{
+    const __m128 a0 = simd_load(*this, 0);
+    const __m128 a1 = simd_load(*this, 1);
+    const __m128 a2 = simd_load(*this, 2);
+
+    const __m128 b0 = simd_load(other, 0);
+    const __m128 b1 = simd_load(other, 1);
+    const __m128 b2 = simd_load(other, 2);
+
+    simd_store(*this, 0, _mm_div_ps(a0, b0));
+    simd_store(*this, 1, _mm_div_ps(a1, b1));
+    simd_store(*this, 2, _mm_div_ps(a2, b2));
+    return *this;
+}
+
+
+/** ---------------------------------------------------------------------------
+ * @brief Unary arithmetic scalar operators.
+ */
+template<>
+core_inline
+mat3<float> &mat3<float>::operator+=(const float scalar)
+{
+    const __m128 a0 = simd_load(*this, 0);
+    const __m128 a1 = simd_load(*this, 1);
+    const __m128 a2 = simd_load(*this, 2);
+    const __m128 b = _mm_set1_ps(scalar);
+
+    simd_store(*this, 0, _mm_add_ps(a0, b));
+    simd_store(*this, 1, _mm_add_ps(a1, b));
+    simd_store(*this, 2, _mm_add_ps(a2, b));
+    return *this;
+}
+
+template<>
+core_inline
+mat3<float> &mat3<float>::operator-=(const float scalar)
+{
+    const __m128 a0 = simd_load(*this, 0);
+    const __m128 a1 = simd_load(*this, 1);
+    const __m128 a2 = simd_load(*this, 2);
+    const __m128 b = _mm_set1_ps(scalar);
+
+    simd_store(*this, 0, _mm_sub_ps(a0, b));
+    simd_store(*this, 1, _mm_sub_ps(a1, b));
+    simd_store(*this, 2, _mm_sub_ps(a2, b));
+    return *this;
+}
+
+template<>
+core_inline
+mat3<float> &mat3<float>::operator*=(const float scalar)
+{
+    const __m128 a0 = simd_load(*this, 0);
+    const __m128 a1 = simd_load(*this, 1);
+    const __m128 a2 = simd_load(*this, 2);
+    const __m128 b = _mm_set1_ps(scalar);
+
+    simd_store(*this, 0, _mm_mul_ps(a0, b));
+    simd_store(*this, 1, _mm_mul_ps(a1, b));
+    simd_store(*this, 2, _mm_mul_ps(a2, b));
+    return *this;
+}
+
+template<>
+core_inline
+mat3<float> &mat3<float>::operator/=(const float scalar)
+{
+    const __m128 a0 = simd_load(*this, 0);
+    const __m128 a1 = simd_load(*this, 1);
+    const __m128 a2 = simd_load(*this, 2);
+    const __m128 b = _mm_set1_ps(scalar);
+
+    simd_store(*this, 0, _mm_div_ps(a0, b));
+    simd_store(*this, 1, _mm_div_ps(a1, b));
+    simd_store(*this, 2, _mm_div_ps(a2, b));
+    return *this;
+}
+
 } /* math */
 } /* atto */
 
@@ -39,6 +39,30 @@ void simd_store(mat4<double> &mat, const size_t row, const __m256d a)
     _mm256_store_pd(mat.data() + row*mat.dim(), a);
 }
 
+#ifdef ATTO_MATH_SIMD512
+/**
+ * simd512_load
+ * @brief Load 512-bits (8 packed double precision 64-bit) from the
+ * specified pair of rows {2*pair, 2*pair+1} in the 4d-matrix.
+ */
+core_inline
+__m512d simd512_load(const mat4<double> &mat, const size_t pair)
+{
+    return _mm512_loadu_pd(mat.data() + 2*pair*mat.dim());
+}
+
+/**
+ * simd512_store
+ * @brief Store 512-bits (8 packed double precision 64-bit) into the
+ * specified pair of rows {2*pair, 2*pair+1} in the 4d-matrix.
+ */
+core_inline
+void simd512_store(mat4<double> &mat, const size_t pair, const __m512d a)
+{
+    _mm512_storeu_pd(mat.data() + 2*pair*mat.dim(), a);
+}
+#endif  /* ATTO_MATH_SIMD512 */
+
 
 /** ---------------------------------------------------------------------------
  * @brief Unary arithmetic matrix operators.
@@ -199,6 +223,187 @@ mat4<double> &mat4<double>::operator/=(const double scalar)
     return *this;
 }
 
+/** ---- Single precision ----------------------------------------------------
+ * simd_load
+ * @brief Load 128-bits (4 packed single-precision 32-bit)
+ * from the specified row in the 4d-matrix (16-byte aligned).
+ */
+core_inline
+__m128 simd_load(const mat4<float> &mat, const size_t row)
+{
+    return _mm_load_ps(mat.data() + row*mat.dim());
+}
+
+/**
+ * simd_store
+ * @brief Store 128-bits (4 packed single-precision 32-bit)
+ * into the specified row in the 4d-matrix (16-byte aligned).
+ */
+core_inline
+void simd_store(mat4<float> &mat, const size_t row, const __m128 a)
+{
+    _mm_store_ps(mat.data() + row*mat.dim(), a);
+}
+
+/** ---------------------------------------------------------------------------
+ * @brief Unary arithmetic matrix operators.
+ */
+template<>
+core_inline
+mat4<float> &mat4<float>::operator+=(const mat4<float> &other)
+{
+    const __m128 a0 = simd_load(*this, 0);
+    const __m128 a1 = simd_load(*this, 1);
+    const __m128 a2 = simd_load(*this, 2);
+    const __m128 a3 = simd_load(*this, 3);
+
+    const __m128 b0 = simd_load(other, 0);
+    const __m128 b1 = simd_load(other, 1);
+    const __m128 b2 = simd_load(other, 2);
+    const __m128 b3 = simd_load(other, 3);
+
+    simd_store(*this, 0, _mm_add_ps(a0, b0));
+    simd_store(*this, 1, _mm_add_ps(a1, b1));
+    simd_store(*this, 2, _mm_add_ps(a2, b2));
+    simd_store(*this, 3, _mm_add_ps(a3, b3));
+    return *this;
+}
+
+template<>
+core_inline
+mat4<float> &mat4<float>::operator-=(const mat4<float> &other)
+{
+    const __m128 a0 = simd_load(*this, 0);
+    const __m128 a1 = simd_load(*this, 1);
+    const __m128 a2 = simd_load(*this, 2);
+    const __m128 a3 = simd_load(*this, 3);
+
+    const __m128 b0 = simd_load(other, 0);
+    const __m128 b1 = simd_load(other, 1);
+    const __m128 b2 = simd_load(other, 2);
+    const __m128 b3 = simd_load(other, 3);
+
+    simd_store(*this, 0, _mm_sub_ps(a0, b0));
+    simd_store(*this, 1, _mm_sub_ps(a1, b1));
+    simd_store(*this, 2, _mm_sub_ps(a2, b2));
+    simd_store(*this, 3, _mm_sub_ps(a3, b3));
+    return *this;
+}
+
+template<>
+core_inline
+mat4<float> &mat4<float>::operator*=(const mat4<float> &other)
+{
+    const __m128 a0 = simd_load(*this, 0);
+    const __m128 a1 = simd_load(*this, 1);
+    const __m128 a2 = simd_load(*this, 2);
+    const __m128 a3 = simd_load(*this, 3);
+
+    const __m128 b0 = simd_load(other, 0);
+    const __m128 b1 = simd_load(other, 1);
+    const __m128 b2 = simd_load(other, 2);
+    const __m128 b3 = simd_load(other, 3);
+
+    simd_store(*this, 0, _mm_mul_ps(a0, b0));
+    simd_store(*this, 1, _mm_mul_ps(a1, b1));
+    simd_store(*this, 2, _mm_mul_ps(a2, b2));
+    simd_store(*this, 3, _mm_mul_ps(a3, b3));
+    return *this;
+}
+
+template<>
+core_inline
+mat4<float> &mat4<float>::operator/=(const mat4<float> &other)
+{
+    const __m128 a0 = simd_load(*this, 0);
+    const __m128 a1 = simd_load(*this, 1);
+    const __m128 a2 = simd_load(*this, 2);
+    const __m128 a3 = simd_load(*this, 3);
+
+    const __m128 b0 = simd_load(other, 0);
+    const __m128 b1 = simd_load(other, 1);
+    const __m128 b2 = simd_load(other, 2);
+    const __m128 b3 = simd_load(other, 3);
+
+    simd_store(*this, 0, _mm_div_ps(a0, b0));
+    simd_store(*this, 1, _mm_div_ps(a1, b1));
+    simd_store(*this, 2, _mm_div_ps(a2, b2));
+    simd_store(*this, 3, _mm_div_ps(a3, b3));
+    return *this;
+}
+
+
+/** ---------------------------------------------------------------------------
+ * @brief Unary arithmetic scalar operators.
+ */
+template<>
+core_inline
+mat4<float> &mat4<float>::operator+=(const float scalar)
+{
+    const __m128 a0 = simd_load(*this, 0);
+    const __m128 a1 = simd_load(*this, 1);
+    const __m128 a2 = simd_load(*this, 2);
+    const __m128 a3 = simd_load(*this, 3);
+    const __m128 b = _mm_set1_ps(scalar);
+
+    simd_store(*this, 0, _mm_add_ps(a0, b));
+    simd_store(*this, 1, _mm_add_ps(a1, b));
+    simd_store(*this, 2, _mm_add_ps(a2, b));
+    simd_store(*this, 3, _mm_add_ps(a3, b));
+    return *this;
+}
+
+template<>
+core_inline
+mat4<float> &mat4<float>::operator-=(const float scalar)
+{
+    const __m128 a0 = simd_load(*this, 0);
+    const __m128 a1 = simd_load(*this, 1);
+    const __m128 a2 = simd_load(*this, 2);
+    const __m128 a3 = simd_load(*this, 3);
+    const __m128 b = _mm_set1_ps(scalar);
+
+    simd_store(*this, 0, _mm_sub_ps(a0, b));
+    simd_store(*this, 1, _mm_sub_ps(a1, b));
+    simd_store(*this, 2, _mm_sub_ps(a2, b));
+    simd_store(*this, 3, _mm_sub_ps(a3, b));
+    return *this;
+}
+
+template<>
+core_inline
+mat4<float> &mat4<float>::operator*=(const float scalar)
+{
+    const __m128 a0 = simd_load(*this, 0);
+    const __m128 a1 = simd_load(*this, 1);
+    const __m128 a2 = simd_load(*this, 2);
+    const __m128 a3 = simd_load(*this, 3);
+    const __m128 b = _mm_set1_ps(scalar);
+
+    simd_store(*this, 0, _mm_mul_ps(a0, b));
+    simd_store(*this, 1, _mm_mul_ps(a1, b));
+    simd_store(*this, 2, _mm_mul_ps(a2, b));
+    simd_store(*this, 3, _mm_mul_ps(a3, b));
+    return *this;
+}
+
+template<>
+core_inline
+mat4<float> &mat4<float>::operator/=(const float scalar)
+{
+    const __m128 a0 = simd_load(*this, 0);
+    const __m128 a1 = simd_load(*this, 1);
+    const __m128 a2 = simd_load(*this, 2);
+    const __m128 a3 = simd_load(*this, 3);
+    const __m128 b = _mm_set1_ps(scalar);
+
+    simd_store(*this, 0, _mm_div_ps(a0, b));
+    simd_store(*this, 1, _mm_div_ps(a1, b));
+    simd_store(*this, 2, _mm_div_ps(a2, b));
+    simd_store(*this, 3, _mm_div_ps(a3, b));
+    return *this;
+}
+
 } /* math */
 } /* atto */
 
@@ -0,0 +1,563 @@
+/*
+ * quat-simd.hpp
+ *
+ * Copyright (c) 2020 Carlos Braga
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the MIT License.
+ *
+ * See accompanying LICENSE.md or https://opensource.org/licenses/MIT.
+ */
+
+#ifndef ATTO_MATH_GEOMETRY_QUAT_SIMD_H_
+#define ATTO_MATH_GEOMETRY_QUAT_SIMD_H_
+
+#include "atto/math/geometry/simd.hpp"
+
+namespace atto {
+namespace math {
+
+/** ---- simd load/store functions --------------------------------------------
+ * simd_load
+ * @brief Load 256-bits (4 packed double precision 64-bit)
+ * from the quaternion (32-byte aligned).
+ */
+core_inline
+__m256d simd_load(const quat<double> &q)
+{
+    return _mm256_load_pd(q.data());
+}
+
+/**
+ * simd_store
+ * @brief Store 256-bits (4 packed double precision 64-bit)
+ * into the quaternion (32-byte aligned).
+ */
+core_inline
+void simd_store(quat<double> &q, const __m256d a)
+{
+    _mm256_store_pd(q.data(), a);
+}
+
+/**
+ * simd256_qmul_
+ * @brief Hamilton product of two quaternions {w, z, y, x}, as the sum of
+ * the broadcast elements of a times the permuted and sign-flipped
+ * elements of b,
+ *  r = a_w * {bw,  bz,  by,  bx}
+ *    + a_x * {-bx, by, -bz,  bw}
+ *    + a_y * {-by, -bx, bw,  bz}
+ *    + a_z * {-bz,  bw, bx, -by}
+ */
+core_inline
+__m256d simd256_qmul_(__m256d a, __m256d b)
+{
+    /*
+     * lo = {a1, a0, a1, a0}, hi = {a3, a2, a3, a2}
+     */
+    const __m256d lo = _mm256_permute2f128_pd(a, a, core_extension(0x00));
+    const __m256d hi = _mm256_permute2f128_pd(a, a, core_extension(0x11));
+    const __m256d a_x = _mm256_permute_pd(lo, core_extension(0b0000));
+    const __m256d a_y = _mm256_permute_pd(lo, core_extension(0b1111));
+    const __m256d a_z = _mm256_permute_pd(hi, core_extension(0b0000));
+    const __m256d a_w = _mm256_permute_pd(hi, core_extension(0b1111));
+    /*
+     * b2 = {b1, b0, b3, b2}
+     * b3 = {b2, b3, b0, b1}
+     * b1 = {b0, b1, b2, b3}
+     */
+    const __m256d b2 = _mm256_permute2f128_pd(b, b, core_extension(0b0001));
+    const __m256d b3 = _mm256_permute_pd(b, core_extension(0b0101));
+    const __m256d b1 = _mm256_permute_pd(b2, core_extension(0b0101));
+    const __m256d s1 = _mm256_set_pd(-0.0,  0.0, -0.0,  0.0);
+    const __m256d s2 = _mm256_set_pd(-0.0, -0.0,  0.0,  0.0);
+    const __m256d s3 = _mm256_set_pd(-0.0,  0.0,  0.0, -0.0);
+
+    __m256d r = _mm256_mul_pd(a_w, b);
+    r = simd256_fmadd_(a_x, _mm256_xor_pd(b1, s1), r);
+    r = simd256_fmadd_(a_y, _mm256_xor_pd(b2, s2), r);
+    r = simd256_fmadd_(a_z, _mm256_xor_pd(b3, s3), r);
+    return r;
+}
+
+
+/** ---------------------------------------------------------------------------
+ * @brief Unary arithmetic quaternion operators.
+ */
+template<>
+core_inline
+quat<double> &quat<double>::operator+=(const quat<double> &other)
+{
+    const __m256d a = simd_load(*this);
+    const __m256d b = simd_load(other);
+    simd_store(*this, _mm256_add_pd(a, b));
+    return *this;
+}
+
+template<>
+core_inline
+quat<double> &quat<double>::operator-=(const quat<double> &other)
+{
+    const __m256d a = simd_load(*this);
+    const __m256d b = simd_load(other);
+    simd_store(*this, _mm256_sub_pd(a, b));
+    return *this;
+}
+
+template<>
+core_inline
+quat<double> &quat<double>::operator*=(const quat<double> &other)
+{
+    const __m256d a = simd_load(*this);
+    const __m256d b = simd_load(other);
+    simd_store(*this, simd256_qmul_(a, b));
+    return *this;
+}
+
+
+/** ---------------------------------------------------------------------------
+ * @brief Unary arithmetic scalar operators.
+ */
+template<>
+core_inline
+quat<double> &quat<double>::operator*=(const double scalar)
+{
+    const __m256d a = simd_load(*this);
+    const __m256d b = _mm256_set1_pd(scalar);
+    simd_store(*this, _mm256_mul_pd(a, b));
+    return *this;
+}
+
+template<>
+core_inline
+quat<double> &quat<double>::operator/=(const double scalar)
+{
+    const __m256d a = simd_load(*this);
+    const __m256d b = _mm256_set1_pd(scalar);
+    simd_store(*this, _mm256_div_pd(a, b));
+    return *this;
+}
+
+
+/** ---------------------------------------------------------------------------
+ * dot
+ * @brief Return the 4-dimensional dot product of two quaternions.
+ */
+template<>
+core_inline
+double dot(const quat<double> &a, const quat<double> &b)
+{
+    return _mm256_cvtsd_f64(simd256_dot_(simd_load(a), simd_load(b)));
+}
+
+/**
+ * norm
+ * @brief Return the norm of the quaternion.
+ */
+template<>
+core_inline
+double norm(const quat<double> &q)
+{
+    return _mm256_cvtsd_f64(simd256_norm_(simd_load(q)));
+}
+
+/**
+ * normalize
+ * @brief Return the unit quaternion q / |q|.
+ */
+template<>
+core_inline
+quat<double> normalize(const quat<double> &q)
+{
+    quat<double> result{};
+    simd_store(result, simd256_normalize_(simd_load(q)));
+    return result;
+}
+
+/**
+ * conjugate
+ * @brief Return the conjugate quaternion, flipping the sign bits of the
+ * vector part.
+ */
+template<>
+core_inline
+quat<double> conjugate(const quat<double> &q)
+{
+    const __m256d sign = _mm256_set_pd(0.0, -0.0, -0.0, -0.0);
+    quat<double> result{};
+    simd_store(result, _mm256_xor_pd(simd_load(q), sign));
+    return result;
+}
+
+
+/** ---------------------------------------------------------------------------
+ * rotate
+ * @brief Rotate the vector v by the unit quaternion q,
+ *  t = 2 u x v, v' = v + w t + u x t.
+ * The vector loads with a zero fourth element, so the scalar part of q
+ * drops out of both cross products.
+ */
+template<>
+core_inline
+vec3<double> rotate(const quat<double> &q, const vec3<double> &v)
+{
+    const __m256d u = simd_load(q);
+    const __m256d a = simd_load(v);
+    const __m256d t = simd256_cross_(_mm256_add_pd(u, u), a);
+    const __m256d r = _mm256_add_pd(
+        simd256_fmadd_(_mm256_set1_pd(q.w), t, a),
+        simd256_cross_(u, t));
+
+    vec3<double> result{};
+    simd_store(result, r);
+    return result;
+}
+
+
+/** ---------------------------------------------------------------------------
+ * slerp
+ * @brief Spherical linear interpolation between the unit quaternions a and b
+ * at t in [0,1], along the shortest arc.
+ */
+template<>
+core_inline
+quat<double> slerp(
+    const quat<double> &a,
+    const quat<double> &b,
+    const double t)
+{
+    static constexpr double threshold =
+        1.0 - std::numeric_limits<double>::epsilon();
+
+    const __m256d a_ = simd_load(a);
+    __m256d b_ = simd_load(b);
+    double cos_theta = _mm256_cvtsd_f64(simd256_dot_(a_, b_));
+    if (cos_theta < 0.0) {
+        b_ = _mm256_xor_pd(b_, _mm256_set1_pd(-0.0));
+        cos_theta = -cos_theta;
+    }
+
+    quat<double> result{};
+    if (cos_theta > threshold) {
+        const __m256d c = simd256_fmadd_(
+            _mm256_set1_pd(t), _mm256_sub_pd(b_, a_), a_);
+        simd_store(result, simd256_normalize_(c));
+        return result;
+    }
+
+    const double theta = std::acos(cos_theta);
+    const double inv_sin = 1.0 / std::sin(theta);
+    const __m256d w_a = _mm256_set1_pd(std::sin((1.0 - t) * theta) * inv_sin);
+    const __m256d w_b = _mm256_set1_pd(std::sin(t * theta) * inv_sin);
+    simd_store(result, simd256_fmadd_(w_a, a_, _mm256_mul_pd(w_b, b_)));
+    return result;
+}
+
+
+/** ---------------------------------------------------------------------------
+ * to_mat3
+ * @brief Return the rotation matrix of the unit quaternion q, with each row
+ *  r_i = s e_i + 2 u_i u + 2 w c_i,
+ * where s = w^2 - u.u and c_i is the i-th row of the cross product
+ * matrix [u]x. The fourth element of each row is not stored.
+ */
+template<>
+core_inline
+mat3<double> to_mat3(const quat<double> &q)
+{
+    const __m256d u = simd_load(q);
+    const __m256d u2 = _mm256_add_pd(u, u);
+    const __m256d w2 = _mm256_set1_pd(2.0 * q.w);
+    /*
+     * s = {w^2 - u.u, w^2 - u.u, w^2 - u.u, w^2 - u.u}
+     */
+    const __m256d sign = _mm256_set_pd(0.0, -0.0, -0.0, -0.0);
+    const __m256d s = simd256_dot_(u, _mm256_xor_pd(u, sign));
+    const __m256d zero = _mm256_setzero_pd();
+    /*
+     * c0 = {0,  y, -z,  0}
+     * c1 = {0, -x,  0,  z}
+     * c2 = {0,  0,  x, -y}
+     */
+    const __m256d c0 = _mm256_set_pd(0.0,  q.y, -q.z,  0.0);
+    const __m256d c1 = _mm256_set_pd(0.0, -q.x,  0.0,  q.z);
+    const __m256d c2 = _mm256_set_pd(0.0,  0.0,  q.x, -q.y);
+    /*
+     * u2_i = {2 u_i, 2 u_i, 2 u_i, 2 u_i}
+     */
+    const __m256d lo = _mm256_permute2f128_pd(u2, u2, core_extension(0x00));
+    const __m256d hi = _mm256_permute2f128_pd(u2, u2, core_extension(0x11));
+    const __m256d u2_x = _mm256_permute_pd(lo, core_extension(0b0000));
+    const __m256d u2_y = _mm256_permute_pd(lo, core_extension(0b1111));
+    const __m256d u2_z = _mm256_permute_pd(hi, core_extension(0b0000));
+
+    mat3<double> result{};
+    simd_store(result, 0, simd256_fmadd_(u2_x, u, simd256_fmadd_(
+        w2, c0, _mm256_blend_pd(zero, s, core_extension(0b0001)))));
+    simd_store(result, 1, simd256_fmadd_(u2_y, u, simd256_fmadd_(
+        w2, c1, _mm256_blend_pd(zero, s, core_extension(0b0010)))));
+    simd_store(result, 2, simd256_fmadd_(u2_z, u, simd256_fmadd_(
+        w2, c2, _mm256_blend_pd(zero, s, core_extension(0b0100)))));
+    return result;
+}
+
+
+/** ---- Single precision ----------------------------------------------------
+ * simd_load
+ * @brief Load 128-bits (4 packed single-precision 32-bit)
+ * from the quaternion (16-byte aligned).
+ */
+core_inline
+__m128 simd_load(const quat<float> &q)
+{
+    return _mm_load_ps(q.data());
+}
+
+/**
+ * simd_store
+ * @brief Store 128-bits (4 packed single-precision 32-bit)
+ * into the quaternion (16-byte aligned).
+ */
+core_inline
+void simd_store(quat<float> &q, const __m128 a)
+{
+    _mm_store_ps(q.data(), a);
+}
+
+/**
+ * simd128_qmul_
+ * @brief Hamilton product of two quaternions {w, z, y, x}, as the sum of
+ * the broadcast elements of a times the permuted and sign-flipped
+ * elements of b.
+ */
+core_inline
+__m128 simd128_qmul_(__m128 a, __m128 b)
+{
+    const __m128 a_x = _mm_shuffle_ps(a, a, _MM_SHUFFLE(0, 0, 0, 0));
+    const __m128 a_y = _mm_shuffle_ps(a, a, _MM_SHUFFLE(1, 1, 1, 1));
+    const __m128 a_z = _mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 2, 2, 2));
+    const __m128 a_w = _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 3, 3, 3));
+    /*
+     * b1 = {b0, b1, b2, b3}
+     * b2 = {b1, b0, b3, b2}
+     * b3 = {b2, b3, b0, b1}
+     */
+    const __m128 b1 = _mm_shuffle_ps(b, b, _MM_SHUFFLE(0, 1, 2, 3));
+    const __m128 b2 = _mm_shuffle_ps(b, b, _MM_SHUFFLE(1, 0, 3, 2));
+    const __m128 b3 = _mm_shuffle_ps(b, b, _MM_SHUFFLE(2, 3, 0, 1));
+    const __m128 s1 = _mm_set_ps(-0.0f,  0.0f, -0.0f,  0.0f);
+    const __m128 s2 = _mm_set_ps(-0.0f, -0.0f,  0.0f,  0.0f);
+    const __m128 s3 = _mm_set_ps(-0.0f,  0.0f,  0.0f, -0.0f);
+
+    __m128 r = _mm_mul_ps(a_w, b);
+    r = simd128_fmadd_(a_x, _mm_xor_ps(b1, s1), r);
+    r = simd128_fmadd_(a_y, _mm_xor_ps(b2, s2), r);
+    r = simd128_fmadd_(a_z, _mm_xor_ps(b3, s3), r);
+    return r;
+}
+
+
+/** ---------------------------------------------------------------------------
+ * @brief Unary arithmetic quaternion operators.
+ */
+template<>
+core_inline
+quat<float> &quat<float>::operator+=(const quat<float> &other)
+{
+    const __m128 a = simd_load(*this);
+    const __m128 b = simd_load(other);
+    simd_store(*this, _mm_add_ps(a, b));
+    return *this;
+}
+
+template<>
+core_inline
+quat<float> &quat<float>::operator-=(const quat<float> &other)
+{
+    const __m128 a = simd_load(*this);
+    const __m128 b = simd_load(other);
+    simd_store(*this, _mm_sub_ps(a, b));
+    return *this;
+}
+
+template<>
+core_inline
+quat<float> &quat<float>::operator*=(const quat<float> &other)
+{
+    const __m128 a = simd_load(*this);
+    const __m128 b = simd_load(other);
+    simd_store(*this, simd128_qmul_(a, b));
+    return *this;
+}
+
+
+/** ---------------------------------------------------------------------------
+ * @brief Unary arithmetic scalar operators.
+ */
+template<>
+core_inline
+quat<float> &quat<float>::operator*=(const float scalar)
+{
+    const __m128 a = simd_load(*this);
+    const __m128 b = _mm_set1_ps(scalar);
+    simd_store(*this, _mm_mul_ps(a, b));
+    return *this;
+}
+
+template<>
+core_inline
+quat<float> &quat<float>::operator/=(const float scalar)
+{
+    const __m128 a = simd_load(*this);
+    const __m128 b = _mm_set1_ps(scalar);
+    simd_store(*this, _mm_div_ps(a, b));
+    return *this;
+}
+
+
+/** ---------------------------------------------------------------------------
+ * dot
+ * @brief Return the 4-dimensional dot product of two quaternions.
+ */
+template<>
+core_inline
+float dot(const quat<float> &a, const quat<float> &b)
+{
+    return _mm_cvtss_f32(simd128_dot_(simd_load(a), simd_load(b)));
+}
+
+/**
+ * norm
+ * @brief Return the norm of the quaternion.
+ */
+template<>
+core_inline
+float norm(const quat<float> &q)
+{
+    return _mm_cvtss_f32(simd128_norm_(simd_load(q)));
+}
+
+/**
+ * normalize
+ * @brief Return the unit quaternion q / |q|.
+ */
+template<>
+core_inline
+quat<float> normalize(const quat<float> &q)
+{
+    quat<float> result{};
+    simd_store(result, simd128_normalize_(simd_load(q)));
+    return result;
+}
+
+/**
+ * conjugate
+ * @brief Return the conjugate quaternion, flipping the sign bits of the
+ * vector part.
+ */
+template<>
+core_inline
+quat<float> conjugate(const quat<float> &q)
+{
+    const __m128 sign = _mm_set_ps(0.0f, -0.0f, -0.0f, -0.0f);
+    quat<float> result{};
+    simd_store(result, _mm_xor_ps(simd_load(q), sign));
+    return result;
+}
+
+
+/** ---------------------------------------------------------------------------
+ * rotate
+ * @brief Rotate the vector v by the unit quaternion q,
+ *  t = 2 u x v, v' = v + w t + u x t.
+ */
+template<>
+core_inline
+vec3<float> rotate(const quat<float> &q, const vec3<float> &v)
+{
+    const __m128 u = simd_load(q);
+    const __m128 a = simd_load(v);
+    const __m128 t = simd128_cross_(_mm_add_ps(u, u), a);
+    const __m128 r = _mm_add_ps(
+        simd128_fmadd_(_mm_set1_ps(q.w), t, a),
+        simd128_cross_(u, t));
+
+    vec3<float> result{};
+    simd_store(result, r);
+    return result;
+}
+
+
+/** ---------------------------------------------------------------------------
+ * slerp
+ * @brief Spherical linear interpolation between the unit quaternions a and b
+ * at t in [0,1], along the shortest arc.
+ */
+template<>
+core_inline
+quat<float> slerp(const quat<float> &a, const quat<float> &b, const float t)
+{
+    static constexpr float threshold =
+        1.0f - std::numeric_limits<float>::epsilon();
+
+    const __m128 a_ = simd_load(a);
+    __m128 b_ = simd_load(b);
+    float cos_theta = _mm_cvtss_f32(simd128_dot_(a_, b_));
+    if (cos_theta < 0.0f) {
+        b_ = _mm_xor_ps(b_, _mm_set1_ps(-0.0f));
+        cos_theta = -cos_theta;
+    }
+
+    quat<float> result{};
+    if (cos_theta > threshold) {
+        const __m128 c = simd128_fmadd_(
+            _mm_set1_ps(t), _mm_sub_ps(b_, a_), a_);
+        simd_store(result, simd128_normalize_(c));
+        return result;
+    }
+
+    const float theta = std::acos(cos_theta);
+    const float inv_sin = 1.0f / std::sin(theta);
+    const __m128 w_a = _mm_set1_ps(std::sin((1.0f - t) * theta) * inv_sin);
+    const __m128 w_b = _mm_set1_ps(std::sin(t * theta) * inv_sin);
+    simd_store(result, simd128_fmadd_(w_a, a_, _mm_mul_ps(w_b, b_)));
+    return result;
+}
+
+
+/** ---------------------------------------------------------------------------
+ * to_mat3
+ * @brief Return the rotation matrix of the unit quaternion q, with each row
+ *  r_i = s e_i + 2 u_i u + 2 w c_i.
+ */
+template<>
+core_inline
+mat3<float> to_mat3(const quat<float> &q)
+{
+    const __m128 u = simd_load(q);
+    const __m128 u2 = _mm_add_ps(u, u);
+    const __m128 w2 = _mm_set1_ps(2.0f * q.w);
+    const __m128 sign = _mm_set_ps(0.0f, -0.0f, -0.0f, -0.0f);
+    const __m128 s = simd128_dot_(u, _mm_xor_ps(u, sign));
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 c0 = _mm_set_ps(0.0f,  q.y, -q.z,  0.0f);
+    const __m128 c1 = _mm_set_ps(0.0f, -q.x,  0.0f,  q.z);
+    const __m128 c2 = _mm_set_ps(0.0f,  0.0f,  q.x, -q.y);
+    const __m128 u2_x = _mm_shuffle_ps(u2, u2, _MM_SHUFFLE(0, 0, 0, 0));
+    const __m128 u2_y = _mm_shuffle_ps(u2, u2, _MM_SHUFFLE(1, 1, 1, 1));
+    const __m128 u2_z = _mm_shuffle_ps(u2, u2, _MM_SHUFFLE(2, 2, 2, 2));
+
+    mat3<float> result{};
+    simd_store(result, 0, simd128_fmadd_(u2_x, u, simd128_fmadd_(
+        w2, c0, _mm_blend_ps(zero, s, core_extension(0b0001)))));
+    simd_store(result, 1, simd128_fmadd_(u2_y, u, simd128_fmadd_(
+        w2, c1, _mm_blend_ps(zero, s, core_extension(0b0010)))));
+    simd_store(result, 2, simd128_fmadd_(u2_z, u, simd128_fmadd_(
+        w2, c2, _mm_blend_ps(zero, s, core_extension(0b0100)))));
+    return result;
+}
+
+} /* math */
+} /* atto */
+
+#endif /* ATTO_MATH_GEOMETRY_QUAT_SIMD_H_ */
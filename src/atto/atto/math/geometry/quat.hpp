@@ -0,0 +1,456 @@
+/*
+ * quat.hpp
+ *
+ * Copyright (c) 2020 Carlos Braga
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the MIT License.
+ *
+ * See accompanying LICENSE.md or https://opensource.org/licenses/MIT.
+ */
+
+#ifndef ATTO_MATH_GEOMETRY_QUAT_H_
+#define ATTO_MATH_GEOMETRY_QUAT_H_
+
+#include "atto/math/geometry/vec3.hpp"
+#include "atto/math/geometry/mat3.hpp"
+
+namespace atto {
+namespace math {
+
+/** ---------------------------------------------------------------------------
+ * quat
+ * @brief A templated quaternion type q = w + x i + y j + z k.
+ *
+ * The vector part (x, y, z) is stored first and the scalar part w last,
+ * so the vector part of a quaternion and a vec3 occupy the same register
+ * lanes. A unit quaternion represents the rotation by an angle theta
+ * around an axis n as q = (sin(theta/2) n, cos(theta/2)).
+ */
+template<typename Type> struct vec3;
+template<typename Type> struct mat3;
+template<typename Type> struct quat;
+
+template<typename Type>
+struct quat {
+    /* Types */
+    typedef std::size_t size_type;
+    typedef Type        value_type;
+    typedef Type&       reference;
+    typedef const Type& const_reference;
+
+    /* Member variables/accessors. */
+    static const size_type m_length = 4;
+
+    union {
+        value_type m_data[m_length] core_aligned(32);
+        struct { value_type s0, s1, s2, s3; };
+        struct { value_type x, y, z, w; };
+    };
+
+    size_type length(void) const { return m_length; }
+    size_type size(void) const { return sizeof(m_data); }
+
+    /* Element access. */
+    value_type *data(void) { return m_data; }
+    const value_type *data(void) const { return m_data; }
+
+    reference operator()(size_type i) { return m_data[i]; }
+    const_reference operator()(size_type i) const { return m_data[i]; }
+
+    /* Unary arithmetic quaternion operators, *= is the Hamilton product. */
+    quat &operator+=(const quat &other);
+    quat &operator-=(const quat &other);
+    quat &operator*=(const quat &other);
+
+    /* Unary plus/negation operators. */
+    quat operator+(void) const;
+    quat operator-(void) const;
+
+    /* Unary arithmetic scalar operators. */
+    quat &operator*=(const value_type scalar);
+    quat &operator/=(const value_type scalar);
+
+    /* Constructor/destructor. */
+    quat() = default;
+    explicit quat(const value_type *data) {
+        std::memcpy(m_data, data, sizeof(m_data));
+    }
+    explicit quat(
+        const value_type e0,
+        const value_type e1,
+        const value_type e2,
+        const value_type e3) {
+        m_data[0] = e0;
+        m_data[1] = e1;
+        m_data[2] = e2;
+        m_data[3] = e3;
+    }
+    explicit quat(const vec3<value_type> &v, const value_type e3) {
+        m_data[0] = v(0);
+        m_data[1] = v(1);
+        m_data[2] = v(2);
+        m_data[3] = e3;
+    }
+    ~quat() = default;
+}; /* quat */
+
+
+/** ---------------------------------------------------------------------------
+ * @brief Unary arithmetic quaternion operators.
+ */
+template<typename Type>
+core_inline
+quat<Type> &quat<Type>::operator+=(const quat<Type> &other)
+{
+    m_data[0] += other.m_data[0];
+    m_data[1] += other.m_data[1];
+    m_data[2] += other.m_data[2];
+    m_data[3] += other.m_data[3];
+    return *this;
+}
+
+template<typename Type>
+core_inline
+quat<Type> &quat<Type>::operator-=(const quat<Type> &other)
+{
+    m_data[0] -= other.m_data[0];
+    m_data[1] -= other.m_data[1];
+    m_data[2] -= other.m_data[2];
+    m_data[3] -= other.m_data[3];
+    return *this;
+}
+
+template<typename Type>
+core_inline
+quat<Type> &quat<Type>::operator*=(const quat<Type> &other)
+{
+    const Type rx = w * other.x + x * other.w + y * other.z - z * other.y;
+    const Type ry = w * other.y - x * other.z + y * other.w + z * other.x;
+    const Type rz = w * other.z + x * other.y - y * other.x + z * other.w;
+    const Type rw = w * other.w - x * other.x - y * other.y - z * other.z;
+    m_data[0] = rx;
+    m_data[1] = ry;
+    m_data[2] = rz;
+    m_data[3] = rw;
+    return *this;
+}
+
+/** ---------------------------------------------------------------------------
+ * @brief Unary arithmetic scalar operators.
+ */
+template<typename Type>
+core_inline
+quat<Type> &quat<Type>::operator*=(const Type scalar)
+{
+    m_data[0] *= scalar;
+    m_data[1] *= scalar;
+    m_data[2] *= scalar;
+    m_data[3] *= scalar;
+    return *this;
+}
+
+template<typename Type>
+core_inline
+quat<Type> &quat<Type>::operator/=(const Type scalar)
+{
+    m_data[0] /= scalar;
+    m_data[1] /= scalar;
+    m_data[2] /= scalar;
+    m_data[3] /= scalar;
+    return *this;
+}
+
+
+/** ---------------------------------------------------------------------------
+ * @brief Unary plus/negation operators.
+ */
+template<typename Type>
+core_inline
+quat<Type> quat<Type>::operator+(void) const
+{
+    quat<Type> result(*this);
+    return result;
+}
+
+template<typename Type>
+core_inline
+quat<Type> quat<Type>::operator-(void) const
+{
+    quat<Type> result(*this);
+    result *= (Type) (-1);
+    return result;
+}
+
+
+/** ---------------------------------------------------------------------------
+ * @brief Binary arithmetic operators between two quaternions.
+ */
+template<typename Type>
+core_inline
+quat<Type> operator+(quat<Type> lhs, const quat<Type> &rhs)
+{
+    lhs += rhs;
+    return lhs;
+}
+
+template<typename Type>
+core_inline
+quat<Type> operator-(quat<Type> lhs, const quat<Type> &rhs)
+{
+    lhs -= rhs;
+    return lhs;
+}
+
+template<typename Type>
+core_inline
+quat<Type> operator*(quat<Type> lhs, const quat<Type> &rhs)
+{
+    lhs *= rhs;
+    return lhs;
+}
+
+
+/** ---------------------------------------------------------------------------
+ * @brief Binary arithmetic operators between a quaternion and a scalar.
+ */
+template<typename Type>
+core_inline
+quat<Type> operator*(quat<Type> lhs, const Type scalar)
+{
+    lhs *= scalar;
+    return lhs;
+}
+
+template<typename Type>
+core_inline
+quat<Type> operator/(quat<Type> lhs, const Type scalar)
+{
+    lhs /= scalar;
+    return lhs;
+}
+
+template<typename Type>
+core_inline
+quat<Type> operator*(const Type scalar, quat<Type> rhs)
+{
+    rhs *= scalar;
+    return rhs;
+}
+
+
+/** ---------------------------------------------------------------------------
+ * dot
+ * @brief Return the 4-dimensional dot product of two quaternions.
+ */
+template<typename Type>
+core_inline
+Type dot(const quat<Type> &a, const quat<Type> &b)
+{
+    static_assert(std::is_floating_point<Type>::value, "non floating point");
+    return a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w;
+}
+
+/**
+ * norm
+ * @brief Return the norm of the quaternion.
+ */
+template<typename Type>
+core_inline
+Type norm(const quat<Type> &q)
+{
+    static_assert(std::is_floating_point<Type>::value, "non floating point");
+    return std::sqrt(dot(q, q));
+}
+
+/**
+ * normalize
+ * @brief Return the unit quaternion q / |q|.
+ */
+template<typename Type>
+core_inline
+quat<Type> normalize(const quat<Type> &q)
+{
+    static_assert(std::is_floating_point<Type>::value, "non floating point");
+    return q * ((Type) 1 / norm(q));
+}
+
+/**
+ * conjugate
+ * @brief Return the conjugate quaternion (-x, -y, -z, w), the inverse
+ * rotation of a unit quaternion.
+ */
+template<typename Type>
+core_inline
+quat<Type> conjugate(const quat<Type> &q)
+{
+    static_assert(std::is_floating_point<Type>::value, "non floating point");
+    return quat<Type>(-q.x, -q.y, -q.z, q.w);
+}
+
+/**
+ * inverse
+ * @brief Return the inverse quaternion conjugate(q) / |q|^2.
+ */
+template<typename Type>
+core_inline
+quat<Type> inverse(const quat<Type> &q)
+{
+    static_assert(std::is_floating_point<Type>::value, "non floating point");
+    return conjugate(q) / dot(q, q);
+}
+
+
+/** ---------------------------------------------------------------------------
+ * rotate
+ * @brief Rotate the vector v by the unit quaternion q, v' = q v q*,
+ * computed as t = 2 u x v and v' = v + w t + u x t, with u the vector
+ * part of q.
+ */
+template<typename Type>
+core_inline
+vec3<Type> rotate(const quat<Type> &q, const vec3<Type> &v)
+{
+    static_assert(std::is_floating_point<Type>::value, "non floating point");
+    const Type tx = (Type) 2 * (q.y * v.z - q.z * v.y);
+    const Type ty = (Type) 2 * (q.z * v.x - q.x * v.z);
+    const Type tz = (Type) 2 * (q.x * v.y - q.y * v.x);
+    return vec3<Type>(
+        v.x + q.w * tx + (q.y * tz - q.z * ty),
+        v.y + q.w * ty + (q.z * tx - q.x * tz),
+        v.z + q.w * tz + (q.x * ty - q.y * tx));
+}
+
+
+/** ---------------------------------------------------------------------------
+ * slerp
+ * @brief Spherical linear interpolation between the unit quaternions a and b
+ * at t in [0,1], along the shortest arc. Quaternions parallel to within
+ * rounding, where sin(theta) vanishes, are interpolated linearly and
+ * normalized.
+ */
+template<typename Type>
+core_inline
+quat<Type> slerp(const quat<Type> &a, const quat<Type> &b, const Type t)
+{
+    static_assert(std::is_floating_point<Type>::value, "non floating point");
+
+    static constexpr Type one = (Type) 1;
+    static constexpr Type threshold =
+        one - std::numeric_limits<Type>::epsilon();
+
+    quat<Type> c = b;
+    Type cos_theta = dot(a, b);
+    if (cos_theta < (Type) 0) {
+        c = -c;
+        cos_theta = -cos_theta;
+    }
+
+    if (cos_theta > threshold) {
+        return normalize(a + (c - a) * t);
+    }
+
+    const Type theta = std::acos(cos_theta);
+    const Type inv_sin = one / std::sin(theta);
+    return a * (std::sin((one - t) * theta) * inv_sin) +
+           c * (std::sin(t * theta) * inv_sin);
+}
+
+
+/** ---------------------------------------------------------------------------
+ * to_quat
+ * @brief Return the unit quaternion of the rotation by theta around the
+ * axis n.
+ */
+template<typename Type>
+core_inline
+quat<Type> to_quat(const vec3<Type> &n, const Type theta)
+{
+    static_assert(std::is_floating_point<Type>::value, "non floating point");
+    const Type half = (Type) 0.5 * theta;
+    const Type s =
+        std::sin(half) / std::sqrt(n.x * n.x + n.y * n.y + n.z * n.z);
+    return quat<Type>(n.x * s, n.y * s, n.z * s, std::cos(half));
+}
+
+/**
+ * to_quat
+ * @brief Return the unit quaternion of the rotation matrix m, with the
+ * largest of |w|, |x|, |y| and |z| computed from the diagonal and the
+ * others from the off-diagonal elements (Shepperd's method).
+ */
+template<typename Type>
+core_inline
+quat<Type> to_quat(const mat3<Type> &m)
+{
+    static_assert(std::is_floating_point<Type>::value, "non floating point");
+
+    static constexpr Type one = (Type) 1;
+    static constexpr Type quarter = (Type) 0.25;
+
+    const Type trace = m(0,0) + m(1,1) + m(2,2);
+    if (trace > (Type) 0) {
+        const Type s = (Type) 2 * std::sqrt(one + trace);
+        return quat<Type>(
+            (m(2,1) - m(1,2)) / s,
+            (m(0,2) - m(2,0)) / s,
+            (m(1,0) - m(0,1)) / s,
+            quarter * s);
+    } else if (m(0,0) > m(1,1) && m(0,0) > m(2,2)) {
+        const Type s = (Type) 2 * std::sqrt(one + m(0,0) - m(1,1) - m(2,2));
+        return quat<Type>(
+            quarter * s,
+            (m(0,1) + m(1,0)) / s,
+            (m(0,2) + m(2,0)) / s,
+            (m(2,1) - m(1,2)) / s);
+    } else if (m(1,1) > m(2,2)) {
+        const Type s = (Type) 2 * std::sqrt(one + m(1,1) - m(0,0) - m(2,2));
+        return quat<Type>(
+            (m(0,1) + m(1,0)) / s,
+            quarter * s,
+            (m(1,2) + m(2,1)) / s,
+            (m(0,2) - m(2,0)) / s);
+    }
+    const Type s = (Type) 2 * std::sqrt(one + m(2,2) - m(0,0) - m(1,1));
+    return quat<Type>(
+        (m(0,2) + m(2,0)) / s,
+        (m(1,2) + m(2,1)) / s,
+        quarter * s,
+        (m(1,0) - m(0,1)) / s);
+}
+
+/**
+ * to_mat3
+ * @brief Return the rotation matrix of the unit quaternion q,
+ *  R = (w^2 - u.u) I + 2 u u^t + 2 w [u]x,
+ * with u the vector part of q. A quaternion of norm |q| gives the rotation
+ * matrix scaled by |q|^2.
+ */
+template<typename Type>
+core_inline
+mat3<Type> to_mat3(const quat<Type> &q)
+{
+    static_assert(std::is_floating_point<Type>::value, "non floating point");
+    const Type s = q.w * q.w - q.x * q.x - q.y * q.y - q.z * q.z;
+    const Type x2 = (Type) 2 * q.x;
+    const Type y2 = (Type) 2 * q.y;
+    const Type z2 = (Type) 2 * q.z;
+    const Type w2 = (Type) 2 * q.w;
+    return mat3<Type>(
+        s + x2 * q.x, x2 * q.y - w2 * q.z, x2 * q.z + w2 * q.y,
+        y2 * q.x + w2 * q.z, s + y2 * q.y, y2 * q.z - w2 * q.x,
+        z2 * q.x - w2 * q.y, z2 * q.y + w2 * q.x, s + z2 * q.z);
+}
+
+} /* math */
+} /* atto */
+
+
+/** ---------------------------------------------------------------------------
+ * @brief Enable simd vectorized instructions.
+ */
+#ifdef ATTO_MATH_SIMD
+#include "atto/math/geometry/quat-simd.hpp"
+#endif
+
+#endif /* ATTO_MATH_GEOMETRY_QUAT_H_ */
@@ -15,6 +15,18 @@
 namespace atto {
 namespace math {
 
+/*
+ * A dispatch build has a baseline older than AVX. It compiles the helpers
+ * for the AVX instruction set, and the AVX-512 helpers for AVX-512F, so the
+ * kernels of each instruction set can inline them, see batch-dispatch.hpp.
+ * The FMA helpers are then a separate multiply and add, which the compiler
+ * contracts into a fused multiply-add in the kernels that target FMA.
+ */
+#ifdef ATTO_CORE_DISPATCH
+#pragma GCC push_options
+#pragma GCC target("avx")
+#endif
+
 /** ---- Vector insert and extract intrinsics ---------------------------------
  *
  * @fn _mm256_set_m128d(__m128d hi, __m128d lo)
@@ -434,6 +446,187 @@ __m256d simd256_reverse_(__m256d a)
 }
 
 
+/** ---- Vector rounding intrinsics -------------------------------------------
+ *
+ * simd128_round_, simd256_round_
+ *
+ * @brief Round the double-precision (64-bit) elements to the nearest
+ * integer, with ties to even, and suppress exceptions.
+ *
+ * @fn __m256d _mm256_round_pd(__m256d a, int rounding)
+ * dst[i+63:i] := ROUND(a[i+63:i], rounding)
+ */
+core_inline
+__m128d simd128_round_(__m128d a)
+{
+    return _mm_round_pd(a, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+}
+
+core_inline
+__m256d simd256_round_(__m256d a)
+{
+    return _mm256_round_pd(a, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+}
+
+/**
+ * simd128_floor_, simd256_floor_
+ *
+ * @brief Round the double-precision (64-bit) elements down to an integer.
+ *
+ * @fn __m256d _mm256_floor_pd(__m256d a)
+ * dst[i+63:i] := FLOOR(a[i+63:i])
+ */
+core_inline
+__m128d simd128_floor_(__m128d a)
+{
+    return _mm_floor_pd(a);
+}
+
+core_inline
+__m256d simd256_floor_(__m256d a)
+{
+    return _mm256_floor_pd(a);
+}
+
+
+/** ---- Fused multiply-add intrinsics ----------------------------------------
+ *
+ * simd_fmadd_, simd_fmsub_, simd_fnmadd_
+ *
+ * @brief Multiply-add of packed elements rounded once, when the compiler
+ * targets the FMA instruction set (-mfma, -march=haswell or later), or as
+ * a separate multiply and add otherwise.
+ *
+ * @fn _mm256_fmadd_pd(__m256d a, __m256d b, __m256d c)
+ * dst[i+63:i] :=  (a[i+63:i] * b[i+63:i]) + c[i+63:i]
+ *
+ * @fn _mm256_fmsub_pd(__m256d a, __m256d b, __m256d c)
+ * dst[i+63:i] :=  (a[i+63:i] * b[i+63:i]) - c[i+63:i]
+ *
+ * @fn _mm256_fnmadd_pd(__m256d a, __m256d b, __m256d c)
+ * dst[i+63:i] := -(a[i+63:i] * b[i+63:i]) + c[i+63:i]
+ */
+core_inline
+__m128d simd128_fmadd_(__m128d a, __m128d b, __m128d c)
+{
+#ifdef __FMA__
+    return _mm_fmadd_pd(a, b, c);
+#else
+    return _mm_add_pd(_mm_mul_pd(a, b), c);
+#endif
+}
+
+core_inline
+__m128d simd128_fmsub_(__m128d a, __m128d b, __m128d c)
+{
+#ifdef __FMA__
+    return _mm_fmsub_pd(a, b, c);
+#else
+    return _mm_sub_pd(_mm_mul_pd(a, b), c);
+#endif
+}
+
+core_inline
+__m128d simd128_fnmadd_(__m128d a, __m128d b, __m128d c)
+{
+#ifdef __FMA__
+    return _mm_fnmadd_pd(a, b, c);
+#else
+    return _mm_sub_pd(c, _mm_mul_pd(a, b));
+#endif
+}
+
+core_inline
+__m256d simd256_fmadd_(__m256d a, __m256d b, __m256d c)
+{
+#ifdef __FMA__
+    return _mm256_fmadd_pd(a, b, c);
+#else
+    return _mm256_add_pd(_mm256_mul_pd(a, b), c);
+#endif
+}
+
+core_inline
+__m256d simd256_fmsub_(__m256d a, __m256d b, __m256d c)
+{
+#ifdef __FMA__
+    return _mm256_fmsub_pd(a, b, c);
+#else
+    return _mm256_sub_pd(_mm256_mul_pd(a, b), c);
+#endif
+}
+
+core_inline
+__m256d simd256_fnmadd_(__m256d a, __m256d b, __m256d c)
+{
+#ifdef __FMA__
+    return _mm256_fnmadd_pd(a, b, c);
+#else
+    return _mm256_sub_pd(c, _mm256_mul_pd(a, b));
+#endif
+}
+
+core_inline
+__m128 simd128_fmadd_(__m128 a, __m128 b, __m128 c)
+{
+#ifdef __FMA__
+    return _mm_fmadd_ps(a, b, c);
+#else
+    return _mm_add_ps(_mm_mul_ps(a, b), c);
+#endif
+}
+
+core_inline
+__m128 simd128_fmsub_(__m128 a, __m128 b, __m128 c)
+{
+#ifdef __FMA__
+    return _mm_fmsub_ps(a, b, c);
+#else
+    return _mm_sub_ps(_mm_mul_ps(a, b), c);
+#endif
+}
+
+core_inline
+__m128 simd128_fnmadd_(__m128 a, __m128 b, __m128 c)
+{
+#ifdef __FMA__
+    return _mm_fnmadd_ps(a, b, c);
+#else
+    return _mm_sub_ps(c, _mm_mul_ps(a, b));
+#endif
+}
+
+core_inline
+__m256 simd256_fmadd_(__m256 a, __m256 b, __m256 c)
+{
+#ifdef __FMA__
+    return _mm256_fmadd_ps(a, b, c);
+#else
+    return _mm256_add_ps(_mm256_mul_ps(a, b), c);
+#endif
+}
+
+core_inline
+__m256 simd256_fmsub_(__m256 a, __m256 b, __m256 c)
+{
+#ifdef __FMA__
+    return _mm256_fmsub_ps(a, b, c);
+#else
+    return _mm256_sub_ps(_mm256_mul_ps(a, b), c);
+#endif
+}
+
+core_inline
+__m256 simd256_fnmadd_(__m256 a, __m256 b, __m256 c)
+{
+#ifdef __FMA__
+    return _mm256_fnmadd_ps(a, b, c);
+#else
+    return _mm256_sub_ps(c, _mm256_mul_ps(a, b));
+#endif
+}
+
+
 /** ---- Vector arithmetic intrinsics -----------------------------------------
  *
  * @fn _mm_rsqrt_pd
@@ -749,6 +942,36 @@ __m256d simd256_normalize_(__m256d a)
      return _mm256_mul_pd(a, ynorm);
 }
 
+/**
+ * simd256_cross_
+ *
+ * @brief Cross product of the first three double precision (64-bit)
+ * elements. The fourth element of the result is zero if the fourth element
+ * of either operand is zero.
+ *
+ * @note Operation:
+ * a3 = {a3, a0, a2, a1}
+ * a5 = {a3, a1, a0, a2}
+ * c  = (a3 * b5) - (a5 * b3)
+ */
+core_inline
+__m256d simd256_cross_(__m256d a, __m256d b)
+{
+    __m256d a1 = _mm256_permute2f128_pd(a, a, core_extension(0b00000001));
+    __m256d a2 = _mm256_shuffle_pd(a, a1, core_extension(0b0101));
+    __m256d a3 = _mm256_permute_pd(a2, core_extension(0b0110));
+    __m256d a4 = _mm256_shuffle_pd(a, a1, core_extension(0b1100));
+    __m256d a5 = _mm256_permute_pd(a4, core_extension(0b0101));
+
+    __m256d b1 = _mm256_permute2f128_pd(b, b, core_extension(0b00000001));
+    __m256d b2 = _mm256_shuffle_pd(b, b1, core_extension(0b0101));
+    __m256d b3 = _mm256_permute_pd(b2, core_extension(0b0110));
+    __m256d b4 = _mm256_shuffle_pd(b, b1, core_extension(0b1100));
+    __m256d b5 = _mm256_permute_pd(b4, core_extension(0b0101));
+
+    return simd256_fmsub_(a3, b5, _mm256_mul_pd(a5, b3));
+}
+
 
 /** ---- Matrix transpose intrinsics ------------------------------------------
  *
@@ -933,6 +1156,257 @@ __m256d simd256_det_(__m256d a)
     return _mm256_hsub_pd(r3, r3);
 }
 
+/** ---- Single precision intrinsics ------------------------------------------
+ *
+ * simd128_rsqrt_
+ *
+ * @brief Inverse square root of four single-precision (32-bit) elements,
+ * from the approximate reciprocal square root refined by one step of
+ * Newton's method, y = y * (3/2 - x/2 * y * y).
+ *
+ * @fn __m128 _mm_rsqrt_ps(__m128 a)
+ * dst[31:0]   :=  APPROXIMATE(1.0 / SQRT(a[31:0]))
+ * dst[63:32]  :=  APPROXIMATE(1.0 / SQRT(a[63:32]))
+ * dst[95:64]  :=  APPROXIMATE(1.0 / SQRT(a[95:64]))
+ * dst[127:96] :=  APPROXIMATE(1.0 / SQRT(a[127:96]))
+ */
+core_inline
+__m128 simd128_rsqrt_(__m128 x)
+{
+    const __m128 half = _mm_set1_ps(0.5f);
+    const __m128 one_half = _mm_set1_ps(1.5f);
+
+    __m128 x2 = _mm_mul_ps(x, half);
+    __m128 y0 = _mm_rsqrt_ps(x);
+    __m128 y1 = _mm_mul_ps(
+        y0, _mm_sub_ps(
+            one_half, _mm_mul_ps(
+                x2, _mm_mul_ps(y0, y0))));
+
+    return y1;
+}
+
+/**
+ * simd128_dot_
+ *
+ * @brief Dot product of four single precision (32-bit) elements.
+ *
+ * @fn _mm_hadd_ps(__m128 a, __m128 b)
+ * dst[31:0]   := a[63:32]  + a[31:0]
+ * dst[63:32]  := a[127:96] + a[95:64]
+ * dst[95:64]  := b[63:32]  + b[31:0]
+ * dst[127:96] := b[127:96] + b[95:64]
+ */
+core_inline
+__m128 simd128_dot_(__m128 a, __m128 b)
+{
+    /*
+     * {a3*b3, a2*b2, a1*b1, a0*b0}
+     */
+    __m128 xmul = _mm_mul_ps(a, b);
+    /*
+     * {a3*b3 + a2*b2,
+     *  a1*b1 + a0*b0,
+     *  a3*b3 + a2*b2,
+     *  a1*b1 + a0*b0}
+     */
+    __m128 xadd = _mm_hadd_ps(xmul, xmul);
+    /*
+     * {a3*b3 + a2*b2 + a1*b1 + a0*b0, ...}
+     */
+    __m128 xdot = _mm_hadd_ps(xadd, xadd);
+
+    return xdot;
+}
+
+/**
+ * simd128_norm_
+ *
+ * @brief Euclidean norm of four single-precision (32-bit) elements.
+ */
+core_inline
+__m128 simd128_norm_(__m128 a)
+{
+    return _mm_sqrt_ps(simd128_dot_(a, a));
+}
+
+/**
+ * simd128_normalize_
+ *
+ * @brief Normalize four single precision (32-bit) elements by their
+ * Euclidean norm.
+ */
+core_inline
+__m128 simd128_normalize_(__m128 a)
+{
+    __m128 xdot = simd128_dot_(a, a);
+    __m128 xnorm = simd128_rsqrt_(xdot);
+
+    return _mm_mul_ps(a, xnorm);
+}
+
+/**
+ * simd128_cross_
+ *
+ * @brief Cross product of the lower three single precision (32-bit)
+ * elements. The upper element of the result is zero.
+ *
+ * c = {a1, a2, a0} * {b2, b0, b1} - {a2, a0, a1} * {b1, b2, b0}
+ *
+ * @fn _mm_shuffle_ps(__m128 a, __m128 b, unsigned int imm8)
+ * dst[31:0]   := SELECT4(a[127:0], imm8[1:0])
+ * dst[63:32]  := SELECT4(a[127:0], imm8[3:2])
+ * dst[95:64]  := SELECT4(b[127:0], imm8[5:4])
+ * dst[127:96] := SELECT4(b[127:0], imm8[7:6])
+ */
+core_inline
+__m128 simd128_cross_(__m128 a, __m128 b)
+{
+    /*
+     * a0 = {a3, a0, a2, a1}
+     * b0 = {b3, b1, b0, b2}
+     * a1 = {a3, a1, a0, a2}
+     * b1 = {b3, b0, b2, b1}
+     */
+    __m128 a0 = _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 0, 2, 1));
+    __m128 b0 = _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 1, 0, 2));
+    __m128 a1 = _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 1, 0, 2));
+    __m128 b1 = _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 0, 2, 1));
+
+    return simd128_fmsub_(a0, b0, _mm_mul_ps(a1, b1));
+}
+
+/**
+ * simd128_transpose_
+ *
+ * @brief Return the transpose of a 4x4 matrix represented as 4 vector-rows
+ * of four single precision (32-bit) elements.
+ *
+ * @note Operation:
+ * row0 = { a3,  a2,  a1,  a0} -> {a12, a8,  a4, a0}
+ * row1 = { a7,  a6,  a5,  a4} -> {a13, a9,  a5, a1}
+ * row2 = {a11, a10,  a9,  a8} -> {a14, a10, a6, a2}
+ * row3 = {a15, a14, a13, a12} -> {a15, a11, a7, a3}
+ */
+core_inline
+void simd128_transpose_(__m128 (&row)[4])
+{
+    _MM_TRANSPOSE4_PS(row[0], row[1], row[2], row[3]);
+}
+
+/**
+ * simd128_recip_
+ *
+ * @brief Return the reciprocal of the four single precision (32-bit)
+ * elements, or zero where an element is zero.
+ */
+core_inline
+__m128 simd128_recip_(__m128 a)
+{
+    __m128 mask = _mm_cmp_ps(a, _mm_setzero_ps(), _CMP_NEQ_OQ);
+    return _mm_and_ps(_mm_div_ps(_mm_set1_ps(1.0f), a), mask);
+}
+
+#if defined(ATTO_MATH_SIMD512) || defined(ATTO_CORE_DISPATCH)
+#ifdef ATTO_CORE_DISPATCH
+#pragma GCC target("avx512f")
+#endif
+/** ---- AVX-512 intrinsics ---------------------------------------------------
+ * simd512_mask_
+ *
+ * @brief Return the mask of the first min(n, 8) double precision (64-bit)
+ * elements of a 512-bit register. Masked loads and stores process the
+ * remaining elements of an array without touching memory past its end.
+ */
+core_inline
+__mmask8 simd512_mask_(const size_t n)
+{
+    return n < 8 ? (__mmask8) ((1u << n) - 1u) : (__mmask8) 0xff;
+}
+
+/**
+ * simd512_rsqrt_
+ *
+ * @brief Inverse square root of the double precision (64-bit) elements
+ * selected by the mask. The other elements are zero.
+ *
+ * @fn __m512d _mm512_maskz_rsqrt14_pd(__mmask8 k, __m512d a)
+ * dst[i+63:i] := k[j] ? APPROXIMATE(1.0 / SQRT(a[i+63:i])) : 0
+ * with a relative error < 2^-14.
+ */
+core_inline
+__m512d simd512_rsqrt_(const __mmask8 mask, __m512d x)
+{
+    const __m512d one = _mm512_set1_pd(1.0);
+    const __m512d half = _mm512_set1_pd(0.5);
+    /*
+     * Newton-Raphson optimization of the inverse square root estimate.
+     * Each step squares the relative error, so two steps refine the 14-bit
+     * estimate to double precision.
+     *
+     * e(k)   = 1 - x*y(k)*y(k)
+     * y(k+1) = y(k) + 0.5*y(k)*e(k)
+     */
+    __m512d y = _mm512_maskz_rsqrt14_pd(mask, x);
+    __m512d e = _mm512_fnmadd_pd(_mm512_mul_pd(x, y), y, one);
+    y = _mm512_fmadd_pd(_mm512_mul_pd(half, y), e, y);
+    e = _mm512_fnmadd_pd(_mm512_mul_pd(x, y), y, one);
+    y = _mm512_fmadd_pd(_mm512_mul_pd(half, y), e, y);
+    return y;
+}
+
+/**
+ * simd512_recip_
+ *
+ * @brief Reciprocal of the double precision (64-bit) elements selected by
+ * the mask. The other elements are zero.
+ *
+ * @fn __m512d _mm512_maskz_rcp14_pd(__mmask8 k, __m512d a)
+ * dst[i+63:i] := k[j] ? APPROXIMATE(1.0 / a[i+63:i]) : 0
+ * with a relative error < 2^-14.
+ */
+core_inline
+__m512d simd512_recip_(const __mmask8 mask, __m512d x)
+{
+    const __m512d one = _mm512_set1_pd(1.0);
+    /*
+     * Newton-Raphson optimization of the reciprocal estimate.
+     *
+     * e(k)   = 1 - x*y(k)
+     * y(k+1) = y(k) + y(k)*e(k)
+     */
+    __m512d y = _mm512_maskz_rcp14_pd(mask, x);
+    y = _mm512_fmadd_pd(y, _mm512_fnmadd_pd(x, y, one), y);
+    y = _mm512_fmadd_pd(y, _mm512_fnmadd_pd(x, y, one), y);
+    return y;
+}
+#endif  /* ATTO_MATH_SIMD512 || ATTO_CORE_DISPATCH */
+
+#ifdef ATTO_CORE_DISPATCH
+#pragma GCC pop_options
+
+/** ---- Run time kernel selection --------------------------------------------
+ * simd_dispatch_
+ *
+ * @brief Call the kernel fn of the widest instruction set enabled in
+ * core::cpu_dispatch, from the namespaces avx512, avx2 and avx of the
+ * calling namespace, or the generic template fn<> on an older processor.
+ */
+#define simd_dispatch_(fn, ...) \
+    do { \
+        const core::CpuFeatures &cpu_ = core::cpu_dispatch(); \
+        if (cpu_.avx512f && cpu_.avx2 && cpu_.fma) { \
+            avx512::fn(__VA_ARGS__); \
+        } else if (cpu_.avx2 && cpu_.fma) { \
+            avx2::fn(__VA_ARGS__); \
+        } else if (cpu_.avx) { \
+            avx::fn(__VA_ARGS__); \
+        } else { \
+            fn<>(__VA_ARGS__); \
+        } \
+    } while (0)
+#endif  /* ATTO_CORE_DISPATCH */
+
 } /* math */
 } /* atto */
 
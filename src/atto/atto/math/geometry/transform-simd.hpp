@@ -18,6 +18,29 @@ namespace atto {
 namespace math {
 
 /** ---------------------------------------------------------------------------
+ * translate
+ * @brief Translate this matrix by d. The translation matrix only adds a
+ * multiple of the last row of m to each of the first three rows,
+ *  translate(m, d) = {m0 + d0 * m3, m1 + d1 * m3, m2 + d2 * m3, m3}
+ */
+template<>
+core_inline
+mat4<double> translate(const mat4<double> m, const vec3<double> d)
+{
+    __m256d m3 = simd_load(m, 3);
+
+    mat4<double> result{};
+    simd_store(result, 0, simd256_fmadd_(
+        _mm256_set1_pd(d(0)), m3, simd_load(m, 0)));
+    simd_store(result, 1, simd256_fmadd_(
+        _mm256_set1_pd(d(1)), m3, simd_load(m, 1)));
+    simd_store(result, 2, simd256_fmadd_(
+        _mm256_set1_pd(d(2)), m3, simd_load(m, 2)));
+    simd_store(result, 3, m3);
+    return result;
+}
+
+/**
  * rotate
  * @brief Rotate this matrix by theta given an axis of rotation defined by n.
  */
@@ -42,35 +65,28 @@ mat4<double> rotate(vec3<double> n, const double theta)
     __m256d nn0 = _mm256_set1_pd(n(0));
     __m256d nn1 = _mm256_set1_pd(n(1));
     __m256d nn2 = _mm256_set1_pd(n(2));
-    __m256d nn3 = one3;
 
-    nn0 = _mm256_mul_pd(alpha, _mm256_mul_pd(nn0, nn));
-    nn1 = _mm256_mul_pd(alpha, _mm256_mul_pd(nn1, nn));
-    nn2 = _mm256_mul_pd(alpha, _mm256_mul_pd(nn2, nn));
-    nn3 = _mm256_mul_pd(alpha, nn3);
-
-    /* Compute identity matrix */
-    __m256d id0 = _mm256_mul_pd(beta, one0);
-    __m256d id1 = _mm256_mul_pd(beta, one1);
-    __m256d id2 = _mm256_mul_pd(beta, one2);
-    __m256d id3 = _mm256_mul_pd(beta, one3);
+    nn0 = _mm256_mul_pd(nn0, nn);
+    nn1 = _mm256_mul_pd(nn1, nn);
+    nn2 = _mm256_mul_pd(nn2, nn);
 
     /* Compute cross product matrix */
     __m256d rc0 = _mm256_set_pd(0.0,  n(1), -n(2),  0.0);
     __m256d rc1 = _mm256_set_pd(0.0, -n(0),   0.0,  n(2));
     __m256d rc2 = _mm256_set_pd(0.0,   0.0,  n(0), -n(1));
-    __m256d rc3 = _mm256_set_pd(1.0,   0.0,   0.0,  1.0);
 
-    rc0 = _mm256_mul_pd(gamma, rc0);
-    rc1 = _mm256_mul_pd(gamma, rc1);
-    rc2 = _mm256_mul_pd(gamma, rc2);
-    rc3 = _mm256_mul_pd(gamma, rc3);
+    /*
+     * Compute rotation matrix
+     * rot = beta * I + alpha * (n n^t) + gamma * R
+     */
+    __m256d rot0 = _mm256_mul_pd(beta, one0);
+    __m256d rot1 = _mm256_mul_pd(beta, one1);
+    __m256d rot2 = _mm256_mul_pd(beta, one2);
+    __m256d rot3 = one3;
 
-    /* Compute rotation matrix */
-    __m256d rot0 = _mm256_add_pd(nn0, _mm256_add_pd(id0, rc0));
-    __m256d rot1 = _mm256_add_pd(nn1, _mm256_add_pd(id1, rc1));
-    __m256d rot2 = _mm256_add_pd(nn2, _mm256_add_pd(id2, rc2));
-    __m256d rot3 = _mm256_add_pd(nn3, _mm256_add_pd(id3, rc3));
+    rot0 = simd256_fmadd_(alpha, nn0, simd256_fmadd_(gamma, rc0, rot0));
+    rot1 = simd256_fmadd_(alpha, nn1, simd256_fmadd_(gamma, rc1, rot1));
+    rot2 = simd256_fmadd_(alpha, nn2, simd256_fmadd_(gamma, rc2, rot2));
 
     mat4<double> result{};
     simd_store(result, 0, rot0);
@@ -80,6 +96,83 @@ mat4<double> rotate(vec3<double> n, const double theta)
     return result;
 }
 
+/** ---- Single precision ----------------------------------------------------
+ * translate
+ * @brief Translate this matrix by d.
+ */
+template<>
+core_inline
+mat4<float> translate(const mat4<float> m, const vec3<float> d)
+{
+    __m128 m3 = simd_load(m, 3);
+
+    mat4<float> result{};
+    simd_store(result, 0, simd128_fmadd_(
+        _mm_set1_ps(d(0)), m3, simd_load(m, 0)));
+    simd_store(result, 1, simd128_fmadd_(
+        _mm_set1_ps(d(1)), m3, simd_load(m, 1)));
+    simd_store(result, 2, simd128_fmadd_(
+        _mm_set1_ps(d(2)), m3, simd_load(m, 2)));
+    simd_store(result, 3, m3);
+    return result;
+}
+
+/**
+ * rotate
+ * @brief Rotate this matrix by theta given an axis of rotation defined by n.
+ */
+template<>
+core_inline
+mat4<float> rotate(vec3<float> n, const float theta)
+{
+    /* Identity matrix */
+    const __m128 one0 = _mm_set_ps(0.0f, 0.0f, 0.0f, 1.0f);
+    const __m128 one1 = _mm_set_ps(0.0f, 0.0f, 1.0f, 0.0f);
+    const __m128 one2 = _mm_set_ps(0.0f, 1.0f, 0.0f, 0.0f);
+    const __m128 one3 = _mm_set_ps(1.0f, 0.0f, 0.0f, 0.0f);
+
+    /* Compute trigonometric coefficients */
+    __m128 alpha = _mm_set1_ps(1.0f - std::cos(theta));
+    __m128 beta  = _mm_set1_ps(std::cos(theta));
+    __m128 gamma = _mm_set1_ps(std::sin(theta));
+
+    /* Compute diadic product matrix */
+    n = normalize(n);
+    __m128 nn  = simd_load(n);
+    __m128 nn0 = _mm_set1_ps(n(0));
+    __m128 nn1 = _mm_set1_ps(n(1));
+    __m128 nn2 = _mm_set1_ps(n(2));
+
+    nn0 = _mm_mul_ps(nn0, nn);
+    nn1 = _mm_mul_ps(nn1, nn);
+    nn2 = _mm_mul_ps(nn2, nn);
+
+    /* Compute cross product matrix */
+    __m128 rc0 = _mm_set_ps(0.0f,  n(1), -n(2),  0.0f);
+    __m128 rc1 = _mm_set_ps(0.0f, -n(0),   0.0f,  n(2));
+    __m128 rc2 = _mm_set_ps(0.0f,   0.0f,  n(0), -n(1));
+
+    /*
+     * Compute rotation matrix
+     * rot = beta * I + alpha * (n n^t) + gamma * R
+     */
+    __m128 rot0 = _mm_mul_ps(beta, one0);
+    __m128 rot1 = _mm_mul_ps(beta, one1);
+    __m128 rot2 = _mm_mul_ps(beta, one2);
+    __m128 rot3 = one3;
+
+    rot0 = simd128_fmadd_(alpha, nn0, simd128_fmadd_(gamma, rc0, rot0));
+    rot1 = simd128_fmadd_(alpha, nn1, simd128_fmadd_(gamma, rc1, rot1));
+    rot2 = simd128_fmadd_(alpha, nn2, simd128_fmadd_(gamma, rc2, rot2));
+
+    mat4<float> result{};
+    simd_store(result, 0, rot0);
+    simd_store(result, 1, rot1);
+    simd_store(result, 2, rot2);
+    simd_store(result, 3, rot3);
+    return result;
+}
+
 } /* math */
 } /* atto */
 
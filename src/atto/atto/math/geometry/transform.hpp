@@ -386,7 +386,7 @@ mat4<Type> ortho(
  * @brief Enable simd vectorized instructions.
  */
 #ifdef ATTO_MATH_SIMD
-#include "atto/math/geometry/transform.hpp"
+#include "atto/math/geometry/transform-simd.hpp"
 #endif
 
 #endif /* ATTO_MATH_GEOMETRY_TRANSFORM_H_ */
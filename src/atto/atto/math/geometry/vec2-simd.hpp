@@ -127,6 +127,120 @@ vec2<double> &vec2<double>::operator/=(const double scalar)
     return *this;
 }
 
+/** ---- Single precision ----------------------------------------------------
+ * simd_load
+ * @brief Load 64-bits (2 packed single-precision 32-bit) from the 2d-array
+ * into the lower half of the register. The upper half is set to zero.
+ *
+ * @fn _mm_load_sd(double const* mem_addr)
+ * dst[63:0]   := MEM[mem_addr+63:mem_addr]
+ * dst[127:64] := 0
+ */
+core_inline
+__m128 simd_load(const vec2<float> &v)
+{
+    return _mm_castpd_ps(
+        _mm_load_sd(reinterpret_cast<const double *>(v.data())));
+}
+
+/**
+ * simd_store
+ * @brief Store the lower 64-bits (2 packed single-precision 32-bit)
+ * into the 2d-array.
+ */
+core_inline
+void simd_store(vec2<float> &v, const __m128 a)
+{
+    _mm_store_sd(reinterpret_cast<double *>(v.data()), _mm_castps_pd(a));
+}
+
+/** ---------------------------------------------------------------------------
+ * @brief Unary arithmetic vector operators.
+ */
+template<>
+core_inline
+vec2<float> &vec2<float>::operator+=(const vec2<float> &other)
+{
+    const __m128 a = simd_load(*this);
+    const __m128 b = simd_load(other);
+    simd_store(*this, _mm_add_ps(a, b));
+    return *this;
+}
+
+template<>
+core_inline
+vec2<float> &vec2<float>::operator-=(const vec2<float> &other)
+{
+    const __m128 a = simd_load(*this);
+    const __m128 b = simd_load(other);
+    simd_store(*this, _mm_sub_ps(a, b));
+    return *this;
+}
+
+template<>
+core_inline
+vec2<float> &vec2<float>::operator*=(const vec2<float> &other)
+{
+    const __m128 a = simd_load(*this);
+    const __m128 b = simd_load(other);
+    simd_store(*this, _mm_mul_ps(a, b));
+    return *this;
+}
+
+template<>
+core_inline
+vec2<float> &vec2<float>::operator/=(const vec2<float> &other)
+{
+    const __m128 a = simd_load(*this);
+    const __m128 b = simd_load(other);
+    simd_store(*this, _mm_div_ps(a, b));
+    return *this;
+}
+
+
+/** ---------------------------------------------------------------------------
+ * @brief Unary arithmetic scalar operators.
+ */
+template<>
+core_inline
+vec2<float> &vec2<float>::operator+=(const float scalar)
+{
+    const __m128 a = simd_load(*this);
+    const __m128 b = _mm_set1_ps(scalar);
+    simd_store(*this, _mm_add_ps(a, b));
+    return *this;
+}
+
+template<>
+core_inline
+vec2<float> &vec2<float>::operator-=(const float scalar)
+{
+    const __m128 a = simd_load(*this);
+    const __m128 b = _mm_set1_ps(scalar);
+    simd_store(*this, _mm_sub_ps(a, b));
+    return *this;
+}
+
+template<>
+core_inline
+vec2<float> &vec2<float>::operator*=(const float scalar)
+{
+    const __m128 a = simd_load(*this);
+    const __m128 b = _mm_set1_ps(scalar);
+    simd_store(*this, _mm_mul_ps(a, b));
+    return *this;
+}
+
+template<>
+core_inline
+vec2<float> &vec2<float>::operator/=(const float scalar)
+{
+    const __m128 a = simd_load(*this);
+    const __m128 b = _mm_set1_ps(scalar);
+    simd_store(*this, _mm_div_ps(a, b));
+    return *this;
+}
+
 } /* math */
 } /* atto */
 
@@ -167,6 +167,122 @@ vec3<double> &vec3<double>::operator/=(const double scalar)
     return *this;
 }
 
+/** ---- Single precision ----------------------------------------------------
+ * simd_load
+ * @brief Load 96-bits (3 packed single-precision 32-bit) from the 3d-array.
+ *
+ * @fn _mm_maskload_ps(float const * v, __m128i mask)
+ * dst[31:0]   := (mask[31]  == 1) ? v[31:0]   : 0
+ * dst[63:32]  := (mask[63]  == 1) ? v[63:32]  : 0
+ * dst[95:64]  := (mask[95]  == 1) ? v[95:64]  : 0
+ * dst[127:96] := (mask[127] == 1) ? v[127:96] : 0
+ */
+core_inline
+__m128 simd_load(const vec3<float> &v)
+{
+    const __m128i mask = _mm_set_epi32(0x0, -1, -1, -1);
+    return _mm_maskload_ps(v.data(), mask);
+}
+
+/**
+ * simd_store
+ * @brief Store 96-bits (3 packed single-precision 32-bit) into the 3d-array.
+ * The masked upper element is not written.
+ */
+core_inline
+void simd_store(vec3<float> &v, const __m128 a)
+{
+    const __m128i mask = _mm_set_epi32(0x0, -1, -1, -1);
+    _mm_maskstore_ps(v.data(), mask, a);
+}
+
+/** ---------------------------------------------------------------------------
+ * @brief Unary arithmetic vector operators.
+ */
+template<>
+core_inline
+vec3<float> &vec3<float>::operator+=(const vec3<float> &other)
+{
+    const __m128 a = simd_load(*this);
+    const __m128 b = simd_load(other);
+    simd_store(*this, _mm_add_ps(a, b));
+    return *this;
+}
+
+template<>
+core_inline
+vec3<float> &vec3<float>::operator-=(const vec3<float> &other)
+{
+    const __m128 a = simd_load(*this);
+    const __m128 b = simd_load(other);
+    simd_store(*this, _mm_sub_ps(a, b));
+    return *this;
+}
+
+template<>
+core_inline
+vec3<float> &vec3<float>::operator*=(const vec3<float> &other)
+{
+    const __m128 a = simd_load(*this);
+    const __m128 b = simd_load(other);
+    simd_store(*this, _mm_mul_ps(a, b));
+    return *this;
+}
+
+template<>
+core_inline
+vec3<float> &vec3<float>::operator/=(const vec3<float> &other)
+{
+    const __m128 a = simd_load(*this);
+    const __m128 b = simd_load(other);
+    simd_store(*this, _mm_div_ps(a, b));
+    return *this;
+}
+
+
+/** ---------------------------------------------------------------------------
+ * @brief Unary arithmetic scalar operators.
+ */
+template<>
+core_inline
+vec3<float> &vec3<float>::operator+=(const float scalar)
+{
+    const __m128 a = simd_load(*this);
+    const __m128 b = _mm_set1_ps(scalar);
+    simd_store(*this, _mm_add_ps(a, b));
+    return *this;
+}
+
+template<>
+core_inline
+vec3<float> &vec3<float>::operator-=(const float scalar)
+{
+    const __m128 a = simd_load(*this);
+    const __m128 b = _mm_set1_ps(scalar);
+    simd_store(*this, _mm_sub_ps(a, b));
+    return *this;
+}
+
+template<>
+core_inline
+vec3<float> &vec3<float>::operator*=(const float scalar)
+{
+    const __m128 a = simd_load(*this);
+    const __m128 b = _mm_set1_ps(scalar);
+    simd_store(*this, _mm_mul_ps(a, b));
+    return *this;
+}
+
+template<>
+core_inline
+vec3<float> &vec3<float>::operator/=(const float scalar)
+{
+    const __m128 a = simd_load(*this);
+    const __m128 b = _mm_set1_ps(scalar);
+    simd_store(*this, _mm_div_ps(a, b));
+    return *this;
+}
+
 } /* math */
 } /* atto */
 
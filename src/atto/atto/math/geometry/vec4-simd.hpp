@@ -127,6 +127,115 @@ vec4<double> &vec4<double>::operator/=(const double scalar)
     return *this;
 }
 
+/** ---- Single precision ----------------------------------------------------
+ * simd_load
+ * @brief Load 128-bits (4 packed single-precision 32-bit)
+ * from the 4d-array (16-byte aligned).
+ */
+core_inline
+__m128 simd_load(const vec4<float> &v)
+{
+    return _mm_load_ps(v.data());
+}
+
+/**
+ * simd_store
+ * @brief Store 128-bits (4 packed single-precision 32-bit)
+ * into the 4d-array (16-byte aligned).
+ */
+core_inline
+void simd_store(vec4<float> &v, const __m128 a)
+{
+    _mm_store_ps(v.data(), a);
+}
+
+/** ---------------------------------------------------------------------------
+ * @brief Unary arithmetic vector operators.
+ */
+template<>
+core_inline
+vec4<float> &vec4<float>::operator+=(const vec4<float> &other)
+{
+    const __m128 a = simd_load(*this);
+    const __m128 b = simd_load(other);
+    simd_store(*this, _mm_add_ps(a, b));
+    return *this;
+}
+
+template<>
+core_inline
+vec4<float> &vec4<float>::operator-=(const vec4<float> &other)
+{
+    const __m128 a = simd_load(*this);
+    const __m128 b = simd_load(other);
+    simd_store(*this, _mm_sub_ps(a, b));
+    return *this;
+}
+
+template<>
+core_inline
+vec4<float> &vec4<float>::operator*=(const vec4<float> &other)
+{
+    const __m128 a = simd_load(*this);
+    const __m128 b = simd_load(other);
+    simd_store(*this, _mm_mul_ps(a, b));
+    return *this;
+}
+
+template<>
+core_inline
+vec4<float> &vec4<float>::operator/=(const vec4<float> &other)
+{
+    const __m128 a = simd_load(*this);
+    const __m128 b = simd_load(other);
+    simd_store(*this, _mm_div_ps(a, b));
+    return *this;
+}
+
+
+/** ---------------------------------------------------------------------------
+ * @brief Unary arithmetic scalar operators.
+ */
+template<>
+core_inline
+vec4<float> &vec4<float>::operator+=(const float scalar)
+{
+    const __m128 a = simd_load(*this);
+    const __m128 b = _mm_set1_ps(scalar);
+    simd_store(*this, _mm_add_ps(a, b));
+    return *this;
+}
+
+template<>
+core_inline
+vec4<float> &vec4<float>::operator-=(const float scalar)
+{
+    const __m128 a = simd_load(*this);
+    const __m128 b = _mm_set1_ps(scalar);
+    simd_store(*this, _mm_sub_ps(a, b));
+    return *this;
+}
+
+template<>
+core_inline
+vec4<float> &vec4<float>::operator*=(const float scalar)
+{
+    const __m128 a = simd_load(*this);
+    const __m128 b = _mm_set1_ps(scalar);
+    simd_store(*this, _mm_mul_ps(a, b));
+    return *this;
+}
+
+template<>
+core_inline
+vec4<float> &vec4<float>::operator/=(const float scalar)
+{
+    const __m128 a = simd_load(*this);
+    const __m128 b = _mm_set1_ps(scalar);
+    simd_store(*this, _mm_div_ps(a, b));
+    return *this;
+}
+
 } /* math */
 } /* atto */
 
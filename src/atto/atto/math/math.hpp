@@ -23,5 +23,6 @@
 #include "atto/math/numeric.hpp"
 #include "atto/math/geometry.hpp"
 #include "atto/math/random.hpp"
+#include "atto/math/fft.hpp"
 
 #endif /* ATTO_MATH_H_ */
\ No newline at end of file
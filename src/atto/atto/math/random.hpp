@@ -516,6 +516,163 @@ uint64_t Cmwc::rand64 (void)
             ((uint64_t) (z2) << 32 & 0xFFFFFFFF00000000ULL));
 }
 
+/** ---- Philox counter-based random number generator engine ------------------
+ * Philox
+ * @brief Counter-based random number generator engine Philox4x32-10 of
+ * Salmon, Moraes, Dror and Shaw. Each sample is a pure function of a 64-bit
+ * key and a 128-bit counter, so there is no sequential state to share or
+ * warm up, and a stream is addressed directly by its key and counter.
+ *
+ * The key holds the seed, and the counter the stream of a particle at a
+ * given step, with the block index of the stream in its first word,
+ *  key = {seed_lo, seed_hi}
+ *  ctr = {n, step_lo, id_lo, id_hi}.
+ * Each block yields four 32-bit samples, and a stream holds 2^32 blocks.
+ * The device function philox4x32_10 in mumd.cl is bit-identical, so a
+ * (seed, id, step) stream is the same on any rank, thread or device, see
+ * tests/opencl/8-philox.
+ *
+ * @see Salmon et al., Parallel random numbers: as easy as 1, 2, 3, SC11.
+ */
+struct Philox : Engine<Philox> {
+    /* Random number generator engine constants. */
+    static constexpr uint32_t m_m0 = 0xD2511F53U;   /* round multipliers */
+    static constexpr uint32_t m_m1 = 0xCD9E8D57U;
+    static constexpr uint32_t m_w0 = 0x9E3779B9U;   /* key schedule, golden */
+    static constexpr uint32_t m_w1 = 0xBB67AE85U;   /* ratio and sqrt(3)-1 */
+    static constexpr uint32_t m_rounds = 10;
+
+    /* Random number generator engine state. */
+    uint32_t m_key[2];      /* seed */
+    uint32_t m_ctr[4];      /* block index, step and stream id */
+    uint32_t m_out[4];      /* current block of samples */
+    uint32_t m_ix;          /* next sample in the block */
+
+    /* Random number generator engine initialisation and sampling functions. */
+    void init(void);
+    uint32_t rand32 (void);
+    uint64_t rand64 (void);
+
+    /* Counter-based engine functions. */
+    void seek(const uint64_t id, const uint64_t step);
+    static void block(
+        const uint32_t ctr[4],
+        const uint32_t key[2],
+        uint32_t out[4]);
+
+    /* Constructor/destructor. */
+    Philox(const uint64_t seed = 0, const uint64_t id = 0,
+        const uint64_t step = 0) {
+        m_key[0] = (uint32_t) (seed);
+        m_key[1] = (uint32_t) (seed >> 32);
+        seek(id, step);
+    }
+    ~Philox() = default;
+
+    /* Copy constructor/assignment. */
+    Philox(const Philox &other) : m_ix(other.m_ix) {
+        std::memcpy(m_key, other.m_key, sizeof(m_key));
+        std::memcpy(m_ctr, other.m_ctr, sizeof(m_ctr));
+        std::memcpy(m_out, other.m_out, sizeof(m_out));
+    }
+    Philox &operator=(const Philox &other) {
+        if (this == &other) {
+            return *this;
+        }
+        m_ix = other.m_ix;
+        std::memcpy(m_key, other.m_key, sizeof(m_key));
+        std::memcpy(m_ctr, other.m_ctr, sizeof(m_ctr));
+        std::memcpy(m_out, other.m_out, sizeof(m_out));
+        return *this;
+    }
+};
+
+/**
+ * Philox::init
+ * @brief Seed the key of the Philox engine from the random device, and
+ * rewind the counter to the first block of its stream.
+ */
+core_inline
+void Philox::init(void)
+{
+    m_key[0] = randev();
+    m_key[1] = randev();
+    m_ctr[0] = 0;
+    m_ix = 4;
+}
+
+/**
+ * Philox::seek
+ * @brief Move the engine to the first block of the stream of particle id at
+ * the given step. Only the lower 32 bits of the step are used.
+ */
+core_inline
+void Philox::seek(const uint64_t id, const uint64_t step)
+{
+    m_ctr[0] = 0;
+    m_ctr[1] = (uint32_t) (step);
+    m_ctr[2] = (uint32_t) (id);
+    m_ctr[3] = (uint32_t) (id >> 32);
+    m_ix = 4;
+}
+
+/**
+ * Philox::block
+ * @brief Compute the block of four 32-bit samples of a counter and a key,
+ * with ten rounds of the Philox S-box and a Weyl sequence key schedule,
+ *  {hi1 ^ c1 ^ k0, lo1, hi0 ^ c3 ^ k1, lo0},
+ * where hi_i:lo_i is the 64-bit product m_i * c_2i.
+ */
+core_inline
+void Philox::block(
+    const uint32_t ctr[4],
+    const uint32_t key[2],
+    uint32_t out[4])
+{
+    uint32_t c[4] = {ctr[0], ctr[1], ctr[2], ctr[3]};
+    uint32_t k[2] = {key[0], key[1]};
+    for (uint32_t r = 0; r < m_rounds; ++r) {
+        const uint64_t p0 = (uint64_t) m_m0 * c[0];
+        const uint64_t p1 = (uint64_t) m_m1 * c[2];
+        c[0] = (uint32_t) (p1 >> 32) ^ c[1] ^ k[0];
+        c[1] = (uint32_t) (p1);
+        c[2] = (uint32_t) (p0 >> 32) ^ c[3] ^ k[1];
+        c[3] = (uint32_t) (p0);
+        k[0] += m_w0;
+        k[1] += m_w1;
+    }
+    std::memcpy(out, c, sizeof(c));
+}
+
+/**
+ * Philox::rand32
+ * @brief Return the next 32-bit sample of the current block, and compute
+ * the next block of the stream when it is exhausted.
+ */
+core_inline
+uint32_t Philox::rand32 (void)
+{
+    if (m_ix == 4) {
+        block(m_ctr, m_key, m_out);
+        m_ctr[0]++;
+        m_ix = 0;
+    }
+    return m_out[m_ix++];
+}
+
+/**
+ * Philox::rand64
+ * @brief Return a 64-bit sample from two consecutive 32-bit samples, the
+ * first one in the lower half.
+ */
+core_inline
+uint64_t Philox::rand64 (void)
+{
+    const uint64_t lo = rand32();
+    const uint64_t hi = rand32();
+    return (lo | (hi << 32));
+}
+
 /** ---- Random number generator samplers -------------------------------------
  * uniform
  * @brief Sample a random number from a uniform distribution in interval [a,b].
@@ -369,6 +369,24 @@ std::string get_info_string(const cl_device_id &device)
     return ss.str();
 }
 
+/**
+ * get_info_size
+ * @brief Wrapper for clGetDeviceInfo. Return the value of a size_t device
+ * parameter, such as CL_DEVICE_IMAGE2D_MAX_WIDTH.
+ */
+size_t get_info_size(const cl_device_id &device, cl_device_info param_name)
+{
+    size_t param_value = 0;
+    cl_int err = clGetDeviceInfo(
+        device,
+        param_name,
+        sizeof(size_t),
+        &param_value,
+        NULL);
+    core_assert(err == CL_SUCCESS, "clGetDeviceInfo");
+    return param_value;
+}
+
 } /* Device */
 } /* cl */
 } /* atto */
@@ -48,6 +48,13 @@ cl_int release(const cl_device_id &device);
  */
 std::string get_info_string(const cl_device_id &device);
 
+/**
+ * get_info_size
+ * @brief Wrapper for clGetDeviceInfo. Return the value of a size_t device
+ * parameter, such as CL_DEVICE_IMAGE2D_MAX_WIDTH.
+ */
+size_t get_info_size(const cl_device_id &device, cl_device_info param_name);
+
 } /* Device */
 } /* cl */
 } /* atto */
@@ -0,0 +1,99 @@
+/*
+ * test-fft.cpp
+ *
+ * Copyright (c) 2020 Carlos Braga
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the MIT License.
+ *
+ * See accompanying LICENSE.md or https://opensource.org/licenses/MIT.
+ */
+
+#include "Catch2/catch.hpp"
+
+#include "../common.hpp"
+using namespace atto;
+
+/** ---------------------------------------------------------------------------
+ * dft
+ * Reference O(n^2) discrete Fourier transform of a strided line.
+ */
+template<typename T>
+static std::vector<std::complex<T>> dft(
+    const std::vector<std::complex<T>> &data,
+    const size_t n,
+    const size_t stride,
+    const int sign)
+{
+    std::vector<std::complex<T>> result(n);
+    for (size_t m = 0; m < n; ++m) {
+        std::complex<double> sum(0.0, 0.0);
+        for (size_t k = 0; k < n; ++k) {
+            double arg = (sign < 0 ? -2.0 : 2.0) * M_PI *
+                (double) ((m * k) % n) / (double) n;
+            std::complex<double> u(
+                (double) data[k*stride].real(),
+                (double) data[k*stride].imag());
+            sum += u * std::complex<double>(std::cos(arg), std::sin(arg));
+        }
+        result[m] = std::complex<T>((T) sum.real(), (T) sum.imag());
+    }
+    return result;
+}
+
+/** ---------------------------------------------------------------------------
+ * test_fft
+ * Compare the radix-2 transform against the reference transform.
+ */
+template<typename T>
+static void test_fft(const T tolerance)
+{
+    math::rng::Kiss engine(true);
+    math::rng::uniform<T> rand;
+
+    for (size_t n = 1; n <= 1024; n <<= 1) {
+        for (size_t stride = 1; stride <= 3; ++stride) {
+            std::vector<std::complex<T>> data(n * stride);
+            for (auto &u : data) {
+                u = std::complex<T>(
+                    rand(engine, (T) -1, (T) 1),
+                    rand(engine, (T) -1, (T) 1));
+            }
+
+            math::fft::Plan<T> plan(n);
+            for (int sign = -1; sign <= 1; sign += 2) {
+                std::vector<std::complex<T>> result = data;
+                math::fft::transform(plan, result.data(), stride, sign);
+
+                std::vector<std::complex<T>> reference =
+                    dft(data, n, stride, sign);
+                for (size_t m = 0; m < n; ++m) {
+                    REQUIRE(std::abs(result[m*stride] - reference[m]) <=
+                        tolerance * (T) n);
+                }
+            }
+
+            /* Forward and backward transforms scale the data by n. */
+            std::vector<std::complex<T>> result = data;
+            math::fft::transform(plan, result.data(), stride, -1);
+            math::fft::transform(plan, result.data(), stride, 1);
+            for (size_t k = 0; k < n; ++k) {
+                REQUIRE(std::abs(result[k*stride] / (T) n - data[k*stride]) <=
+                    tolerance * (T) n);
+            }
+        }
+    }
+}
+
+/** ---------------------------------------------------------------------------
+ * FFT test client.
+ */
+TEST_CASE("FFT") {
+    SECTION("FFT-float") {
+        test_fft<float>(1.0e-5f);
+    }
+
+    SECTION("FFT-double") {
+        test_fft<double>(1.0e-12);
+    }
+}
@@ -0,0 +1,35 @@
+/*
+ * test-batch.cpp
+ *
+ * Copyright (c) 2020 Carlos Braga
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the MIT License.
+ *
+ * See accompanying LICENSE.md or https://opensource.org/licenses/MIT.
+ */
+
+#include "Catch2/catch.hpp"
+
+#include "test-batch.hpp"
+using namespace atto;
+
+TEST_CASE("Batch") {
+    const size_t n_iters = 8;
+    const size_t n_items = 1048573;
+
+    for (size_t i = 0; i < n_iters; ++i) {
+        auto tic = std::chrono::high_resolution_clock::now();
+        test_batch<float>(n_items);
+        test_batch<double>(n_items);
+        auto toc = std::chrono::high_resolution_clock::now();
+        std::chrono::duration<double,std::ratio<1,1000>> msec = toc-tic;
+        std::cout << msec.count() << " msec\n";
+    }
+
+    /* Short arrays, all in the remainder of a full register. */
+    for (size_t n = 0; n <= 16; ++n) {
+        test_batch<float>(n);
+        test_batch<double>(n);
+    }
+}
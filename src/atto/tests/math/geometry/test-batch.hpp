@@ -0,0 +1,221 @@
+/*
+ * test-batch.hpp
+ *
+ * Copyright (c) 2020 Carlos Braga
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the MIT License.
+ *
+ * See accompanying LICENSE.md or https://opensource.org/licenses/MIT.
+ */
+
+#ifndef TEST_CORE_GEOMETRY_BATCH_H_
+#define TEST_CORE_GEOMETRY_BATCH_H_
+
+#include <random>
+#include "../common.hpp"
+
+/*
+ * test_batch
+ * @brief Compare the batch operations with the single vector operations.
+ */
+template<typename Type>
+core_inline
+void test_batch(const size_t n_items)
+{
+    using namespace atto;
+
+    /*
+     * Create two arrays of random 4d-vectors, and use their first three
+     * components as 3d-vectors.
+     */
+    std::vector<std::vector<Type>> a(4, std::vector<Type>(n_items));
+    std::vector<std::vector<Type>> b(4, std::vector<Type>(n_items));
+    std::vector<std::vector<Type>> c(4, std::vector<Type>(n_items));
+    std::vector<Type> r(n_items);
+    {
+        std::random_device seed;
+        std::mt19937 rng(seed());
+        std::normal_distribution<Type> dist((Type) 0, (Type) 1);
+        for (size_t k = 0; k < 4; ++k) {
+            for (size_t i = 0; i < n_items; ++i) {
+                a[k][i] = dist(rng);
+                b[k][i] = dist(rng);
+            }
+        }
+    }
+
+    math::mat3<Type> m3(
+        (Type) 1, (Type) 2, (Type) 3,
+        (Type) -4, (Type) 5, (Type) 6,
+        (Type) 7, (Type) -8, (Type) 9);
+    math::mat4<Type> m4(
+        (Type) 1, (Type) 2, (Type) 3, (Type) 4,
+        (Type) -5, (Type) 6, (Type) 7, (Type) 8,
+        (Type) 9, (Type) -10, (Type) 11, (Type) 12,
+        (Type) 13, (Type) 14, (Type) -15, (Type) 16);
+
+    auto vec3_a = [&](size_t i) -> math::vec3<Type> {
+        return math::vec3<Type>(a[0][i], a[1][i], a[2][i]);
+    };
+    auto vec3_b = [&](size_t i) -> math::vec3<Type> {
+        return math::vec3<Type>(b[0][i], b[1][i], b[2][i]);
+    };
+    auto vec4_a = [&](size_t i) -> math::vec4<Type> {
+        return math::vec4<Type>(a[0][i], a[1][i], a[2][i], a[3][i]);
+    };
+    auto vec4_b = [&](size_t i) -> math::vec4<Type> {
+        return math::vec4<Type>(b[0][i], b[1][i], b[2][i], b[3][i]);
+    };
+
+    /*
+     * 3d-vector operations
+     */
+    math::batch::dot(n_items,
+        a[0].data(), a[1].data(), a[2].data(),
+        b[0].data(), b[1].data(), b[2].data(),
+        r.data());
+    for (size_t i = 0; i < n_items; ++i) {
+        REQUIRE(math::isequal(r[i], math::dot(vec3_a(i), vec3_b(i))));
+    }
+
+    math::batch::cross(n_items,
+        a[0].data(), a[1].data(), a[2].data(),
+        b[0].data(), b[1].data(), b[2].data(),
+        c[0].data(), c[1].data(), c[2].data());
+    for (size_t i = 0; i < n_items; ++i) {
+        math::vec3<Type> v = math::cross(vec3_a(i), vec3_b(i));
+        for (size_t k = 0; k < 3; ++k) {
+            REQUIRE(math::isequal(c[k][i], v(k)));
+        }
+    }
+
+    math::batch::norm(n_items,
+        a[0].data(), a[1].data(), a[2].data(),
+        r.data());
+    for (size_t i = 0; i < n_items; ++i) {
+        REQUIRE(math::isequal(r[i], math::norm(vec3_a(i))));
+    }
+
+    math::batch::normalize(n_items,
+        a[0].data(), a[1].data(), a[2].data(),
+        c[0].data(), c[1].data(), c[2].data());
+    for (size_t i = 0; i < n_items; ++i) {
+        math::vec3<Type> v = math::normalize(vec3_a(i));
+        for (size_t k = 0; k < 3; ++k) {
+            REQUIRE(math::isequal(c[k][i], v(k)));
+        }
+    }
+
+    math::batch::distance(n_items,
+        a[0].data(), a[1].data(), a[2].data(),
+        b[0].data(), b[1].data(), b[2].data(),
+        r.data());
+    for (size_t i = 0; i < n_items; ++i) {
+        REQUIRE(math::isequal(r[i], math::distance(vec3_a(i), vec3_b(i))));
+    }
+
+    math::batch::dot(n_items, m3,
+        a[0].data(), a[1].data(), a[2].data(),
+        c[0].data(), c[1].data(), c[2].data());
+    for (size_t i = 0; i < n_items; ++i) {
+        math::vec3<Type> v = math::dot(m3, vec3_a(i));
+        for (size_t k = 0; k < 3; ++k) {
+            REQUIRE(math::isequal(c[k][i], v(k)));
+        }
+    }
+
+    /*
+     * 4d-vector operations
+     */
+    math::batch::dot(n_items,
+        a[0].data(), a[1].data(), a[2].data(), a[3].data(),
+        b[0].data(), b[1].data(), b[2].data(), b[3].data(),
+        r.data());
+    for (size_t i = 0; i < n_items; ++i) {
+        REQUIRE(math::isequal(r[i], math::dot(vec4_a(i), vec4_b(i))));
+    }
+
+    math::batch::norm(n_items,
+        a[0].data(), a[1].data(), a[2].data(), a[3].data(),
+        r.data());
+    for (size_t i = 0; i < n_items; ++i) {
+        REQUIRE(math::isequal(r[i], math::norm(vec4_a(i))));
+    }
+
+    math::batch::normalize(n_items,
+        a[0].data(), a[1].data(), a[2].data(), a[3].data(),
+        c[0].data(), c[1].data(), c[2].data(), c[3].data());
+    for (size_t i = 0; i < n_items; ++i) {
+        math::vec4<Type> v = math::normalize(vec4_a(i));
+        for (size_t k = 0; k < 4; ++k) {
+            REQUIRE(math::isequal(c[k][i], v(k)));
+        }
+    }
+
+    math::batch::distance(n_items,
+        a[0].data(), a[1].data(), a[2].data(), a[3].data(),
+        b[0].data(), b[1].data(), b[2].data(), b[3].data(),
+        r.data());
+    for (size_t i = 0; i < n_items; ++i) {
+        REQUIRE(math::isequal(r[i], math::distance(vec4_a(i), vec4_b(i))));
+    }
+
+    math::batch::dot(n_items, m4,
+        a[0].data(), a[1].data(), a[2].data(), a[3].data(),
+        c[0].data(), c[1].data(), c[2].data(), c[3].data());
+    for (size_t i = 0; i < n_items; ++i) {
+        math::vec4<Type> v = math::dot(m4, vec4_a(i));
+        for (size_t k = 0; k < 4; ++k) {
+            REQUIRE(math::isequal(c[k][i], v(k)));
+        }
+    }
+
+    /*
+     * Quaternion operations, with the 4d-vectors a and b as quaternions.
+     */
+    auto quat_a = [&](size_t i) -> math::quat<Type> {
+        return math::quat<Type>(a[0][i], a[1][i], a[2][i], a[3][i]);
+    };
+    auto quat_b = [&](size_t i) -> math::quat<Type> {
+        return math::quat<Type>(b[0][i], b[1][i], b[2][i], b[3][i]);
+    };
+
+    math::batch::product(n_items,
+        a[0].data(), a[1].data(), a[2].data(), a[3].data(),
+        b[0].data(), b[1].data(), b[2].data(), b[3].data(),
+        c[0].data(), c[1].data(), c[2].data(), c[3].data());
+    for (size_t i = 0; i < n_items; ++i) {
+        math::quat<Type> q = quat_a(i) * quat_b(i);
+        for (size_t k = 0; k < 4; ++k) {
+            REQUIRE(math::isequal(c[k][i], q(k)));
+        }
+    }
+
+    math::batch::rotate(n_items,
+        a[0].data(), a[1].data(), a[2].data(), a[3].data(),
+        b[0].data(), b[1].data(), b[2].data(),
+        c[0].data(), c[1].data(), c[2].data());
+    for (size_t i = 0; i < n_items; ++i) {
+        math::vec3<Type> v = math::rotate(quat_a(i), vec3_b(i));
+        for (size_t k = 0; k < 3; ++k) {
+            REQUIRE(math::isequal(c[k][i], v(k)));
+        }
+    }
+
+    /*
+     * In place operations on the input arrays.
+     */
+    std::vector<std::vector<Type>> d(a);
+    math::batch::normalize(n_items,
+        d[0].data(), d[1].data(), d[2].data(),
+        d[0].data(), d[1].data(), d[2].data());
+    math::batch::norm(n_items,
+        d[0].data(), d[1].data(), d[2].data(),
+        r.data());
+    for (size_t i = 0; i < n_items; ++i) {
+        REQUIRE(math::isequal(r[i], (Type) 1));
+    }
+}
+
+#endif /* TEST_CORE_GEOMETRY_BATCH_H_ */
@@ -0,0 +1,49 @@
+/*
+ * test-box.cpp
+ *
+ * Copyright (c) 2020 Carlos Braga
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the MIT License.
+ *
+ * See accompanying LICENSE.md or https://opensource.org/licenses/MIT.
+ */
+
+#include "Catch2/catch.hpp"
+
+#include "test-box.hpp"
+using namespace atto;
+
+TEST_CASE("Box") {
+    const size_t n_iters = 8;
+    const size_t n_items = 1048573;
+
+    for (size_t i = 0; i < n_iters; ++i) {
+        auto tic = std::chrono::high_resolution_clock::now();
+        test_box(math::OrthoBoxf::create_from_bounds(
+            math::vec3f(-1.0f, 0.0f, 2.0f),
+            math::vec3f(9.0f, 12.0f, 7.0f)), n_items);
+        test_box(math::OrthoBoxd::create_from_bounds(
+            math::vec3d(-1.0, 0.0, 2.0),
+            math::vec3d(9.0, 12.0, 7.0)), n_items);
+        test_box(math::TriclinicBoxf::create(
+            math::vec3f(-1.0f, 0.0f, 2.0f),
+            math::mat3f(
+                10.0f, 2.0f, -1.5f,
+                 0.0f, 9.0f,  3.0f,
+                 0.0f, 0.0f,  8.0f)), n_items);
+        test_box(math::TriclinicBoxd::create(
+            math::vec3d(-1.0, 0.0, 2.0),
+            math::mat3d(
+                10.0, 2.0, -1.5,
+                 0.0, 9.0,  3.0,
+                 0.0, 0.0,  8.0)), n_items);
+        auto toc = std::chrono::high_resolution_clock::now();
+        std::chrono::duration<double,std::ratio<1,1000>> msec = toc-tic;
+        std::cout << msec.count() << " msec\n";
+    }
+
+    /* Displacements of exactly half a cell length. */
+    test_box_ties<float>(13);
+    test_box_ties<double>(13);
+}
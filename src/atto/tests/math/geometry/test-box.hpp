@@ -0,0 +1,213 @@
+/*
+ * test-box.hpp
+ *
+ * Copyright (c) 2020 Carlos Braga
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the MIT License.
+ *
+ * See accompanying LICENSE.md or https://opensource.org/licenses/MIT.
+ */
+
+#ifndef TEST_CORE_GEOMETRY_BOX_H_
+#define TEST_CORE_GEOMETRY_BOX_H_
+
+#include <random>
+#include "../common.hpp"
+
+/**
+ * check_fractional
+ * @brief Check the fractional coordinates of a vector lie in [lo,hi].
+ */
+template<typename Type, bool Triclinic>
+core_inline
+bool check_fractional(
+    const atto::math::Box<Type, Triclinic> &box,
+    const atto::math::vec3<Type> &v,
+    const Type lo,
+    const Type hi)
+{
+    using namespace atto;
+
+    static const Type eps = (Type) 16 * std::numeric_limits<Type>::epsilon();
+    math::vec3<Type> s = math::dot(box.h_inv, v);
+    for (size_t k = 0; k < 3; ++k) {
+        if (s(k) < lo - eps || s(k) > hi + eps) {
+            std::cerr << core::str_format("s(%lu) %lf\n", k, s(k)) << "\n";
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * check_lattice
+ * @brief Check the vector is a lattice vector, a sum of whole cell vectors.
+ */
+template<typename Type, bool Triclinic>
+core_inline
+bool check_lattice(
+    const atto::math::Box<Type, Triclinic> &box,
+    const atto::math::vec3<Type> &v)
+{
+    using namespace atto;
+
+    static const Type eps = (Type) 16 * std::numeric_limits<Type>::epsilon();
+    math::vec3<Type> s = math::dot(box.h_inv, v);
+    for (size_t k = 0; k < 3; ++k) {
+        const Type scale = (Type) 1 + std::fabs(s(k));
+        if (std::fabs(s(k) - std::round(s(k))) > eps * scale) {
+            std::cerr << core::str_format("s(%lu) %lf\n", k, s(k)) << "\n";
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * check_equal
+ * @brief Check the vectors are equal within the rounding error.
+ */
+template<typename Type>
+core_inline
+bool check_equal(
+    const atto::math::vec3<Type> &u,
+    const atto::math::vec3<Type> &v)
+{
+    using namespace atto;
+
+    static const Type eps = (Type) 16 * std::numeric_limits<Type>::epsilon();
+    const Type scale = (Type) 1 + math::norm(u);
+    if (std::fabs(u(0) - v(0)) > eps * scale ||
+        std::fabs(u(1) - v(1)) > eps * scale ||
+        std::fabs(u(2) - v(2)) > eps * scale) {
+        std::cerr << u << " " << v << "\n";
+        return false;
+    }
+    return true;
+}
+
+/*
+ * test_box
+ */
+template<typename Type, bool Triclinic>
+core_inline
+void test_box(const atto::math::Box<Type, Triclinic> &box, const size_t n_items)
+{
+    using namespace atto;
+
+    /*
+     * Create positions spread over several cells around the box.
+     */
+    std::vector<Type> x(n_items);
+    std::vector<Type> y(n_items);
+    std::vector<Type> z(n_items);
+    std::vector<Type> ix(n_items, (Type) 0);
+    std::vector<Type> iy(n_items, (Type) 0);
+    std::vector<Type> iz(n_items, (Type) 0);
+    std::vector<Type> rx(n_items);
+    std::vector<Type> ry(n_items);
+    std::vector<Type> rz(n_items);
+    {
+        std::random_device seed;
+        std::mt19937 rng(seed());
+        std::uniform_real_distribution<Type> dist((Type) -2, (Type) 3);
+        for (size_t i = 0; i < n_items; ++i) {
+            math::vec3<Type> s(dist(rng), dist(rng), dist(rng));
+            math::vec3<Type> r = box.origin + math::dot(box.h, s);
+            x[i] = rx[i] = r(0);
+            y[i] = ry[i] = r(1);
+            z[i] = rz[i] = r(2);
+        }
+    }
+
+    /*
+     * Minimum image of the positions taken as displacements.
+     */
+    box.min_image(n_items, x.data(), y.data(), z.data());
+    for (size_t i = 0; i < n_items; ++i) {
+        math::vec3<Type> r(rx[i], ry[i], rz[i]);
+        math::vec3<Type> d(x[i], y[i], z[i]);
+        REQUIRE(check_fractional(box, d, (Type) -0.5, (Type) 0.5));
+        REQUIRE(check_lattice(box, r - d));
+
+        /* A single vector image may only differ at a rounding tie. */
+        math::vec3<Type> e = box.min_image(r);
+        REQUIRE(check_fractional(box, e, (Type) -0.5, (Type) 0.5));
+        REQUIRE(check_lattice(box, e - d));
+    }
+
+    /*
+     * Wrap the positions inside the cell and unwrap them back.
+     */
+    std::copy(rx.begin(), rx.end(), x.begin());
+    std::copy(ry.begin(), ry.end(), y.begin());
+    std::copy(rz.begin(), rz.end(), z.begin());
+    box.wrap(n_items,
+        x.data(), y.data(), z.data(),
+        ix.data(), iy.data(), iz.data());
+    for (size_t i = 0; i < n_items; ++i) {
+        math::vec3<Type> r(rx[i], ry[i], rz[i]);
+        math::vec3<Type> w(x[i], y[i], z[i]);
+        math::vec3<Type> image(ix[i], iy[i], iz[i]);
+        REQUIRE(check_fractional(box, w - box.origin, (Type) 0, (Type) 1));
+        REQUIRE(check_equal(r, box.unwrap(w, image)));
+
+        image = math::vec3<Type>((Type) 0);
+        math::vec3<Type> v = box.wrap(r, image);
+        REQUIRE(check_fractional(box, v - box.origin, (Type) 0, (Type) 1));
+        REQUIRE(check_equal(r, box.unwrap(v, image)));
+    }
+
+    box.unwrap(n_items,
+        x.data(), y.data(), z.data(),
+        ix.data(), iy.data(), iz.data());
+    for (size_t i = 0; i < n_items; ++i) {
+        math::vec3<Type> r(rx[i], ry[i], rz[i]);
+        REQUIRE(check_equal(r, math::vec3<Type>(x[i], y[i], z[i])));
+    }
+}
+
+/*
+ * test_box_ties
+ * @brief Check the batch and single vector minimum images round half a cell
+ * length to even, like the SIMD and OpenCL paths.
+ */
+template<typename Type>
+core_inline
+void test_box_ties(const size_t n_items)
+{
+    using namespace atto;
+
+    const math::Box<Type, false> box = math::Box<Type, false>::create_from_bounds(
+        math::vec3<Type>((Type) 0), math::vec3<Type>((Type) 8));
+
+    /* Odd multiples of half the cell length, s = +-0.5, +-1.5, ... */
+    std::vector<Type> x(n_items);
+    std::vector<Type> y(n_items);
+    std::vector<Type> z(n_items);
+    for (size_t i = 0; i < n_items; ++i) {
+        const Type m = (Type) ((long) i - (long) (n_items / 2));
+        x[i] = (Type) 4 * ((Type) 2 * m + (Type) 1);
+        y[i] = -x[i];
+        z[i] = x[i];
+    }
+    std::vector<Type> rx(x);
+    std::vector<Type> ry(y);
+    std::vector<Type> rz(z);
+
+    box.min_image(n_items, x.data(), y.data(), z.data());
+    for (size_t i = 0; i < n_items; ++i) {
+        math::vec3<Type> r(rx[i], ry[i], rz[i]);
+        math::vec3<Type> d = box.min_image(r);
+        for (size_t k = 0; k < 3; ++k) {
+            const Type s = r(k) * box.inv_length(k);
+            REQUIRE(d(k) == r(k) - box.length(k) * std::nearbyint(s));
+        }
+        REQUIRE(x[i] == d(0));
+        REQUIRE(y[i] == d(1));
+        REQUIRE(z[i] == d(2));
+    }
+}
+
+#endif /* TEST_CORE_GEOMETRY_BOX_H_ */
@@ -0,0 +1,73 @@
+/*
+ * test-dispatch.cpp
+ *
+ * Copyright (c) 2020 Carlos Braga
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the MIT License.
+ *
+ * See accompanying LICENSE.md or https://opensource.org/licenses/MIT.
+ */
+
+#include "Catch2/catch.hpp"
+
+#include "test-batch.hpp"
+#include "test-box.hpp"
+using namespace atto;
+
+#ifdef ATTO_CORE_DISPATCH
+/*
+ * test_dispatch
+ * @brief Compare the batch and box kernels of the current dispatch level
+ * with the single vector operations, on long and short arrays.
+ */
+static void test_dispatch(void)
+{
+    const size_t n_items = 65537;
+    std::cout << "dispatch " << core::cpu_dispatch_level() << "\n";
+
+    test_batch<float>(n_items);
+    test_batch<double>(n_items);
+    for (size_t n = 0; n <= 16; ++n) {
+        test_batch<float>(n);
+        test_batch<double>(n);
+    }
+
+    test_box(math::OrthoBoxd::create_from_bounds(
+        math::vec3d(-1.0, 0.0, 2.0),
+        math::vec3d(9.0, 12.0, 7.0)), n_items);
+    test_box(math::TriclinicBoxd::create(
+        math::vec3d(-1.0, 0.0, 2.0),
+        math::mat3d(
+            10.0, 2.0, -1.5,
+             0.0, 9.0,  3.0,
+             0.0, 0.0,  8.0)), n_items);
+    test_box_ties<double>(13);
+}
+#endif /* ATTO_CORE_DISPATCH */
+
+TEST_CASE("Dispatch") {
+#ifdef ATTO_CORE_DISPATCH
+    /*
+     * Run the kernels of every instruction set the processor supports,
+     * from the widest down to the generic loops, by clearing the features
+     * the dispatch selects from.
+     */
+    const core::CpuFeatures features = core::cpu_dispatch();
+    core::CpuFeatures &dispatch = core::cpu_dispatch();
+
+    test_dispatch();
+    dispatch.avx512f = false;
+    test_dispatch();
+    dispatch.avx2 = false;
+    dispatch.fma = false;
+    test_dispatch();
+    dispatch.avx = false;
+    test_dispatch();
+    REQUIRE(std::string(core::cpu_dispatch_level()) == "default");
+
+    dispatch = features;
+#else
+    std::cout << "dispatch disabled, build with dispatch=yes\n";
+#endif
+}
@@ -0,0 +1,96 @@
+/*
+ * test-performance-batch.hpp
+ *
+ * Copyright (c) 2020 Carlos Braga
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the MIT License.
+ *
+ * See accompanying LICENSE.md or https://opensource.org/licenses/MIT.
+ */
+
+#ifndef TEST_CORE_GEOMETRY_PERFORMANCE_BATCH_H_
+#define TEST_CORE_GEOMETRY_PERFORMANCE_BATCH_H_
+
+#include "../common.hpp"
+
+/**
+ * test_performance_batch
+ * @brief Batch vec3d performance test, the dot, norm and normalize tests
+ * of test_performance_vec3 over structure of arrays components.
+ */
+core_inline
+void test_performance_batch (const size_t n_items, const double maxeps)
+{
+    using namespace atto;
+
+    /*
+     * Create the component arrays of the vectors
+     */
+    std::vector<double> ax(n_items), ay(n_items), az(n_items);
+    std::vector<double> cx(n_items), cy(n_items), cz(n_items);
+    std::vector<double> dot_a(n_items), dot_c(n_items);
+    std::vector<double> norm_c(n_items), norm_u(n_items);
+
+    /*
+     * Create an array of random number generators
+     */
+    std::vector<math::rng::Kiss> engine;
+    core_pragma_omp(parallel default(none) shared(engine))
+    {
+        core_pragma_omp(master)
+        {
+            engine.resize(omp_get_num_threads());
+            for (auto &e : engine) { e.init(); }
+        }
+    } /* omp parallel */
+
+    core_pragma_omp(parallel for \
+        default(none) \
+        shared(n_items, ax, ay, az, cx, cy, cz, engine) \
+        schedule(static))
+    for (size_t ix = 0; ix < n_items; ++ix) {
+        size_t tid = omp_get_thread_num();
+        math::rng::gauss<double> rand;
+        ax[ix] = rand(engine[tid], rand_avg, rand_sdev);
+        ay[ix] = rand(engine[tid], rand_avg, rand_sdev);
+        az[ix] = rand(engine[tid], rand_avg, rand_sdev);
+        cx[ix] = 2.0 * ax[ix];
+        cy[ix] = 2.0 * ay[ix];
+        cz[ix] = 2.0 * az[ix];
+    }
+
+    /*
+     * Test dot, norm and normalize, one block of items per thread.
+     */
+    core_pragma_omp(parallel default(none) \
+        shared(n_items, ax, ay, az, cx, cy, cz, dot_a, dot_c, norm_c, norm_u))
+    {
+        size_t n_threads = omp_get_num_threads();
+        size_t block = (n_items + n_threads - 1) / n_threads;
+        size_t begin = std::min(omp_get_thread_num() * block, n_items);
+        size_t n = std::min(block, n_items - begin);
+
+        math::batch::dot(n,
+            &ax[begin], &ay[begin], &az[begin],
+            &ax[begin], &ay[begin], &az[begin], &dot_a[begin]);
+        math::batch::dot(n,
+            &cx[begin], &cy[begin], &cz[begin],
+            &cx[begin], &cy[begin], &cz[begin], &dot_c[begin]);
+        math::batch::norm(n,
+            &cx[begin], &cy[begin], &cz[begin], &norm_c[begin]);
+        math::batch::normalize(n,
+            &cx[begin], &cy[begin], &cz[begin],
+            &cx[begin], &cy[begin], &cz[begin]);
+        math::batch::norm(n,
+            &cx[begin], &cy[begin], &cz[begin], &norm_u[begin]);
+    } /* omp parallel */
+
+    for (size_t ix = 0; ix < n_items; ++ix) {
+        REQUIRE(math::isequal(dot_c[ix], 4.0*dot_a[ix]));
+        REQUIRE(math::isequal(norm_c[ix], 2.0*std::sqrt(dot_a[ix])));
+        REQUIRE(math::isequal(norm_u[ix], 1.0));
+    }
+}
+
+#endif /* TEST_CORE_GEOMETRY_PERFORMANCE_BATCH_H_ */
@@ -0,0 +1,169 @@
+/*
+ * test-performance-kernels.hpp
+ *
+ * Copyright (c) 2020 Carlos Braga
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the MIT License.
+ *
+ * See accompanying LICENSE.md or https://opensource.org/licenses/MIT.
+ */
+
+#ifndef TEST_CORE_GEOMETRY_PERFORMANCE_KERNELS_H_
+#define TEST_CORE_GEOMETRY_PERFORMANCE_KERNELS_H_
+
+#include "../common.hpp"
+
+/**
+ * test_performance_kernels
+ * @brief Time the double precision mat4 kernels and the batch normalize,
+ * over n_items per iteration. Build with avx512=no to time the AVX path
+ * on the same processor, and with fma=no to time it without FMA.
+ */
+core_inline
+void test_performance_kernels(
+    const size_t n_items,
+    const size_t n_iterations,
+    const double maxeps)
+{
+    using namespace atto;
+
+#if defined(ATTO_MATH_SIMD512)
+    const char *simd = "avx512";
+#elif defined(ATTO_MATH_SIMD)
+    const char *simd = "avx";
+#else
+    const char *simd = "none";
+#endif
+#ifdef __FMA__
+    const char *fma = "fma";
+#else
+    const char *fma = "no fma";
+#endif
+
+    /*
+     * Create the matrix arrays in aligned memory, and the component arrays
+     * of the vectors.
+     */
+    math::mat4<double> *arr_a =
+        core::align_alloc_array<math::mat4<double>>(n_items);
+    math::mat4<double> *arr_b =
+        core::align_alloc_array<math::mat4<double>>(n_items);
+    math::mat4<double> *arr_c =
+        core::align_alloc_array<math::mat4<double>>(n_items);
+    math::vec4<double> *arr_v =
+        core::align_alloc_array<math::vec4<double>>(n_items);
+    std::vector<double> ax(n_items), ay(n_items), az(n_items);
+    std::vector<double> rx(n_items), ry(n_items), rz(n_items);
+    std::vector<double> det(n_items);
+
+    math::rng::Kiss engine;
+    engine.init();
+    math::rng::gauss<double> rand;
+    for (size_t ix = 0; ix < n_items; ++ix) {
+        for (size_t j = 0; j < 4; ++j) {
+            for (size_t k = 0; k < 4; ++k) {
+                double mu = (j == k) ? rand_avg : 0.0;
+                arr_a[ix](j,k) = rand(engine, mu, rand_sdev);
+                arr_b[ix](j,k) = rand(engine, 0.0, rand_sdev);
+            }
+            arr_v[ix](j) = rand(engine, rand_avg, rand_sdev);
+        }
+        ax[ix] = rand(engine, rand_avg, rand_sdev);
+        ay[ix] = rand(engine, rand_avg, rand_sdev);
+        az[ix] = rand(engine, rand_avg, rand_sdev);
+    }
+
+    /*
+     * Time each kernel over the arrays.
+     */
+    auto time_kernel = [n_iterations] (std::function<void()> kernel) {
+        auto tic = std::chrono::high_resolution_clock::now();
+        for (size_t i = 0; i < n_iterations; ++i) {
+            kernel();
+        }
+        auto toc = std::chrono::high_resolution_clock::now();
+        std::chrono::duration<double,std::ratio<1,1000>> msec = toc-tic;
+        return msec.count();
+    };
+
+    double msec_dot = time_kernel([&] () {
+        for (size_t ix = 0; ix < n_items; ++ix) {
+            arr_c[ix] = math::dot(arr_a[ix], arr_b[ix]);
+        }
+    });
+    for (size_t ix = 0; ix < n_items; ix += n_items / 64 + 1) {
+        math::mat4<double> c = math::mat4<double>::zeros;
+        for (size_t j = 0; j < 4; ++j) {
+            for (size_t k = 0; k < 4; ++k) {
+                for (size_t l = 0; l < 4; ++l) {
+                    c(j,k) += arr_a[ix](j,l) * arr_b[ix](l,k);
+                }
+                REQUIRE(math::isequal(arr_c[ix](j,k), c(j,k)));
+            }
+        }
+    }
+
+    double msec_dotv = time_kernel([&] () {
+        for (size_t ix = 0; ix < n_items; ++ix) {
+            math::vec4<double> v = math::dot(arr_a[ix], arr_v[ix]);
+            det[ix] = v(0) + v(1) + v(2) + v(3);
+        }
+    });
+    for (size_t ix = 0; ix < n_items; ix += n_items / 64 + 1) {
+        double sum = 0.0;
+        for (size_t j = 0; j < 4; ++j) {
+            for (size_t k = 0; k < 4; ++k) {
+                sum += arr_a[ix](j,k) * arr_v[ix](k);
+            }
+        }
+        REQUIRE(math::isequal(det[ix], sum));
+    }
+
+    double msec_det = time_kernel([&] () {
+        for (size_t ix = 0; ix < n_items; ++ix) {
+            det[ix] = math::determinant(arr_a[ix]);
+        }
+    });
+
+    double msec_inverse = time_kernel([&] () {
+        for (size_t ix = 0; ix < n_items; ++ix) {
+            arr_c[ix] = math::inverse(arr_a[ix]);
+        }
+    });
+    for (size_t ix = 0; ix < n_items; ix += n_items / 64 + 1) {
+        math::mat4<double> ident = math::dot(arr_a[ix], arr_c[ix]);
+        for (size_t j = 0; j < 4; ++j) {
+            for (size_t k = 0; k < 4; ++k) {
+                double delta = (j == k) ? 1.0 : 0.0;
+                REQUIRE(std::fabs(ident(j,k) - delta) < maxeps);
+            }
+        }
+        double det_inv = math::determinant(arr_c[ix]);
+        REQUIRE(std::fabs(det[ix] * det_inv - 1.0) < maxeps);
+    }
+
+    double msec_normalize = time_kernel([&] () {
+        math::batch::normalize(n_items,
+            ax.data(), ay.data(), az.data(),
+            rx.data(), ry.data(), rz.data());
+    });
+    math::batch::norm(n_items, rx.data(), ry.data(), rz.data(), ax.data());
+    for (size_t ix = 0; ix < n_items; ++ix) {
+        REQUIRE(math::isequal(ax[ix], 1.0));
+    }
+
+    std::cout << core::str_format(
+        "simd %s, %s: mat4 dot %.3lf msec, mat4 dot vec4 %.3lf msec, "
+        "mat4 determinant %.3lf msec, mat4 inverse %.3lf msec, "
+        "batch normalize %.3lf msec\n",
+        simd, fma, msec_dot, msec_dotv, msec_det, msec_inverse,
+        msec_normalize);
+
+    core::align_free_array(arr_a, n_items);
+    core::align_free_array(arr_b, n_items);
+    core::align_free_array(arr_c, n_items);
+    core::align_free_array(arr_v, n_items);
+}
+
+#endif /* TEST_CORE_GEOMETRY_PERFORMANCE_KERNELS_H_ */
@@ -16,24 +16,25 @@
 
 /**
  * test_performance_mat2
- * @brief mat2d performance test.
+ * @brief mat2<Type> performance test.
  */
+template<typename Type>
 core_inline
 void test_performance_mat2 (const size_t n_items, const double maxeps)
 {
     using namespace atto;
 
     const size_t dim = 2;
-    const math::mat2d zero(0.0);
-    const math::mat2d one(1.0);
-    const math::mat2d two(2.0);
+    const math::mat2<Type> zero((Type) 0);
+    const math::mat2<Type> one((Type) 1);
+    const math::mat2<Type> two((Type) 2);
 
     /*
      * Create an array of matrixs
      */
-    std::vector<math::mat2d> arr_a(n_items, one);
-    std::vector<math::mat2d> arr_b(n_items, two);
-    std::vector<math::mat2d> arr_c(n_items, zero);
+    std::vector<math::mat2<Type>> arr_a(n_items, one);
+    std::vector<math::mat2<Type>> arr_b(n_items, two);
+    std::vector<math::mat2<Type>> arr_c(n_items, zero);
 
     /*
      * Create an array of random number generators
@@ -57,14 +58,14 @@ void test_performance_mat2 (const size_t n_items, const double maxeps)
         schedule(static))
     for (size_t ix = 0; ix < n_items; ++ix) {
         size_t tid = omp_get_thread_num();
-        math::rng::gauss<double> rand;
+        math::rng::gauss<Type> rand;
 
-        arr_a[ix] = math::mat2d(
-            rand(engine[tid], rand_sdev, 0.0),
-            rand(engine[tid], rand_sdev, 0.0),
-            rand(engine[tid], rand_sdev, 0.0),
-            rand(engine[tid], rand_sdev, 0.0));
-        arr_b[ix] = arr_a[ix] * (-1.0);
+        arr_a[ix] = math::mat2<Type>(
+            rand(engine[tid], (Type) 0, rand_sdev),
+            rand(engine[tid], (Type) 0, rand_sdev),
+            rand(engine[tid], (Type) 0, rand_sdev),
+            rand(engine[tid], (Type) 0, rand_sdev));
+        arr_b[ix] = arr_a[ix] * (Type) (-1);
 
         /*
          * Test arithmetic functions
@@ -72,7 +73,7 @@ void test_performance_mat2 (const size_t n_items, const double maxeps)
         arr_c[ix] = arr_a[ix] + arr_b[ix];      /* 1 + (-1) = 0 */
         for (size_t j = 0; j < dim; ++j) {
             for (size_t k = 0; k < dim; ++k) {
-                REQUIRE(math::isequal(arr_c[ix](j, k), 0.0));
+                REQUIRE(math::isequal(arr_c[ix](j, k), (Type) 0));
             }
         }
 
@@ -89,7 +90,7 @@ void test_performance_mat2 (const size_t n_items, const double maxeps)
         (arr_c[ix] = arr_a[ix]) += arr_b[ix];   /* 1 + (-1) = 0 */
         for (size_t j = 0; j < dim; ++j) {
             for (size_t k = 0; k < dim; ++k) {
-                REQUIRE(math::isequal(arr_c[ix](j, k), 0.0));
+                REQUIRE(math::isequal(arr_c[ix](j, k), (Type) 0));
             }
         }
 
@@ -103,18 +104,18 @@ void test_performance_mat2 (const size_t n_items, const double maxeps)
         /*
          * Test algebraic operators
          */
-        arr_a[ix] = math::mat2d(
-            rand(engine[tid], rand_sdev, rand_avg),
-            rand(engine[tid], rand_sdev, 0.0),
-            rand(engine[tid], rand_sdev, 0.0),
-            rand(engine[tid], rand_sdev, rand_avg));
+        arr_a[ix] = math::mat2<Type>(
+            rand(engine[tid], rand_avg, rand_sdev),
+            rand(engine[tid], (Type) 0, rand_sdev),
+            rand(engine[tid], (Type) 0, rand_sdev),
+            rand(engine[tid], rand_avg, rand_sdev));
 
         /* Matrix transpose */
         arr_b[ix] = transpose(arr_a[ix]);       /* b = a^t */
         arr_c[ix] = dot(arr_a[ix], arr_b[ix]);  /* c = a * a^t */
-        double det_a = determinant(arr_a[ix]);
-        double det_b = determinant(arr_b[ix]);
-        double det_c = determinant(arr_c[ix]);
+        Type det_a = determinant(arr_a[ix]);
+        Type det_b = determinant(arr_b[ix]);
+        Type det_c = determinant(arr_c[ix]);
         REQUIRE(math::isequal(det_a, det_b));
         REQUIRE(math::isequal(det_a*det_b, det_c));
 
@@ -122,7 +123,7 @@ void test_performance_mat2 (const size_t n_items, const double maxeps)
         arr_b[ix] = inverse(arr_a[ix]);         /* b = a^(-1) */
         arr_c[ix] = dot(arr_a[ix], arr_b[ix]);  /* c = a * a^(-1) */
 
-        math::mat2d ident = math::mat2d::eye;
+        math::mat2<Type> ident = math::mat2<Type>::eye;
         for (size_t j = 0; j < dim; ++j) {
             for (size_t k = 0; k < dim; ++k) {
                 REQUIRE(math::isequal(arr_c[ix](j,k), ident(j,k)));
@@ -130,16 +131,16 @@ void test_performance_mat2 (const size_t n_items, const double maxeps)
         }
 
         /* Matrix solve */
-        math::vec2d vec_b(
-            rand(engine[tid], rand_sdev, rand_avg),
-            rand(engine[tid], rand_sdev, rand_avg));
-        math::mat2d inv_a = inverse(arr_a[ix]);
+        math::vec2<Type> vec_b(
+            rand(engine[tid], rand_avg, rand_sdev),
+            rand(engine[tid], rand_avg, rand_sdev));
+        math::mat2<Type> inv_a = inverse(arr_a[ix]);
         /*
          * x = a^-1 * arr_b[ix]); err = a * x - b
          */
-        math::vec2d vec_x = inverse(arr_a[ix]) * vec_b;
-        math::vec2d err = vec_b - (arr_a[ix] * vec_x);
-        REQUIRE(math::isequal(norm(err), 0.0));
+        math::vec2<Type> vec_x = inverse(arr_a[ix]) * vec_b;
+        math::vec2<Type> err = vec_b - (arr_a[ix] * vec_x);
+        REQUIRE(math::isequal(norm(err), (Type) 0));
     }
 }
 
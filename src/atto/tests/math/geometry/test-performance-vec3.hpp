@@ -16,24 +16,25 @@
 
 /**
  * test_performance_vec3
- * @brief vec3d performance test.
+ * @brief vec3<Type> performance test.
  */
+template<typename Type>
 core_inline
 void test_performance_vec3 (const size_t n_items, const double maxeps)
 {
     using namespace atto;
 
     const size_t dim = 3;
-    const math::vec3d zero(0.0);
-    const math::vec3d one(1.0);
-    const math::vec3d two(2.0);
+    const math::vec3<Type> zero((Type) 0);
+    const math::vec3<Type> one((Type) 1);
+    const math::vec3<Type> two((Type) 2);
 
     /*
      * Create an array of vectors
      */
-    std::vector<math::vec3d> arr_a(n_items, one);
-    std::vector<math::vec3d> arr_b(n_items, two);
-    std::vector<math::vec3d> arr_c(n_items, zero);
+    std::vector<math::vec3<Type>> arr_a(n_items, one);
+    std::vector<math::vec3<Type>> arr_b(n_items, two);
+    std::vector<math::vec3<Type>> arr_c(n_items, zero);
 
     /*
      * Create an array of random number generators
@@ -57,20 +58,20 @@ void test_performance_vec3 (const size_t n_items, const double maxeps)
         schedule(static))
     for (size_t ix = 0; ix < n_items; ++ix) {
         size_t tid = omp_get_thread_num();
-        math::rng::gauss<double> rand;
+        math::rng::gauss<Type> rand;
 
-        arr_a[ix] = math::vec3d(
-            rand(engine[tid], rand_sdev, rand_avg),
-            rand(engine[tid], rand_sdev, rand_avg),
-            rand(engine[tid], rand_sdev, rand_avg));
-        arr_b[ix] = arr_a[ix] * (-1.0);
+        arr_a[ix] = math::vec3<Type>(
+            rand(engine[tid], rand_avg, rand_sdev),
+            rand(engine[tid], rand_avg, rand_sdev),
+            rand(engine[tid], rand_avg, rand_sdev));
+        arr_b[ix] = arr_a[ix] * (Type) (-1);
 
         /*
          * Test arithmetic functions
          */
         arr_c[ix] = arr_a[ix] + arr_b[ix];      /* 1 + (-1) = 0 */
         for (size_t j = 0; j < dim; ++j) {
-            REQUIRE(math::isequal(arr_c[ix](j), 0.0));
+            REQUIRE(math::isequal(arr_c[ix](j), (Type) 0));
         }
 
         arr_c[ix] = arr_a[ix] - arr_b[ix];      /* 1 - (-1) = 2 */
@@ -83,7 +84,7 @@ void test_performance_vec3 (const size_t n_items, const double maxeps)
          */
         (arr_c[ix] = arr_a[ix]) += arr_b[ix];   /* 1 + (-1) = 0 */
         for (size_t j = 0; j < dim; ++j) {
-            REQUIRE(math::isequal(arr_c[ix](j), 0.0));
+            REQUIRE(math::isequal(arr_c[ix](j), (Type) 0));
         }
 
         (arr_c[ix] = arr_a[ix]) -= arr_b[ix];   /* 1 - (-1) = 2 */
@@ -95,10 +96,10 @@ void test_performance_vec3 (const size_t n_items, const double maxeps)
         arr_c[ix] = arr_a[ix] - arr_b[ix];
 
         REQUIRE(math::isequal(
-            dot(arr_c[ix], arr_c[ix]), 4.0*dot(arr_a[ix], arr_a[ix])));
+            dot(arr_c[ix], arr_c[ix]), (Type) 4 * dot(arr_a[ix], arr_a[ix])));
         REQUIRE(math::isequal(
-            norm(arr_c[ix]), 2.0*std::sqrt(dot(arr_a[ix], arr_a[ix]))));
-        REQUIRE(math::isequal(norm(normalize(arr_c[ix])), 1.0));
+            norm(arr_c[ix]), (Type) 2 * std::sqrt(dot(arr_a[ix], arr_a[ix]))));
+        REQUIRE(math::isequal(norm(normalize(arr_c[ix])), (Type) 1));
     }
 }
 
@@ -17,6 +17,8 @@
 #include "test-performance-mat2.hpp"
 #include "test-performance-mat3.hpp"
 #include "test-performance-mat4.hpp"
+#include "test-performance-batch.hpp"
+#include "test-performance-kernels.hpp"
 using namespace atto;
 
 /** ---------------------------------------------------------------------------
@@ -34,7 +36,17 @@ TEST_CASE("Performance") {
     SECTION("Performance-vec2") {
         auto tic = std::chrono::high_resolution_clock::now();
         for (size_t i = 0; i < n_iterations; ++i) {
-            test_performance_vec2(n_items, maxeps);
+            test_performance_vec2<double>(n_items, maxeps);
+        }
+        auto toc = std::chrono::high_resolution_clock::now();
+        std::chrono::duration<double,std::ratio<1,1000>> msec = toc-tic;
+        std::cout << msec.count() << " msec\n";
+    }
+
+    SECTION("Performance-vec2 float") {
+        auto tic = std::chrono::high_resolution_clock::now();
+        for (size_t i = 0; i < n_iterations; ++i) {
+            test_performance_vec2<float>(n_items, maxeps);
         }
         auto toc = std::chrono::high_resolution_clock::now();
         std::chrono::duration<double,std::ratio<1,1000>> msec = toc-tic;
@@ -44,7 +56,17 @@ TEST_CASE("Performance") {
     SECTION("Performance-vec3") {
         auto tic = std::chrono::high_resolution_clock::now();
         for (size_t i = 0; i < n_iterations; ++i) {
-            test_performance_vec3(n_items, maxeps);
+            test_performance_vec3<double>(n_items, maxeps);
+        }
+        auto toc = std::chrono::high_resolution_clock::now();
+        std::chrono::duration<double,std::ratio<1,1000>> msec = toc-tic;
+        std::cout << msec.count() << " msec\n";
+    }
+
+    SECTION("Performance-vec3 float") {
+        auto tic = std::chrono::high_resolution_clock::now();
+        for (size_t i = 0; i < n_iterations; ++i) {
+            test_performance_vec3<float>(n_items, maxeps);
         }
         auto toc = std::chrono::high_resolution_clock::now();
         std::chrono::duration<double,std::ratio<1,1000>> msec = toc-tic;
@@ -54,7 +76,27 @@ TEST_CASE("Performance") {
     SECTION("Performance-vec4") {
         auto tic = std::chrono::high_resolution_clock::now();
         for (size_t i = 0; i < n_iterations; ++i) {
-            test_performance_vec4(n_items, maxeps);
+            test_performance_vec4<double>(n_items, maxeps);
+        }
+        auto toc = std::chrono::high_resolution_clock::now();
+        std::chrono::duration<double,std::ratio<1,1000>> msec = toc-tic;
+        std::cout << msec.count() << " msec\n";
+    }
+
+    SECTION("Performance-vec4 float") {
+        auto tic = std::chrono::high_resolution_clock::now();
+        for (size_t i = 0; i < n_iterations; ++i) {
+            test_performance_vec4<float>(n_items, maxeps);
+        }
+        auto toc = std::chrono::high_resolution_clock::now();
+        std::chrono::duration<double,std::ratio<1,1000>> msec = toc-tic;
+        std::cout << msec.count() << " msec\n";
+    }
+
+    SECTION("Performance-batch") {
+        auto tic = std::chrono::high_resolution_clock::now();
+        for (size_t i = 0; i < n_iterations; ++i) {
+            test_performance_batch(n_items, maxeps);
         }
         auto toc = std::chrono::high_resolution_clock::now();
         std::chrono::duration<double,std::ratio<1,1000>> msec = toc-tic;
@@ -64,7 +106,17 @@ TEST_CASE("Performance") {
     SECTION("Performance mat2") {
         auto tic = std::chrono::high_resolution_clock::now();
         for (size_t i = 0; i < n_iterations; ++i) {
-            test_performance_mat2(n_items, maxeps);
+            test_performance_mat2<double>(n_items, maxeps);
+        }
+        auto toc = std::chrono::high_resolution_clock::now();
+        std::chrono::duration<double,std::ratio<1,1000>> msec = toc-tic;
+        std::cout << msec.count() << " msec\n";
+    }
+
+    SECTION("Performance mat2 float") {
+        auto tic = std::chrono::high_resolution_clock::now();
+        for (size_t i = 0; i < n_iterations; ++i) {
+            test_performance_mat2<float>(n_items, maxeps);
         }
         auto toc = std::chrono::high_resolution_clock::now();
         std::chrono::duration<double,std::ratio<1,1000>> msec = toc-tic;
@@ -74,7 +126,17 @@ TEST_CASE("Performance") {
     SECTION("Performance mat3") {
         auto tic = std::chrono::high_resolution_clock::now();
         for (size_t i = 0; i < n_iterations; ++i) {
-            test_performance_mat3(n_items, maxeps);
+            test_performance_mat3<double>(n_items, maxeps);
+        }
+        auto toc = std::chrono::high_resolution_clock::now();
+        std::chrono::duration<double,std::ratio<1,1000>> msec = toc-tic;
+        std::cout << msec.count() << " msec\n";
+    }
+
+    SECTION("Performance mat3 float") {
+        auto tic = std::chrono::high_resolution_clock::now();
+        for (size_t i = 0; i < n_iterations; ++i) {
+            test_performance_mat3<float>(n_items, maxeps);
         }
         auto toc = std::chrono::high_resolution_clock::now();
         std::chrono::duration<double,std::ratio<1,1000>> msec = toc-tic;
@@ -84,10 +146,24 @@ TEST_CASE("Performance") {
     SECTION("Performance mat4") {
         auto tic = std::chrono::high_resolution_clock::now();
         for (size_t i = 0; i < n_iterations; ++i) {
-            test_performance_mat4(n_items, maxeps);
+            test_performance_mat4<double>(n_items, maxeps);
+        }
+        auto toc = std::chrono::high_resolution_clock::now();
+        std::chrono::duration<double,std::ratio<1,1000>> msec = toc-tic;
+        std::cout << msec.count() << " msec\n";
+    }
+
+    SECTION("Performance mat4 float") {
+        auto tic = std::chrono::high_resolution_clock::now();
+        for (size_t i = 0; i < n_iterations; ++i) {
+            test_performance_mat4<float>(n_items, maxeps);
         }
         auto toc = std::chrono::high_resolution_clock::now();
         std::chrono::duration<double,std::ratio<1,1000>> msec = toc-tic;
         std::cout << msec.count() << " msec\n";
     }
+
+    SECTION("Performance kernels") {
+        test_performance_kernels(n_items, n_iterations, maxeps);
+    }
 }
@@ -0,0 +1,36 @@
+/*
+ * test-quat.cpp
+ *
+ * Copyright (c) 2020 Carlos Braga
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the MIT License.
+ *
+ * See accompanying LICENSE.md or https://opensource.org/licenses/MIT.
+ */
+
+#include "Catch2/catch.hpp"
+
+#include "test-quat.hpp"
+using namespace atto;
+
+TEST_CASE("Quat") {
+    const size_t n_iters = 8;
+    const size_t n_items = 65536;
+
+    for (size_t i = 0; i < n_iters; ++i) {
+        auto tic = std::chrono::high_resolution_clock::now();
+        test_quat<float>(n_items);
+        test_quat<double>(n_items);
+        auto toc = std::chrono::high_resolution_clock::now();
+        std::chrono::duration<double,std::ratio<1,1000>> msec = toc-tic;
+        std::cout << msec.count() << " msec\n";
+    }
+
+    /*
+     * Free rigid body rotation over time steps of 0.01 time units, fewer
+     * in single precision where the rounding errors accumulate faster.
+     */
+    test_nosquish<float>(4096, 100, 0.01f);
+    test_nosquish<double>(4096, 1000, 0.01);
+}
@@ -0,0 +1,262 @@
+/*
+ * test-quat.hpp
+ *
+ * Copyright (c) 2020 Carlos Braga
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the MIT License.
+ *
+ * See accompanying LICENSE.md or https://opensource.org/licenses/MIT.
+ */
+
+#ifndef TEST_CORE_GEOMETRY_QUAT_H_
+#define TEST_CORE_GEOMETRY_QUAT_H_
+
+#include <random>
+#include "../common.hpp"
+
+/**
+ * check_quat
+ * @brief Check the quaternions a and b are equal element by element.
+ */
+template<typename Type>
+core_inline
+bool check_quat(
+    const atto::math::quat<Type> &a,
+    const atto::math::quat<Type> &b)
+{
+    using namespace atto;
+
+    for (size_t i = 0; i < 4; ++i) {
+        if (!math::isequal(a(i), b(i))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * check_mat3
+ * @brief Check the matrices a and b are equal element by element.
+ */
+template<typename Type>
+core_inline
+bool check_mat3(
+    const atto::math::mat3<Type> &a,
+    const atto::math::mat3<Type> &b)
+{
+    using namespace atto;
+
+    for (size_t i = 0; i < 3; ++i) {
+        for (size_t j = 0; j < 3; ++j) {
+            if (!math::isequal(a(i,j), b(i,j))) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/**
+ * test_quat
+ * @brief Compare the quaternion operations with the rotation matrices
+ * they represent.
+ */
+template<typename Type>
+core_inline
+void test_quat(const size_t n_items)
+{
+    using namespace atto;
+
+    std::random_device seed;
+    std::mt19937 rng(seed());
+    std::normal_distribution<Type> dist((Type) 0, (Type) 1);
+    std::uniform_real_distribution<Type> angle(
+        (Type) -M_PI, (Type) M_PI);
+    std::uniform_real_distribution<Type> unit((Type) 0, (Type) 1);
+
+    const math::quat<Type> one((Type) 0, (Type) 0, (Type) 0, (Type) 1);
+
+    for (size_t ix = 0; ix < n_items; ++ix) {
+        math::vec3<Type> n(dist(rng), dist(rng), dist(rng));
+        math::vec3<Type> m(dist(rng), dist(rng), dist(rng));
+        math::vec3<Type> v(dist(rng), dist(rng), dist(rng));
+        const Type theta = angle(rng);
+        const Type phi = angle(rng);
+
+        /*
+         * to_mat3(to_quat(n, theta)) = rotate(n, theta)
+         */
+        math::quat<Type> q = math::to_quat(n, theta);
+        REQUIRE(math::isequal(math::norm(q), (Type) 1));
+
+        math::mat3<Type> r = math::to_mat3(q);
+        math::mat4<Type> r4 = math::rotate(n, theta);
+        for (size_t i = 0; i < 3; ++i) {
+            for (size_t j = 0; j < 3; ++j) {
+                REQUIRE(math::isequal(r(i,j), r4(i,j)));
+            }
+        }
+
+        /*
+         * rotate(q, v) = R v
+         */
+        math::vec3<Type> u = math::rotate(q, v);
+        math::vec3<Type> w = math::dot(r, v);
+        for (size_t i = 0; i < 3; ++i) {
+            REQUIRE(math::isequal(u(i), w(i)));
+        }
+
+        /*
+         * to_mat3(q p) = to_mat3(q) to_mat3(p)
+         */
+        math::quat<Type> p = math::to_quat(m, phi);
+        REQUIRE(check_mat3(
+            math::to_mat3(q * p), math::dot(r, math::to_mat3(p))));
+
+        /*
+         * q q* = 1, to_mat3(q*) = R^t, (c q)^-1 (c q) = 1
+         */
+        REQUIRE(check_quat(q * math::conjugate(q), one));
+        REQUIRE(check_mat3(
+            math::to_mat3(math::conjugate(q)), math::transpose(r)));
+        math::quat<Type> c = q * (Type) 2.5;
+        REQUIRE(check_quat(math::inverse(c) * c, one));
+        REQUIRE(check_quat(math::normalize(c), q));
+
+        /*
+         * to_quat(R) = q, up to the sign of q.
+         */
+        math::quat<Type> s = math::to_quat(r);
+        if (math::dot(s, q) < (Type) 0) {
+            s = -s;
+        }
+        REQUIRE(check_quat(s, q));
+
+        /*
+         * slerp(q, q p, t) = q p^t, with p^t the rotation by t phi around m.
+         */
+        const Type t = unit(rng);
+        REQUIRE(check_quat(
+            math::slerp(q, q * p, t), q * math::to_quat(m, t * phi)));
+        REQUIRE(check_quat(math::slerp(q, q * p, (Type) 0), q));
+        REQUIRE(check_quat(math::slerp(q, q * p, (Type) 1), q * p));
+        REQUIRE(check_quat(math::slerp(q, -(q * p), t),
+            q * math::to_quat(m, t * phi)));
+
+        const Type eps = (Type) 1.0E-3 * phi;
+        REQUIRE(check_quat(
+            math::slerp(q, q * math::to_quat(m, eps), t),
+            q * math::to_quat(m, t * eps)));
+    }
+}
+
+/**
+ * test_nosquish
+ * @brief Integrate the free rotation of n_items rigid bodies with the
+ * NO_SQUISH scheme and check the conservation of the norm of the
+ * quaternions and of the kinetic energy. A rotation around a principal
+ * axis is integrated exactly.
+ */
+template<typename Type>
+core_inline
+void test_nosquish(
+    const size_t n_items,
+    const size_t n_steps,
+    const Type dt)
+{
+    using namespace atto;
+
+    std::random_device seed;
+    std::mt19937 rng(seed());
+    std::normal_distribution<Type> dist((Type) 0, (Type) 1);
+    std::uniform_real_distribution<Type> angle(
+        (Type) -M_PI, (Type) M_PI);
+
+    const math::vec3<Type> inertia((Type) 1, (Type) 2, (Type) 3);
+
+    /*
+     * Body angular momentum pi = I w from the conjugate momentum,
+     * (pi, 0) = q* p / 2, and kinetic energy sum pi_k^2 / (2 I_k).
+     */
+    auto energy = [&] (
+        const math::quat<Type> &q,
+        const math::quat<Type> &p) -> Type {
+        math::quat<Type> l = math::conjugate(q) * p * (Type) 0.5;
+        Type e = (Type) 0;
+        for (size_t k = 0; k < 3; ++k) {
+            e += l(k) * l(k) / ((Type) 2 * inertia(k));
+        }
+        return e;
+    };
+
+    std::vector<std::vector<Type>> q(4, std::vector<Type>(n_items));
+    std::vector<std::vector<Type>> p(4, std::vector<Type>(n_items));
+    std::vector<Type> e(n_items);
+    for (size_t i = 0; i < n_items; ++i) {
+        math::vec3<Type> n(dist(rng), dist(rng), dist(rng));
+        math::vec3<Type> w(dist(rng), dist(rng), dist(rng));
+        math::quat<Type> qi = math::to_quat(n, angle(rng));
+        math::quat<Type> pi = qi * math::quat<Type>(
+            (Type) 2 * inertia(0) * w(0),
+            (Type) 2 * inertia(1) * w(1),
+            (Type) 2 * inertia(2) * w(2),
+            (Type) 0);
+        for (size_t k = 0; k < 4; ++k) {
+            q[k][i] = qi(k);
+            p[k][i] = pi(k);
+        }
+        e[i] = energy(qi, pi);
+    }
+
+    for (size_t step = 0; step < n_steps; ++step) {
+        math::batch::nosquish(n_items, dt,
+            inertia(0), inertia(1), inertia(2),
+            q[0].data(), q[1].data(), q[2].data(), q[3].data(),
+            p[0].data(), p[1].data(), p[2].data(), p[3].data());
+    }
+
+    const Type maxeps = (Type) 1.0E-3;
+    for (size_t i = 0; i < n_items; ++i) {
+        math::quat<Type> qi(q[0][i], q[1][i], q[2][i], q[3][i]);
+        math::quat<Type> pi(p[0][i], p[1][i], p[2][i], p[3][i]);
+        REQUIRE(math::isequal(math::norm(qi), (Type) 1));
+        REQUIRE(std::fabs(energy(qi, pi) - e[i]) < maxeps * e[i]);
+    }
+
+    /*
+     * Rotation with angular velocity w3 around the third principal axis,
+     * q(t) = q(0) to_quat(e3, w3 t).
+     */
+    const math::vec3<Type> e3((Type) 0, (Type) 0, (Type) 1);
+    std::vector<std::vector<Type>> q0(4, std::vector<Type>(n_items));
+    std::vector<Type> w3(n_items);
+    for (size_t i = 0; i < n_items; ++i) {
+        math::vec3<Type> n(dist(rng), dist(rng), dist(rng));
+        math::quat<Type> qi = math::to_quat(n, angle(rng));
+        w3[i] = dist(rng);
+        math::quat<Type> pi = qi * math::quat<Type>(
+            (Type) 0, (Type) 0, (Type) 2 * inertia(2) * w3[i], (Type) 0);
+        for (size_t k = 0; k < 4; ++k) {
+            q0[k][i] = q[k][i] = qi(k);
+            p[k][i] = pi(k);
+        }
+    }
+
+    for (size_t step = 0; step < n_steps; ++step) {
+        math::batch::nosquish(n_items, dt,
+            inertia(0), inertia(1), inertia(2),
+            q[0].data(), q[1].data(), q[2].data(), q[3].data(),
+            p[0].data(), p[1].data(), p[2].data(), p[3].data());
+    }
+
+    for (size_t i = 0; i < n_items; ++i) {
+        math::quat<Type> qi(q[0][i], q[1][i], q[2][i], q[3][i]);
+        math::quat<Type> qt =
+            math::quat<Type>(q0[0][i], q0[1][i], q0[2][i], q0[3][i]) *
+            math::to_quat(e3, w3[i] * dt * (Type) n_steps);
+        REQUIRE(check_quat(qi, qt));
+    }
+}
+
+#endif /* TEST_CORE_GEOMETRY_QUAT_H_ */
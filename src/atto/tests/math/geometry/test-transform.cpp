@@ -0,0 +1,29 @@
+/*
+ * test-transform.cpp
+ *
+ * Copyright (c) 2020 Carlos Braga
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the MIT License.
+ *
+ * See accompanying LICENSE.md or https://opensource.org/licenses/MIT.
+ */
+
+#include "Catch2/catch.hpp"
+
+#include "test-transform.hpp"
+using namespace atto;
+
+TEST_CASE("Transform") {
+    const size_t n_iters = 8;
+    const size_t n_items = 65536;
+
+    for (size_t i = 0; i < n_iters; ++i) {
+        auto tic = std::chrono::high_resolution_clock::now();
+        test_transform<float>(n_items);
+        test_transform<double>(n_items);
+        auto toc = std::chrono::high_resolution_clock::now();
+        std::chrono::duration<double,std::ratio<1,1000>> msec = toc-tic;
+        std::cout << msec.count() << " msec\n";
+    }
+}
@@ -0,0 +1,123 @@
+/*
+ * test-transform.hpp
+ *
+ * Copyright (c) 2020 Carlos Braga
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the MIT License.
+ *
+ * See accompanying LICENSE.md or https://opensource.org/licenses/MIT.
+ */
+
+#ifndef TEST_CORE_GEOMETRY_TRANSFORM_H_
+#define TEST_CORE_GEOMETRY_TRANSFORM_H_
+
+#include <random>
+#include "../common.hpp"
+
+/**
+ * check_transform
+ * @brief Check the matrix a is equal to the matrix product l*r, computed
+ * element by element.
+ */
+template<typename Type>
+core_inline
+bool check_transform(
+    const atto::math::mat4<Type> &a,
+    const atto::math::mat4<Type> &l,
+    const atto::math::mat4<Type> &r)
+{
+    using namespace atto;
+
+    for (size_t i = 0; i < 4; ++i) {
+        for (size_t j = 0; j < 4; ++j) {
+            Type sum = (Type) 0;
+            for (size_t k = 0; k < 4; ++k) {
+                sum += l(i,k) * r(k,j);
+            }
+            if (!math::isequal(a(i,j), sum)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/*
+ * test_transform
+ * @brief Compare the translate, rotate and lookat transforms with their
+ * matrices computed element by element.
+ */
+template<typename Type>
+core_inline
+void test_transform(const size_t n_items)
+{
+    using namespace atto;
+
+    std::random_device seed;
+    std::mt19937 rng(seed());
+    std::normal_distribution<Type> dist((Type) 0, (Type) 1);
+    std::uniform_real_distribution<Type> angle(
+        (Type) -M_PI, (Type) M_PI);
+
+    for (size_t ix = 0; ix < n_items; ++ix) {
+        math::mat4<Type> m;
+        for (size_t i = 0; i < 4; ++i) {
+            for (size_t j = 0; j < 4; ++j) {
+                m(i,j) = dist(rng);
+            }
+        }
+        math::vec3<Type> d(dist(rng), dist(rng), dist(rng));
+        math::vec3<Type> n(dist(rng), dist(rng), dist(rng));
+        const Type theta = angle(rng);
+
+        /*
+         * translate(m, d) = T(d) * m
+         */
+        math::mat4<Type> t = math::mat4<Type>::eye;
+        t(0,3) = d(0);
+        t(1,3) = d(1);
+        t(2,3) = d(2);
+        REQUIRE(check_transform(math::translate(m, d), t, m));
+
+        /*
+         * rotate(n, theta) = cos * I + sin * [n]x + (1 - cos) * n n^t
+         */
+        const Type c = std::cos(theta);
+        const Type s = std::sin(theta);
+        math::vec3<Type> u = math::normalize(n);
+        math::mat4<Type> r(
+            c + (1 - c)*u(0)*u(0),
+            (1 - c)*u(0)*u(1) - s*u(2),
+            (1 - c)*u(0)*u(2) + s*u(1),
+            (Type) 0,
+            (1 - c)*u(1)*u(0) + s*u(2),
+            c + (1 - c)*u(1)*u(1),
+            (1 - c)*u(1)*u(2) - s*u(0),
+            (Type) 0,
+            (1 - c)*u(2)*u(0) - s*u(1),
+            (1 - c)*u(2)*u(1) + s*u(0),
+            c + (1 - c)*u(2)*u(2),
+            (Type) 0,
+            (Type) 0, (Type) 0, (Type) 0, (Type) 1);
+        math::mat4<Type> rot = math::rotate(n, theta);
+        REQUIRE(check_transform(rot, r, math::mat4<Type>::eye));
+        REQUIRE(check_transform(math::rotate(m, n, theta), r, m));
+        REQUIRE(check_transform(
+            math::mat4<Type>::eye, rot, math::transpose(rot)));
+
+        /*
+         * lookat(m, eye, ctr, up) = L * m, with orthonormal s-u-f rows.
+         */
+        math::vec3<Type> ctr = d + n;
+        math::vec3<Type> up(dist(rng), dist(rng), dist(rng));
+        math::mat4<Type> l = math::lookat(d, ctr, up);
+        math::mat4<Type> l3 = l;
+        l3(0,3) = l3(1,3) = l3(2,3) = (Type) 0;
+        REQUIRE(check_transform(
+            math::mat4<Type>::eye, l3, math::transpose(l3)));
+        REQUIRE(check_transform(math::lookat(m, d, ctr, up), l, m));
+    }
+}
+
+#endif /* TEST_CORE_GEOMETRY_TRANSFORM_H_ */
@@ -273,3 +273,111 @@ TEST_CASE("Cmwc-Random-Number-Engine") {
         }
     }
 }
+
+
+/* ---- Test Philox Random Number Engine --------------------------------------
+ */
+TEST_CASE("Philox-Random-Number-Engine") {
+    /*
+     * Known answer vectors of Philox4x32-10 from the reference implementation.
+     */
+    SECTION("known-answer-vectors") {
+        const uint32_t ctr[3][4] = {
+            {0x00000000, 0x00000000, 0x00000000, 0x00000000},
+            {0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff},
+            {0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344}};
+        const uint32_t key[3][2] = {
+            {0x00000000, 0x00000000},
+            {0xffffffff, 0xffffffff},
+            {0xa4093822, 0x299f31d0}};
+        const uint32_t ans[3][4] = {
+            {0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8},
+            {0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd},
+            {0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1}};
+
+        for (size_t i = 0; i < 3; ++i) {
+            uint32_t out[4];
+            math::rng::Philox::block(ctr[i], key[i], out);
+            for (size_t k = 0; k < 4; ++k) {
+                REQUIRE(out[k] == ans[i][k]);
+            }
+        }
+    }
+
+    /*
+     * The stream of a particle at a given step is the same, whatever the
+     * order of the particles and the number of threads sampling them.
+     */
+    SECTION("independence-of-decomposition") {
+        const uint64_t seed = 0x9e3779b97f4a7c15ULL;
+        const uint64_t step = 12345;
+        const size_t n_items = 65536;
+        const size_t n_samples = 8;
+
+        std::vector<uint64_t> serial(n_items * n_samples);
+        for (size_t i = 0; i < n_items; ++i) {
+            math::rng::Philox engine(seed, i, step);
+            for (size_t k = 0; k < n_samples; ++k) {
+                serial[k + i * n_samples] = engine.rand64();
+            }
+        }
+
+        std::vector<uint64_t> parallel(n_items * n_samples);
+        core_pragma_omp(parallel default(none) shared(parallel))
+        {
+            math::rng::Philox engine(seed);
+            core_pragma_omp(for schedule(dynamic, 64))
+            for (size_t j = 0; j < n_items; ++j) {
+                size_t i = n_items - 1 - j;
+                engine.seek(i, step);
+                for (size_t k = 0; k < n_samples; ++k) {
+                    parallel[k + i * n_samples] = engine.rand64();
+                }
+            }
+        } /* omp parallel */
+        REQUIRE(serial == parallel);
+
+        /*
+         * Different particles and steps sample different streams.
+         */
+        math::rng::Philox a(seed, 0, step);
+        math::rng::Philox b(seed, 1, step);
+        math::rng::Philox c(seed, 0, step + 1);
+        uint64_t x = a.rand64();
+        REQUIRE(x != b.rand64());
+        REQUIRE(x != c.rand64());
+    }
+
+    /*
+     * 32-bit random number engine
+     */
+    SECTION("32-bit-random-number-engine") {
+        std::vector<uint32_t> samples32(numsamples);
+        for (size_t ir = 0; ir < numruns; ++ir) {
+            /*
+             * Generate the sample data, one stream per block of samples.
+             */
+            core_pragma_omp(parallel default(none) shared(samples32, ir))
+            {
+                math::rng::Philox engine(0x243f6a8885a308d3ULL);
+                core_pragma_omp(for schedule(static))
+                for (size_t i = 0; i < samples32.size(); i += 1024) {
+                    engine.seek(i, ir);
+                    for (size_t k = i; k < i + 1024; ++k) {
+                        samples32[k] = engine.rand32();
+                    }
+                }
+            } /* omp parallel */
+
+            /*
+             * Write the data to the output file
+             */
+            core::FileOut fp(
+                std::string(TestPrefix + "/out.philox32." + std::to_string(ir)),
+                core::FileOut::Binary);
+            fp.write(samples32.data(), samples32.size()*sizeof(uint32_t));
+            REQUIRE(!fp.is_error());
+            fp.close();
+        }
+    }
+}
@@ -38,6 +38,33 @@ ask() {
 # -----------------------------------------------------------------------------
 # Test geometry
 pushd geometry
+run make -f ../Makefile clean && \
+    make -f ../Makefile -j48 all && \
+    ./test.out
+    make -f ../Makefile clean
+
+# Time the AVX path of the geometry kernels on an AVX-512 processor
+run make -f ../Makefile clean && \
+    make -f ../Makefile -j48 avx512=no all && \
+    ./test.out "Performance" -c "Performance kernels"
+    make -f ../Makefile clean
+
+# Time the AVX path of the geometry kernels without FMA
+run make -f ../Makefile clean && \
+    make -f ../Makefile -j48 avx512=no fma=no all && \
+    ./test.out "Performance" -c "Performance kernels"
+    make -f ../Makefile clean
+
+# Test the kernels of every instruction set in a runtime dispatch build
+run make -f ../Makefile clean && \
+    make -f ../Makefile -j48 dispatch=yes all && \
+    ./test.out "Dispatch","Batch","Box"
+    make -f ../Makefile clean
+popd
+
+# -----------------------------------------------------------------------------
+# Test fft
+pushd fft
 run make -f ../Makefile clean && \
     make -f ../Makefile -j48 all && \
     ./test.out
@@ -0,0 +1,187 @@
+/*
+ * box.cl
+ *
+ * Copyright (c) 2020 Carlos Braga
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the MIT License.
+ *
+ * See accompanying LICENSE.md or https://opensource.org/licenses/MIT.
+ */
+
+#pragma OPENCL EXTENSION cl_khr_fp64 : enable
+
+/**
+ * Periodic box operations, the device counterpart of math::Box.
+ *
+ * The cell holds 21 doubles: the origin, the cell matrix h with the cell
+ * vectors in its columns, and its inverse, both in row major order. The
+ * shape is selected when the program is built. With -DBOX_TRICLINIC the
+ * operations map through the fractional coordinates s = h^-1 d. Otherwise
+ * the box is orthorhombic and only the diagonals of h and h^-1 are read.
+ *
+ * rint rounds to the nearest even integer like the AVX round instruction
+ * used on the host, so both give the same images.
+ */
+#define BOX_ORIGIN  0
+#define BOX_H       3
+#define BOX_H_INV   12
+
+/**
+ * box_dot
+ * @brief Return the product of the 3x3 matrix m, in row major order, with
+ * the vector v.
+ */
+double3 box_dot(__global const double *m, const double3 v)
+{
+    return (double3) (
+        m[0] * v.x + m[1] * v.y + m[2] * v.z,
+        m[3] * v.x + m[4] * v.y + m[5] * v.z,
+        m[6] * v.x + m[7] * v.y + m[8] * v.z);
+}
+
+/**
+ * box_diagonal
+ * @brief Return the diagonal of the 3x3 matrix m, in row major order.
+ */
+double3 box_diagonal(__global const double *m)
+{
+    return (double3) (m[0], m[4], m[8]);
+}
+
+/**
+ * box_origin
+ * @brief Return the origin of the cell.
+ */
+double3 box_origin(__global const double *cell)
+{
+    return vload3(0, cell + BOX_ORIGIN);
+}
+
+/** ---------------------------------------------------------------------------
+ * box_min_image
+ * @brief Return the minimum image of the displacement d.
+ */
+double3 box_min_image(__global const double *cell, const double3 d)
+{
+#ifdef BOX_TRICLINIC
+    double3 s = box_dot(cell + BOX_H_INV, d);
+    return box_dot(cell + BOX_H, s - rint(s));
+#else
+    const double3 length = box_diagonal(cell + BOX_H);
+    const double3 inv_length = box_diagonal(cell + BOX_H_INV);
+    return d - length * rint(d * inv_length);
+#endif
+}
+
+/**
+ * box_wrap
+ * @brief Return the position r wrapped inside the cell, and add the number
+ * of cell vectors removed from it to the image counts.
+ */
+double3 box_wrap(
+    __global const double *cell,
+    const double3 r,
+    double3 *image)
+{
+    const double3 origin = box_origin(cell);
+#ifdef BOX_TRICLINIC
+    double3 s = box_dot(cell + BOX_H_INV, r - origin);
+    double3 n = floor(s);
+    *image += n;
+    return origin + box_dot(cell + BOX_H, s - n);
+#else
+    const double3 length = box_diagonal(cell + BOX_H);
+    const double3 inv_length = box_diagonal(cell + BOX_H_INV);
+    double3 n = floor((r - origin) * inv_length);
+    *image += n;
+    return r - length * n;
+#endif
+}
+
+/**
+ * box_unwrap
+ * @brief Return the position r shifted back by its image counts.
+ */
+double3 box_unwrap(
+    __global const double *cell,
+    const double3 r,
+    const double3 image)
+{
+#ifdef BOX_TRICLINIC
+    return r + box_dot(cell + BOX_H, image);
+#else
+    return r + box_diagonal(cell + BOX_H) * image;
+#endif
+}
+
+/** ---------------------------------------------------------------------------
+ * Batch kernels over n elements in structure of arrays layout, one element
+ * per work item.
+ */
+__kernel void box_min_image_kernel(
+    __global double *x,
+    __global double *y,
+    __global double *z,
+    __global const double *cell,
+    const ulong n)
+{
+    const size_t i = get_global_id(0);
+    if (i >= n) {
+        return;
+    }
+
+    double3 d = box_min_image(cell, (double3) (x[i], y[i], z[i]));
+    x[i] = d.x;
+    y[i] = d.y;
+    z[i] = d.z;
+}
+
+__kernel void box_wrap_kernel(
+    __global double *x,
+    __global double *y,
+    __global double *z,
+    __global double *ix,
+    __global double *iy,
+    __global double *iz,
+    __global const double *cell,
+    const ulong n)
+{
+    const size_t i = get_global_id(0);
+    if (i >= n) {
+        return;
+    }
+
+    double3 image = (double3) (ix[i], iy[i], iz[i]);
+    double3 r = box_wrap(cell, (double3) (x[i], y[i], z[i]), &image);
+    x[i] = r.x;
+    y[i] = r.y;
+    z[i] = r.z;
+    ix[i] = image.x;
+    iy[i] = image.y;
+    iz[i] = image.z;
+}
+
+__kernel void box_unwrap_kernel(
+    __global double *x,
+    __global double *y,
+    __global double *z,
+    __global const double *ix,
+    __global const double *iy,
+    __global const double *iz,
+    __global const double *cell,
+    const ulong n)
+{
+    const size_t i = get_global_id(0);
+    if (i >= n) {
+        return;
+    }
+
+    double3 r = box_unwrap(
+        cell,
+        (double3) (x[i], y[i], z[i]),
+        (double3) (ix[i], iy[i], iz[i]));
+    x[i] = r.x;
+    y[i] = r.y;
+    z[i] = r.z;
+}
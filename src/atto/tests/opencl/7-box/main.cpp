@@ -0,0 +1,223 @@
+/*
+ * main.cpp
+ *
+ * Copyright (c) 2020 Carlos Braga
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the MIT License.
+ *
+ * See accompanying LICENSE.md or https://opensource.org/licenses/MIT.
+ */
+
+#include <vector>
+#include <chrono>
+#include <numeric>
+#include <random>
+#include <algorithm>
+
+#include "../base.hpp"
+using namespace atto;
+
+/** ---------------------------------------------------------------------------
+ * Box operations on the device, compared with the batch operations of the
+ * periodic box on the host.
+ */
+template<bool Triclinic>
+void test_box(
+    cl_context &context,
+    cl_device_id &device,
+    cl_command_queue &queue,
+    const math::Box<double, Triclinic> &box)
+{
+    std::cout << __PRETTY_FUNCTION__ << "\n";
+
+    /*
+     * Create the program with the box shape selected by the build option.
+     */
+    cl_program program = cl::Program::create_from_file(context, "box.cl");
+    cl::Program::build(program, device, Triclinic ? "-DBOX_TRICLINIC" : "");
+
+    std::vector<cl_kernel> kernels;
+    kernels.emplace_back(cl::Kernel::create(program, "box_min_image_kernel"));
+    kernels.emplace_back(cl::Kernel::create(program, "box_wrap_kernel"));
+    kernels.emplace_back(cl::Kernel::create(program, "box_unwrap_kernel"));
+
+    /*
+     * Generate positions spread over several cells around the box.
+     */
+    const cl_ulong n = 1 << 20;
+    std::vector<std::vector<double>> arr(6, std::vector<double>(n, 0.0));
+    {
+        std::random_device seed;
+        std::mt19937 rng(seed());
+        std::uniform_real_distribution<double> dist(-2.0, 3.0);
+        for (cl_ulong i = 0; i < n; ++i) {
+            math::vec3<double> s(dist(rng), dist(rng), dist(rng));
+            math::vec3<double> r = box.origin + math::dot(box.h, s);
+            arr[0][i] = r(0);
+            arr[1][i] = r(1);
+            arr[2][i] = r(2);
+        }
+    }
+    std::vector<double> cell(21, 0.0);
+    for (size_t i = 0; i < 3; ++i) {
+        cell[i] = box.origin(i);
+        for (size_t j = 0; j < 3; ++j) {
+            cell[3 + 3 * i + j] = box.h(i,j);
+            cell[12 + 3 * i + j] = box.h_inv(i,j);
+        }
+    }
+
+    std::vector<cl_mem> buffers;
+    for (size_t k = 0; k < 6; ++k) {
+        buffers.emplace_back(cl::Memory::create_buffer(
+            context,
+            CL_MEM_READ_WRITE,
+            n * sizeof(double),
+            (void *) NULL));
+    }
+    buffers.emplace_back(cl::Memory::create_buffer(
+        context,
+        CL_MEM_READ_ONLY,
+        cell.size() * sizeof(double),
+        (void *) NULL));
+
+    for (size_t k = 0; k < 6; ++k) {
+        cl::Queue::enqueue_write_buffer(
+            queue,
+            buffers[k],
+            CL_TRUE,
+            0,
+            n * sizeof(double),
+            (void *) arr[k].data());
+    }
+    cl::Queue::enqueue_write_buffer(
+        queue,
+        buffers[6],
+        CL_TRUE,
+        0,
+        cell.size() * sizeof(double),
+        (void *) cell.data());
+
+    /*
+     * Set the kernel arguments.
+     */
+    cl::Kernel::set_arg(kernels[0], 0, sizeof(cl_mem), &buffers[0]);
+    cl::Kernel::set_arg(kernels[0], 1, sizeof(cl_mem), &buffers[1]);
+    cl::Kernel::set_arg(kernels[0], 2, sizeof(cl_mem), &buffers[2]);
+    cl::Kernel::set_arg(kernels[0], 3, sizeof(cl_mem), &buffers[6]);
+    cl::Kernel::set_arg(kernels[0], 4, sizeof(cl_ulong), &n);
+    for (size_t k = 1; k < 3; ++k) {
+        for (cl_uint arg = 0; arg < 6; ++arg) {
+            cl::Kernel::set_arg(kernels[k], arg, sizeof(cl_mem), &buffers[arg]);
+        }
+        cl::Kernel::set_arg(kernels[k], 6, sizeof(cl_mem), &buffers[6]);
+        cl::Kernel::set_arg(kernels[k], 7, sizeof(cl_ulong), &n);
+    }
+
+    /*
+     * Run each kernel on the device and the batch operation on the host,
+     * and compare the results.
+     */
+    std::vector<std::vector<double>> res(6, std::vector<double>(n, 0.0));
+    const char *names[3] = {"min_image", "wrap", "unwrap"};
+    for (size_t k = 0; k < 3; ++k) {
+        cl_event event;
+        cl::Queue::enqueue_nd_range_kernel(
+            queue,
+            kernels[k],
+            cl::NDRange::Null,
+            cl::NDRange::Make(n, Params::work_group_size_1d),
+            cl::NDRange(Params::work_group_size_1d),
+            NULL,
+            &event);
+        cl::Queue::finish(queue);
+        double exec_time_msec = (double) (
+            cl::Event::get_command_end(event) -
+            cl::Event::get_command_start(event)) / 1000000;
+
+        for (size_t c = 0; c < 6; ++c) {
+            cl::Queue::enqueue_read_buffer(
+                queue,
+                buffers[c],
+                CL_TRUE,
+                0,
+                n * sizeof(double),
+                (void *) res[c].data());
+        }
+
+        auto tic = std::chrono::high_resolution_clock::now();
+        if (k == 0) {
+            box.min_image(n, arr[0].data(), arr[1].data(), arr[2].data());
+        } else if (k == 1) {
+            box.wrap(n,
+                arr[0].data(), arr[1].data(), arr[2].data(),
+                arr[3].data(), arr[4].data(), arr[5].data());
+        } else {
+            box.unwrap(n,
+                arr[0].data(), arr[1].data(), arr[2].data(),
+                arr[3].data(), arr[4].data(), arr[5].data());
+        }
+        auto toc = std::chrono::high_resolution_clock::now();
+        std::chrono::duration<double,std::ratio<1,1000>> msec = toc-tic;
+
+        double err = 0.0;
+        for (size_t c = 0; c < 6; ++c) {
+            for (cl_ulong i = 0; i < n; ++i) {
+                err = std::max(err, std::fabs(res[c][i] - arr[c][i]));
+            }
+        }
+        std::printf("%s: device %lf msec, host %lf msec, max error %e\n",
+            names[k], exec_time_msec, msec.count(), err);
+        core_assert(err < 1.0e-9, "FAIL");
+    }
+
+    /*
+     * Teardown OpenCL data.
+     */
+    for (auto &it : buffers) {
+        cl::Memory::release(it);
+    }
+    for (auto &it : kernels) {
+        cl::Kernel::release(it);
+    }
+    cl::Program::release(program);
+}
+
+/** ---------------------------------------------------------------------------
+ * main
+ */
+int main(int argc, char const *argv[])
+{
+    /*
+     * Setup OpenCL context.
+     */
+    cl_context context = cl::Context::create(CL_DEVICE_TYPE_GPU);
+    cl_device_id device = cl::Context::get_device(
+        context, Params::device_index);
+    std::cout << cl::Device::get_info_string(device) << "\n";
+    cl_command_queue queue = cl::Queue::create(
+        context, device, CL_QUEUE_PROFILING_ENABLE);
+
+    /*
+     * Run the box operations on an orthorhombic and a triclinic box.
+     */
+    test_box(context, device, queue, math::OrthoBoxd::create_from_bounds(
+        math::vec3d(-1.0, 0.0, 2.0),
+        math::vec3d(9.0, 12.0, 7.0)));
+    test_box(context, device, queue, math::TriclinicBoxd::create(
+        math::vec3d(-1.0, 0.0, 2.0),
+        math::mat3d(
+            10.0, 2.0, -1.5,
+             0.0, 9.0,  3.0,
+             0.0, 0.0,  8.0)));
+
+    /*
+     * Teardown OpenCL data.
+     */
+    cl::Queue::release(queue);
+    cl::Device::release(device);
+    cl::Context::release(context);
+
+    exit(EXIT_SUCCESS);
+}
@@ -0,0 +1,257 @@
+/*
+ * main.cpp
+ *
+ * Copyright (c) 2020 Carlos Braga
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the MIT License.
+ *
+ * See accompanying LICENSE.md or https://opensource.org/licenses/MIT.
+ */
+
+#include <vector>
+#include <cstring>
+#include <algorithm>
+
+#include "../base.hpp"
+using namespace atto;
+
+/** ---------------------------------------------------------------------------
+ * Known answer vectors of Philox4x32-10 on the device, compared with the
+ * reference implementation and with math::rng::Philox::block on the host.
+ */
+void test_philox_block(
+    cl_context &context,
+    cl_device_id &device,
+    cl_command_queue &queue,
+    cl_program &program)
+{
+    std::cout << __PRETTY_FUNCTION__ << "\n";
+
+    const cl_ulong n = 3;
+    const cl_uint ctr[3][4] = {
+        {0x00000000, 0x00000000, 0x00000000, 0x00000000},
+        {0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff},
+        {0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344}};
+    const cl_uint key[3][2] = {
+        {0x00000000, 0x00000000},
+        {0xffffffff, 0xffffffff},
+        {0xa4093822, 0x299f31d0}};
+    const cl_uint ans[3][4] = {
+        {0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8},
+        {0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd},
+        {0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1}};
+
+    cl_kernel kernel = cl::Kernel::create(program, "philox_block_kernel");
+    std::vector<cl_mem> buffers;
+    buffers.emplace_back(cl::Memory::create_buffer(
+        context, CL_MEM_READ_ONLY, sizeof(ctr), (void *) NULL));
+    buffers.emplace_back(cl::Memory::create_buffer(
+        context, CL_MEM_READ_ONLY, sizeof(key), (void *) NULL));
+    buffers.emplace_back(cl::Memory::create_buffer(
+        context, CL_MEM_WRITE_ONLY, sizeof(ans), (void *) NULL));
+    cl::Queue::enqueue_write_buffer(
+        queue, buffers[0], CL_TRUE, 0, sizeof(ctr), (void *) ctr);
+    cl::Queue::enqueue_write_buffer(
+        queue, buffers[1], CL_TRUE, 0, sizeof(key), (void *) key);
+
+    for (cl_uint arg = 0; arg < 3; ++arg) {
+        cl::Kernel::set_arg(kernel, arg, sizeof(cl_mem), &buffers[arg]);
+    }
+    cl::Kernel::set_arg(kernel, 3, sizeof(cl_ulong), &n);
+    cl::Queue::enqueue_nd_range_kernel(
+        queue,
+        kernel,
+        cl::NDRange::Null,
+        cl::NDRange(n),
+        cl::NDRange::Null);
+    cl::Queue::finish(queue);
+
+    cl_uint out[3][4];
+    cl::Queue::enqueue_read_buffer(
+        queue, buffers[2], CL_TRUE, 0, sizeof(out), (void *) out);
+
+    for (size_t i = 0; i < n; ++i) {
+        uint32_t host[4];
+        math::rng::Philox::block(ctr[i], key[i], host);
+        for (size_t k = 0; k < 4; ++k) {
+            std::printf("device 0x%08x, host 0x%08x, answer 0x%08x\n",
+                out[i][k], host[k], ans[i][k]);
+            core_assert(out[i][k] == ans[i][k], "FAIL");
+            core_assert(host[k] == ans[i][k], "FAIL");
+        }
+    }
+
+    /*
+     * Teardown OpenCL data.
+     */
+    for (auto &it : buffers) {
+        cl::Memory::release(it);
+    }
+    cl::Kernel::release(kernel);
+}
+
+/** ---------------------------------------------------------------------------
+ * Uniform and Gaussian noise streams of many particles on the device,
+ * compared with math::rng::Philox(seed, id, step) on the host.
+ *
+ * The uniform numbers must be bit-identical. The Gaussian numbers are the
+ * Box-Muller transform of the same uniform numbers, but the OpenCL log, sin
+ * and cos are only accurate to a few ulp, so they are compared within a
+ * relative tolerance, and the count of bit-identical ones is reported.
+ */
+void test_noise_stream(
+    cl_context &context,
+    cl_device_id &device,
+    cl_command_queue &queue,
+    cl_program &program)
+{
+    std::cout << __PRETTY_FUNCTION__ << "\n";
+
+    const cl_ulong n = 1 << 20;
+    const cl_ulong seed = 0x243f6a8885a308d3ULL;
+    const cl_ulong step = 0x13198a2eULL;
+
+    /*
+     * Particle ids with both halves of the 64-bit id in use.
+     */
+    std::vector<cl_ulong> id(n);
+    for (cl_ulong i = 0; i < n; ++i) {
+        id[i] = i * 0x9e3779b97f4a7c15ULL;
+    }
+
+    cl_kernel kernel = cl::Kernel::create(program, "noise_kernel");
+    std::vector<cl_mem> buffers;
+    buffers.emplace_back(cl::Memory::create_buffer(
+        context, CL_MEM_READ_ONLY, n * sizeof(cl_ulong), (void *) NULL));
+    buffers.emplace_back(cl::Memory::create_buffer(
+        context, CL_MEM_WRITE_ONLY, 4 * n * sizeof(double), (void *) NULL));
+    buffers.emplace_back(cl::Memory::create_buffer(
+        context, CL_MEM_WRITE_ONLY, 3 * n * sizeof(double), (void *) NULL));
+    cl::Queue::enqueue_write_buffer(
+        queue,
+        buffers[0],
+        CL_TRUE,
+        0,
+        n * sizeof(cl_ulong),
+        (void *) id.data());
+
+    for (cl_uint arg = 0; arg < 3; ++arg) {
+        cl::Kernel::set_arg(kernel, arg, sizeof(cl_mem), &buffers[arg]);
+    }
+    cl::Kernel::set_arg(kernel, 3, sizeof(cl_ulong), &seed);
+    cl::Kernel::set_arg(kernel, 4, sizeof(cl_ulong), &step);
+    cl::Kernel::set_arg(kernel, 5, sizeof(cl_ulong), &n);
+
+    cl_event event;
+    cl::Queue::enqueue_nd_range_kernel(
+        queue,
+        kernel,
+        cl::NDRange::Null,
+        cl::NDRange::Make(n, Params::work_group_size_1d),
+        cl::NDRange(Params::work_group_size_1d),
+        NULL,
+        &event);
+    cl::Queue::finish(queue);
+    double exec_time_msec = (double) (
+        cl::Event::get_command_end(event) -
+        cl::Event::get_command_start(event)) / 1000000;
+
+    std::vector<double> uniform(4 * n);
+    std::vector<double> gaussian(3 * n);
+    cl::Queue::enqueue_read_buffer(
+        queue,
+        buffers[1],
+        CL_TRUE,
+        0,
+        uniform.size() * sizeof(double),
+        (void *) uniform.data());
+    cl::Queue::enqueue_read_buffer(
+        queue,
+        buffers[2],
+        CL_TRUE,
+        0,
+        gaussian.size() * sizeof(double),
+        (void *) gaussian.data());
+
+    /*
+     * Compute the same streams on the host.
+     */
+    const double scale = std::ldexp(1.0, -53);
+    size_t n_equal = 0;
+    double err = 0.0;
+    for (cl_ulong i = 0; i < n; ++i) {
+        math::rng::Philox engine(seed, id[i], step);
+        double u[4];
+        for (size_t k = 0; k < 4; ++k) {
+            u[k] = ((double) (engine.rand64() >> 11) + 1.0) * scale;
+        }
+        core_assert(std::memcmp(u, &uniform[4 * i], sizeof(u)) == 0, "FAIL");
+
+        double r0 = std::sqrt(-2.0 * std::log(u[0]));
+        double r1 = std::sqrt(-2.0 * std::log(u[2]));
+        double g[3] = {
+            r0 * std::cos(2.0 * M_PI * u[1]),
+            r0 * std::sin(2.0 * M_PI * u[1]),
+            r1 * std::cos(2.0 * M_PI * u[3])};
+        for (size_t k = 0; k < 3; ++k) {
+            double d = gaussian[3 * i + k];
+            n_equal += std::memcmp(&g[k], &d, sizeof(d)) == 0;
+            err = std::max(err,
+                std::fabs(d - g[k]) / std::max(1.0, std::fabs(g[k])));
+        }
+    }
+
+    std::printf("noise: device %lf msec, %lu of %lu Gaussian numbers "
+        "bit-identical, max error %e\n",
+        exec_time_msec, n_equal, 3 * n, err);
+    core_assert(err < 1.0e-13, "FAIL");
+
+    /*
+     * Teardown OpenCL data.
+     */
+    for (auto &it : buffers) {
+        cl::Memory::release(it);
+    }
+    cl::Kernel::release(kernel);
+}
+
+/** ---------------------------------------------------------------------------
+ * main
+ */
+int main(int argc, char const *argv[])
+{
+    /*
+     * Setup OpenCL context.
+     */
+    cl_context context = cl::Context::create(CL_DEVICE_TYPE_GPU);
+    cl_device_id device = cl::Context::get_device(
+        context, Params::device_index);
+    std::cout << cl::Device::get_info_string(device) << "\n";
+    cl_command_queue queue = cl::Queue::create(
+        context, device, CL_QUEUE_PROFILING_ENABLE);
+
+    /*
+     * Create the program from the device functions of mumd and the test
+     * kernels, with the default build options of the model.
+     */
+    const std::string mumd_cl = "../../../../mumd/data/mumd.cl";
+    std::string source;
+    source += cl::Program::load_source_from_file(mumd_cl);
+    source += cl::Program::load_source_from_file("philox.cl");
+    cl_program program = cl::Program::create_from_source(context, source);
+    cl::Program::build(program, device, "");
+
+    test_philox_block(context, device, queue, program);
+    test_noise_stream(context, device, queue, program);
+
+    /*
+     * Teardown OpenCL data.
+     */
+    cl::Program::release(program);
+    cl::Queue::release(queue);
+    cl::Device::release(device);
+    cl::Context::release(context);
+
+    exit(EXIT_SUCCESS);
+}
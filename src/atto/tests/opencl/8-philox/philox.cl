@@ -0,0 +1,57 @@
+/*
+ * philox.cl
+ *
+ * Copyright (c) 2020 Carlos Braga
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the MIT License.
+ *
+ * See accompanying LICENSE.md or https://opensource.org/licenses/MIT.
+ */
+
+/**
+ * Test kernels of the device random numbers of mumd. The program source is
+ * mumd/data/mumd.cl followed by this file, so the kernels call the device
+ * functions philox4x32_10, noise_uniform and noise_gaussian of the model
+ * itself rather than a copy.
+ */
+
+/**
+ * philox_block_kernel
+ * @brief Compute the Philox4x32-10 block of each counter and key.
+ */
+__kernel void philox_block_kernel(
+    __global const uint *ctr,
+    __global const uint *key,
+    __global uint *out,
+    const ulong n)
+{
+    const ulong i = get_global_id(0);
+    if (i >= n) {
+        return;
+    }
+
+    vstore4(philox4x32_10(vload4(i, ctr), vload2(i, key)), i, out);
+}
+
+/**
+ * noise_kernel
+ * @brief Compute the uniform and the Gaussian numbers of the stream of
+ * each particle id at a given step.
+ */
+__kernel void noise_kernel(
+    __global const ulong *id,
+    __global double *uniform,
+    __global double *gaussian,
+    const ulong seed,
+    const ulong step,
+    const ulong n)
+{
+    const ulong i = get_global_id(0);
+    if (i >= n) {
+        return;
+    }
+
+    vstore4(noise_uniform(seed, id[i], step), i, uniform);
+    vstore3(noise_gaussian(seed, id[i], step), i, gaussian);
+}
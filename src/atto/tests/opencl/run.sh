@@ -61,3 +61,5 @@ animate /tmp/out_0*
 execute 6-image-texture
 animate /tmp/out_0*
 execute 6-image-texture-gl
+execute 7-box
+execute 8-philox
@@ -0,0 +1,128 @@
+/*
+ * balance.cpp
+ *
+ * Copyright (c) 2020 Carlos Braga
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the MIT License.
+ *
+ * See accompanying LICENSE.md or https://opensource.org/licenses/MIT.
+ */
+
+#include <algorithm>
+#include "balance.hpp"
+using namespace atto;
+
+/** ---------------------------------------------------------------------------
+ * Balance::imbalance
+ * @brief Return the ratio between the maximum and the average work time over
+ * all processes in the domain communicator.
+ */
+cl_double Balance::imbalance(const Domain &domain, const cl_double time)
+{
+    cl_double time_max = 0.0;
+    cl_double time_sum = 0.0;
+    MPI_Allreduce(&time, &time_max, 1, MPI_DOUBLE, MPI_MAX, domain.m_comm);
+    MPI_Allreduce(&time, &time_sum, 1, MPI_DOUBLE, MPI_SUM, domain.m_comm);
+
+    cl_double time_avg = time_sum / (cl_double) domain.m_n_procs;
+    return (time_avg > 0.0) ? time_max / time_avg : 1.0;
+}
+
+/** ---------------------------------------------------------------------------
+ * Balance::compute_planes
+ * @brief Compute the shifted grid planes that balance the work along each
+ * dimension.
+ *
+ * The load profile along each dimension is a histogram of the particle costs,
+ * reduced over all processes. The new planes split the cumulative load into
+ * equal parts. They are relaxed towards the target to damp oscillations and
+ * clamped so every subdomain stays wider than the halo width.
+ */
+void Balance::compute_planes(
+    const Domain &domain,
+    const std::vector<cl_double> &position,
+    const cl_uint stride,
+    const cl_uint n_local,
+    const cl_double weight,
+    std::vector<cl_double> planes[3])
+{
+    const cl_ulong n_bins = Params::balance_bins;
+
+    for (int dim = 0; dim < 3; ++dim) {
+        const int n_planes = domain.m_dims[dim] + 1;
+        planes[dim] = domain.m_planes[dim];
+        if (n_planes == 2) {
+            continue;
+        }
+
+        /* Compute the global load profile along the dimension. */
+        const cl_double box_lo = domain.m_box_lo[dim];
+        const cl_double bin_width = domain.m_box_length[dim] / (cl_double) n_bins;
+        std::vector<cl_double> local(n_bins, 0.0);
+        for (cl_uint i = 0; i < n_local; ++i) {
+            cl_double x = position[i + dim * stride];
+            cl_long bin = (cl_long) std::floor((x - box_lo) / bin_width);
+            bin = std::min(std::max(bin, (cl_long) 0), (cl_long) n_bins - 1);
+            local[bin] += weight;
+        }
+
+        std::vector<cl_double> load(n_bins, 0.0);
+        MPI_Allreduce(
+            local.data(),
+            load.data(),
+            (int) n_bins,
+            MPI_DOUBLE,
+            MPI_SUM,
+            domain.m_comm);
+
+        cl_double total = 0.0;
+        for (auto &it : load) {
+            total += it;
+        }
+        if (total <= 0.0) {
+            continue;
+        }
+
+        /* Split the cumulative load into equal parts. */
+        std::vector<cl_double> target(planes[dim]);
+        cl_double sum = 0.0;
+        cl_ulong bin = 0;
+        for (int k = 1; k < n_planes - 1; ++k) {
+            cl_double part = total * (cl_double) k / (cl_double) (n_planes - 1);
+            while (bin < n_bins - 1 && sum + load[bin] < part) {
+                sum += load[bin++];
+            }
+            cl_double frac = (load[bin] > 0.0) ? (part - sum) / load[bin] : 0.0;
+            frac = std::min(std::max(frac, 0.0), 1.0);
+            target[k] = box_lo + bin_width * ((cl_double) bin + frac);
+        }
+
+        /* Relax the planes towards the target and enforce the minimum width. */
+        for (int k = 1; k < n_planes - 1; ++k) {
+            planes[dim][k] += Params::balance_relax * (target[k] - planes[dim][k]);
+        }
+        clamp_planes(planes[dim]);
+    }
+}
+
+/** ---------------------------------------------------------------------------
+ * Balance::clamp_planes
+ * @brief Push the inner planes up from the lower box bound and then down
+ * from the upper one, so every subdomain is at least the halo width wide.
+ *
+ * The difference of two planes set a halo width apart can round to just
+ * below it, and Domain::set_planes would reject them. The planes are set a
+ * slightly wider width apart, so the difference is never below r_halo.
+ */
+void Balance::clamp_planes(std::vector<cl_double> &planes)
+{
+    const cl_double width = Params::r_halo * (1.0 + 1.0e-12);
+    const int n_planes = (int) planes.size();
+    for (int k = 1; k < n_planes - 1; ++k) {
+        planes[k] = std::max(planes[k], planes[k - 1] + width);
+    }
+    for (int k = n_planes - 2; k > 0; --k) {
+        planes[k] = std::min(planes[k], planes[k + 1] - width);
+    }
+}
@@ -0,0 +1,49 @@
+/*
+ * balance.hpp
+ *
+ * Copyright (c) 2020 Carlos Braga
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the MIT License.
+ *
+ * See accompanying LICENSE.md or https://opensource.org/licenses/MIT.
+ */
+
+#ifndef BALANCE_H_
+#define BALANCE_H_
+
+#include <vector>
+#include "base.hpp"
+#include "domain.hpp"
+
+namespace Balance {
+/**
+ * imbalance
+ * @brief Return the ratio between the maximum and the average work time over
+ * all processes in the domain communicator.
+ */
+cl_double imbalance(const Domain &domain, const cl_double time);
+
+/**
+ * compute_planes
+ * @brief Compute the shifted grid planes that balance the work along each
+ * dimension. Each particle contributes its process cost per particle, so
+ * the load profile accounts for the throughput of each device.
+ */
+void compute_planes(
+    const Domain &domain,
+    const std::vector<cl_double> &position,
+    const cl_uint stride,
+    const cl_uint n_local,
+    const cl_double weight,
+    std::vector<cl_double> planes[3]);
+
+/**
+ * clamp_planes
+ * @brief Move the inner grid planes along one dimension so every subdomain
+ * is at least the halo width wide, keeping the outer planes fixed.
+ */
+void clamp_planes(std::vector<cl_double> &planes);
+} /* Balance */
+
+#endif /* BALANCE_H_ */
@@ -0,0 +1,247 @@
+/*
+ * base.hpp
+ *
+ * Copyright (c) 2020 Carlos Braga
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the MIT License.
+ *
+ * See accompanying LICENSE.md or https://opensource.org/licenses/MIT.
+ */
+
+#ifndef BASE_H_
+#define BASE_H_
+
+#include "atto/opencl/opencl.hpp"
+
+namespace Params {
+/* Model parameters */
+static const cl_ulong n_steps = 1000;
+static const cl_ulong n_sample_steps = 100;
+static const cl_ulong n_migrate_steps = 10;
+static const cl_ulong n_reorder_steps = 100;
+static const cl_ulong n_balance_steps = 1000;
+static const cl_ulong n_frame_steps = 100;
+
+/*
+ * Molecule model, see topology.hpp. The sites of a molecule may lie up to
+ * molecule_extent away from its first site, which decides the subdomain of
+ * the whole molecule, so the halo width covers the extent as well.
+ */
+enum {
+    MoleculeAtom = 0,
+    MoleculeWater,
+    MoleculeChain
+};
+static const int molecule = MoleculeAtom;
+static const cl_double water_bond = 0.33;
+static const cl_double water_angle = 109.47 * M_PI / 180.0;
+static const cl_ulong max_sites = 8;
+
+/* Flexible chain of chain_length sites with harmonic bonds and angles. */
+static const cl_ulong chain_length = 4;
+static const cl_double chain_bond = 0.5;
+static const cl_double chain_angle = 109.47 * M_PI / 180.0;
+static const cl_double bond_k = 400.0;
+static const cl_double angle_k = 60.0;
+static const cl_double dihedral_k = 1.0;
+static const cl_ulong dihedral_n = 3;
+
+static const cl_double molecule_extent =
+    (molecule == MoleculeWater) ? water_bond :
+    (molecule == MoleculeChain) ? chain_bond * (chain_length - 1) : 0.0;
+
+/* Constraint solver tolerance and iteration limit of SHAKE and RATTLE. */
+static const cl_double constraint_tolerance = 1.0e-10;
+static const cl_ulong constraint_max_iter = 500;
+
+/*
+ * Initial state, see lattice.hpp. One molecule is placed on each site of
+ * n_lattice^3 cubic cells of edge lattice_spacing, with one, two or four
+ * sites per cell, or n_random molecules are placed at random at least
+ * random_distance apart. Velocities are drawn from the Maxwell-Boltzmann
+ * distribution with streams derived from lattice_seed.
+ */
+enum {
+    LatticeSc = 0,
+    LatticeBcc,
+    LatticeFcc,
+    LatticeRandom
+};
+static const int lattice = LatticeSc;
+static const cl_ulong n_lattice = 16;
+static const cl_double lattice_spacing =
+    (molecule == MoleculeWater) ? 2.0 :
+    (molecule == MoleculeChain) ? 2.5 : 1.5;
+static const cl_double box_length = lattice_spacing * n_lattice;
+static const cl_double box_lo[3] = {0.0, 0.0, 0.0};
+static const cl_double box_hi[3] = {box_length, box_length, box_length};
+static const cl_ulong n_random = 4096;
+static const cl_double random_distance = 0.9;
+static const cl_ulong lattice_seed = 0x2545f4914f6cdd1d;
+
+/*
+ * Initial configuration of atoms in XYZ or LAMMPS data format, see
+ * config.hpp, read instead of the lattice if the name is not empty. The
+ * box of the file must match the model box.
+ */
+static const char config_file[] = "";
+
+static const cl_double r_cut = 2.5;
+static const cl_double skin = 0.4;
+static const cl_double r_halo = r_cut + skin + molecule_extent;
+static const cl_double time_step = 0.005;
+
+/*
+ * Multiple time step r-RESPA. The short range and bonded forces are fast
+ * and integrated with time_step. The reciprocal space forces are slow, and
+ * are evaluated once every respa_steps inner steps and applied as impulses
+ * at the ends of each outer step. Migration and balancing change the local
+ * particles, so they run at outer step boundaries only, and so do samples,
+ * where the slow energy is up to date.
+ */
+static const cl_ulong respa_steps = 1;
+static_assert(n_sample_steps % respa_steps == 0,
+    "samples must be taken at outer step boundaries");
+static_assert(n_migrate_steps % respa_steps == 0,
+    "migration must run at outer step boundaries");
+static_assert(n_balance_steps % respa_steps == 0,
+    "balancing must run at outer step boundaries");
+static const cl_double temperature = 1.0;
+
+/*
+ * Short range pair potential, the analytic Lennard-Jones potential or a
+ * cubic spline table in r^2, see table.hpp. The table is read from
+ * pair_table_file, or tabulates the Lennard-Jones potential itself with
+ * pair_table_size segments from pair_table_r_min if the name is empty.
+ */
+enum {
+    PairAnalytic = 0,
+    PairTabulated
+};
+static const int pair_potential = PairAnalytic;
+static const char pair_table_file[] = "";
+static const cl_ulong pair_table_size = 2048;
+static const cl_double pair_table_r_min = 0.6;
+
+/*
+ * Precision policy of the pair forces, see mumd.cl, selected when the
+ * program is built. The mixed policy evaluates the pair terms in single
+ * precision and accumulates them in double precision. The policy can be
+ * set from the make command line, see drift.sh.
+ */
+enum {
+    PrecisionDouble = 0,
+    PrecisionMixed
+};
+#ifdef MUMD_PRECISION_MIXED
+static const int precision = PrecisionMixed;
+#else
+static const int precision = PrecisionDouble;
+#endif
+
+/* Electrostatics: particle charge magnitude and particle mesh Ewald sum. */
+static const cl_double charge = 0.5;
+static const cl_double ewald_alpha = 2.8 / r_cut;
+static const cl_ulong pme_grid = 64;
+static const cl_ulong pme_order = 4;
+
+/* Temperature and pressure control, see ensemble.hpp. */
+enum {
+    ThermostatNone = 0,
+    ThermostatBerendsen,
+    ThermostatBussi,
+    ThermostatNoseHoover
+};
+enum {
+    BarostatNone = 0,
+    BarostatBerendsen,
+    BarostatMtk
+};
+#ifdef MUMD_NVE
+static const int thermostat = ThermostatNone;
+#else
+static const int thermostat = ThermostatBussi;
+#endif
+static const cl_double thermostat_tau = 0.1;
+static const cl_ulong nhc_length = 3;
+static const int barostat = BarostatNone;
+static const cl_double pressure = 1.0;
+static const cl_double barostat_tau = 1.0;
+static const cl_double compressibility = 0.1;
+static const cl_ulong noise_seed = 0x9e3779b97f4a7c15;
+
+/*
+ * Binary trajectory output, see trajectory.hpp, written every n_frame_steps
+ * steps. The trajectory is disabled if the file name is empty. Quantized
+ * frames store 16-bit positions and velocities. Mapped frames are read back
+ * through staging buffers in pinned host memory.
+ */
+static const char trajectory_file[] = "";
+static const bool trajectory_velocity = true;
+static const bool trajectory_quantize = false;
+static const bool trajectory_mapped = false;
+static_assert(n_frame_steps % n_sample_steps == 0,
+    "frames must be written at sample steps");
+
+/*
+ * Radial distribution function, see rdf.hpp, accumulated on the device
+ * every n_rdf_steps steps up to rdf_r_max, which may exceed the cutoff but
+ * not the halo width, and written every n_rdf_output_steps steps. The
+ * accumulator is disabled if the file name is empty. Partial functions are
+ * computed for each pair of species, the distinct particle charges.
+ */
+static const char rdf_file[] = "";
+static const cl_ulong n_rdf_steps = 10;
+static const cl_ulong n_rdf_output_steps = 1000;
+static const cl_ulong rdf_bins = 256;
+static const cl_double rdf_r_max = r_cut;
+static const bool rdf_partial = false;
+static_assert(n_rdf_output_steps % n_sample_steps == 0,
+    "the rdf must be written at sample steps");
+static_assert(n_rdf_output_steps % n_rdf_steps == 0,
+    "the rdf must be written at accumulation steps");
+
+/*
+ * Streaming mean squared displacement and velocity autocorrelation, see
+ * transport.hpp, updated every n_transport_steps steps and written every
+ * n_transport_output_steps steps. The analysis is disabled if the file
+ * name is empty. The multiple-tau correlator has transport_levels levels
+ * of transport_points values each, coarsened by transport_factor, and
+ * holds 6 transport_points transport_levels doubles per particle.
+ */
+static const char transport_file[] = "";
+static const cl_ulong n_transport_steps = 10;
+static const cl_ulong n_transport_output_steps = 1000;
+static const cl_ulong transport_points = 16;
+static const cl_ulong transport_factor = 4;
+static const cl_ulong transport_levels = 10;
+static_assert(transport_points % transport_factor == 0,
+    "correlator points must be a multiple of the coarsening factor");
+static_assert(n_transport_output_steps % n_sample_steps == 0,
+    "transport must be written at sample steps");
+
+/* Per-rank capacity of local particles, ghost particles and messages. */
+static const cl_ulong max_particles = 65536;
+static const cl_ulong max_ghost = 65536;
+static const cl_ulong max_halo = 16384;
+static const cl_ulong max_migrate = 4096;
+static const cl_ulong max_cell = 64;
+
+/* Number of doubles per particle record in a migration message. */
+static const cl_ulong migrate_record_size = 9;
+
+/* Load balancer parameters */
+static const cl_double balance_threshold = 1.1;
+static const cl_double balance_relax = 0.5;
+static const cl_ulong balance_bins = 1024;
+
+/* OpenCL parameters */
+static const cl_ulong device_index = 2;
+static const cl_ulong work_group_size = 256;
+
+/* OpenMPI parameters */
+static const int master_id = 0;
+} /* Params */
+
+#endif /* BASE_H_ */
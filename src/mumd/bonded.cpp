@@ -0,0 +1,298 @@
+/*
+ * bonded.cpp
+ *
+ * Copyright (c) 2020 Carlos Braga
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the MIT License.
+ *
+ * See accompanying LICENSE.md or https://opensource.org/licenses/MIT.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include "bonded.hpp"
+using namespace atto;
+
+/** ---------------------------------------------------------------------------
+ * load
+ * @brief Load the position of particle i.
+ */
+static math::vec3d load(
+    const std::vector<cl_double> &a,
+    const cl_uint i,
+    const cl_uint stride)
+{
+    return math::vec3d(a[i], a[i + stride], a[i + 2 * stride]);
+}
+
+/**
+ * scatter
+ * @brief Add the force f to particle i.
+ */
+static void scatter(
+    std::vector<cl_double> &a,
+    const cl_uint i,
+    const cl_uint stride,
+    const math::vec3d &f)
+{
+    a[i] += f.x;
+    a[i + stride] += f.y;
+    a[i + 2 * stride] += f.z;
+}
+
+/** ---------------------------------------------------------------------------
+ * bond_force
+ * @brief Compute the forces of a harmonic bond between sites i and j, and
+ * return the energy. The virial r_ij . f_j is accumulated.
+ */
+static core_dispatch cl_double bond_force(
+    const math::vec3d r[],
+    const cl_double *param,
+    math::vec3d f[],
+    cl_double &virial)
+{
+    const cl_double k = param[0];
+    const cl_double r0 = param[1];
+
+    math::vec3d r_ij = r[1] - r[0];
+    cl_double len = math::norm(r_ij);
+    cl_double dr = len - r0;
+    f[1] = (-k * dr / len) * r_ij;
+    f[0] = -f[1];
+    virial += math::dot(r_ij, f[1]);
+    return 0.5 * k * dr * dr;
+}
+
+/**
+ * angle_force
+ * @brief Compute the forces of a harmonic angle between the bonds from the
+ * apex j to sites i and k, and return the energy. With the unit bond vectors
+ * u and w of lengths a and b, dtheta/dr_i = (cos theta u - w) / (a sin theta)
+ * and likewise for k. The virial is accumulated relative to the apex.
+ */
+static core_dispatch cl_double angle_force(
+    const math::vec3d r[],
+    const cl_double *param,
+    math::vec3d f[],
+    cl_double &virial)
+{
+    const cl_double k = param[0];
+    const cl_double theta0 = param[1];
+
+    math::vec3d a = r[0] - r[1];
+    math::vec3d b = r[2] - r[1];
+    math::vec3d u = math::normalize(a);
+    math::vec3d w = math::normalize(b);
+    cl_double cos_theta = math::dot(u, w);
+    cl_double sin_theta = std::max(math::norm(math::cross(u, w)), 1.0e-12);
+    cl_double theta = std::atan2(sin_theta, cos_theta);
+    cl_double dtheta = theta - theta0;
+
+    cl_double du = k * dtheta / sin_theta;
+    f[0] = (du / math::norm(a)) * (w - cos_theta * u);
+    f[2] = (du / math::norm(b)) * (u - cos_theta * w);
+    f[1] = -(f[0] + f[2]);
+    virial += math::dot(a, f[0]) + math::dot(b, f[2]);
+    return 0.5 * k * dtheta * dtheta;
+}
+
+/**
+ * dihedral_force
+ * @brief Compute the forces of a periodic dihedral between the planes of
+ * sites (i,j,k) and (j,k,l), and return the energy. With the bond vectors
+ * b1 = r_j - r_i, b2 = r_k - r_j, b3 = r_l - r_k and the plane normals
+ * m = b1 x b2 and n = b2 x b3, the angle is phi = atan2(|b2| b1 . n, m . n),
+ * zero for the cis conformation, Bekker (1996). When three consecutive
+ * sites are collinear the angle is undefined and the force along the
+ * degenerate normal vanishes. The virial is accumulated relative to site i.
+ */
+static core_dispatch cl_double dihedral_force(
+    const math::vec3d r[],
+    const cl_double *param,
+    math::vec3d f[],
+    cl_double &virial)
+{
+    const cl_double k = param[0];
+    const cl_double mult = param[1];
+    const cl_double phi0 = param[2];
+
+    math::vec3d b1 = r[1] - r[0];
+    math::vec3d b2 = r[2] - r[1];
+    math::vec3d b3 = r[3] - r[2];
+    math::vec3d m = math::cross(b1, b2);
+    math::vec3d n = math::cross(b2, b3);
+
+    /*
+     * Clamp the middle bond and the plane normals away from zero, as the
+     * sine in angle_force, so three collinear sites give a finite force.
+     */
+    cl_double len_b2 = std::max(math::norm(b2), 1.0e-12);
+    cl_double m_sq = std::max(math::dot(m, m), 1.0e-24);
+    cl_double n_sq = std::max(math::dot(n, n), 1.0e-24);
+    cl_double phi = std::atan2(len_b2 * math::dot(b1, n), math::dot(m, n));
+
+    /* dU/dphi and the gradients of phi with respect to the end sites. */
+    cl_double du = -k * mult * std::sin(mult * phi - phi0);
+    math::vec3d g_i = (-len_b2 / m_sq) * m;
+    math::vec3d g_l = (len_b2 / n_sq) * n;
+    cl_double p = math::dot(b1, b2) / (len_b2 * len_b2);
+    cl_double q = math::dot(b3, b2) / (len_b2 * len_b2);
+
+    f[0] = -du * g_i;
+    f[3] = -du * g_l;
+    f[1] = q * f[3] - (1.0 + p) * f[0];
+    f[2] = p * f[0] - (1.0 + q) * f[3];
+    virial += math::dot(b1, f[1]) +
+              math::dot(b1 + b2, f[2]) +
+              math::dot(b1 + b2 + b3, f[3]);
+    return k * (1.0 + std::cos(mult * phi - phi0));
+}
+
+/** ---------------------------------------------------------------------------
+ * Bonded::Bonded
+ * @brief Copy the bonded terms of the molecule template and colour them.
+ * Each template term takes the lowest colour not used by an earlier term
+ * sharing one of its sites.
+ */
+Bonded::Bonded(const Topology &topology)
+{
+    m_n_sites = topology.m_n_sites;
+    m_site[Bond] = topology.m_bond_site;
+    m_site[Angle] = topology.m_angle_site;
+    m_site[Dihedral] = topology.m_dihedral_site;
+    m_param[Bond] = topology.m_bond_param;
+    m_param[Angle] = topology.m_angle_param;
+    m_param[Dihedral] = topology.m_dihedral_param;
+    m_energy = 0.0;
+    m_virial = 0.0;
+
+    for (cl_uint kind = 0; kind < NumKinds; ++kind) {
+        const cl_uint n_sites = n_term_sites(kind);
+        const cl_uint n_terms = (cl_uint) m_site[kind].size() / n_sites;
+        std::vector<cl_ulong> site_colours(m_n_sites, 0);
+
+        m_n_colours[kind] = 0;
+        m_colour[kind].resize(n_terms, 0);
+        for (cl_uint t = 0; t < n_terms; ++t) {
+            const cl_uint *sites = &m_site[kind][t * n_sites];
+            cl_ulong used = 0;
+            for (cl_uint s = 0; s < n_sites; ++s) {
+                used |= site_colours[sites[s]];
+            }
+
+            cl_uint colour = 0;
+            while (used & (1ul << colour)) {
+                ++colour;
+            }
+            core_assert(colour < 64, "too many bonded term colours");
+            for (cl_uint s = 0; s < n_sites; ++s) {
+                site_colours[sites[s]] |= 1ul << colour;
+            }
+            m_colour[kind][t] = colour;
+            m_n_colours[kind] = std::max(m_n_colours[kind], colour + 1);
+        }
+    }
+}
+
+/**
+ * Bonded::build
+ * @brief Build the local term arrays after the particle store changed
+ * order. The local particles are sorted by id, so the sites of each
+ * molecule are consecutive, and the terms of every molecule are appended
+ * colour by colour.
+ */
+void Bonded::build(const std::vector<cl_ulong> &id, const cl_uint n_local)
+{
+    std::vector<std::pair<cl_ulong, cl_uint>> sorted(n_local);
+    for (cl_uint i = 0; i < n_local; ++i) {
+        sorted[i] = std::make_pair(id[i], i);
+    }
+    std::sort(sorted.begin(), sorted.end());
+
+    const cl_uint n_molecules = n_local / m_n_sites;
+    for (cl_uint mol = 0; mol < n_molecules; ++mol) {
+        core_assert(sorted[mol * m_n_sites].first % m_n_sites == 0 &&
+            sorted[(mol + 1) * m_n_sites - 1].first ==
+            sorted[mol * m_n_sites].first + m_n_sites - 1,
+            "incomplete local molecule");
+    }
+
+    for (cl_uint kind = 0; kind < NumKinds; ++kind) {
+        const cl_uint n_sites = n_term_sites(kind);
+        const cl_uint n_terms = (cl_uint) m_colour[kind].size();
+
+        m_term[kind].clear();
+        m_type[kind].clear();
+        m_batch[kind].assign(1, 0);
+        for (cl_uint colour = 0; colour < m_n_colours[kind]; ++colour) {
+            for (cl_uint mol = 0; mol < n_molecules; ++mol) {
+                const auto *local = &sorted[mol * m_n_sites];
+                for (cl_uint t = 0; t < n_terms; ++t) {
+                    if (m_colour[kind][t] != colour) {
+                        continue;
+                    }
+                    for (cl_uint s = 0; s < n_sites; ++s) {
+                        m_term[kind].push_back(
+                            local[m_site[kind][t * n_sites + s]].second);
+                    }
+                    m_type[kind].push_back(t);
+                }
+            }
+            m_batch[kind].push_back((cl_uint) m_type[kind].size());
+        }
+    }
+}
+
+/**
+ * Bonded::compute
+ * @brief Compute the bonded forces of the local terms and add them to the
+ * force array. The batches of each kind are computed in turn, and the terms
+ * of a batch in parallel. Return the bonded energy, and store it with the
+ * virial. The term force functions are multiversioned with ATTO_DISPATCH.
+ */
+cl_double Bonded::compute(
+    const std::vector<cl_double> &position,
+    const cl_uint stride,
+    std::vector<cl_double> &force)
+{
+    typedef cl_double (*TermForce)(
+        const math::vec3d *, const cl_double *, math::vec3d *, cl_double &);
+    const TermForce term_force[NumKinds] = {
+        bond_force, angle_force, dihedral_force};
+    const cl_uint n_params[NumKinds] = {2, 2, 3};
+
+    cl_double energy = 0.0;
+    cl_double virial = 0.0;
+    for (cl_uint kind = 0; kind < NumKinds; ++kind) {
+        const cl_uint n_sites = n_term_sites(kind);
+        for (cl_uint colour = 0; colour < m_n_colours[kind]; ++colour) {
+            const cl_uint begin = m_batch[kind][colour];
+            const cl_uint end = m_batch[kind][colour + 1];
+
+            core_pragma_omp(parallel for schedule(static) reduction(+:energy,virial))
+            for (cl_uint term = begin; term < end; ++term) {
+                const cl_uint *sites = &m_term[kind][term * n_sites];
+                math::vec3d r[4];
+                math::vec3d f[4];
+                for (cl_uint s = 0; s < n_sites; ++s) {
+                    r[s] = load(position, sites[s], stride);
+                }
+
+                energy += term_force[kind](
+                    r,
+                    &m_param[kind][m_type[kind][term] * n_params[kind]],
+                    f,
+                    virial);
+                for (cl_uint s = 0; s < n_sites; ++s) {
+                    scatter(force, sites[s], stride, f[s]);
+                }
+            }
+        }
+    }
+
+    m_energy = energy;
+    m_virial = virial;
+    return energy;
+}
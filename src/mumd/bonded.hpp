@@ -0,0 +1,76 @@
+/*
+ * bonded.hpp
+ *
+ * Copyright (c) 2020 Carlos Braga
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the MIT License.
+ *
+ * See accompanying LICENSE.md or https://opensource.org/licenses/MIT.
+ */
+
+#ifndef BONDED_H_
+#define BONDED_H_
+
+#include <vector>
+#include "base.hpp"
+#include "topology.hpp"
+
+/**
+ * Bonded
+ * @brief Bonded forces of the local molecules, computed on the host with
+ * the reciprocal space forces.
+ *
+ * The local terms are stored as flat arrays of local particle indices, two
+ * per bond, three per angle and four per dihedral, with the index of the
+ * template term giving their parameters. The terms are grouped in colour
+ * batches, such that no two terms of a batch share a particle. The template
+ * terms are coloured once, greedily, and every local term inherits the
+ * colour of its template term, since terms of different molecules never
+ * share a particle. Each batch is computed by the OpenMP threads in
+ * parallel and its forces are scattered without atomics.
+ */
+struct Bonded {
+    /* ---- Template terms and their colours ------------------------------- */
+    cl_uint m_n_sites;
+    std::vector<cl_uint> m_site[3];
+    std::vector<cl_double> m_param[3];
+    std::vector<cl_uint> m_colour[3];
+    cl_uint m_n_colours[3];
+
+    /* ---- Local terms sorted by colour, and the batch offsets ------------ */
+    std::vector<cl_uint> m_term[3];
+    std::vector<cl_uint> m_type[3];
+    std::vector<cl_uint> m_batch[3];
+
+    /* ---- Energy and virial of the last computation ---------------------- */
+    cl_double m_energy;
+    cl_double m_virial;
+
+    /* ---- Bonded member functions ---------------------------------------- */
+    enum {
+        Bond = 0,
+        Angle,
+        Dihedral,
+        NumKinds
+    };
+    static cl_uint n_term_sites(const cl_uint kind) { return kind + 2; }
+    bool is_active(void) const {
+        return !m_site[Bond].empty() ||
+               !m_site[Angle].empty() ||
+               !m_site[Dihedral].empty();
+    }
+
+    void build(const std::vector<cl_ulong> &id, const cl_uint n_local);
+    cl_double compute(
+        const std::vector<cl_double> &position,
+        const cl_uint stride,
+        std::vector<cl_double> &force);
+
+    explicit Bonded(const Topology &topology);
+    ~Bonded() = default;
+    Bonded(const Bonded &) = delete;
+    Bonded &operator=(const Bonded &) = delete;
+};
+
+#endif /* BONDED_H_ */
@@ -0,0 +1,658 @@
+/*
+ * config.cpp
+ *
+ * Copyright (c) 2020 Carlos Braga
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the MIT License.
+ *
+ * See accompanying LICENSE.md or https://opensource.org/licenses/MIT.
+ */
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "config.hpp"
+using namespace atto;
+
+/** ---------------------------------------------------------------------------
+ * is_space
+ * @brief Is the character a blank within a line?
+ */
+static inline bool is_space(const char c)
+{
+    return (c == ' ' || c == '\t' || c == '\r');
+}
+
+/**
+ * skip_space
+ * @brief Return the first non-blank character in the line.
+ */
+static inline const char *skip_space(const char *p, const char *end)
+{
+    while (p < end && is_space(*p)) {
+        ++p;
+    }
+    return p;
+}
+
+/**
+ * skip_token
+ * @brief Return the first blank character after the next token in the line.
+ */
+static inline const char *skip_token(const char *p, const char *end)
+{
+    p = skip_space(p, end);
+    while (p < end && !is_space(*p)) {
+        ++p;
+    }
+    return p;
+}
+
+/**
+ * end_of_line
+ * @brief Return the end of the line starting at p, its newline or the end
+ * of the file.
+ */
+static inline const char *end_of_line(const char *p, const char *end)
+{
+    const char *eol = static_cast<const char *>(std::memchr(p, '\n', end - p));
+    return (eol != NULL) ? eol : end;
+}
+
+/**
+ * is_blank
+ * @brief Is the line empty, blank or a comment?
+ */
+static inline bool is_blank(const char *p, const char *eol)
+{
+    p = skip_space(p, eol);
+    return (p == eol || *p == '#');
+}
+
+/**
+ * match_token
+ * @brief Match the next token in the line to a keyword, and advance past it.
+ */
+static inline bool match_token(const char *&p, const char *end, const char *key)
+{
+    const char *begin = skip_space(p, end);
+    const char *last = skip_token(begin, end);
+    const size_t length = std::strlen(key);
+    if ((size_t) (last - begin) != length ||
+        std::strncmp(begin, key, length) != 0) {
+        return false;
+    }
+    p = last;
+    return true;
+}
+
+/** ---------------------------------------------------------------------------
+ * parse_ulong
+ * @brief Parse an unsigned integer token in place, and advance past it.
+ */
+static inline bool parse_ulong(const char *&p, const char *end, cl_ulong &value)
+{
+    const char *q = skip_space(p, end);
+    const char *first = q;
+    cl_ulong v = 0;
+    while (q < end && *q >= '0' && *q <= '9') {
+        v = 10 * v + (cl_ulong) (*q++ - '0');
+    }
+    if (q == first || (q < end && !is_space(*q) && *q != '\n')) {
+        return false;
+    }
+    value = v;
+    p = q;
+    return true;
+}
+
+/**
+ * parse_double
+ * @brief Parse a floating point token in place, and advance past it. The
+ * decimal significand is accumulated in a 64-bit integer. If it is exact in
+ * a double and the decimal exponent is at most 22 in magnitude, the value
+ * is a single correctly rounded multiply or divide by an exact power of ten.
+ * Other tokens fall back to strtod on a copy in a stack buffer, so every
+ * value is correctly rounded and no token is allocated. Tokens too long for
+ * the buffer are rejected rather than parsed as their prefix.
+ */
+static inline bool parse_double(const char *&p, const char *end, cl_double &value)
+{
+    static const cl_double pow10[] = {
+        1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,
+        1e8,  1e9,  1e10, 1e11, 1e12, 1e13, 1e14, 1e15,
+        1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+    const char *q = skip_space(p, end);
+    const char *first = q;
+    bool negative = false;
+    if (q < end && (*q == '-' || *q == '+')) {
+        negative = (*q++ == '-');
+    }
+
+    cl_ulong significand = 0;
+    int n_digits = 0;
+    int n_significant = 0;
+    int exponent = 0;
+    while (q < end && *q >= '0' && *q <= '9') {
+        if (n_significant < 19) {
+            significand = 10 * significand + (cl_ulong) (*q - '0');
+            n_significant += (significand > 0);
+        } else {
+            exponent++;
+        }
+        ++n_digits;
+        ++q;
+    }
+    if (q < end && *q == '.') {
+        ++q;
+        while (q < end && *q >= '0' && *q <= '9') {
+            if (n_significant < 19) {
+                significand = 10 * significand + (cl_ulong) (*q - '0');
+                n_significant += (significand > 0);
+                exponent--;
+            }
+            ++n_digits;
+            ++q;
+        }
+    }
+    if (n_digits == 0) {
+        return false;
+    }
+    if (q < end && (*q == 'e' || *q == 'E')) {
+        ++q;
+        bool negative_exponent = false;
+        if (q < end && (*q == '-' || *q == '+')) {
+            negative_exponent = (*q++ == '-');
+        }
+        if (q == end || *q < '0' || *q > '9') {
+            return false;
+        }
+        int e = 0;
+        while (q < end && *q >= '0' && *q <= '9') {
+            e = std::min(10 * e + (*q++ - '0'), 100000);
+        }
+        exponent += negative_exponent ? -e : e;
+    }
+    if (q < end && !is_space(*q) && *q != '\n') {
+        return false;
+    }
+
+    if (significand < (1ull << 53) && exponent >= -22 && exponent <= 22) {
+        cl_double v = (cl_double) significand;
+        v = (exponent < 0) ? v / pow10[-exponent] : v * pow10[exponent];
+        value = negative ? -v : v;
+    } else {
+        char buffer[64];
+        const size_t length = (size_t) (q - first);
+        if (length >= sizeof(buffer)) {
+            return false;
+        }
+        std::memcpy(buffer, first, length);
+        buffer[length] = '\0';
+        value = std::strtod(buffer, NULL);
+    }
+    p = q;
+    return true;
+}
+
+/** ---------------------------------------------------------------------------
+ * scan
+ * @brief First pass over the chunks of a section of n_records records. The
+ * parse function reads a line and flags the particles of this process. Each
+ * chunk counts its records and saves the local lines with their record
+ * number, and the first line that is not a record. The records past the
+ * section are then dropped, and the chunk offsets in the particle store
+ * are the prefix sums of the local lines. Return the end of the section,
+ * the first line past its last record.
+ */
+template<typename Parse>
+static const char *scan(
+    std::vector<Configuration::Chunk> &chunks,
+    const cl_ulong n_records,
+    const char *end,
+    Parse parse)
+{
+    const int n_chunks = (int) chunks.size();
+    core_pragma_omp(parallel for schedule(dynamic, 1))
+    for (int k = 0; k < n_chunks; ++k) {
+        Configuration::Chunk &chunk = chunks[k];
+        chunk.n_records = 0;
+        chunk.invalid = NULL;
+        chunk.invalid_record = 0;
+        chunk.lines.clear();
+
+        const char *line = chunk.begin;
+        while (line < chunk.end) {
+            const char *eol = end_of_line(line, chunk.end);
+            if (!is_blank(line, eol)) {
+                bool local = false;
+                if (!parse(line, eol, local)) {
+                    if (chunk.invalid == NULL) {
+                        chunk.invalid = line;
+                        chunk.invalid_record = chunk.n_records;
+                    }
+                } else if (local) {
+                    chunk.lines.emplace_back(chunk.n_records, line);
+                }
+                chunk.n_records++;
+            }
+            line = eol + 1;
+        }
+    }
+
+    cl_ulong first_record = 0;
+    cl_ulong offset = 0;
+    const char *section_end = end;
+    for (auto &chunk : chunks) {
+        chunk.first_record = first_record;
+        chunk.offset = offset;
+        if (chunk.invalid != NULL && section_end == end) {
+            core_assert(first_record + chunk.invalid_record >= n_records,
+                "invalid configuration record");
+            section_end = chunk.invalid;
+        }
+
+        auto last = std::lower_bound(
+            chunk.lines.begin(),
+            chunk.lines.end(),
+            std::make_pair(n_records - std::min(first_record, n_records),
+                (const char *) NULL));
+        chunk.lines.erase(last, chunk.lines.end());
+        first_record += chunk.n_records;
+        offset += chunk.lines.size();
+    }
+    core_assert(first_record >= n_records, "missing configuration records");
+    return section_end;
+}
+
+/** ---------------------------------------------------------------------------
+ * Configuration::Configuration
+ * @brief Map the configuration file and read its header. Files with the
+ * .xyz extension are read as XYZ, and other files as LAMMPS data.
+ */
+Configuration::Configuration(const char *filename)
+{
+    const size_t length = std::strlen(filename);
+    m_format = (length > 4 && std::strcmp(filename + length - 4, ".xyz") == 0)
+        ? FormatXyz : FormatLammps;
+
+    m_fd = ::open(filename, O_RDONLY);
+    core_assert(m_fd >= 0, "failed to open configuration file");
+    struct stat info;
+    core_assert(::fstat(m_fd, &info) == 0, "failed to stat configuration file");
+    m_size = (size_t) info.st_size;
+    core_assert(m_size > 0, "empty configuration file");
+
+    void *data = ::mmap(NULL, m_size, PROT_READ, MAP_PRIVATE, m_fd, 0);
+    core_assert(data != MAP_FAILED, "failed to map configuration file");
+    ::madvise(data, m_size, MADV_WILLNEED);
+    m_data = static_cast<const char *>(data);
+
+    read_header();
+}
+
+/**
+ * Configuration::~Configuration
+ * @brief Unmap and close the configuration file.
+ */
+Configuration::~Configuration()
+{
+    ::munmap(const_cast<char *>(m_data), m_size);
+    ::close(m_fd);
+}
+
+/** ---------------------------------------------------------------------------
+ * Configuration::read_header
+ * @brief Read the number of particles, the box and the record layout, and
+ * locate the first record.
+ */
+void Configuration::read_header(void)
+{
+    const char *end = m_data + m_size;
+    m_n_particles = 0;
+    m_has_box = false;
+    m_has_charge = false;
+    m_has_velocity = false;
+    m_atoms = m_velocities = NULL;
+
+    if (m_format == FormatXyz) {
+        /* Number of particles. */
+        const char *p = m_data;
+        const char *eol = end_of_line(p, end);
+        core_assert(parse_ulong(p, eol, m_n_particles) && m_n_particles > 0,
+            "invalid xyz particle count");
+
+        /* Extended xyz orthorhombic lattice in the comment line. */
+        p = std::min(eol + 1, end);
+        eol = end_of_line(p, end);
+        for (const char *q = p; q + 9 <= eol; ++q) {
+            if (std::strncmp(q, "Lattice=\"", 9) != 0) {
+                continue;
+            }
+            q += 9;
+            const char *quote = static_cast<const char *>(
+                std::memchr(q, '"', eol - q));
+            core_assert(quote != NULL, "invalid xyz lattice");
+            cl_double h[9];
+            for (int k = 0; k < 9; ++k) {
+                core_assert(parse_double(q, quote, h[k]), "invalid xyz lattice");
+            }
+            core_assert(h[1] == 0.0 && h[2] == 0.0 && h[3] == 0.0 &&
+                        h[5] == 0.0 && h[6] == 0.0 && h[7] == 0.0,
+                "xyz lattice is not orthorhombic");
+            for (int dim = 0; dim < 3; ++dim) {
+                m_box_lo[dim] = 0.0;
+                m_box_hi[dim] = h[4 * dim];
+            }
+            m_has_box = true;
+            break;
+        }
+
+        /* Velocities follow the positions in each record. */
+        m_atoms = std::min(eol + 1, end);
+        p = m_atoms;
+        eol = end_of_line(p, end);
+        p = skip_token(p, eol);
+        cl_double value[6];
+        int n_values = 0;
+        while (n_values < 6 && parse_double(p, eol, value[n_values])) {
+            n_values++;
+        }
+        core_assert(n_values == 3 || n_values == 6, "invalid xyz record");
+        m_has_velocity = (n_values == 6);
+        return;
+    }
+
+    /*
+     * LAMMPS data header, after the title line. Section keyword lines
+     * start with a letter and their records with a number.
+     */
+    const char *line = std::min(end_of_line(m_data, end) + 1, end);
+    int n_box = 0;
+    while (line < end) {
+        const char *eol = end_of_line(line, end);
+        const char *p = skip_space(line, eol);
+        if (p < eol && std::isalpha(*p)) {
+            if (match_token(p, eol, "Atoms")) {
+                /*
+                 * Only the atomic and charge styles are supported, other
+                 * styles have more columns than the records are parsed for.
+                 */
+                if (skip_space(p, eol) != eol) {
+                    core_assert(match_token(p, eol, "#"),
+                        "invalid atoms section style");
+                    m_has_charge = match_token(p, eol, "charge");
+                    core_assert(
+                        (m_has_charge || match_token(p, eol, "atomic")) &&
+                        skip_space(p, eol) == eol,
+                        "unsupported atoms style, only atomic and charge");
+                }
+                m_atoms = std::min(eol + 1, end);
+                break;
+            }
+        } else {
+            static const char *bounds[3][2] = {
+                {"xlo", "xhi"}, {"ylo", "yhi"}, {"zlo", "zhi"}};
+            cl_ulong n;
+            cl_double lo, hi;
+            const char *q = p;
+            if (parse_ulong(q, eol, n) && match_token(q, eol, "atoms")) {
+                m_n_particles = n;
+            }
+            for (int dim = 0; dim < 3; ++dim) {
+                q = p;
+                if (parse_double(q, eol, lo) && parse_double(q, eol, hi) &&
+                    match_token(q, eol, bounds[dim][0]) &&
+                    match_token(q, eol, bounds[dim][1])) {
+                    m_box_lo[dim] = lo;
+                    m_box_hi[dim] = hi;
+                    n_box++;
+                }
+            }
+        }
+        line = eol + 1;
+    }
+    core_assert(m_atoms != NULL, "missing atoms section");
+    core_assert(m_n_particles > 0, "invalid atom count");
+    m_has_box = (n_box == 3);
+}
+
+/**
+ * Configuration::split
+ * @brief Split the file from begin to its end in line-aligned chunks, a
+ * few per thread for dynamic scheduling, each at least a minimum size.
+ */
+void Configuration::split(const char *begin)
+{
+    const char *end = m_data + m_size;
+    const size_t min_size = 1 << 20;
+    const size_t size = (size_t) (end - begin);
+    const size_t n_chunks = std::max((size_t) 1, std::min(
+        (size_t) (4 * omp_get_max_threads()), size / min_size));
+
+    m_chunks.resize(n_chunks);
+    const char *last = begin;
+    for (size_t k = 0; k < n_chunks; ++k) {
+        m_chunks[k].begin = last;
+        if (k + 1 < n_chunks) {
+            const char *split = std::max(last, begin + (k + 1) * size / n_chunks);
+            last = std::min(end_of_line(split, end) + 1, end);
+        } else {
+            last = end;
+        }
+        m_chunks[k].end = last;
+    }
+}
+
+/** ---------------------------------------------------------------------------
+ * Configuration::read
+ * @brief Read the particles inside the subdomain into the particle store
+ * with stride capacity, and return their number. Positions are wrapped in
+ * the periodic box. Ids start at zero. The velocities and charges are only
+ * written if the file holds them.
+ */
+cl_uint Configuration::read(
+    const Domain &domain,
+    const cl_uint capacity,
+    cl_double *position,
+    cl_double *velocity,
+    cl_double *charge,
+    cl_ulong *id)
+{
+    const char *end = m_data + m_size;
+    const int format = m_format;
+    const bool has_charge = m_has_charge;
+    const bool has_velocity = m_has_velocity;
+    const cl_ulong n_particles = m_n_particles;
+
+    cl_double box_lo[3];
+    cl_double box_length[3];
+    for (int dim = 0; dim < 3; ++dim) {
+        box_lo[dim] = domain.m_box_lo[dim];
+        box_length[dim] = domain.m_box_hi[dim] - domain.m_box_lo[dim];
+        if (m_has_box) {
+            core_assert(
+                std::fabs(m_box_lo[dim] - domain.m_box_lo[dim]) <= 1.0e-9 * box_length[dim] &&
+                std::fabs(m_box_hi[dim] - domain.m_box_hi[dim]) <= 1.0e-9 * box_length[dim],
+                "configuration box does not match the model box");
+        }
+    }
+
+    /*
+     * Parse a particle record, its id, charge, wrapped position and
+     * velocity.
+     */
+    auto parse_record = [&] (
+        const char *p,
+        const char *eol,
+        cl_ulong &record_id,
+        cl_double &q,
+        cl_double r[3],
+        cl_double v[3]) -> bool {
+        if (format == FormatXyz) {
+            p = skip_token(p, eol);
+        } else {
+            cl_ulong type;
+            if (!parse_ulong(p, eol, record_id) || !parse_ulong(p, eol, type) ||
+                record_id == 0 || record_id > n_particles) {
+                return false;
+            }
+            record_id--;
+            if (has_charge && !parse_double(p, eol, q)) {
+                return false;
+            }
+        }
+        for (int dim = 0; dim < 3; ++dim) {
+            if (!parse_double(p, eol, r[dim])) {
+                return false;
+            }
+            r[dim] -= box_length[dim] *
+                std::floor((r[dim] - box_lo[dim]) / box_length[dim]);
+        }
+        if (format == FormatXyz && has_velocity) {
+            for (int dim = 0; dim < 3; ++dim) {
+                if (!parse_double(p, eol, v[dim])) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    };
+
+    /*
+     * First pass over the atoms section, keep the lines of the particles
+     * inside the subdomain.
+     */
+    split(m_atoms);
+    const char *section_end = scan(m_chunks, n_particles, end,
+        [&] (const char *line, const char *eol, bool &local) -> bool {
+            cl_ulong record_id = 0;
+            cl_double q, r[3], v[3];
+            if (!parse_record(line, eol, record_id, q, r, v)) {
+                return false;
+            }
+            local = domain.is_inside(r);
+            return true;
+        });
+    const cl_ulong n_local = m_chunks.back().offset + m_chunks.back().lines.size();
+    core_assert(n_local <= capacity, "particle capacity exceeded");
+
+    /*
+     * Second pass, parse the local lines into their slots in the store.
+     */
+    const int n_chunks = (int) m_chunks.size();
+    core_pragma_omp(parallel for schedule(dynamic, 1))
+    for (int k = 0; k < n_chunks; ++k) {
+        const Chunk &chunk = m_chunks[k];
+        for (size_t j = 0; j < chunk.lines.size(); ++j) {
+            const char *line = chunk.lines[j].second;
+            const char *eol = end_of_line(line, chunk.end);
+            const cl_ulong i = chunk.offset + j;
+            cl_ulong record_id = chunk.first_record + chunk.lines[j].first;
+            cl_double q = 0.0, r[3], v[3];
+            parse_record(line, eol, record_id, q, r, v);
+
+            id[i] = record_id;
+            if (has_charge) {
+                charge[i] = q;
+            }
+            for (int dim = 0; dim < 3; ++dim) {
+                position[i + dim * capacity] = r[dim];
+                if (has_velocity) {
+                    velocity[i + dim * capacity] = v[dim];
+                }
+            }
+        }
+    }
+
+    /*
+     * LAMMPS velocities section following the atoms section, with the
+     * records matched to the local particles by id.
+     */
+    if (format == FormatLammps) {
+        const char *line = section_end;
+        while (line < end && is_blank(line, end_of_line(line, end))) {
+            line = end_of_line(line, end) + 1;
+        }
+        if (line < end) {
+            const char *eol = end_of_line(line, end);
+            const char *p = line;
+            if (match_token(p, eol, "Velocities")) {
+                m_velocities = std::min(eol + 1, end);
+            }
+        }
+    }
+
+    if (m_velocities != NULL) {
+        std::vector<std::pair<cl_ulong, cl_uint>> index(n_local);
+        for (cl_uint i = 0; i < n_local; ++i) {
+            index[i] = std::make_pair(id[i], i);
+        }
+        std::sort(index.begin(), index.end());
+        auto find = [&index] (const cl_ulong key) -> cl_long {
+            auto it = std::lower_bound(
+                index.begin(), index.end(), std::make_pair(key, (cl_uint) 0));
+            return (it != index.end() && it->first == key) ? (cl_long) it->second : -1;
+        };
+        auto parse_velocity = [&] (
+            const char *p,
+            const char *eol,
+            cl_ulong &record_id,
+            cl_double v[3]) -> bool {
+            if (!parse_ulong(p, eol, record_id) ||
+                record_id == 0 || record_id > n_particles) {
+                return false;
+            }
+            record_id--;
+            for (int dim = 0; dim < 3; ++dim) {
+                if (!parse_double(p, eol, v[dim])) {
+                    return false;
+                }
+            }
+            return true;
+        };
+
+        split(m_velocities);
+        scan(m_chunks, n_particles, end,
+            [&] (const char *line, const char *eol, bool &local) -> bool {
+                cl_ulong record_id = 0;
+                cl_double v[3];
+                if (!parse_velocity(line, eol, record_id, v)) {
+                    return false;
+                }
+                local = (find(record_id) >= 0);
+                return true;
+            });
+
+        const int n_chunks = (int) m_chunks.size();
+        core_pragma_omp(parallel for schedule(dynamic, 1))
+        for (int k = 0; k < n_chunks; ++k) {
+            const Chunk &chunk = m_chunks[k];
+            for (auto &it : chunk.lines) {
+                cl_ulong record_id = 0;
+                cl_double v[3];
+                const char *eol = end_of_line(it.second, chunk.end);
+                if (!parse_velocity(it.second, eol, record_id, v)) {
+                    continue;
+                }
+                const cl_long i = find(record_id);
+                if (i < 0) {
+                    continue;
+                }
+                for (int dim = 0; dim < 3; ++dim) {
+                    velocity[i + dim * capacity] = v[dim];
+                }
+            }
+        }
+        m_has_velocity = true;
+    }
+    return (cl_uint) n_local;
+}
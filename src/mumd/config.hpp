@@ -0,0 +1,95 @@
+/*
+ * config.hpp
+ *
+ * Copyright (c) 2020 Carlos Braga
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the MIT License.
+ *
+ * See accompanying LICENSE.md or https://opensource.org/licenses/MIT.
+ */
+
+#ifndef CONFIG_H_
+#define CONFIG_H_
+
+#include <utility>
+#include <vector>
+#include "base.hpp"
+#include "domain.hpp"
+
+/**
+ * Configuration
+ * @brief Parallel reader of an initial configuration in XYZ or LAMMPS data
+ * text format. The file is memory mapped and each process reads the whole
+ * file, keeping the particles whose wrapped position lies inside its
+ * subdomain.
+ *
+ * A section of records is split into line-aligned chunks parsed by the
+ * OpenMP threads in two passes. The first pass parses the positions, counts
+ * the records and saves the lines of the local particles in each chunk. The
+ * second pass, after a prefix sum over the chunks, parses the saved lines
+ * again and writes each particle directly into its slot of the structure
+ * of arrays store. Tokens are parsed in place without allocation.
+ *
+ * XYZ files hold the number of particles, a comment line, and one record
+ * per particle, name x y z [vx vy vz], in id order. An extended XYZ comment
+ * with an orthorhombic Lattice="a 0 0 0 b 0 0 0 c" gives the box.
+ *
+ * LAMMPS data files hold the atoms and xlo xhi, ylo yhi, zlo zhi header
+ * lines, an Atoms section of records id type x y z in atomic style, or
+ * id type q x y z in charge style, and optionally a Velocities section of
+ * records id vx vy vz following it. Ids start at one. The Atoms line may
+ * only name the atomic or charge style, other styles are rejected.
+ */
+struct Configuration {
+    /* ---- Memory mapped file --------------------------------------------- */
+    enum {
+        FormatXyz = 0,
+        FormatLammps
+    };
+    int m_format;
+    int m_fd;
+    size_t m_size;
+    const char *m_data;
+
+    /* ---- Configuration header ------------------------------------------- */
+    cl_ulong m_n_particles;
+    bool m_has_box;
+    bool m_has_charge;
+    bool m_has_velocity;
+    cl_double m_box_lo[3];
+    cl_double m_box_hi[3];
+    const char *m_atoms;
+    const char *m_velocities;
+
+    /* ---- Line-aligned chunks of a section ------------------------------- */
+    struct Chunk {
+        const char *begin;
+        const char *end;
+        cl_ulong n_records;
+        cl_ulong first_record;
+        cl_ulong offset;
+        const char *invalid;
+        cl_ulong invalid_record;
+        std::vector<std::pair<cl_ulong, const char *>> lines;
+    };
+    std::vector<Chunk> m_chunks;
+
+    /* ---- Configuration member functions --------------------------------- */
+    void read_header(void);
+    void split(const char *begin);
+    cl_uint read(
+        const Domain &domain,
+        const cl_uint capacity,
+        cl_double *position,
+        cl_double *velocity,
+        cl_double *charge,
+        cl_ulong *id);
+
+    explicit Configuration(const char *filename);
+    ~Configuration();
+    Configuration(const Configuration &) = delete;
+    Configuration &operator=(const Configuration &) = delete;
+};
+
+#endif /* CONFIG_H_ */
@@ -0,0 +1,514 @@
+/*
+ * constraints.cpp
+ *
+ * Copyright (c) 2020 Carlos Braga
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the MIT License.
+ *
+ * See accompanying LICENSE.md or https://opensource.org/licenses/MIT.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include "constraints.hpp"
+using namespace atto;
+
+/** ---------------------------------------------------------------------------
+ * settle_positions
+ * @brief Constrain the positions of a batch of up to settle_batch rigid
+ * 3-site molecules with the analytical SETTLE algorithm. The sites are
+ * gathered in structure of arrays layout, [site][dim][lane], and the batch
+ * is padded by repeating its last cluster, so the solver loop has a fixed
+ * trip count and no branches.
+ *
+ * The new positions are expressed in a frame built from the old molecular
+ * plane and the new apex. The out-of-plane displacements fix the tilt
+ * angles phi and psi of the canonical triangle, and the in-plane rotation
+ * theta follows from the condition that the constraint displacements lie
+ * along the old bonds, Miyamoto and Kollman (1992).
+ */
+static core_dispatch void settle_positions(
+    const Topology &topology,
+    const cl_uint *cluster,
+    const cl_uint n_clusters,
+    const std::vector<cl_double> &position_old,
+    std::vector<cl_double> &position,
+    std::vector<cl_double> &velocity,
+    const cl_uint stride,
+    const cl_double dt,
+    std::vector<cl_double> &virial)
+{
+    const cl_uint n_lanes = Constraints::settle_batch;
+    cl_double r0[3][3][n_lanes];
+    cl_double r1[3][3][n_lanes];
+    cl_double r3[3][3][n_lanes];
+
+    for (cl_uint lane = 0; lane < n_lanes; ++lane) {
+        const cl_uint *sites = &cluster[3 * std::min(lane, n_clusters - 1)];
+        for (cl_uint site = 0; site < 3; ++site) {
+            for (cl_uint dim = 0; dim < 3; ++dim) {
+                r0[site][dim][lane] = position_old[sites[site] + dim * stride];
+                r1[site][dim][lane] = position[sites[site] + dim * stride];
+            }
+        }
+    }
+
+    const cl_double ra = topology.m_settle_ra;
+    const cl_double rb = topology.m_settle_rb;
+    const cl_double rc = topology.m_settle_rc;
+    core_pragma_omp(simd)
+    for (cl_uint lane = 0; lane < n_lanes; ++lane) {
+        /* Old bonds from the apex and new sites about the centre of mass. */
+        cl_double b0[3], c0[3], a1[3], b1[3], c1[3], com[3];
+        for (cl_uint d = 0; d < 3; ++d) {
+            b0[d] = r0[1][d][lane] - r0[0][d][lane];
+            c0[d] = r0[2][d][lane] - r0[0][d][lane];
+            com[d] = (r1[0][d][lane] + r1[1][d][lane] + r1[2][d][lane]) / 3.0;
+            a1[d] = r1[0][d][lane] - com[d];
+            b1[d] = r1[1][d][lane] - com[d];
+            c1[d] = r1[2][d][lane] - com[d];
+        }
+
+        /* Frame with z normal to the old plane and x normal to the apex. */
+        cl_double ez[3] = {
+            b0[1] * c0[2] - b0[2] * c0[1],
+            b0[2] * c0[0] - b0[0] * c0[2],
+            b0[0] * c0[1] - b0[1] * c0[0]};
+        cl_double ex[3] = {
+            a1[1] * ez[2] - a1[2] * ez[1],
+            a1[2] * ez[0] - a1[0] * ez[2],
+            a1[0] * ez[1] - a1[1] * ez[0]};
+        cl_double ey[3] = {
+            ez[1] * ex[2] - ez[2] * ex[1],
+            ez[2] * ex[0] - ez[0] * ex[2],
+            ez[0] * ex[1] - ez[1] * ex[0]};
+        cl_double inv_x = 1.0 / std::sqrt(ex[0]*ex[0] + ex[1]*ex[1] + ex[2]*ex[2]);
+        cl_double inv_y = 1.0 / std::sqrt(ey[0]*ey[0] + ey[1]*ey[1] + ey[2]*ey[2]);
+        cl_double inv_z = 1.0 / std::sqrt(ez[0]*ez[0] + ez[1]*ez[1] + ez[2]*ez[2]);
+        for (cl_uint d = 0; d < 3; ++d) {
+            ex[d] *= inv_x;
+            ey[d] *= inv_y;
+            ez[d] *= inv_z;
+        }
+
+        /* Project the old bonds and the new sites onto the frame. */
+        cl_double xb0 = b0[0]*ex[0] + b0[1]*ex[1] + b0[2]*ex[2];
+        cl_double yb0 = b0[0]*ey[0] + b0[1]*ey[1] + b0[2]*ey[2];
+        cl_double xc0 = c0[0]*ex[0] + c0[1]*ex[1] + c0[2]*ex[2];
+        cl_double yc0 = c0[0]*ey[0] + c0[1]*ey[1] + c0[2]*ey[2];
+        cl_double za1 = a1[0]*ez[0] + a1[1]*ez[1] + a1[2]*ez[2];
+        cl_double xb1 = b1[0]*ex[0] + b1[1]*ex[1] + b1[2]*ex[2];
+        cl_double yb1 = b1[0]*ey[0] + b1[1]*ey[1] + b1[2]*ey[2];
+        cl_double zb1 = b1[0]*ez[0] + b1[1]*ez[1] + b1[2]*ez[2];
+        cl_double xc1 = c1[0]*ex[0] + c1[1]*ex[1] + c1[2]*ex[2];
+        cl_double yc1 = c1[0]*ey[0] + c1[1]*ey[1] + c1[2]*ey[2];
+        cl_double zc1 = c1[0]*ez[0] + c1[1]*ez[1] + c1[2]*ez[2];
+
+        /* Tilt of the canonical triangle out of the old plane. */
+        cl_double sin_phi = za1 / ra;
+        cl_double cos_phi = std::sqrt(1.0 - sin_phi * sin_phi);
+        cl_double sin_psi = (zb1 - zc1) / (2.0 * rc * cos_phi);
+        cl_double cos_psi = std::sqrt(1.0 - sin_psi * sin_psi);
+
+        cl_double ya2 = ra * cos_phi;
+        cl_double xb2 = -rc * cos_psi;
+        cl_double t1 = -rb * cos_phi;
+        cl_double t2 = rc * sin_psi * sin_phi;
+        cl_double yb2 = t1 - t2;
+        cl_double yc2 = t1 + t2;
+
+        /* Rotation of the canonical triangle in the old plane. */
+        cl_double alpha = xb2 * (xb0 - xc0) + yb0 * yb2 + yc0 * yc2;
+        cl_double beta = xb2 * (yc0 - yb0) + xb0 * yb2 + xc0 * yc2;
+        cl_double gamma = xb0 * yb1 - xb1 * yb0 + xc0 * yc1 - xc1 * yc0;
+        cl_double alpha_beta = alpha * alpha + beta * beta;
+        cl_double sin_theta = (alpha * gamma -
+            beta * std::sqrt(alpha_beta - gamma * gamma)) / alpha_beta;
+        cl_double cos_theta = std::sqrt(1.0 - sin_theta * sin_theta);
+
+        cl_double a3[3] = {
+            -ya2 * sin_theta,
+             ya2 * cos_theta,
+             za1};
+        cl_double b3[3] = {
+             xb2 * cos_theta - yb2 * sin_theta,
+             xb2 * sin_theta + yb2 * cos_theta,
+             zb1};
+        cl_double c3[3] = {
+            -xb2 * cos_theta - yc2 * sin_theta,
+            -xb2 * sin_theta + yc2 * cos_theta,
+             zc1};
+
+        /* Back to the lab frame. */
+        for (cl_uint d = 0; d < 3; ++d) {
+            r3[0][d][lane] = com[d] + a3[0]*ex[d] + a3[1]*ey[d] + a3[2]*ez[d];
+            r3[1][d][lane] = com[d] + b3[0]*ex[d] + b3[1]*ey[d] + b3[2]*ez[d];
+            r3[2][d][lane] = com[d] + c3[0]*ex[d] + c3[1]*ey[d] + c3[2]*ez[d];
+        }
+    }
+
+    for (cl_uint lane = 0; lane < n_clusters; ++lane) {
+        const cl_uint *sites = &cluster[3 * lane];
+        for (cl_uint site = 0; site < 3; ++site) {
+            cl_double w = 0.0;
+            for (cl_uint dim = 0; dim < 3; ++dim) {
+                cl_uint ix = sites[site] + dim * stride;
+                cl_double dv = (r3[site][dim][lane] - r1[site][dim][lane]) / dt;
+                w += (r0[site][dim][lane] - r0[0][dim][lane]) * dv / dt;
+                position[ix] = r3[site][dim][lane];
+                velocity[ix] += dv;
+            }
+            virial[sites[site]] += w;
+        }
+    }
+}
+
+/**
+ * settle_velocities
+ * @brief Remove the velocity components along the three constraints of a
+ * batch of rigid 3-site molecules. With unit masses, the impulses tau along
+ * the unit bond vectors e_k of the pairs (0,1), (0,2) and (1,2) solve the
+ * 3x3 linear system
+ *      sum_l c_kl (e_k . e_l) tau_l = -e_k . (v_j - v_i),
+ * with c = {{-2,-1,1},{-1,-2,-1},{1,-1,-2}}, solved by Cramer's rule.
+ */
+static core_dispatch void settle_velocities(
+    const cl_uint *cluster,
+    const cl_uint n_clusters,
+    const std::vector<cl_double> &position,
+    std::vector<cl_double> &velocity,
+    const cl_uint stride,
+    const cl_double dt,
+    std::vector<cl_double> &virial)
+{
+    const cl_uint n_lanes = Constraints::settle_batch;
+    cl_double r[3][3][n_lanes];
+    cl_double v[3][3][n_lanes];
+    cl_double w[3][n_lanes];
+
+    for (cl_uint lane = 0; lane < n_lanes; ++lane) {
+        const cl_uint *sites = &cluster[3 * std::min(lane, n_clusters - 1)];
+        for (cl_uint site = 0; site < 3; ++site) {
+            for (cl_uint dim = 0; dim < 3; ++dim) {
+                r[site][dim][lane] = position[sites[site] + dim * stride];
+                v[site][dim][lane] = velocity[sites[site] + dim * stride];
+            }
+        }
+    }
+
+    core_pragma_omp(simd)
+    for (cl_uint lane = 0; lane < n_lanes; ++lane) {
+        /* Unit bond vectors and relative velocities of the three pairs. */
+        cl_double e[3][3], b[3];
+        const cl_uint pair[3][2] = {{0, 1}, {0, 2}, {1, 2}};
+        for (cl_uint k = 0; k < 3; ++k) {
+            cl_uint i = pair[k][0];
+            cl_uint j = pair[k][1];
+            cl_double len_sq = 0.0;
+            for (cl_uint d = 0; d < 3; ++d) {
+                e[k][d] = r[j][d][lane] - r[i][d][lane];
+                len_sq += e[k][d] * e[k][d];
+            }
+            cl_double inv_len = 1.0 / std::sqrt(len_sq);
+            b[k] = 0.0;
+            for (cl_uint d = 0; d < 3; ++d) {
+                e[k][d] *= inv_len;
+                b[k] -= e[k][d] * (v[j][d][lane] - v[i][d][lane]);
+            }
+        }
+
+        cl_double e01 = e[0][0]*e[1][0] + e[0][1]*e[1][1] + e[0][2]*e[1][2];
+        cl_double e02 = e[0][0]*e[2][0] + e[0][1]*e[2][1] + e[0][2]*e[2][2];
+        cl_double e12 = e[1][0]*e[2][0] + e[1][1]*e[2][1] + e[1][2]*e[2][2];
+        cl_double m[3][3] = {
+            {-2.0,      -e01,       e02},
+            {-e01,      -2.0,      -e12},
+            { e02,      -e12,      -2.0}};
+
+        cl_double det =
+            m[0][0] * (m[1][1] * m[2][2] - m[1][2] * m[2][1]) -
+            m[0][1] * (m[1][0] * m[2][2] - m[1][2] * m[2][0]) +
+            m[0][2] * (m[1][0] * m[2][1] - m[1][1] * m[2][0]);
+        cl_double tau[3];
+        for (cl_uint k = 0; k < 3; ++k) {
+            cl_double a[3][3];
+            for (cl_uint row = 0; row < 3; ++row) {
+                for (cl_uint col = 0; col < 3; ++col) {
+                    a[row][col] = (col == k) ? b[row] : m[row][col];
+                }
+            }
+            tau[k] = (
+                a[0][0] * (a[1][1] * a[2][2] - a[1][2] * a[2][1]) -
+                a[0][1] * (a[1][0] * a[2][2] - a[1][2] * a[2][0]) +
+                a[0][2] * (a[1][0] * a[2][1] - a[1][1] * a[2][0])) / det;
+        }
+
+        /* Apply the impulses and the virial of the constraint forces. */
+        cl_double dv[3][3];
+        for (cl_uint d = 0; d < 3; ++d) {
+            dv[0][d] =  tau[0] * e[0][d] + tau[1] * e[1][d];
+            dv[1][d] = -tau[0] * e[0][d] + tau[2] * e[2][d];
+            dv[2][d] = -tau[1] * e[1][d] - tau[2] * e[2][d];
+        }
+        for (cl_uint site = 0; site < 3; ++site) {
+            w[site][lane] = 0.0;
+            for (cl_uint d = 0; d < 3; ++d) {
+                v[site][d][lane] += dv[site][d];
+                w[site][lane] += (r[site][d][lane] - r[0][d][lane]) *
+                    dv[site][d] / dt;
+            }
+        }
+    }
+
+    for (cl_uint lane = 0; lane < n_clusters; ++lane) {
+        const cl_uint *sites = &cluster[3 * lane];
+        for (cl_uint site = 0; site < 3; ++site) {
+            for (cl_uint dim = 0; dim < 3; ++dim) {
+                velocity[sites[site] + dim * stride] = v[site][dim][lane];
+            }
+            virial[sites[site]] += w[site][lane];
+        }
+    }
+}
+
+/** ---------------------------------------------------------------------------
+ * shake_cluster
+ * @brief Constrain the positions of one cluster by SHAKE. Each constraint
+ * in turn displaces its sites along the old bond vector to restore its
+ * length, until every constraint holds within the tolerance.
+ */
+static void shake_cluster(
+    const Topology &topology,
+    const cl_uint *sites,
+    const std::vector<cl_double> &position_old,
+    std::vector<cl_double> &position,
+    std::vector<cl_double> &velocity,
+    const cl_uint stride,
+    const cl_double dt,
+    std::vector<cl_double> &virial)
+{
+    const cl_uint n_sites = topology.m_n_sites;
+    cl_double r0[Params::max_sites][3];
+    cl_double r[Params::max_sites][3];
+    for (cl_uint site = 0; site < n_sites; ++site) {
+        for (cl_uint d = 0; d < 3; ++d) {
+            r0[site][d] = position_old[sites[site] + d * stride];
+            r[site][d] = position[sites[site] + d * stride];
+        }
+    }
+
+    bool converged = false;
+    for (cl_ulong iter = 0; iter < Params::constraint_max_iter && !converged; ++iter) {
+        converged = true;
+        for (cl_uint k = 0; k < topology.n_constraints(); ++k) {
+            cl_uint a = topology.m_constraint_site[2*k];
+            cl_uint b = topology.m_constraint_site[2*k + 1];
+            cl_double len_sq = topology.m_constraint_length[k] *
+                topology.m_constraint_length[k];
+
+            cl_double s[3], dr[3];
+            cl_double dr_sq = 0.0;
+            cl_double s_dr = 0.0;
+            for (cl_uint d = 0; d < 3; ++d) {
+                s[d] = r0[b][d] - r0[a][d];
+                dr[d] = r[b][d] - r[a][d];
+                dr_sq += dr[d] * dr[d];
+                s_dr += s[d] * dr[d];
+            }
+            cl_double diff = len_sq - dr_sq;
+            if (std::fabs(diff) <= 2.0 * Params::constraint_tolerance * len_sq) {
+                continue;
+            }
+            converged = false;
+
+            cl_double g = diff / (4.0 * s_dr);
+            for (cl_uint d = 0; d < 3; ++d) {
+                r[a][d] -= g * s[d];
+                r[b][d] += g * s[d];
+            }
+        }
+    }
+    core_assert(converged, "SHAKE did not converge");
+
+    for (cl_uint site = 0; site < n_sites; ++site) {
+        cl_double w = 0.0;
+        for (cl_uint d = 0; d < 3; ++d) {
+            cl_uint ix = sites[site] + d * stride;
+            cl_double dv = (r[site][d] - position[ix]) / dt;
+            w += (r0[site][d] - r0[0][d]) * dv / dt;
+            velocity[ix] += dv;
+            position[ix] = r[site][d];
+        }
+        virial[sites[site]] += w;
+    }
+}
+
+/**
+ * rattle_cluster
+ * @brief Remove the velocity components along the constraints of one
+ * cluster by RATTLE, iterating over the constraints until the relative
+ * velocity of every pair is normal to its bond within the tolerance.
+ */
+static void rattle_cluster(
+    const Topology &topology,
+    const cl_uint *sites,
+    const std::vector<cl_double> &position,
+    std::vector<cl_double> &velocity,
+    const cl_uint stride,
+    const cl_double dt,
+    std::vector<cl_double> &virial)
+{
+    const cl_uint n_sites = topology.m_n_sites;
+    cl_double r[Params::max_sites][3];
+    cl_double v[Params::max_sites][3];
+    for (cl_uint site = 0; site < n_sites; ++site) {
+        for (cl_uint d = 0; d < 3; ++d) {
+            r[site][d] = position[sites[site] + d * stride];
+            v[site][d] = velocity[sites[site] + d * stride];
+        }
+    }
+
+    bool converged = false;
+    for (cl_ulong iter = 0; iter < Params::constraint_max_iter && !converged; ++iter) {
+        converged = true;
+        for (cl_uint k = 0; k < topology.n_constraints(); ++k) {
+            cl_uint a = topology.m_constraint_site[2*k];
+            cl_uint b = topology.m_constraint_site[2*k + 1];
+            cl_double len_sq = topology.m_constraint_length[k] *
+                topology.m_constraint_length[k];
+
+            cl_double dr[3];
+            cl_double dr_dv = 0.0;
+            for (cl_uint d = 0; d < 3; ++d) {
+                dr[d] = r[b][d] - r[a][d];
+                dr_dv += dr[d] * (v[b][d] - v[a][d]);
+            }
+            if (std::fabs(dr_dv) <= Params::constraint_tolerance * len_sq) {
+                continue;
+            }
+            converged = false;
+
+            cl_double g = dr_dv / (2.0 * len_sq);
+            for (cl_uint d = 0; d < 3; ++d) {
+                v[a][d] += g * dr[d];
+                v[b][d] -= g * dr[d];
+            }
+        }
+    }
+    core_assert(converged, "RATTLE did not converge");
+
+    for (cl_uint site = 0; site < n_sites; ++site) {
+        cl_double w = 0.0;
+        for (cl_uint d = 0; d < 3; ++d) {
+            cl_uint ix = sites[site] + d * stride;
+            w += (r[site][d] - r[0][d]) * (v[site][d] - velocity[ix]) / dt;
+            velocity[ix] = v[site][d];
+        }
+        virial[sites[site]] += w;
+    }
+}
+
+/** ---------------------------------------------------------------------------
+ * Constraints::shake
+ * @brief Constrain the positions of every cluster, in parallel over the
+ * SETTLE batches or over the clusters.
+ */
+void Constraints::shake(
+    const Topology &topology,
+    const std::vector<cl_uint> &cluster,
+    const std::vector<cl_double> &position_old,
+    std::vector<cl_double> &position,
+    std::vector<cl_double> &velocity,
+    const cl_uint stride,
+    const cl_double dt,
+    std::vector<cl_double> &virial)
+{
+    const cl_uint n_sites = topology.m_n_sites;
+    const cl_uint n_clusters = (cl_uint) (cluster.size() / n_sites);
+    if (!topology.has_constraints() || n_clusters == 0) {
+        return;
+    }
+
+    if (topology.m_settle) {
+        const cl_uint n_batches = (n_clusters + settle_batch - 1) / settle_batch;
+        core_pragma_omp(parallel for schedule(static))
+        for (cl_uint batch = 0; batch < n_batches; ++batch) {
+            cl_uint first = batch * settle_batch;
+            settle_positions(
+                topology,
+                &cluster[3 * first],
+                std::min(settle_batch, n_clusters - first),
+                position_old,
+                position,
+                velocity,
+                stride,
+                dt,
+                virial);
+        }
+        return;
+    }
+
+    core_pragma_omp(parallel for schedule(static))
+    for (cl_uint k = 0; k < n_clusters; ++k) {
+        shake_cluster(
+            topology,
+            &cluster[k * n_sites],
+            position_old,
+            position,
+            velocity,
+            stride,
+            dt,
+            virial);
+    }
+}
+
+/**
+ * Constraints::rattle
+ * @brief Constrain the velocities of every cluster, in parallel over the
+ * SETTLE batches or over the clusters.
+ */
+void Constraints::rattle(
+    const Topology &topology,
+    const std::vector<cl_uint> &cluster,
+    const std::vector<cl_double> &position,
+    std::vector<cl_double> &velocity,
+    const cl_uint stride,
+    const cl_double dt,
+    std::vector<cl_double> &virial)
+{
+    const cl_uint n_sites = topology.m_n_sites;
+    const cl_uint n_clusters = (cl_uint) (cluster.size() / n_sites);
+    if (!topology.has_constraints() || n_clusters == 0) {
+        return;
+    }
+
+    if (topology.m_settle) {
+        const cl_uint n_batches = (n_clusters + settle_batch - 1) / settle_batch;
+        core_pragma_omp(parallel for schedule(static))
+        for (cl_uint batch = 0; batch < n_batches; ++batch) {
+            cl_uint first = batch * settle_batch;
+            settle_velocities(
+                &cluster[3 * first],
+                std::min(settle_batch, n_clusters - first),
+                position,
+                velocity,
+                stride,
+                dt,
+                virial);
+        }
+        return;
+    }
+
+    core_pragma_omp(parallel for schedule(static))
+    for (cl_uint k = 0; k < n_clusters; ++k) {
+        rattle_cluster(
+            topology,
+            &cluster[k * n_sites],
+            position,
+            velocity,
+            stride,
+            dt,
+            virial);
+    }
+}
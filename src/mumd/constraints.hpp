@@ -0,0 +1,75 @@
+/*
+ * constraints.hpp
+ *
+ * Copyright (c) 2020 Carlos Braga
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the MIT License.
+ *
+ * See accompanying LICENSE.md or https://opensource.org/licenses/MIT.
+ */
+
+#ifndef CONSTRAINTS_H_
+#define CONSTRAINTS_H_
+
+#include <vector>
+#include "base.hpp"
+#include "topology.hpp"
+
+namespace Constraints {
+/**
+ * Host constraint solvers. The constrained molecules are independent
+ * clusters, given by the local indices of their sites, n_sites consecutive
+ * indices per cluster. Rigid 3-site molecules are solved by SETTLE in
+ * batches of settle_batch clusters, with the cluster sites gathered in
+ * structure of arrays layout so each batch is vectorized across clusters.
+ * The SETTLE solvers are multiversioned with ATTO_DISPATCH, and a batch
+ * fills two AVX2 registers or one AVX-512 register per component. Other
+ * molecules are solved by SHAKE and RATTLE, one cluster per thread. The
+ * device kernels solve one cluster per work-item.
+ */
+static const cl_uint settle_batch = 8;
+
+/**
+ * Virial of the constraint forces. The velocity corrections dv of the
+ * position and velocity stages are the half step kicks of the constraint
+ * forces f = 2 dv / dt at the old and new positions. Each stage adds half
+ * its virial, r_i0 . dv / dt, to the virial of each site, so the sum of
+ * both stages is the mean of the constraint virials over the step.
+ */
+
+/**
+ * shake
+ * @brief Constrain the positions after an unconstrained update from the old
+ * positions, correct the velocities by the constraint displacements, and
+ * add the virial of the constraint forces at the old positions to the
+ * virial of each site. The model constrains the initial positions with the
+ * positions as their own reference.
+ */
+void shake(
+    const Topology &topology,
+    const std::vector<cl_uint> &cluster,
+    const std::vector<cl_double> &position_old,
+    std::vector<cl_double> &position,
+    std::vector<cl_double> &velocity,
+    const cl_uint stride,
+    const cl_double dt,
+    std::vector<cl_double> &virial);
+
+/**
+ * rattle
+ * @brief Remove the velocity components along the constraints, and add the
+ * virial of the constraint forces at the new positions to the virial of
+ * each site.
+ */
+void rattle(
+    const Topology &topology,
+    const std::vector<cl_uint> &cluster,
+    const std::vector<cl_double> &position,
+    std::vector<cl_double> &velocity,
+    const cl_uint stride,
+    const cl_double dt,
+    std::vector<cl_double> &virial);
+} /* Constraints */
+
+#endif /* CONSTRAINTS_H_ */
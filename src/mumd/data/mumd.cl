@@ -0,0 +1,1575 @@
+#ifdef cl_khr_fp64
+#pragma OPENCL EXTENSION cl_khr_fp64 : enable
+#endif
+#ifdef cl_khr_int64_base_atomics
+#pragma OPENCL EXTENSION cl_khr_int64_base_atomics : enable
+#endif
+
+/**
+ * Precision policy of the pair forces, selected by the build options. With
+ * PRECISION_MIXED the pair forces are evaluated in single precision, from
+ * the separation of each pair formed in double precision from the double
+ * positions, so the pair geometry keeps its relative accuracy anywhere in
+ * the box. The forces, energies and virials are accumulated in double
+ * precision, and the integration stays in double precision. Otherwise the
+ * pair forces are evaluated in double precision as well.
+ */
+#ifdef PRECISION_MIXED
+typedef float real;
+typedef float2 real2;
+typedef float3 real3;
+#define convert_real2 convert_float2
+#define convert_real3 convert_float3
+#else
+typedef double real;
+typedef double2 real2;
+typedef double3 real3;
+#define convert_real2 convert_double2
+#define convert_real3 convert_double3
+#endif
+
+/**
+ * Particle arrays are stored in structure of arrays layout. Each vector array
+ * holds the x, y and z components in consecutive blocks of size stride.
+ */
+double3 load3(__global const double *a, const uint i, const uint stride);
+void store3(__global double *a, const uint i, const uint stride, double3 v);
+int is_boundary(double3 r, const double4 lo, const double4 hi, double r_halo);
+int4 cell_coord(
+    double3 r,
+    const double4 cell_lo,
+    const double4 cell_width,
+    const int4 n_cells);
+uint cell_index(int4 c, const int4 n_cells);
+uint morton_spread(uint v);
+uint index_slot(const ulong key, const uint mask);
+uint index_lookup(
+    __global const uint *table,
+    const uint mask,
+    __global const ulong *id,
+    const ulong key);
+uint4 philox4x32_10(uint4 ctr, uint2 key);
+double4 noise_uniform(const ulong seed, const ulong id, const ulong step);
+double3 noise_gaussian(const ulong seed, const ulong id, const ulong step);
+real erfc_approx(const real x, real *exp_x_sq);
+real pair_table_lookup(
+    read_only image1d_t pair_table,
+    sampler_t pair_sampler,
+    const double4 pair_grid,
+    const real r_sq,
+    real *u);
+double3 pair_force(
+    double3 r_ij,
+    const real q_ij,
+    const real r_cut_sq,
+    const real alpha,
+    const int excluded,
+    read_only image1d_t pair_table,
+    sampler_t pair_sampler,
+    const double4 pair_grid,
+    double *e,
+    double *w);
+double det3(double3 c0, double3 c1, double3 c2);
+uint rdf_species(const double q, const double4 species, const uint n_species);
+uint rdf_pair(uint a, uint b, const uint n_species);
+void halo_append(
+    double4 pos,
+    const uint dim,
+    const double lo,
+    const double hi,
+    const double r_halo,
+    const double shift_lo,
+    const double shift_hi,
+    __global double *send,
+    __global uint *count,
+    const uint max_halo);
+
+/**
+ * Migration messages hold one record per particle with the position, the
+ * velocity, the charge, the particle id stored as the bit pattern of a
+ * double and the constraint virial of the position stage.
+ */
+#define MIGRATE_RECORD_SIZE 9
+
+/**
+ * Observable reductions store one record of partial sums per work-group.
+ */
+#define OBSERVABLES_SIZE 5
+
+/**
+ * Constraint kernels hold the sites of a molecule in private memory, up to
+ * Params::max_sites sites per molecule.
+ */
+#define MAX_SITES 8
+
+/** ---------------------------------------------------------------------------
+ * load3
+ * @brief Load the vector components of particle i.
+ */
+double3 load3(__global const double *a, const uint i, const uint stride)
+{
+    return (double3) (a[i], a[i + stride], a[i + 2*stride]);
+}
+
+/**
+ * store3
+ * @brief Store the vector components of particle i.
+ */
+void store3(__global double *a, const uint i, const uint stride, double3 v)
+{
+    a[i] = v.x;
+    a[i + stride] = v.y;
+    a[i + 2*stride] = v.z;
+}
+
+/**
+ * is_boundary
+ * @brief Is the position within a halo width of the subdomain faces?
+ */
+int is_boundary(double3 r, const double4 lo, const double4 hi, double r_halo)
+{
+    return (r.x < lo.x + r_halo || r.x >= hi.x - r_halo ||
+            r.y < lo.y + r_halo || r.y >= hi.y - r_halo ||
+            r.z < lo.z + r_halo || r.z >= hi.z - r_halo);
+}
+
+/**
+ * cell_coord
+ * @brief Return the coordinates of the cell containing the position. The cell
+ * grid spans the subdomain plus one layer of ghost cells on each side.
+ */
+int4 cell_coord(
+    double3 r,
+    const double4 cell_lo,
+    const double4 cell_width,
+    const int4 n_cells)
+{
+    int4 c = (int4) (
+        (int) floor((r.x - cell_lo.x) / cell_width.x),
+        (int) floor((r.y - cell_lo.y) / cell_width.y),
+        (int) floor((r.z - cell_lo.z) / cell_width.z),
+        0);
+    return clamp(c, (int4) (0), n_cells - (int4) (1, 1, 1, 0));
+}
+
+/**
+ * cell_index
+ * @brief Return the linear index of the cell with the specified coordinates.
+ */
+uint cell_index(int4 c, const int4 n_cells)
+{
+    return c.x + n_cells.x * (c.y + n_cells.y * c.z);
+}
+
+/** ---------------------------------------------------------------------------
+ * integrate_position
+ * @brief First half of the velocity Verlet step. Scale the velocities by the
+ * thermostat factor and the positions about the box origin by the barostat
+ * factor, then update the velocities by half a time step and the positions
+ * by a full time step. Particles leaving the subdomain are wrapped in the
+ * periodic box when they migrate. At the start of an outer r-RESPA step the
+ * slow forces are added with weight slow_scale, the number of inner steps.
+ */
+__kernel void integrate_position(
+    __global double *pos,
+    __global double *vel,
+    __global const double *force,
+    __global const double *force_slow,
+    const uint stride,
+    const uint n_local,
+    const double dt,
+    const double slow_scale,
+    const double velocity_scale,
+    const double position_scale,
+    const double4 origin)
+{
+    const uint i = get_global_id(0);
+    if (i >= n_local) {
+        return;
+    }
+
+    double3 f = load3(force, i, stride);
+    if (slow_scale != 0.0) {
+        f += slow_scale * load3(force_slow, i, stride);
+    }
+
+    double3 v = velocity_scale * load3(vel, i, stride) + 0.5 * dt * f;
+    double3 r = origin.xyz +
+        position_scale * (load3(pos, i, stride) - origin.xyz) + dt * v;
+    store3(vel, i, stride, v);
+    store3(pos, i, stride, r);
+}
+
+/**
+ * integrate_velocity
+ * @brief Second half of the velocity Verlet step. Update the velocities by
+ * half a time step using the new forces. At the end of an outer r-RESPA step
+ * the new slow forces are added with weight slow_scale.
+ */
+__kernel void integrate_velocity(
+    __global double *vel,
+    __global const double *force,
+    __global const double *force_slow,
+    const uint stride,
+    const uint n_local,
+    const double dt,
+    const double slow_scale)
+{
+    const uint i = get_global_id(0);
+    if (i >= n_local) {
+        return;
+    }
+
+    double3 f = load3(force, i, stride);
+    if (slow_scale != 0.0) {
+        f += slow_scale * load3(force_slow, i, stride);
+    }
+
+    double3 v = load3(vel, i, stride) + 0.5 * dt * f;
+    store3(vel, i, stride, v);
+}
+
+/**
+ * forces_accumulate
+ * @brief Add the bonded forces, computed on the host, to the short range
+ * forces.
+ */
+__kernel void forces_accumulate(
+    __global double *force,
+    __global const double *force_bonded,
+    const uint stride,
+    const uint n_local)
+{
+    const uint i = get_global_id(0);
+    if (i >= n_local) {
+        return;
+    }
+
+    double3 f = load3(force, i, stride) + load3(force_bonded, i, stride);
+    store3(force, i, stride, f);
+}
+
+/**
+ * philox4x32_10
+ * @brief Counter-based random number generator Philox4x32-10. Return the
+ * block of four 32-bit random numbers of a 128-bit counter and a 64-bit key.
+ * It is bit-identical to math::rng::Philox::block on the host.
+ */
+uint4 philox4x32_10(uint4 ctr, uint2 key)
+{
+    for (uint r = 0; r < 10; ++r) {
+        uint hi0 = mul_hi(0xD2511F53U, ctr.x);
+        uint lo0 = 0xD2511F53U * ctr.x;
+        uint hi1 = mul_hi(0xCD9E8D57U, ctr.z);
+        uint lo1 = 0xCD9E8D57U * ctr.z;
+        ctr = (uint4) (hi1 ^ ctr.y ^ key.x, lo1, hi0 ^ ctr.w ^ key.y, lo0);
+        key += (uint2) (0x9E3779B9U, 0xBB67AE85U);
+    }
+    return ctr;
+}
+
+/**
+ * noise_uniform
+ * @brief Return four uniform numbers in (0,1] for a particle at a given
+ * step. The numbers are a pure function of the seed, the particle id and
+ * the step, so they do not depend on the particle order or its process.
+ * The two Philox blocks of the stream
+ *  key = {seed_lo, seed_hi}, ctr = {n, step_lo, id_lo, id_hi}
+ * give four 64-bit numbers, as math::rng::Philox(seed, id, step).rand64(),
+ * and each keeps its upper 53 bits.
+ */
+double4 noise_uniform(const ulong seed, const ulong id, const ulong step)
+{
+    const uint2 key = (uint2) ((uint) seed, (uint) (seed >> 32));
+    double u[4];
+    for (uint n = 0; n < 2; ++n) {
+        uint4 x = philox4x32_10(
+            (uint4) (n, (uint) step, (uint) id, (uint) (id >> 32)), key);
+        ulong x0 = upsample(x.y, x.x);
+        ulong x1 = upsample(x.w, x.z);
+        u[2*n] = ((double) (x0 >> 11) + 1.0) * 0x1.0p-53;
+        u[2*n + 1] = ((double) (x1 >> 11) + 1.0) * 0x1.0p-53;
+    }
+    return (double4) (u[0], u[1], u[2], u[3]);
+}
+
+/**
+ * noise_gaussian
+ * @brief Return three standard Gaussian numbers for a particle at a given
+ * step, from the Box-Muller transform of its four uniform numbers.
+ */
+double3 noise_gaussian(const ulong seed, const ulong id, const ulong step)
+{
+    double4 u = noise_uniform(seed, id, step);
+    double r0 = sqrt(-2.0 * log(u.x));
+    double r1 = sqrt(-2.0 * log(u.z));
+    return (double3) (
+        r0 * cos(2.0 * M_PI * u.y),
+        r0 * sin(2.0 * M_PI * u.y),
+        r1 * cos(2.0 * M_PI * u.w));
+}
+
+/**
+ * reduce_observables
+ * @brief Reduce the thermodynamic sums of the local particles in each
+ * work-group, and store one record of partial sums per work-group:
+ *  0   kinetic energy
+ *  1   potential energy
+ *  2   virial, sum of r_ij . f_ij
+ *  3   sum of the Gaussian noise numbers
+ *  4   sum of the squares of the Gaussian noise numbers
+ * The noise mask packs the number of unconstrained degrees of freedom of
+ * each molecule site in two bits, and only as many Gaussian numbers are
+ * drawn for the site. The noise sums are not computed when the mask is
+ * zero. The work-group size must be a power of two.
+ */
+__kernel void reduce_observables(
+    __global const double *vel,
+    __global const double *energy,
+    __global const double *virial,
+    __global const ulong *id,
+    const uint stride,
+    const uint n_local,
+    const uint n_sites,
+    const uint noise,
+    const ulong seed,
+    const ulong step,
+    __local double *scratch,
+    __global double *partial)
+{
+    const uint i = get_global_id(0);
+    const uint lid = get_local_id(0);
+    const uint n = get_local_size(0);
+
+    double sum[OBSERVABLES_SIZE] = {0.0, 0.0, 0.0, 0.0, 0.0};
+    if (i < n_local) {
+        double3 v = load3(vel, i, stride);
+        sum[0] = 0.5 * dot(v, v);
+        sum[1] = energy[i];
+        sum[2] = virial[i];
+        if (noise) {
+            uint n_dof = (noise >> (2 * (id[i] % n_sites))) & 3;
+            double3 xi = noise_gaussian(seed, id[i], step);
+            xi *= (double3) (n_dof > 0, n_dof > 1, n_dof > 2);
+            sum[3] = xi.x + xi.y + xi.z;
+            sum[4] = dot(xi, xi);
+        }
+    }
+    for (uint k = 0; k < OBSERVABLES_SIZE; ++k) {
+        scratch[lid + k*n] = sum[k];
+    }
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+    for (uint s = n >> 1; s > 0; s >>= 1) {
+        if (lid < s) {
+            for (uint k = 0; k < OBSERVABLES_SIZE; ++k) {
+                scratch[lid + k*n] += scratch[lid + k*n + s];
+            }
+        }
+        barrier(CLK_LOCAL_MEM_FENCE);
+    }
+
+    if (lid == 0) {
+        for (uint k = 0; k < OBSERVABLES_SIZE; ++k) {
+            partial[OBSERVABLES_SIZE*get_group_id(0) + k] = scratch[k*n];
+        }
+    }
+}
+
+/** ---------------------------------------------------------------------------
+ * erfc_approx
+ * @brief Rational approximation of the complementary error function for
+ * x >= 0, Abramowitz and Stegun 7.1.26, with absolute error below 1.5e-7.
+ * The Gaussian factor exp(-x^2) is returned as well, since the real space
+ * Ewald force needs it. The error is below single precision rounding, so
+ * the approximation loses nothing in the mixed precision policy.
+ */
+real erfc_approx(const real x, real *exp_x_sq)
+{
+    const real t = (real) 1.0 / ((real) 1.0 + (real) 0.3275911 * x);
+    *exp_x_sq = exp(-x * x);
+    return t * ((real) 0.254829592 +
+           t * ((real) -0.284496736 +
+           t * ((real) 1.421413741 +
+           t * ((real) -1.453152027 +
+           t * (real) 1.061405429)))) * (*exp_x_sq);
+}
+
+/**
+ * pair_table_lookup
+ * @brief Interpolate the tabulated pair potential at the squared distance
+ * r_sq, see table.hpp. The grid holds the first knot, the inverse segment
+ * width and the number of segments. Each segment is two RGBA texels of
+ * 32-bit integers holding the bits of its four double coefficients, which
+ * are rounded to the pair force precision. Return the scaled force F / r
+ * and store the energy in u.
+ */
+real pair_table_lookup(
+    read_only image1d_t pair_table,
+    sampler_t pair_sampler,
+    const double4 pair_grid,
+    const real r_sq,
+    real *u)
+{
+    const real inv_h = (real) pair_grid.y;
+    real x = (r_sq - (real) pair_grid.x) * inv_h;
+    int k = clamp((int) floor(x), 0, (int) pair_grid.z - 1);
+    real t = x - (real) k;
+    real2 c01 = convert_real2(
+        as_double2(read_imageui(pair_table, pair_sampler, 2*k)));
+    real2 c23 = convert_real2(
+        as_double2(read_imageui(pair_table, pair_sampler, 2*k + 1)));
+    *u = c01.x + t * (c01.y + t * (c23.x + t * c23.y));
+    return (real) -2.0 * inv_h *
+        (c01.y + t * ((real) 2.0 * c23.x + t * (real) 3.0 * c23.y));
+}
+
+/**
+ * pair_force
+ * @brief Return the force on a particle separated by r_ij from its neighbour,
+ * the sum of the Lennard-Jones force and the real space Ewald force of the
+ * charge product q_ij, and accumulate half the pair potential energy and
+ * half the pair virial r_ij . f_ij. With PAIR_TABULATED defined by the
+ * build options, the Lennard-Jones term is read from the pair table. The
+ * pair terms are evaluated in the precision of the policy, and the energy
+ * and the virial are accumulated in double precision.
+ *
+ * Excluded pairs, sites of the same molecule, have no Lennard-Jones term,
+ * and their Coulomb term is replaced by q_ij (erfc(alpha r) - 1) / r, which
+ * removes their interaction from the reciprocal space sum.
+ */
+double3 pair_force(
+    double3 r_ij,
+    const real q_ij,
+    const real r_cut_sq,
+    const real alpha,
+    const int excluded,
+    read_only image1d_t pair_table,
+    sampler_t pair_sampler,
+    const double4 pair_grid,
+    double *e,
+    double *w)
+{
+    real3 d = convert_real3(r_ij);
+    real r_sq = dot(d, d);
+    if (r_sq >= r_cut_sq || r_sq == (real) 0.0) {
+        return (double3) (0.0, 0.0, 0.0);
+    }
+    real sr2 = (real) 1.0 / r_sq;
+    real f = (real) 0.0;
+    if (!excluded) {
+#ifdef PAIR_TABULATED
+        real u;
+        f = pair_table_lookup(pair_table, pair_sampler, pair_grid, r_sq, &u);
+        *e += 0.5 * (double) u;
+#else
+        real sr6 = sr2 * sr2 * sr2;
+        f = (real) 24.0 * sr2 * sr6 * ((real) 2.0 * sr6 - (real) 1.0);
+        *e += (double) ((real) 2.0 * sr6 * (sr6 - (real) 1.0));
+#endif
+    }
+
+    if (q_ij != (real) 0.0) {
+        real r = sqrt(r_sq);
+        real exp_x_sq;
+        real erfc_x = erfc_approx(alpha * r, &exp_x_sq);
+        real coulomb = q_ij * (erfc_x - (real) excluded) / r;
+        f += (coulomb + q_ij * (real) M_2_SQRTPI * alpha * exp_x_sq) * sr2;
+        *e += 0.5 * (double) coulomb;
+    }
+    *w += 0.5 * (double) (f * r_sq);
+    return (double) f * r_ij;
+}
+
+/**
+ * forces_interior
+ * @brief Compute the forces on interior particles. Interior particles are
+ * more than a halo width away from the subdomain faces, so they only interact
+ * with local particles and do not depend on the halo exchange, even when the
+ * particles have drifted across the faces since the last migration.
+ * The neighbours are found in the local cell bins of the 27 adjacent cells.
+ * The sites of a molecule are always local to the same process, so only
+ * local neighbours are checked for exclusion.
+ */
+__kernel void forces_interior(
+    __global const double *pos,
+    __global const double *charge,
+    __global const ulong *id,
+    const uint n_sites,
+    __global double *force,
+    __global double *energy,
+    __global double *virial,
+    const uint stride,
+    const uint n_local,
+    const double4 lo,
+    const double4 hi,
+    const double r_cut,
+    const double r_halo,
+    const double alpha,
+    __global const uint *cell_count,
+    __global const uint *cell_list,
+    const uint max_cell,
+    const double4 cell_lo,
+    const double4 cell_width,
+    const int4 n_cells,
+    read_only image1d_t pair_table,
+    sampler_t pair_sampler,
+    const double4 pair_grid)
+{
+    const uint i = get_global_id(0);
+    if (i >= n_local) {
+        return;
+    }
+
+    double3 r_i = load3(pos, i, stride);
+    if (is_boundary(r_i, lo, hi, r_halo)) {
+        return;
+    }
+
+    const double q_i = charge[i];
+    const ulong molecule_i = id[i] / n_sites;
+    const real r_cut_sq = (real) (r_cut * r_cut);
+    const real alpha_r = (real) alpha;
+    const int4 c_i = cell_coord(r_i, cell_lo, cell_width, n_cells);
+    double3 f = (double3) (0.0, 0.0, 0.0);
+    double e = 0.0;
+    double w = 0.0;
+    for (int dz = -1; dz <= 1; ++dz) {
+        for (int dy = -1; dy <= 1; ++dy) {
+            for (int dx = -1; dx <= 1; ++dx) {
+                int4 c = c_i + (int4) (dx, dy, dz, 0);
+                if (any(c.xyz < (int3) (0)) || any(c.xyz >= n_cells.xyz)) {
+                    continue;
+                }
+                uint cell = cell_index(c, n_cells);
+                uint n = min(cell_count[cell], max_cell);
+                for (uint k = 0; k < n; ++k) {
+                    uint j = cell_list[cell * max_cell + k];
+                    f += pair_force(r_i - load3(pos, j, stride),
+                        (real) (q_i * charge[j]), r_cut_sq, alpha_r,
+                        id[j] / n_sites == molecule_i,
+                        pair_table, pair_sampler, pair_grid, &e, &w);
+                }
+            }
+        }
+    }
+    store3(force, i, stride, f);
+    energy[i] = e;
+    virial[i] = w;
+}
+
+/**
+ * forces_boundary
+ * @brief Compute the forces on boundary particles. Boundary particles are
+ * within a halo width of the subdomain faces and interact with both
+ * local and ghost particles, found in the local and ghost cell bins.
+ */
+__kernel void forces_boundary(
+    __global const double *pos,
+    __global const double *charge,
+    __global const ulong *id,
+    const uint n_sites,
+    __global const double *ghost,
+    __global double *force,
+    __global double *energy,
+    __global double *virial,
+    const uint stride,
+    const uint n_local,
+    const double4 lo,
+    const double4 hi,
+    const double r_cut,
+    const double r_halo,
+    const double alpha,
+    __global const uint *cell_count,
+    __global const uint *cell_list,
+    __global const uint *ghost_cell_count,
+    __global const uint *ghost_cell_list,
+    const uint max_cell,
+    const double4 cell_lo,
+    const double4 cell_width,
+    const int4 n_cells,
+    read_only image1d_t pair_table,
+    sampler_t pair_sampler,
+    const double4 pair_grid)
+{
+    const uint i = get_global_id(0);
+    if (i >= n_local) {
+        return;
+    }
+
+    double3 r_i = load3(pos, i, stride);
+    if (!is_boundary(r_i, lo, hi, r_halo)) {
+        return;
+    }
+
+    const double q_i = charge[i];
+    const ulong molecule_i = id[i] / n_sites;
+    const real r_cut_sq = (real) (r_cut * r_cut);
+    const real alpha_r = (real) alpha;
+    const int4 c_i = cell_coord(r_i, cell_lo, cell_width, n_cells);
+    double3 f = (double3) (0.0, 0.0, 0.0);
+    double e = 0.0;
+    double w = 0.0;
+    for (int dz = -1; dz <= 1; ++dz) {
+        for (int dy = -1; dy <= 1; ++dy) {
+            for (int dx = -1; dx <= 1; ++dx) {
+                int4 c = c_i + (int4) (dx, dy, dz, 0);
+                if (any(c.xyz < (int3) (0)) || any(c.xyz >= n_cells.xyz)) {
+                    continue;
+                }
+                uint cell = cell_index(c, n_cells);
+                uint n = min(cell_count[cell], max_cell);
+                for (uint k = 0; k < n; ++k) {
+                    uint j = cell_list[cell * max_cell + k];
+                    f += pair_force(r_i - load3(pos, j, stride),
+                        (real) (q_i * charge[j]), r_cut_sq, alpha_r,
+                        id[j] / n_sites == molecule_i,
+                        pair_table, pair_sampler, pair_grid, &e, &w);
+                }
+                n = min(ghost_cell_count[cell], max_cell);
+                for (uint k = 0; k < n; ++k) {
+                    uint j = ghost_cell_list[cell * max_cell + k];
+                    double4 g = vload4(j, ghost);
+                    f += pair_force(r_i - g.xyz,
+                        (real) (q_i * g.w), r_cut_sq, alpha_r, 0,
+                        pair_table, pair_sampler, pair_grid, &e, &w);
+                }
+            }
+        }
+    }
+    store3(force, i, stride, f);
+    energy[i] = e;
+    virial[i] = w;
+}
+
+/** ---------------------------------------------------------------------------
+ * cell_bin_local
+ * @brief Bin the local particles in the cell grid. Each cell holds up to
+ * max_cell particle indices. Overflowing particles are counted, so the
+ * host can detect an undersized cell capacity.
+ */
+__kernel void cell_bin_local(
+    __global const double *pos,
+    const uint stride,
+    const uint n_local,
+    __global uint *cell_count,
+    __global uint *cell_list,
+    const uint max_cell,
+    const double4 cell_lo,
+    const double4 cell_width,
+    const int4 n_cells,
+    __global uint *overflow)
+{
+    const uint i = get_global_id(0);
+    if (i >= n_local) {
+        return;
+    }
+
+    int4 c = cell_coord(load3(pos, i, stride), cell_lo, cell_width, n_cells);
+    uint cell = cell_index(c, n_cells);
+    uint k = atomic_inc(&cell_count[cell]);
+    if (k < max_cell) {
+        cell_list[cell * max_cell + k] = i;
+    } else {
+        atomic_inc(overflow);
+    }
+}
+
+/**
+ * cell_bin_ghost
+ * @brief Bin the ghost particles in the cell grid. Ghosts lie outside the
+ * subdomain and land in the ghost cell layer.
+ */
+__kernel void cell_bin_ghost(
+    __global const double *ghost,
+    const uint n_ghost,
+    __global uint *cell_count,
+    __global uint *cell_list,
+    const uint max_cell,
+    const double4 cell_lo,
+    const double4 cell_width,
+    const int4 n_cells,
+    __global uint *overflow)
+{
+    const uint i = get_global_id(0);
+    if (i >= n_ghost) {
+        return;
+    }
+
+    int4 c = cell_coord(vload4(i, ghost).xyz, cell_lo, cell_width, n_cells);
+    uint cell = cell_index(c, n_cells);
+    uint k = atomic_inc(&cell_count[cell]);
+    if (k < max_cell) {
+        cell_list[cell * max_cell + k] = i;
+    } else {
+        atomic_inc(overflow);
+    }
+}
+
+/** ---------------------------------------------------------------------------
+ * rdf_species
+ * @brief Return the species of a particle, the index of its charge in the
+ * species table, or zero if the charge is not in the table.
+ */
+uint rdf_species(const double q, const double4 species, const uint n_species)
+{
+    return (n_species > 1 && q == species.y) ? 1 :
+           (n_species > 2 && q == species.z) ? 2 :
+           (n_species > 3 && q == species.w) ? 3 : 0;
+}
+
+/**
+ * rdf_pair
+ * @brief Return the index of the unordered pair of species (a,b), in the
+ * order (0,0), (0,1), ..., (1,1), (1,2), ...
+ */
+uint rdf_pair(uint a, uint b, const uint n_species)
+{
+    uint lo = min(a, b);
+    uint hi = max(a, b);
+    return lo * n_species - lo * (lo - 1) / 2 + (hi - lo);
+}
+
+/**
+ * rdf_accumulate
+ * @brief Accumulate the histogram of the pair distances up to r_max, one
+ * block of n_bins bins per pair of species. Each local particle counts its
+ * local and ghost neighbours, so every ordered pair is counted once over
+ * all processes, and the sites of its own molecule are skipped.
+ *
+ * The neighbours are found in the cell bins of the force computation, in
+ * the cells within reach of the particle cell, with reach = 1 when r_max
+ * is within the cell width. Every ghost within a halo width of the
+ * subdomain is binned in the ghost cell layer, so r_max must be within the
+ * halo width. The counts are accumulated in work-group local bins and
+ * added to the global histogram with one 64-bit atomic per non-empty bin.
+ */
+__kernel void rdf_accumulate(
+    __global const double *pos,
+    __global const double *charge,
+    __global const ulong *id,
+    const uint n_sites,
+    __global const double *ghost,
+    const uint stride,
+    const uint n_local,
+    const double r_max,
+    const uint n_bins,
+    const uint n_species,
+    const double4 species,
+    const int reach,
+    __global const uint *cell_count,
+    __global const uint *cell_list,
+    __global const uint *ghost_cell_count,
+    __global const uint *ghost_cell_list,
+    const uint max_cell,
+    const double4 cell_lo,
+    const double4 cell_width,
+    const int4 n_cells,
+    __local uint *bins,
+    __global ulong *histogram)
+{
+    const uint i = get_global_id(0);
+    const uint lid = get_local_id(0);
+    const uint n = get_local_size(0);
+    const uint n_total = n_bins * (n_species * (n_species + 1) / 2);
+
+    for (uint k = lid; k < n_total; k += n) {
+        bins[k] = 0;
+    }
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+    if (i < n_local) {
+        const double3 r_i = load3(pos, i, stride);
+        const ulong molecule_i = id[i] / n_sites;
+        const uint s_i = rdf_species(charge[i], species, n_species);
+        const double r_max_sq = r_max * r_max;
+        const double bin_scale = (double) n_bins / r_max;
+        const int4 c_i = cell_coord(r_i, cell_lo, cell_width, n_cells);
+        for (int dz = -reach; dz <= reach; ++dz) {
+            for (int dy = -reach; dy <= reach; ++dy) {
+                for (int dx = -reach; dx <= reach; ++dx) {
+                    int4 c = c_i + (int4) (dx, dy, dz, 0);
+                    if (any(c.xyz < (int3) (0)) || any(c.xyz >= n_cells.xyz)) {
+                        continue;
+                    }
+                    uint cell = cell_index(c, n_cells);
+                    uint m = min(cell_count[cell], max_cell);
+                    for (uint k = 0; k < m; ++k) {
+                        uint j = cell_list[cell * max_cell + k];
+                        double3 r_ij = r_i - load3(pos, j, stride);
+                        double r_sq = dot(r_ij, r_ij);
+                        if (r_sq < r_max_sq && id[j] / n_sites != molecule_i) {
+                            uint bin = min((uint) (sqrt(r_sq) * bin_scale),
+                                n_bins - 1);
+                            uint s_j = rdf_species(charge[j], species, n_species);
+                            atomic_inc(&bins[
+                                rdf_pair(s_i, s_j, n_species) * n_bins + bin]);
+                        }
+                    }
+                    m = min(ghost_cell_count[cell], max_cell);
+                    for (uint k = 0; k < m; ++k) {
+                        uint j = ghost_cell_list[cell * max_cell + k];
+                        double4 g = vload4(j, ghost);
+                        double3 r_ij = r_i - g.xyz;
+                        double r_sq = dot(r_ij, r_ij);
+                        if (r_sq < r_max_sq) {
+                            uint bin = min((uint) (sqrt(r_sq) * bin_scale),
+                                n_bins - 1);
+                            uint s_j = rdf_species(g.w, species, n_species);
+                            atomic_inc(&bins[
+                                rdf_pair(s_i, s_j, n_species) * n_bins + bin]);
+                        }
+                    }
+                }
+            }
+        }
+    }
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+    for (uint k = lid; k < n_total; k += n) {
+        if (bins[k] > 0) {
+            atom_add(&histogram[k], (ulong) bins[k]);
+        }
+    }
+}
+
+/** ---------------------------------------------------------------------------
+ * halo_append
+ * @brief Append a ghost record to the lo and/or hi messages if it lies within
+ * a halo width of the corresponding face along dimension dim. The halo width
+ * is the cutoff radius plus a skin, which covers the particles that crossed
+ * the faces since the last migration. Each
+ * message holds one (x,y,z,q) record per particle, with the position shifted
+ * by the periodic image offset of its side. Message slots are reserved with
+ * an atomic counter per side.
+ */
+void halo_append(
+    double4 pos,
+    const uint dim,
+    const double lo,
+    const double hi,
+    const double r_halo,
+    const double shift_lo,
+    const double shift_hi,
+    __global double *send,
+    __global uint *count,
+    const uint max_halo)
+{
+    double r[4] = {pos.x, pos.y, pos.z, pos.w};
+    if (r[dim] < lo + r_halo) {
+        uint k = atomic_inc(&count[0]);
+        if (k < max_halo) {
+            __global double *msg = send + 4*k;
+            msg[0] = r[0];
+            msg[1] = r[1];
+            msg[2] = r[2];
+            msg[3] = r[3];
+            msg[dim] += shift_lo;
+        }
+    }
+    if (r[dim] >= hi - r_halo) {
+        uint k = atomic_inc(&count[1]);
+        if (k < max_halo) {
+            __global double *msg = send + 4*(max_halo + k);
+            msg[0] = r[0];
+            msg[1] = r[1];
+            msg[2] = r[2];
+            msg[3] = r[3];
+            msg[dim] += shift_hi;
+        }
+    }
+}
+
+/**
+ * halo_pack_local
+ * @brief Pack the local particles near the lo and hi faces along dimension dim
+ * into the contiguous send buffer. The lo message starts at the beginning of
+ * the buffer and the hi message at offset 4*max_halo.
+ */
+__kernel void halo_pack_local(
+    __global const double *pos,
+    __global const double *charge,
+    const uint stride,
+    const uint n_local,
+    const uint dim,
+    const double lo,
+    const double hi,
+    const double r_halo,
+    const double shift_lo,
+    const double shift_hi,
+    __global double *send,
+    __global uint *count,
+    const uint max_halo)
+{
+    const uint i = get_global_id(0);
+    if (i < n_local) {
+        double4 r = (double4) (load3(pos, i, stride), charge[i]);
+        halo_append(r, dim, lo, hi, r_halo,
+            shift_lo, shift_hi, send, count, max_halo);
+    }
+}
+
+/**
+ * halo_pack_ghost
+ * @brief Pack the ghost particles received along the previous dimensions,
+ * so that edge and corner neighbours are reached in three exchange stages.
+ */
+__kernel void halo_pack_ghost(
+    __global const double *ghost,
+    const uint n_ghost,
+    const uint dim,
+    const double lo,
+    const double hi,
+    const double r_halo,
+    const double shift_lo,
+    const double shift_hi,
+    __global double *send,
+    __global uint *count,
+    const uint max_halo)
+{
+    const uint i = get_global_id(0);
+    if (i < n_ghost) {
+        halo_append(vload4(i, ghost), dim, lo, hi, r_halo,
+            shift_lo, shift_hi, send, count, max_halo);
+    }
+}
+
+/** ---------------------------------------------------------------------------
+ * migrate_flag
+ * @brief Flag the local particles that left the subdomain across the lo or hi
+ * face along dimension dim, and pack all their fields into one contiguous
+ * message per side. The lo message starts at the beginning of the buffer and
+ * the hi message at record max_migrate. Particles further than drift from
+ * the subdomain are counted, since the halo no longer covers them.
+ *
+ * Molecules migrate whole. Every site follows the first site of its
+ * molecule, found through the local index map of the particle ids.
+ */
+__kernel void migrate_flag(
+    __global const double *pos,
+    __global const double *vel,
+    __global const double *charge,
+    __global const ulong *id,
+    __global const double *constraint_virial,
+    __global const uint *local_index,
+    const uint index_mask,
+    const uint n_sites,
+    const uint stride,
+    const uint n_local,
+    const uint dim,
+    const double lo,
+    const double hi,
+    const double shift_lo,
+    const double shift_hi,
+    const double drift,
+    __global uint *flag,
+    __global double *send,
+    __global uint *count,
+    const uint max_migrate)
+{
+    const uint i = get_global_id(0);
+    if (i >= n_local) {
+        return;
+    }
+
+    const uint head = (n_sites == 1) ? i : index_lookup(
+        local_index, index_mask, id, id[i] - id[i] % n_sites);
+    const double x = pos[head + dim*stride];
+    const uint side = (x < lo) ? 0 : (x >= hi ? 1 : 2);
+    flag[i] = (side < 2);
+    if (side == 2) {
+        return;
+    }
+    if (x < lo - drift || x >= hi + drift) {
+        atomic_inc(&count[4]);
+    }
+
+    uint k = atomic_inc(&count[side]);
+    if (k < max_migrate) {
+        __global double *msg = send + (side*max_migrate + k)*MIGRATE_RECORD_SIZE;
+        msg[0] = pos[i];
+        msg[1] = pos[i + stride];
+        msg[2] = pos[i + 2*stride];
+        msg[dim] += (side == 0) ? shift_lo : shift_hi;
+        msg[3] = vel[i];
+        msg[4] = vel[i + stride];
+        msg[5] = vel[i + 2*stride];
+        msg[6] = charge[i];
+        msg[7] = as_double(id[i]);
+        msg[8] = constraint_virial[i];
+    }
+}
+
+/**
+ * migrate_compact
+ * @brief Stream compaction of the particle store. After n_send particles have
+ * left, the remaining particles must occupy the first n_stay = n_local - n_send
+ * slots. Collect the holes, flagged slots below n_stay, and the movers,
+ * unflagged slots at or above n_stay. Both lists have the same length.
+ */
+__kernel void migrate_compact(
+    __global const uint *flag,
+    const uint n_local,
+    const uint n_stay,
+    __global uint *index,
+    __global uint *count,
+    const uint max_index)
+{
+    const uint i = get_global_id(0);
+    if (i >= n_local) {
+        return;
+    }
+
+    if (i < n_stay && flag[i]) {
+        uint k = atomic_inc(&count[2]);
+        index[k] = i;
+    } else if (i >= n_stay && !flag[i]) {
+        uint k = atomic_inc(&count[3]);
+        index[max_index + k] = i;
+    }
+}
+
+/**
+ * migrate_move
+ * @brief Move each mover into its hole. Holes and movers are disjoint, so the
+ * move is done in place.
+ */
+__kernel void migrate_move(
+    __global double *pos,
+    __global double *vel,
+    __global double *charge,
+    __global ulong *id,
+    __global double *constraint_virial,
+    const uint stride,
+    __global const uint *index,
+    const uint n_moves,
+    const uint max_index)
+{
+    const uint j = get_global_id(0);
+    if (j >= n_moves) {
+        return;
+    }
+
+    const uint dst = index[j];
+    const uint src = index[max_index + j];
+    store3(pos, dst, stride, load3(pos, src, stride));
+    store3(vel, dst, stride, load3(vel, src, stride));
+    charge[dst] = charge[src];
+    id[dst] = id[src];
+    constraint_virial[dst] = constraint_virial[src];
+}
+
+/**
+ * migrate_unpack
+ * @brief Append the received migration records to the particle store,
+ * starting at the specified offset.
+ */
+__kernel void migrate_unpack(
+    __global double *pos,
+    __global double *vel,
+    __global double *charge,
+    __global ulong *id,
+    __global double *constraint_virial,
+    const uint stride,
+    const uint offset,
+    __global const double *recv,
+    const uint n_recv)
+{
+    const uint i = get_global_id(0);
+    if (i >= n_recv) {
+        return;
+    }
+
+    __global const double *msg = recv + i*MIGRATE_RECORD_SIZE;
+    store3(pos, offset + i, stride, (double3) (msg[0], msg[1], msg[2]));
+    store3(vel, offset + i, stride, (double3) (msg[3], msg[4], msg[5]));
+    charge[offset + i] = msg[6];
+    id[offset + i] = as_ulong(msg[7]);
+    constraint_virial[offset + i] = msg[8];
+}
+
+/** ---------------------------------------------------------------------------
+ * index_slot
+ * @brief Return the home slot of a particle id in the local index hash
+ * table, from the upper bits of its Fibonacci hash.
+ */
+uint index_slot(const ulong key, const uint mask)
+{
+    return (uint) ((key * 0x9e3779b97f4a7c15UL) >> 32) & mask;
+}
+
+/**
+ * index_lookup
+ * @brief Return the local index of the particle id in the hash table, or
+ * 0xFFFFFFFF if the particle is not local. Each slot holds a local index,
+ * and the probe compares the id stored at that index with the key.
+ */
+uint index_lookup(
+    __global const uint *table,
+    const uint mask,
+    __global const ulong *id,
+    const ulong key)
+{
+    uint slot = index_slot(key, mask);
+    uint k;
+    while ((k = table[slot]) != 0xFFFFFFFF && id[k] != key) {
+        slot = (slot + 1) & mask;
+    }
+    return k;
+}
+
+/**
+ * cluster_map
+ * @brief Insert the local index of each local particle in the hash table
+ * of its id, with linear probing from its home slot. The table is cleared
+ * to 0xFFFFFFFF beforehand and is at most half full.
+ */
+__kernel void cluster_map(
+    __global const ulong *id,
+    const uint n_local,
+    const uint index_mask,
+    __global uint *local_index)
+{
+    const uint i = get_global_id(0);
+    if (i >= n_local) {
+        return;
+    }
+
+    uint slot = index_slot(id[i], index_mask);
+    while (atomic_cmpxchg(&local_index[slot], 0xFFFFFFFF, i) != 0xFFFFFFFF) {
+        slot = (slot + 1) & index_mask;
+    }
+}
+
+/**
+ * cluster_build
+ * @brief Append the local indices of the n_sites sites of each molecule to
+ * the cluster list, one record per molecule, reserved by its first site.
+ */
+__kernel void cluster_build(
+    __global const ulong *id,
+    const uint n_local,
+    const uint n_sites,
+    const uint index_mask,
+    __global const uint *local_index,
+    __global uint *cluster,
+    __global uint *count)
+{
+    const uint i = get_global_id(0);
+    if (i >= n_local || id[i] % n_sites != 0) {
+        return;
+    }
+
+    uint k = atomic_inc(count);
+    for (uint site = 0; site < n_sites; ++site) {
+        cluster[k*n_sites + site] = index_lookup(
+            local_index, index_mask, id, id[i] + site);
+    }
+}
+
+/**
+ * constrain_position
+ * @brief Constrain the positions of each cluster by SHAKE, one cluster per
+ * work-item. Each constraint in turn displaces its sites along the old bond
+ * vector to restore its length, until every constraint holds within the
+ * tolerance, and the velocities are corrected by the displacements.
+ * Clusters that do not converge are counted in error.
+ *
+ * The velocity correction dv = dr / dt is the half step kick of the
+ * constraint force at the old positions, and the virial of the position
+ * stage, r_i0 . dv / dt at the old positions, is stored for each site and
+ * added to the virial by the velocity stage, see constrain_velocity.
+ */
+__kernel void constrain_position(
+    __global const double *pos_old,
+    __global double *pos,
+    __global double *vel,
+    const uint stride,
+    __global const uint *cluster,
+    const uint n_clusters,
+    const uint n_sites,
+    __global const uint *constraint_site,
+    __global const double *constraint_length,
+    const uint n_constraints,
+    const double tolerance,
+    const uint max_iter,
+    const double dt,
+    __global double *constraint_virial,
+    __global uint *error)
+{
+    const uint k = get_global_id(0);
+    if (k >= n_clusters) {
+        return;
+    }
+
+    __global const uint *sites = cluster + k*n_sites;
+    double3 r0[MAX_SITES];
+    double3 r[MAX_SITES];
+    for (uint site = 0; site < n_sites; ++site) {
+        r0[site] = load3(pos_old, sites[site], stride);
+        r[site] = load3(pos, sites[site], stride);
+    }
+
+    int converged = 0;
+    for (uint iter = 0; iter < max_iter && !converged; ++iter) {
+        converged = 1;
+        for (uint c = 0; c < n_constraints; ++c) {
+            uint a = constraint_site[2*c];
+            uint b = constraint_site[2*c + 1];
+            double len_sq = constraint_length[c] * constraint_length[c];
+            double3 s = r0[b] - r0[a];
+            double3 d = r[b] - r[a];
+            double diff = len_sq - dot(d, d);
+            if (fabs(diff) > 2.0 * tolerance * len_sq) {
+                double g = diff / (4.0 * dot(s, d));
+                r[a] -= g * s;
+                r[b] += g * s;
+                converged = 0;
+            }
+        }
+    }
+    if (!converged) {
+        atomic_inc(error);
+    }
+
+    for (uint site = 0; site < n_sites; ++site) {
+        uint i = sites[site];
+        double3 dv = (r[site] - load3(pos, i, stride)) / dt;
+        constraint_virial[i] = dot(r0[site] - r0[0], dv / dt);
+        store3(vel, i, stride, load3(vel, i, stride) + dv);
+        store3(pos, i, stride, r[site]);
+    }
+}
+
+/**
+ * settle_position
+ * @brief Constrain the positions of each rigid 3-site molecule by SETTLE,
+ * one molecule per work-item, see Constraints::shake. The new positions are
+ * expressed in a frame with z normal to the old molecular plane, where the
+ * canonical triangle of geometry ra, rb and rc is tilted by phi and psi and
+ * rotated by theta to match the unconstrained update. The virial of the
+ * position stage is stored for each site, see constrain_position.
+ */
+__kernel void settle_position(
+    __global const double *pos_old,
+    __global double *pos,
+    __global double *vel,
+    const uint stride,
+    __global const uint *cluster,
+    const uint n_clusters,
+    const double ra,
+    const double rb,
+    const double rc,
+    const double dt,
+    __global double *constraint_virial)
+{
+    const uint k = get_global_id(0);
+    if (k >= n_clusters) {
+        return;
+    }
+
+    __global const uint *sites = cluster + 3*k;
+    double3 a0 = load3(pos_old, sites[0], stride);
+    double3 b0 = load3(pos_old, sites[1], stride) - a0;
+    double3 c0 = load3(pos_old, sites[2], stride) - a0;
+    double3 s0[3] = {(double3) (0.0), b0, c0};
+    double3 r1[3] = {
+        load3(pos, sites[0], stride),
+        load3(pos, sites[1], stride),
+        load3(pos, sites[2], stride)};
+    double3 com = (r1[0] + r1[1] + r1[2]) / 3.0;
+    double3 a1 = r1[0] - com;
+    double3 b1 = r1[1] - com;
+    double3 c1 = r1[2] - com;
+
+    double3 ez = normalize(cross(b0, c0));
+    double3 ex = normalize(cross(a1, ez));
+    double3 ey = cross(ez, ex);
+
+    double xb0 = dot(b0, ex);
+    double yb0 = dot(b0, ey);
+    double xc0 = dot(c0, ex);
+    double yc0 = dot(c0, ey);
+    double za1 = dot(a1, ez);
+    double xb1 = dot(b1, ex);
+    double yb1 = dot(b1, ey);
+    double zb1 = dot(b1, ez);
+    double xc1 = dot(c1, ex);
+    double yc1 = dot(c1, ey);
+    double zc1 = dot(c1, ez);
+
+    double sin_phi = za1 / ra;
+    double cos_phi = sqrt(1.0 - sin_phi * sin_phi);
+    double sin_psi = (zb1 - zc1) / (2.0 * rc * cos_phi);
+    double cos_psi = sqrt(1.0 - sin_psi * sin_psi);
+
+    double ya2 = ra * cos_phi;
+    double xb2 = -rc * cos_psi;
+    double t1 = -rb * cos_phi;
+    double t2 = rc * sin_psi * sin_phi;
+    double yb2 = t1 - t2;
+    double yc2 = t1 + t2;
+
+    double alpha = xb2 * (xb0 - xc0) + yb0 * yb2 + yc0 * yc2;
+    double beta = xb2 * (yc0 - yb0) + xb0 * yb2 + xc0 * yc2;
+    double gamma = xb0 * yb1 - xb1 * yb0 + xc0 * yc1 - xc1 * yc0;
+    double alpha_beta = alpha * alpha + beta * beta;
+    double sin_theta = (alpha * gamma -
+        beta * sqrt(alpha_beta - gamma * gamma)) / alpha_beta;
+    double cos_theta = sqrt(1.0 - sin_theta * sin_theta);
+
+    double3 r3[3] = {
+        (double3) (-ya2 * sin_theta, ya2 * cos_theta, za1),
+        (double3) ( xb2 * cos_theta - yb2 * sin_theta,
+                    xb2 * sin_theta + yb2 * cos_theta, zb1),
+        (double3) (-xb2 * cos_theta - yc2 * sin_theta,
+                   -xb2 * sin_theta + yc2 * cos_theta, zc1)};
+    for (uint site = 0; site < 3; ++site) {
+        uint i = sites[site];
+        double3 r = com + r3[site].x * ex + r3[site].y * ey + r3[site].z * ez;
+        double3 dv = (r - r1[site]) / dt;
+        constraint_virial[i] = dot(s0[site], dv / dt);
+        store3(vel, i, stride, load3(vel, i, stride) + dv);
+        store3(pos, i, stride, r);
+    }
+}
+
+/**
+ * constrain_velocity
+ * @brief Remove the velocity components along the constraints of each
+ * cluster by RATTLE, one cluster per work-item. Clusters that do not
+ * converge are counted in error.
+ *
+ * The constraint forces of the position and velocity stages are the half
+ * step kicks f = 2 dv / dt at the old and new positions. Each stage adds
+ * half its virial, r_i0 . dv / dt, so the virial of each site is the mean
+ * of the constraint virials at the start and the end of the step.
+ */
+__kernel void constrain_velocity(
+    __global const double *pos,
+    __global double *vel,
+    const uint stride,
+    __global const uint *cluster,
+    const uint n_clusters,
+    const uint n_sites,
+    __global const uint *constraint_site,
+    __global const double *constraint_length,
+    const uint n_constraints,
+    const double tolerance,
+    const uint max_iter,
+    const double dt,
+    __global const double *constraint_virial,
+    __global double *virial,
+    __global uint *error)
+{
+    const uint k = get_global_id(0);
+    if (k >= n_clusters) {
+        return;
+    }
+
+    __global const uint *sites = cluster + k*n_sites;
+    double3 r[MAX_SITES];
+    double3 v[MAX_SITES];
+    for (uint site = 0; site < n_sites; ++site) {
+        r[site] = load3(pos, sites[site], stride);
+        v[site] = load3(vel, sites[site], stride);
+    }
+
+    int converged = 0;
+    for (uint iter = 0; iter < max_iter && !converged; ++iter) {
+        converged = 1;
+        for (uint c = 0; c < n_constraints; ++c) {
+            uint a = constraint_site[2*c];
+            uint b = constraint_site[2*c + 1];
+            double len_sq = constraint_length[c] * constraint_length[c];
+            double3 d = r[b] - r[a];
+            double d_dv = dot(d, v[b] - v[a]);
+            if (fabs(d_dv) > tolerance * len_sq) {
+                double g = d_dv / (2.0 * len_sq);
+                v[a] += g * d;
+                v[b] -= g * d;
+                converged = 0;
+            }
+        }
+    }
+    if (!converged) {
+        atomic_inc(error);
+    }
+
+    for (uint site = 0; site < n_sites; ++site) {
+        uint i = sites[site];
+        double3 dv = v[site] - load3(vel, i, stride);
+        virial[i] += constraint_virial[i] + dot(r[site] - r[0], dv / dt);
+        store3(vel, i, stride, v[site]);
+    }
+}
+
+/**
+ * det3
+ * @brief Return the determinant of the 3x3 matrix with columns c0, c1, c2.
+ */
+double det3(double3 c0, double3 c1, double3 c2)
+{
+    return dot(c0, cross(c1, c2));
+}
+
+/**
+ * settle_velocity
+ * @brief Remove the velocity components along the three constraints of each
+ * rigid 3-site molecule, one molecule per work-item. The impulses tau along
+ * the unit bond vectors of the pairs (0,1), (0,2) and (1,2) solve a 3x3
+ * linear system, see Constraints::rattle, by Cramer's rule. The virial of
+ * the constraint forces is added to the virial of each site, see
+ * constrain_velocity.
+ */
+__kernel void settle_velocity(
+    __global const double *pos,
+    __global double *vel,
+    const uint stride,
+    __global const uint *cluster,
+    const uint n_clusters,
+    const double dt,
+    __global const double *constraint_virial,
+    __global double *virial)
+{
+    const uint k = get_global_id(0);
+    if (k >= n_clusters) {
+        return;
+    }
+
+    __global const uint *sites = cluster + 3*k;
+    double3 r[3];
+    double3 v[3];
+    for (uint site = 0; site < 3; ++site) {
+        r[site] = load3(pos, sites[site], stride);
+        v[site] = load3(vel, sites[site], stride);
+    }
+
+    double3 e0 = normalize(r[1] - r[0]);
+    double3 e1 = normalize(r[2] - r[0]);
+    double3 e2 = normalize(r[2] - r[1]);
+    double3 b = (double3) (
+        -dot(e0, v[1] - v[0]),
+        -dot(e1, v[2] - v[0]),
+        -dot(e2, v[2] - v[1]));
+
+    double e01 = dot(e0, e1);
+    double e02 = dot(e0, e2);
+    double e12 = dot(e1, e2);
+    double3 m0 = (double3) (-2.0, -e01,  e02);
+    double3 m1 = (double3) (-e01, -2.0, -e12);
+    double3 m2 = (double3) ( e02, -e12, -2.0);
+    double det = det3(m0, m1, m2);
+    double tau0 = det3(b, m1, m2) / det;
+    double tau1 = det3(m0, b, m2) / det;
+    double tau2 = det3(m0, m1, b) / det;
+
+    double3 dv[3] = {
+         tau0 * e0 + tau1 * e1,
+        -tau0 * e0 + tau2 * e2,
+        -tau1 * e1 - tau2 * e2};
+    for (uint site = 0; site < 3; ++site) {
+        uint i = sites[site];
+        virial[i] += constraint_virial[i] + dot(r[site] - r[0], dv[site] / dt);
+        store3(vel, i, stride, v[site] + dv[site]);
+    }
+}
+
+/** ---------------------------------------------------------------------------
+ * morton_spread
+ * @brief Spread the lower 10 bits of v so there are two zero bits between
+ * each pair of consecutive bits.
+ */
+uint morton_spread(uint v)
+{
+    v &= 0x000003ff;
+    v = (v | (v << 16)) & 0x030000ff;
+    v = (v | (v <<  8)) & 0x0300f00f;
+    v = (v | (v <<  4)) & 0x030c30c3;
+    v = (v | (v <<  2)) & 0x09249249;
+    return v;
+}
+
+/**
+ * reorder_keys
+ * @brief Compute the sort keys of the local particles. The upper 32 bits hold
+ * the Morton key of the particle cell and the lower 32 bits the particle
+ * index, so the keys are unique and the sort is deterministic. Keys beyond
+ * the local particles pad the array to the power of two sort length.
+ */
+__kernel void reorder_keys(
+    __global const double *pos,
+    const uint stride,
+    const uint n_local,
+    const uint n_sort,
+    __global ulong *key,
+    const double4 cell_lo,
+    const double4 cell_width,
+    const int4 n_cells)
+{
+    const uint i = get_global_id(0);
+    if (i >= n_sort) {
+        return;
+    }
+    if (i >= n_local) {
+        key[i] = ULONG_MAX;
+        return;
+    }
+
+    int4 c = cell_coord(load3(pos, i, stride), cell_lo, cell_width, n_cells);
+    ulong morton = morton_spread(c.x) |
+                  (morton_spread(c.y) << 1) |
+                  (morton_spread(c.z) << 2);
+    key[i] = (morton << 32) | i;
+}
+
+/**
+ * reorder_sort
+ * @brief One compare-exchange pass of the bitonic sort network over n_sort
+ * keys, with subsequence size k and comparison distance j.
+ */
+__kernel void reorder_sort(
+    __global ulong *key,
+    const uint n_sort,
+    const uint j,
+    const uint k)
+{
+    const uint i = get_global_id(0);
+    const uint l = i ^ j;
+    if (i >= n_sort || l <= i) {
+        return;
+    }
+
+    ulong key_i = key[i];
+    ulong key_l = key[l];
+    bool ascending = ((i & k) == 0);
+    if ((key_i > key_l) == ascending) {
+        key[i] = key_l;
+        key[l] = key_i;
+    }
+}
+
+/**
+ * reorder_gather
+ * @brief Gather n_components blocks of 64-bit words in sorted order into the
+ * destination array. The words are moved as raw bits, so the same kernel
+ * permutes double and ulong arrays.
+ */
+__kernel void reorder_gather(
+    __global const ulong *src,
+    __global ulong *dst,
+    const uint stride,
+    const uint n_components,
+    __global const ulong *key,
+    const uint n_local)
+{
+    const uint i = get_global_id(0);
+    if (i >= n_local) {
+        return;
+    }
+
+    const uint from = (uint) key[i];
+    for (uint c = 0; c < n_components; ++c) {
+        dst[i + c*stride] = src[from + c*stride];
+    }
+}
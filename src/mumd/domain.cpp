@@ -0,0 +1,232 @@
+/*
+ * domain.cpp
+ *
+ * Copyright (c) 2020 Carlos Braga
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the MIT License.
+ *
+ * See accompanying LICENSE.md or https://opensource.org/licenses/MIT.
+ */
+
+#include "domain.hpp"
+using namespace atto;
+
+/** ---------------------------------------------------------------------------
+ * Domain::Domain
+ * @brief Create a periodic cartesian communicator with MPI_Dims_create and
+ * compute the bounds of the subdomain owned by this process.
+ */
+Domain::Domain(
+    MPI_Comm comm,
+    const cl_double box_lo[3],
+    const cl_double box_hi[3])
+{
+    /*
+     * Setup the cartesian process grid.
+     */
+    {
+        int n_procs;
+        MPI_Comm_size(comm, &n_procs);
+
+        m_dims[0] = m_dims[1] = m_dims[2] = 0;
+        MPI_Dims_create(n_procs, 3, m_dims);
+
+        m_periods[0] = m_periods[1] = m_periods[2] = 1;
+        MPI_Cart_create(comm, 3, m_dims, m_periods, 1, &m_comm);
+        core_assert(m_comm != MPI_COMM_NULL, "MPI_Cart_create");
+
+        MPI_Comm_size(m_comm, &m_n_procs);
+        MPI_Comm_rank(m_comm, &m_proc_id);
+        MPI_Cart_coords(m_comm, m_proc_id, 3, m_coords);
+
+        for (int dim = 0; dim < 3; ++dim) {
+            MPI_Cart_shift(
+                m_comm,
+                dim,
+                1,
+                &m_neighbours[direction(dim, 0)],
+                &m_neighbours[direction(dim, 1)]);
+        }
+    }
+
+    /*
+     * Setup the subdomain bounds on a uniform grid.
+     */
+    {
+        std::vector<cl_double> planes[3];
+        for (int dim = 0; dim < 3; ++dim) {
+            m_box_lo[dim] = box_lo[dim];
+            m_box_hi[dim] = box_hi[dim];
+            m_box_length[dim] = box_hi[dim] - box_lo[dim];
+
+            cl_double width = m_box_length[dim] / (cl_double) m_dims[dim];
+            planes[dim].resize(m_dims[dim] + 1);
+            for (int k = 0; k < m_dims[dim]; ++k) {
+                planes[dim][k] = m_box_lo[dim] + width * (cl_double) k;
+            }
+            planes[dim][m_dims[dim]] = m_box_hi[dim];
+        }
+        set_planes(planes);
+    }
+}
+
+/**
+ * Domain::~Domain
+ * @brief Free the cartesian communicator.
+ */
+Domain::~Domain()
+{
+    if (m_comm != MPI_COMM_NULL) {
+        MPI_Comm_free(&m_comm);
+    }
+}
+
+/** ---------------------------------------------------------------------------
+ * Domain::set_planes
+ * @brief Set the grid planes along each dimension and update the bounds of
+ * the subdomain owned by this process. The outer planes must coincide with
+ * the box bounds and every subdomain must be wider than the halo width.
+ */
+void Domain::set_planes(const std::vector<cl_double> planes[3])
+{
+    for (int dim = 0; dim < 3; ++dim) {
+        core_assert(planes[dim].size() == (size_t) m_dims[dim] + 1,
+            "invalid number of grid planes");
+        core_assert(planes[dim].front() == m_box_lo[dim] &&
+                    planes[dim].back() == m_box_hi[dim],
+            "grid planes do not span the box");
+        for (int k = 0; k < m_dims[dim]; ++k) {
+            core_assert(planes[dim][k + 1] - planes[dim][k] >= Params::r_halo,
+                "subdomain width is smaller than the halo width");
+        }
+
+        m_planes[dim] = planes[dim];
+        m_lo[dim] = m_planes[dim][m_coords[dim]];
+        m_hi[dim] = m_planes[dim][m_coords[dim] + 1];
+    }
+}
+
+/** ---------------------------------------------------------------------------
+ * Domain::shift
+ * @brief Return the periodic image shift of a particle sent across the given
+ * side of the subdomain along dimension dim. The shift is nonzero only when
+ * the message crosses the global box boundary.
+ */
+cl_double Domain::shift(const int dim, const int side) const
+{
+    if (side == 0 && m_coords[dim] == 0) {
+        return m_box_length[dim];
+    }
+    if (side == 1 && m_coords[dim] == m_dims[dim] - 1) {
+        return -m_box_length[dim];
+    }
+    return 0.0;
+}
+
+/**
+ * Domain::scale_box
+ * @brief Scale the box and the grid planes about the box origin, keeping the
+ * relative position of every plane.
+ */
+void Domain::scale_box(const cl_double scale)
+{
+    std::vector<cl_double> planes[3];
+    for (int dim = 0; dim < 3; ++dim) {
+        m_box_length[dim] *= scale;
+        m_box_hi[dim] = m_box_lo[dim] + m_box_length[dim];
+
+        planes[dim] = m_planes[dim];
+        for (auto &it : planes[dim]) {
+            it = m_box_lo[dim] + scale * (it - m_box_lo[dim]);
+        }
+        planes[dim].front() = m_box_lo[dim];
+        planes[dim].back() = m_box_hi[dim];
+    }
+    set_planes(planes);
+}
+
+/**
+ * Domain::volume
+ * @brief Return the volume of the box.
+ */
+cl_double Domain::volume(void) const
+{
+    return m_box_length[0] * m_box_length[1] * m_box_length[2];
+}
+
+/**
+ * Domain::is_inside
+ * @brief Is the position inside the subdomain bounds?
+ */
+bool Domain::is_inside(const cl_double r[3]) const
+{
+    return (r[0] >= m_lo[0] && r[0] < m_hi[0] &&
+            r[1] >= m_lo[1] && r[1] < m_hi[1] &&
+            r[2] >= m_lo[2] && r[2] < m_hi[2]);
+}
+
+/** ---------------------------------------------------------------------------
+ * Domain::exchange
+ * @brief Exchange a pair of contiguous messages with the lo and hi neighbours
+ * along dimension dim. The message sizes are exchanged first, followed by the
+ * payloads, both with non-blocking point-to-point calls. The message tag is
+ * the direction of travel, so lo and hi messages remain distinct when both
+ * neighbours are the same process.
+ */
+void Domain::exchange(
+    const int dim,
+    const std::vector<cl_uchar> send[2],
+    std::vector<cl_uchar> recv[2]) const
+{
+    MPI_Request requests[4];
+
+    /* Exchange the message sizes. */
+    cl_ulong send_size[2] = {send[0].size(), send[1].size()};
+    cl_ulong recv_size[2] = {0, 0};
+    for (int side = 0; side < 2; ++side) {
+        MPI_Irecv(
+            (void *) &recv_size[side],
+            sizeof(recv_size[side]),
+            MPI_BYTE,
+            m_neighbours[direction(dim, side)],
+            direction(dim, 1 - side),
+            m_comm,
+            &requests[side]);
+    }
+    for (int side = 0; side < 2; ++side) {
+        MPI_Isend(
+            (void *) &send_size[side],
+            sizeof(send_size[side]),
+            MPI_BYTE,
+            m_neighbours[direction(dim, side)],
+            direction(dim, side),
+            m_comm,
+            &requests[2 + side]);
+    }
+    MPI_Waitall(4, requests, MPI_STATUSES_IGNORE);
+
+    /* Exchange the message payloads. */
+    for (int side = 0; side < 2; ++side) {
+        recv[side].resize(recv_size[side]);
+        MPI_Irecv(
+            (void *) recv[side].data(),
+            (int) recv_size[side],
+            MPI_BYTE,
+            m_neighbours[direction(dim, side)],
+            direction(dim, 1 - side),
+            m_comm,
+            &requests[side]);
+    }
+    for (int side = 0; side < 2; ++side) {
+        MPI_Isend(
+            (void *) send[side].data(),
+            (int) send_size[side],
+            MPI_BYTE,
+            m_neighbours[direction(dim, side)],
+            direction(dim, side),
+            m_comm,
+            &requests[2 + side]);
+    }
+    MPI_Waitall(4, requests, MPI_STATUSES_IGNORE);
+}
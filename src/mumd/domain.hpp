@@ -0,0 +1,78 @@
+/*
+ * domain.hpp
+ *
+ * Copyright (c) 2020 Carlos Braga
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the MIT License.
+ *
+ * See accompanying LICENSE.md or https://opensource.org/licenses/MIT.
+ */
+
+#ifndef DOMAIN_H_
+#define DOMAIN_H_
+
+#include <vector>
+#include "base.hpp"
+#include "mpi.h"
+
+/**
+ * Domain
+ * @brief Spatial decomposition of a periodic orthorhombic box over a 3-d
+ * cartesian grid of MPI processes. Each process owns the particles inside
+ * its subdomain [lo, hi) and exchanges messages with the six face neighbours.
+ */
+struct Domain {
+    /* ---- Domain communicator -------------------------------------------- */
+    MPI_Comm m_comm = MPI_COMM_NULL;
+    int m_proc_id;
+    int m_n_procs;
+    int m_dims[3];
+    int m_periods[3];
+    int m_coords[3];
+
+    enum {
+        XLo = 0,
+        XHi,
+        YLo,
+        YHi,
+        ZLo,
+        ZHi,
+        NumDirections
+    };
+    int m_neighbours[NumDirections];
+
+    /* ---- Domain bounds -------------------------------------------------- */
+    cl_double m_box_lo[3];
+    cl_double m_box_hi[3];
+    cl_double m_box_length[3];
+    cl_double m_lo[3];
+    cl_double m_hi[3];
+    std::vector<cl_double> m_planes[3];
+
+    /* ---- Domain member functions ---------------------------------------- */
+    static int direction(const int dim, const int side) {
+        return 2 * dim + side;
+    }
+    cl_double shift(const int dim, const int side) const;
+    bool is_inside(const cl_double r[3]) const;
+    bool is_master(void) const { return m_proc_id == Params::master_id; }
+    void set_planes(const std::vector<cl_double> planes[3]);
+    void scale_box(const cl_double scale);
+    cl_double volume(void) const;
+
+    void exchange(
+        const int dim,
+        const std::vector<cl_uchar> send[2],
+        std::vector<cl_uchar> recv[2]) const;
+
+    explicit Domain(
+        MPI_Comm comm,
+        const cl_double box_lo[3],
+        const cl_double box_hi[3]);
+    ~Domain();
+    Domain(const Domain &) = delete;
+    Domain &operator=(const Domain &) = delete;
+};
+
+#endif /* DOMAIN_H_ */
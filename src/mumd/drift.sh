@@ -0,0 +1,86 @@
+#! /bin/bash
+
+#
+# drift.sh
+#
+# Copyright (c) 2020 Carlos Braga
+#
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the MIT License.
+#
+# See accompanying LICENSE.md or https://opensource.org/licenses/MIT.
+#
+
+# -----------------------------------------------------------------------------
+# Energy drift validation of the mixed precision policy.
+#
+# Build and run the model in the microcanonical ensemble with double and with
+# mixed precision pair forces. Fit the total energy per particle of each run
+# to a straight line in the step number, and compare the drift rates. The
+# mixed policy passes if its drift is at most factor times the double
+# precision drift, plus an absolute floor for runs whose drift is at the
+# round-off level.
+#
+# usage: ./drift.sh [n_procs [factor [floor]]]
+#
+n_procs=${1:-1}
+factor=${2:-4.0}
+floor=${3:-1.0e-8}
+
+# A pipeline fails if any of its commands fails, not only the last one.
+set -o pipefail
+
+# -----------------------------------------------------------------------------
+# die with message
+#
+die() {
+    echo >&2 "$@"
+    exit 1
+}
+
+#
+# run command and check exit code
+#
+run() {
+    echo "$@" && "$@"
+    code=$?
+    [[ $code -ne 0 ]] && die "[$@] failed with error code $code"
+    return 0
+}
+
+#
+# fit the total energy per particle against the step number and print the
+# slope, the drift per particle per step.
+#
+drift() {
+    sed -n 's/^step \([0-9]*\) of [0-9]*, n_particles \([0-9]*\),.*etot \([-+0-9.eE]*\),.*/\1 \2 \3/p' "$1" |
+    awk '
+        { x = $1; y = $3 / $2; n++; sx += x; sy += y; sxx += x*x; sxy += x*y }
+        END {
+            if (n < 2) { exit 1 }
+            printf("%.6e\n", (n*sxy - sx*sy) / (n*sxx - sx*sx))
+        }'
+}
+
+# -----------------------------------------------------------------------------
+# Run the double and mixed precision models.
+#
+for precision in double mixed; do
+    run make clean
+    run make -j bin target=mumd_${precision} precision=${precision} nve=yes
+    run mpirun -np ${n_procs} ./mumd_${precision}.out | tee drift_${precision}.log ||
+        die "mumd_${precision} run failed, see drift_${precision}.log"
+    run make clean target=mumd_${precision}
+done
+
+drift_double=$(drift drift_double.log) || die "no samples in drift_double.log"
+drift_mixed=$(drift drift_mixed.log) || die "no samples in drift_mixed.log"
+echo "energy drift per particle per step"
+echo "  double ${drift_double}"
+echo "  mixed  ${drift_mixed}"
+
+awk -v d="${drift_double}" -v m="${drift_mixed}" -v f="${factor}" -v e="${floor}" '
+    function abs(x) { return x < 0 ? -x : x }
+    BEGIN { exit !(abs(m) <= f * abs(d) + e) }' ||
+    die "mixed precision drift exceeds ${factor} x double precision drift"
+echo "mixed precision drift is within ${factor} x double precision drift"
@@ -0,0 +1,230 @@
+/*
+ * ensemble.cpp
+ *
+ * Copyright (c) 2020 Carlos Braga
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the MIT License.
+ *
+ * See accompanying LICENSE.md or https://opensource.org/licenses/MIT.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include "ensemble.hpp"
+using namespace atto;
+
+/** ---------------------------------------------------------------------------
+ * Thermo::reduce
+ * @brief Sum the process contributions over all processes in a single
+ * allreduce of the whole struct.
+ */
+void Thermo::reduce(MPI_Comm comm)
+{
+    static_assert(sizeof(Thermo) == NumFields * sizeof(cl_double),
+        "thermo fields are not contiguous doubles");
+    MPI_Allreduce(
+        MPI_IN_PLACE, (void *) this, NumFields, MPI_DOUBLE, MPI_SUM, comm);
+}
+
+/**
+ * Thermo::temperature
+ * @brief Return the kinetic temperature, 2 K / n_dof.
+ */
+cl_double Thermo::temperature(void) const
+{
+    cl_double n_dof = degrees_of_freedom();
+    return (n_dof > 0.0) ? 2.0 * kinetic_energy / n_dof : 0.0;
+}
+
+/**
+ * Thermo::pressure
+ * @brief Return the pressure from the virial theorem, (2 K + W) / (3 V),
+ * where W is the sum of r_ij . f_ij over all pairs.
+ */
+cl_double Thermo::pressure(const cl_double volume) const
+{
+    return (2.0 * kinetic_energy + virial) / (3.0 * volume);
+}
+
+/** ---------------------------------------------------------------------------
+ * Ensemble::Ensemble
+ * @brief Create the thermostat chain and the barostat at rest. The masses
+ * depend on the number of degrees of freedom and are set on each update.
+ */
+Ensemble::Ensemble()
+{
+    m_chain_mass.resize(Params::nhc_length, 0.0);
+    m_chain_vel.resize(Params::nhc_length, 0.0);
+    m_box_mass = 0.0;
+    m_box_vel = 0.0;
+    m_velocity_scale = 1.0;
+    m_position_scale = 1.0;
+}
+
+/**
+ * Ensemble::update
+ * @brief Compute the velocity and position scale factors of the next step
+ * from the global sums at the end of the current step. The barostat sees
+ * the kinetic energy after the thermostat scaling.
+ */
+void Ensemble::update(const Thermo &thermo, const cl_double volume)
+{
+    m_velocity_scale = 1.0;
+    m_position_scale = 1.0;
+    if (thermo.n_particles == 0.0 || thermo.kinetic_energy <= 0.0) {
+        return;
+    }
+
+    m_velocity_scale = thermostat(thermo);
+    barostat(thermo,
+        m_velocity_scale * m_velocity_scale * thermo.kinetic_energy,
+        volume);
+}
+
+/** ---------------------------------------------------------------------------
+ * Ensemble::thermostat
+ * @brief Return the velocity scale factor of the thermostat.
+ *
+ * The Bussi thermostat needs the sum of n_dof squared Gaussian numbers and
+ * one Gaussian number R1 independent of the remaining n_dof - 1 terms. The
+ * normalised sum of all the numbers is such a Gaussian, since the sample
+ * mean and the spread around it are independent, so
+ *      R1 = noise_sum / sqrt(n_dof),
+ *      R1^2 + sum_{i>1} R_i^2 = noise_sq,
+ * and both come from the device reduction.
+ *
+ * The Nose-Hoover chain is propagated by half a step at the end of this
+ * step and half a step at the start of the next one. No force acts on the
+ * velocities in between, so both halves are combined into one scale factor.
+ */
+cl_double Ensemble::thermostat(const Thermo &thermo)
+{
+    const cl_double dt = Params::time_step;
+    const cl_double tau = Params::thermostat_tau;
+    const cl_double n_dof = thermo.degrees_of_freedom();
+    const cl_double ekin = thermo.kinetic_energy;
+    const cl_double ekin_target = 0.5 * n_dof * Params::temperature;
+
+    switch (Params::thermostat) {
+    case Params::ThermostatBerendsen:
+        return std::sqrt(std::max(
+            1.0 + dt / tau * (ekin_target / ekin - 1.0), 0.0));
+
+    case Params::ThermostatBussi: {
+        cl_double c = std::exp(-dt / tau);
+        cl_double f = ekin_target / (n_dof * ekin);
+        cl_double r1 = thermo.noise_sum / std::sqrt(n_dof);
+        cl_double alpha_sq = c + (1.0 - c) * f * thermo.noise_sq +
+            2.0 * r1 * std::sqrt(c * (1.0 - c) * f);
+        return std::sqrt(std::max(alpha_sq, 0.0));
+    }
+
+    case Params::ThermostatNoseHoover: {
+        cl_double s_end = chain_half_step(ekin, n_dof);
+        cl_double s_start = chain_half_step(s_end * s_end * ekin, n_dof);
+        return s_end * s_start;
+    }
+
+    default:
+        return 1.0;
+    }
+}
+
+/**
+ * Ensemble::chain_half_step
+ * @brief Propagate the Nose-Hoover chain by half a time step and return the
+ * velocity scale factor. The thermostat velocities are updated by quarter
+ * steps from the end of the chain inwards, the particle velocities are
+ * scaled, and the thermostat velocities are updated again outwards. The
+ * first thermostat has mass n_dof kT tau^2 and the others kT tau^2.
+ */
+cl_double Ensemble::chain_half_step(
+    const cl_double kinetic_energy,
+    const cl_double n_dof)
+{
+    const size_t n_chain = m_chain_vel.size();
+    const cl_double kT = Params::temperature;
+    const cl_double tau_sq = Params::thermostat_tau * Params::thermostat_tau;
+    const cl_double dt2 = 0.5 * Params::time_step;
+    const cl_double dt4 = 0.25 * Params::time_step;
+    const cl_double dt8 = 0.125 * Params::time_step;
+
+    std::vector<cl_double> &q = m_chain_mass;
+    std::vector<cl_double> &v = m_chain_vel;
+    q[0] = n_dof * kT * tau_sq;
+    for (size_t j = 1; j < n_chain; ++j) {
+        q[j] = kT * tau_sq;
+    }
+
+    cl_double ekin2 = 2.0 * kinetic_energy;
+    auto force = [&] (size_t j) -> cl_double {
+        return (j == 0)
+            ? (ekin2 - n_dof * kT) / q[0]
+            : (q[j-1] * v[j-1] * v[j-1] - kT) / q[j];
+    };
+    auto kick = [&] (size_t j) {
+        if (j + 1 < n_chain) {
+            v[j] *= std::exp(-dt8 * v[j+1]);
+        }
+        v[j] += dt4 * force(j);
+        if (j + 1 < n_chain) {
+            v[j] *= std::exp(-dt8 * v[j+1]);
+        }
+    };
+
+    for (size_t j = n_chain; j-- > 0; ) {
+        kick(j);
+    }
+    cl_double scale = std::exp(-dt2 * v[0]);
+    ekin2 *= scale * scale;
+    for (size_t j = 0; j < n_chain; ++j) {
+        kick(j);
+    }
+    return scale;
+}
+
+/** ---------------------------------------------------------------------------
+ * Ensemble::barostat
+ * @brief Compute the isotropic position scale factor of the barostat.
+ *
+ * The Berendsen barostat scales the box by the cube root of
+ *      1 - compressibility dt / tau_p (p_target - p).
+ * The MTK barostat integrates the log volume velocity v_eps with mass
+ *      W = (n_dof + 3) kT tau_p^2,
+ * driven by the force 3 V (p - p_target) + (3 / n_dof) 2 K. The box and
+ * positions are scaled by exp(v_eps dt), and the velocities are damped by
+ * exp(-(1 + 3 / n_dof) v_eps dt).
+ */
+void Ensemble::barostat(
+    const Thermo &thermo,
+    const cl_double kinetic_energy,
+    const cl_double volume)
+{
+    const cl_double dt = Params::time_step;
+    const cl_double tau = Params::barostat_tau;
+    const cl_double n_dof = thermo.degrees_of_freedom();
+    const cl_double pressure =
+        (2.0 * kinetic_energy + thermo.virial) / (3.0 * volume);
+
+    switch (Params::barostat) {
+    case Params::BarostatBerendsen:
+        m_position_scale = std::cbrt(std::max(1.0 -
+            Params::compressibility * dt / tau * (Params::pressure - pressure),
+            0.0));
+        break;
+
+    case Params::BarostatMtk: {
+        cl_double alpha = 1.0 + 3.0 / n_dof;
+        m_box_mass = (n_dof + 3.0) * Params::temperature * tau * tau;
+        m_box_vel += dt * (3.0 * volume * (pressure - Params::pressure) +
+            (alpha - 1.0) * 2.0 * kinetic_energy) / m_box_mass;
+        m_position_scale = std::exp(dt * m_box_vel);
+        m_velocity_scale *= std::exp(-alpha * dt * m_box_vel);
+        break;
+    }
+
+    default:
+        break;
+    }
+}
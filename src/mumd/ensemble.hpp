@@ -0,0 +1,107 @@
+/*
+ * ensemble.hpp
+ *
+ * Copyright (c) 2020 Carlos Braga
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the MIT License.
+ *
+ * See accompanying LICENSE.md or https://opensource.org/licenses/MIT.
+ */
+
+#ifndef ENSEMBLE_H_
+#define ENSEMBLE_H_
+
+#include <vector>
+#include "base.hpp"
+#include "mpi.h"
+
+/**
+ * Thermo
+ * @brief Global sums of the thermodynamic quantities. The local sums are
+ * reduced on the device, one partial sum per work-group, and the process
+ * sums are combined by a single allreduce of the whole struct.
+ *
+ * The noise sums hold the sum and the sum of squares of one Gaussian
+ * number per unconstrained degree of freedom, drawn on the device for the
+ * stochastic thermostat.
+ */
+struct Thermo {
+    cl_double n_particles;
+    cl_double n_constraints;
+    cl_double kinetic_energy;
+    cl_double potential_energy;
+    cl_double virial;
+    cl_double noise_sum;
+    cl_double noise_sq;
+
+    /* Number of fields reduced over the processes. */
+    static const int NumFields = 7;
+
+    /* Number of device partial sums per work-group, all but the counts. */
+    static const int NumPartials = 5;
+
+    void reduce(MPI_Comm comm);
+    cl_double degrees_of_freedom(void) const {
+        return 3.0 * n_particles - n_constraints;
+    }
+    cl_double temperature(void) const;
+    cl_double pressure(const cl_double volume) const;
+};
+
+/**
+ * Ensemble
+ * @brief Temperature and pressure control. At the end of each step, the
+ * global sums give the velocity scale factor of the thermostat and the
+ * position scale factor of the barostat. Both are applied by the first half
+ * of the next velocity Verlet step.
+ *
+ * Thermostats:
+ *  Berendsen       weak coupling to the target temperature.
+ *  Bussi           canonical velocity rescale, Bussi, Donadio, Parrinello
+ *                  (2007), with the stochastic term from the device noise.
+ *  NoseHoover      Nose-Hoover chain of nhc_length thermostats, integrated
+ *                  with the Trotter factorisation of Martyna et al. (1996).
+ * Barostats:
+ *  Berendsen       weak coupling of an isotropic box to the target pressure.
+ *  Mtk             isotropic Martyna-Tobias-Klein box equation of motion.
+ */
+struct Ensemble {
+    /* ---- Nose-Hoover chain state ---------------------------------------- */
+    std::vector<cl_double> m_chain_mass;
+    std::vector<cl_double> m_chain_vel;
+
+    /* ---- Barostat state, log volume velocity and mass ------------------- */
+    cl_double m_box_mass;
+    cl_double m_box_vel;
+
+    /* ---- Scale factors applied by the next step ------------------------- */
+    cl_double m_velocity_scale;
+    cl_double m_position_scale;
+
+    /* ---- Ensemble member functions -------------------------------------- */
+    static bool is_active(void) {
+        return (Params::thermostat != Params::ThermostatNone ||
+                Params::barostat != Params::BarostatNone);
+    }
+    static bool has_noise(void) {
+        return Params::thermostat == Params::ThermostatBussi;
+    }
+    void update(const Thermo &thermo, const cl_double volume);
+
+    cl_double thermostat(const Thermo &thermo);
+    cl_double chain_half_step(
+        const cl_double kinetic_energy,
+        const cl_double n_dof);
+    void barostat(
+        const Thermo &thermo,
+        const cl_double kinetic_energy,
+        const cl_double volume);
+
+    Ensemble();
+    ~Ensemble() = default;
+    Ensemble(const Ensemble &) = delete;
+    Ensemble &operator=(const Ensemble &) = delete;
+};
+
+#endif /* ENSEMBLE_H_ */
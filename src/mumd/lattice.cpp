@@ -0,0 +1,338 @@
+/*
+ * lattice.cpp
+ *
+ * Copyright (c) 2020 Carlos Braga
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the MIT License.
+ *
+ * See accompanying LICENSE.md or https://opensource.org/licenses/MIT.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include "lattice.hpp"
+#include "ensemble.hpp"
+using namespace atto;
+
+/** ---------------------------------------------------------------------------
+ * Lattice::Lattice
+ * @brief Create the unit cell basis of the lattice, in units of the cell
+ * edge, and count the molecules.
+ */
+Lattice::Lattice()
+{
+    static const cl_double basis[4][3] = {
+        {0.25, 0.25, 0.25},
+        {0.75, 0.75, 0.25},
+        {0.75, 0.25, 0.75},
+        {0.25, 0.75, 0.75}};
+
+    switch (Params::lattice) {
+    case Params::LatticeBcc:
+        m_n_basis = 2;
+        for (int dim = 0; dim < 3; ++dim) {
+            m_basis[0][dim] = 0.25;
+            m_basis[1][dim] = 0.75;
+        }
+        break;
+    case Params::LatticeFcc:
+        m_n_basis = 4;
+        std::copy(&basis[0][0], &basis[0][0] + 12, &m_basis[0][0]);
+        break;
+    default:
+        m_n_basis = 1;
+        for (int dim = 0; dim < 3; ++dim) {
+            m_basis[0][dim] = 0.5;
+        }
+        break;
+    }
+
+    const cl_ulong n = Params::n_lattice;
+    m_n_molecules = (Params::lattice == Params::LatticeRandom)
+        ? Params::n_random : n * n * n * m_n_basis;
+}
+
+/** ---------------------------------------------------------------------------
+ * Lattice::generate
+ * @brief Place the molecules of the lattice sites inside the subdomain and
+ * return the number of local particles. The first pass counts the sites of
+ * each layer of cells along z, the second writes the molecules of each
+ * layer from the prefix sum of the counts. The charges of single-site
+ * molecules alternate in sign between neighbouring sites.
+ */
+cl_uint Lattice::generate(
+    const Domain &domain,
+    const Topology &topology,
+    const cl_uint capacity,
+    cl_double *position,
+    cl_double *charge,
+    cl_ulong *id) const
+{
+    if (Params::lattice == Params::LatticeRandom) {
+        return generate_random(domain, topology, capacity, position, charge, id);
+    }
+
+    /* Range of cells overlapping the subdomain. */
+    const cl_long n = (cl_long) Params::n_lattice;
+    const cl_double a = Params::lattice_spacing;
+    cl_long c_lo[3], c_hi[3];
+    for (int dim = 0; dim < 3; ++dim) {
+        c_lo[dim] = std::max((cl_long) std::floor(domain.m_lo[dim] / a) - 1, (cl_long) 0);
+        c_hi[dim] = std::min((cl_long) std::ceil(domain.m_hi[dim] / a) + 1, n);
+    }
+
+    const cl_uint n_sites = topology.m_n_sites;
+    const cl_uint n_basis = m_n_basis;
+    const int n_layers = (int) std::max(c_hi[2] - c_lo[2], (cl_long) 0);
+    std::vector<cl_ulong> offset(n_layers + 1, 0);
+
+    for (int pass = 0; pass < 2; ++pass) {
+        core_pragma_omp(parallel for schedule(dynamic, 1))
+        for (int layer = 0; layer < n_layers; ++layer) {
+            const cl_long cz = c_lo[2] + layer;
+            cl_ulong count = 0;
+            for (cl_long cy = c_lo[1]; cy < c_hi[1]; ++cy) {
+                for (cl_long cx = c_lo[0]; cx < c_hi[0]; ++cx) {
+                    for (cl_uint b = 0; b < n_basis; ++b) {
+                        cl_double r[3] = {
+                            a * ((cl_double) cx + m_basis[b][0]),
+                            a * ((cl_double) cy + m_basis[b][1]),
+                            a * ((cl_double) cz + m_basis[b][2])};
+                        if (!domain.is_inside(r)) {
+                            continue;
+                        }
+                        if (pass == 0) {
+                            count++;
+                            continue;
+                        }
+
+                        const cl_ulong site = b + n_basis * (cx + n * (cy + n * cz));
+                        const cl_ulong parity = cx + cy + cz + b;
+                        const cl_double sign =
+                            (n_sites == 1 && parity % 2 == 1) ? -1.0 : 1.0;
+                        for (cl_uint k = 0; k < n_sites; ++k) {
+                            const cl_ulong i = (offset[layer] + count) * n_sites + k;
+                            for (int dim = 0; dim < 3; ++dim) {
+                                position[i + dim * capacity] =
+                                    r[dim] + topology.m_site_position[3 * k + dim];
+                            }
+                            charge[i] = sign * topology.m_site_charge[k];
+                            id[i] = site * n_sites + k;
+                        }
+                        count++;
+                    }
+                }
+            }
+            if (pass == 0) {
+                offset[layer + 1] = count;
+            }
+        }
+
+        if (pass == 0) {
+            for (int layer = 0; layer < n_layers; ++layer) {
+                offset[layer + 1] += offset[layer];
+            }
+            core_assert(offset[n_layers] * n_sites <= capacity,
+                "particle capacity exceeded");
+        }
+    }
+    return (cl_uint) (offset[n_layers] * n_sites);
+}
+
+/**
+ * Lattice::generate_random
+ * @brief Place the share of the random molecules of the subdomain, its
+ * fraction of the box volume, and return the number of local particles.
+ * Each first site is drawn uniformly at least half the distance away from
+ * the subdomain faces and rejected if it lies closer than the distance to
+ * a site already placed, found in a grid of cells at least the distance
+ * wide. Molecule ids continue from the molecules of the previous process.
+ * The candidates of each molecule are drawn from the Philox stream of the
+ * id of its first site at step one, apart from the velocity streams.
+ */
+cl_uint Lattice::generate_random(
+    const Domain &domain,
+    const Topology &topology,
+    const cl_uint capacity,
+    cl_double *position,
+    cl_double *charge,
+    cl_ulong *id) const
+{
+    const cl_double d = Params::random_distance;
+    const cl_uint n_sites = topology.m_n_sites;
+
+    /* Share of the molecules and the first molecule id of this process. */
+    cl_double volume = 1.0;
+    cl_double box_volume = 1.0;
+    for (int dim = 0; dim < 3; ++dim) {
+        volume *= domain.m_hi[dim] - domain.m_lo[dim];
+        box_volume *= domain.m_box_hi[dim] - domain.m_box_lo[dim];
+    }
+    cl_ulong count = (cl_ulong) std::floor(m_n_molecules * volume / box_volume);
+    cl_ulong total = 0;
+    MPI_Allreduce(&count, &total, 1, MPI_UINT64_T, MPI_SUM, domain.m_comm);
+    count += ((cl_ulong) domain.m_proc_id < m_n_molecules - total) ? 1 : 0;
+    cl_ulong first = 0;
+    MPI_Exscan(&count, &first, 1, MPI_UINT64_T, MPI_SUM, domain.m_comm);
+    if (domain.m_proc_id == 0) {
+        first = 0;
+    }
+    core_assert(count * n_sites <= capacity, "particle capacity exceeded");
+
+    /* Cell grid of the sampling region, the subdomain less the margins. */
+    cl_double lo[3], width[3];
+    cl_long n_cells[3];
+    for (int dim = 0; dim < 3; ++dim) {
+        lo[dim] = domain.m_lo[dim] + 0.5 * d;
+        width[dim] = domain.m_hi[dim] - domain.m_lo[dim] - d;
+        core_assert(width[dim] > 0.0, "subdomain too small for random packing");
+        n_cells[dim] = std::max((cl_long) std::floor(width[dim] / d), (cl_long) 1);
+    }
+    std::vector<cl_long> head(n_cells[0] * n_cells[1] * n_cells[2], -1);
+    std::vector<cl_long> next(count, -1);
+    auto cell_of = [&] (const cl_double r[3], cl_long c[3]) {
+        for (int dim = 0; dim < 3; ++dim) {
+            c[dim] = std::min((cl_long) ((r[dim] - lo[dim]) / width[dim] * n_cells[dim]),
+                n_cells[dim] - 1);
+        }
+    };
+
+    math::rng::Philox engine(Params::lattice_seed, first * n_sites, 1);
+    math::rng::uniform<cl_double> rand;
+
+    const cl_ulong max_attempts = 1000 * std::max(count, (cl_ulong) 1);
+    cl_ulong attempts = 0;
+    for (cl_ulong j = 0; j < count; ) {
+        core_assert(attempts++ < max_attempts, "random packing too dense");
+        cl_double r[3];
+        for (int dim = 0; dim < 3; ++dim) {
+            r[dim] = rand(engine, lo[dim], lo[dim] + width[dim]);
+        }
+
+        cl_long c[3];
+        cell_of(r, c);
+        bool overlap = false;
+        for (cl_long z = std::max(c[2] - 1, (cl_long) 0);
+             !overlap && z <= std::min(c[2] + 1, n_cells[2] - 1); ++z) {
+            for (cl_long y = std::max(c[1] - 1, (cl_long) 0);
+                 !overlap && y <= std::min(c[1] + 1, n_cells[1] - 1); ++y) {
+                for (cl_long x = std::max(c[0] - 1, (cl_long) 0);
+                     !overlap && x <= std::min(c[0] + 1, n_cells[0] - 1); ++x) {
+                    cl_long m = head[x + n_cells[0] * (y + n_cells[1] * z)];
+                    for (; m >= 0 && !overlap; m = next[m]) {
+                        cl_double r_sq = 0.0;
+                        for (int dim = 0; dim < 3; ++dim) {
+                            cl_double dr = r[dim] -
+                                position[m * n_sites + dim * capacity];
+                            r_sq += dr * dr;
+                        }
+                        overlap = (r_sq < d * d);
+                    }
+                }
+            }
+        }
+        if (overlap) {
+            continue;
+        }
+
+        const cl_ulong site = first + j;
+        const cl_double sign = (n_sites == 1 && site % 2 == 1) ? -1.0 : 1.0;
+        for (cl_uint k = 0; k < n_sites; ++k) {
+            const cl_ulong i = j * n_sites + k;
+            for (int dim = 0; dim < 3; ++dim) {
+                position[i + dim * capacity] =
+                    r[dim] + topology.m_site_position[3 * k + dim];
+            }
+            charge[i] = sign * topology.m_site_charge[k];
+            id[i] = site * n_sites + k;
+        }
+        cl_long &cell = head[c[0] + n_cells[0] * (c[1] + n_cells[1] * c[2])];
+        next[j] = cell;
+        cell = (cl_long) j;
+        j++;
+        engine.seek((first + j) * n_sites, 1);
+    }
+    return (cl_uint) (count * n_sites);
+}
+
+/** ---------------------------------------------------------------------------
+ * Lattice::sample_velocities
+ * @brief Draw the local velocities from the Maxwell-Boltzmann distribution
+ * of unit mass particles at the target temperature. Each particle draws from
+ * its own Philox stream, keyed by the seed and its global id at step zero,
+ * so its velocity does not depend on the number of processes or threads.
+ */
+void Lattice::sample_velocities(
+    const cl_uint n_local,
+    const cl_ulong *id,
+    const cl_uint stride,
+    cl_double *velocity) const
+{
+    const cl_double sigma = std::sqrt(Params::temperature);
+
+    core_pragma_omp(parallel for schedule(static))
+    for (cl_uint i = 0; i < n_local; ++i) {
+        math::rng::Philox engine(Params::lattice_seed, id[i], 0);
+        math::rng::gauss<cl_double> gauss;
+        for (int dim = 0; dim < 3; ++dim) {
+            velocity[i + dim * stride] = gauss(engine, 0.0, sigma);
+        }
+    }
+}
+
+/**
+ * Lattice::thermalize
+ * @brief Remove the centre of mass momentum and rescale the velocities to
+ * the target temperature, over the degrees of freedom of the thermodynamic
+ * sums. Both keep the velocities consistent with the constraints.
+ */
+void Lattice::thermalize(
+    const Domain &domain,
+    const cl_uint n_local,
+    const cl_uint n_constraints,
+    const cl_uint stride,
+    cl_double *velocity) const
+{
+    /* Remove the centre of mass momentum. */
+    cl_double momentum[4] = {0.0, 0.0, 0.0, (cl_double) n_local};
+    for (int dim = 0; dim < 3; ++dim) {
+        const cl_double *v = &velocity[dim * stride];
+        cl_double sum = 0.0;
+        core_pragma_omp(parallel for simd reduction(+:sum))
+        for (cl_uint i = 0; i < n_local; ++i) {
+            sum += v[i];
+        }
+        momentum[dim] = sum;
+    }
+    MPI_Allreduce(
+        MPI_IN_PLACE, momentum, 4, MPI_DOUBLE, MPI_SUM, domain.m_comm);
+
+    Thermo thermo = {(cl_double) n_local, (cl_double) n_constraints,
+        0.0, 0.0, 0.0, 0.0, 0.0};
+    for (int dim = 0; dim < 3; ++dim) {
+        cl_double *v = &velocity[dim * stride];
+        const cl_double v_com = momentum[dim] / std::max(momentum[3], 1.0);
+        cl_double sum = 0.0;
+        core_pragma_omp(parallel for simd reduction(+:sum))
+        for (cl_uint i = 0; i < n_local; ++i) {
+            v[i] -= v_com;
+            sum += v[i] * v[i];
+        }
+        thermo.kinetic_energy += 0.5 * sum;
+    }
+    thermo.reduce(domain.m_comm);
+
+    /* Rescale to the target temperature. */
+    const cl_double temperature = thermo.temperature();
+    const cl_double scale = (temperature > 0.0)
+        ? std::sqrt(Params::temperature / temperature) : 1.0;
+    for (int dim = 0; dim < 3; ++dim) {
+        cl_double *v = &velocity[dim * stride];
+        core_pragma_omp(parallel for simd)
+        for (cl_uint i = 0; i < n_local; ++i) {
+            v[i] *= scale;
+        }
+    }
+}
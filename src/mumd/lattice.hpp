@@ -0,0 +1,81 @@
+/*
+ * lattice.hpp
+ *
+ * Copyright (c) 2020 Carlos Braga
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the MIT License.
+ *
+ * See accompanying LICENSE.md or https://opensource.org/licenses/MIT.
+ */
+
+#ifndef LATTICE_H_
+#define LATTICE_H_
+
+#include "base.hpp"
+#include "domain.hpp"
+#include "topology.hpp"
+
+/**
+ * Lattice
+ * @brief Parallel generator of the initial state. Each process builds only
+ * the molecules of its subdomain, directly in the particle store, so no
+ * process ever holds the whole system.
+ *
+ * The molecules are placed on the sites of a simple, body-centred or
+ * face-centred cubic lattice of n_lattice^3 cells, or at random at least
+ * random_distance apart. Lattice sites are enumerated over the cells that
+ * overlap the subdomain, one layer of cells per thread. The random packing
+ * draws the share of the subdomain volume of each process, kept half the
+ * distance away from the subdomain faces so no two processes place
+ * overlapping molecules.
+ *
+ * Velocities are drawn from the Maxwell-Boltzmann distribution, each
+ * particle from its own Philox4x32-10 counter-based stream keyed by the
+ * seed and its global id, so a lattice state does not depend on the number
+ * of processes or threads. The random packing draws the candidates of each
+ * molecule from the stream of its first site at step one, but the share of
+ * each process still follows the decomposition. The centre of mass
+ * momentum is then removed and the velocities are rescaled to the target
+ * temperature.
+ */
+struct Lattice {
+    /* ---- Unit cell basis and number of molecules ------------------------ */
+    cl_uint m_n_basis;
+    cl_double m_basis[4][3];
+    cl_ulong m_n_molecules;
+
+    /* ---- Lattice member functions --------------------------------------- */
+    cl_uint generate(
+        const Domain &domain,
+        const Topology &topology,
+        const cl_uint capacity,
+        cl_double *position,
+        cl_double *charge,
+        cl_ulong *id) const;
+    cl_uint generate_random(
+        const Domain &domain,
+        const Topology &topology,
+        const cl_uint capacity,
+        cl_double *position,
+        cl_double *charge,
+        cl_ulong *id) const;
+    void sample_velocities(
+        const cl_uint n_local,
+        const cl_ulong *id,
+        const cl_uint stride,
+        cl_double *velocity) const;
+    void thermalize(
+        const Domain &domain,
+        const cl_uint n_local,
+        const cl_uint n_constraints,
+        const cl_uint stride,
+        cl_double *velocity) const;
+
+    Lattice();
+    ~Lattice() = default;
+    Lattice(const Lattice &) = delete;
+    Lattice &operator=(const Lattice &) = delete;
+};
+
+#endif /* LATTICE_H_ */
@@ -0,0 +1,77 @@
+/*
+ * main.cpp
+ *
+ * Copyright (c) 2020 Carlos Braga
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the MIT License.
+ *
+ * See accompanying LICENSE.md or https://opensource.org/licenses/MIT.
+ */
+
+#include "model.hpp"
+#include "mpi.h"
+using namespace atto;
+
+/**
+ * main test client
+ */
+int main(int argc, char *argv[])
+{
+   /*
+    * Initialize MPI context.
+    */
+    MPI_Init(&argc, &argv);
+
+   /*
+    * Execute the model. The model owns the cartesian communicator, so it
+    * must be destroyed before the MPI context is finalized.
+    */
+    {
+        Model model(MPI_COMM_WORLD);
+        auto report = [&model] () {
+            if (!model.observe() || !model.m_domain.is_master()) {
+                return;
+            }
+            std::cout << core::str_format(
+                "step %lu of %lu, "
+                "n_particles %lu, "
+                "ekin %.15lf, "
+                "epot %.15lf, "
+                "etot %.15lf, "
+                "temp %.6lf, "
+                "press %.6lf\n",
+                model.m_data.sample_step,
+                Params::n_steps,
+                model.m_data.n_particles,
+                model.m_data.kinetic_energy,
+                model.m_data.potential_energy,
+                model.m_data.kinetic_energy +
+                model.m_data.potential_energy,
+                model.m_data.temperature,
+                model.m_data.pressure);
+        };
+
+        /*
+         * Samples are read back asynchronously and reported one sampling
+         * interval later, so the host never waits for the device to drain.
+         */
+        for (cl_ulong step = 0; step <= Params::n_steps; ++step) {
+            if (step % Params::n_sample_steps == 0) {
+                report();
+                model.sample();
+            }
+            if (step < Params::n_steps) {
+                model.execute();
+            }
+        }
+        report();
+    }
+
+    /*
+     * Finalize MPI context.
+     */
+    MPI_Finalize();
+
+    exit(EXIT_SUCCESS);
+}
@@ -0,0 +1,2277 @@
+/*
+ * model.cpp
+ *
+ * Copyright (c) 2020 Carlos Braga
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the MIT License.
+ *
+ * See accompanying LICENSE.md or https://opensource.org/licenses/MIT.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <string>
+#include "model.hpp"
+#include "balance.hpp"
+#include "config.hpp"
+#include "constraints.hpp"
+#include "lattice.hpp"
+using namespace atto;
+
+/** ---------------------------------------------------------------------------
+ * Model::Model
+ * @brief Create OpenCL context and associated objects.
+ */
+Model::Model(MPI_Comm comm)
+    : m_domain(comm, Params::box_lo, Params::box_hi)
+    , m_bonded(m_topology)
+    , m_pme(m_domain)
+    , m_trajectory(m_domain)
+    , m_rdf(m_domain)
+    , m_transport(m_domain)
+{
+    /*
+     * Setup OpenCL program.
+     */
+    {
+        /*
+         * Create a context with two command queues on the specified device.
+         * The halo queue packs and unpacks the ghost messages while the
+         * compute queue runs the interior forces. Profiling is enabled to
+         * measure the device work for the load balancer.
+         */
+        m_context = cl::Context::create(CL_DEVICE_TYPE_GPU);
+        m_device = cl::Context::get_device(m_context, Params::device_index);
+        m_queue = cl::Queue::create(
+            m_context, m_device, CL_QUEUE_PROFILING_ENABLE);
+        m_halo_queue = cl::Queue::create(
+            m_context, m_device, CL_QUEUE_PROFILING_ENABLE);
+        if (m_domain.is_master()) {
+            std::cout << cl::Device::get_info_string(m_device) << "\n";
+            std::cout << "host simd: " << core::cpu_features_str() << "\n";
+        }
+
+        /*
+         * Create the program object. The pair potential and the precision
+         * policy are selected when the program is built.
+         */
+        std::string options;
+        if (Params::pair_potential == Params::PairTabulated) {
+            options += " -DPAIR_TABULATED";
+        }
+        if (Params::precision == Params::PrecisionMixed) {
+            options += " -DPRECISION_MIXED";
+        }
+        m_program = cl::Program::create_from_file(m_context, "data/mumd.cl");
+        cl::Program::build(m_program, m_device, options);
+    }
+
+    /*
+     * Setup Model data.
+     */
+    {
+        m_data.capacity = Params::max_particles;
+        m_data.n_local = 0;
+        m_data.n_ghost = 0;
+        m_data.position.resize(3 * m_data.capacity, 0.0);
+        m_data.velocity.resize(3 * m_data.capacity, 0.0);
+        m_data.force.resize(3 * m_data.capacity, 0.0);
+        m_data.force_slow.resize(3 * m_data.capacity, 0.0);
+        m_data.force_bonded.resize(3 * m_data.capacity, 0.0);
+        m_data.energy.resize(m_data.capacity, 0.0);
+        m_data.virial.resize(m_data.capacity, 0.0);
+        m_data.charge.resize(m_data.capacity, 0.0);
+        m_data.id.resize(m_data.capacity, 0);
+        m_data.halo_count.resize(2, 0);
+        m_data.migrate_count.resize(5, 0);
+
+        for (int dim = 0; dim < 3; ++dim) {
+            m_data.lo.s[dim] = m_domain.m_lo[dim];
+            m_data.hi.s[dim] = m_domain.m_hi[dim];
+        }
+        m_data.lo.s[3] = m_data.hi.s[3] = 0.0;
+        m_data.n_cell_total = 0;
+        m_data.cell_overflow = 0;
+        m_data.index_mask = 0;
+        m_data.n_clusters = 0;
+        m_data.constraint_error = 0;
+
+        m_data.step = 0;
+        m_data.n_particles = 0;
+        m_data.kinetic_energy = 0.0;
+        m_data.potential_energy = 0.0;
+        m_data.temperature = 0.0;
+        m_data.pressure = 0.0;
+        m_data.pme_energy = 0.0;
+        m_data.pme_virial = 0.0;
+        m_data.bonded_energy = 0.0;
+        m_data.bonded_virial = 0.0;
+
+        m_data.observables.resize(Thermo::NumPartials * cl::NDRange::Roundup(
+            m_data.capacity, Params::work_group_size) / Params::work_group_size);
+        m_data.control.resize(m_data.observables.size());
+        m_data.sample_event = NULL;
+        m_data.sample_step = 0;
+        m_data.sample_n_local = 0;
+        m_data.sample_pme_energy = 0.0;
+        m_data.sample_pme_virial = 0.0;
+        m_data.sample_bonded_energy = 0.0;
+        m_data.sample_bonded_virial = 0.0;
+        m_data.sample_volume = 0.0;
+
+        if (Trajectory::is_active() && !Params::trajectory_mapped) {
+            m_data.frame.resize(7 * m_data.capacity, 0.0);
+        }
+        m_data.frame_map = NULL;
+        m_data.frame_event = NULL;
+        m_data.frame_step = 0;
+        m_data.frame_n_local = 0;
+
+        if (Transport::is_active()) {
+            m_data.transport.resize(7 * m_data.capacity, 0.0);
+        }
+        m_data.transport_event = NULL;
+        m_data.transport_n_local = 0;
+
+        /*
+         * Generate the molecules of the subdomain, see lattice.hpp, or read
+         * the atoms of the subdomain from the configuration file. Charges
+         * missing in the file alternate in sign with the particle id. The
+         * initial velocities are made consistent with the constraints on
+         * the host, and unless read from the file, the centre of mass
+         * momentum is removed and the target temperature is set.
+         */
+        const cl_uint stride = m_data.capacity;
+        const cl_uint n_sites = m_topology.m_n_sites;
+        Lattice lattice;
+        bool thermalize = true;
+
+        if (Params::config_file[0] != '\0') {
+            core_assert(n_sites == 1, "configuration files hold atoms only");
+            Configuration config(Params::config_file);
+            m_data.n_local = config.read(
+                m_domain,
+                m_data.capacity,
+                &m_data.position[0],
+                &m_data.velocity[0],
+                &m_data.charge[0],
+                &m_data.id[0]);
+            m_data.n_particles = config.m_n_particles;
+            if (!config.m_has_charge) {
+                for (cl_uint i = 0; i < m_data.n_local; ++i) {
+                    m_data.charge[i] = (m_data.id[i] % 2 == 1 ? -1.0 : 1.0) *
+                        m_topology.m_site_charge[0];
+                }
+            }
+            thermalize = !config.m_has_velocity;
+        } else {
+            m_data.n_local = lattice.generate(
+                m_domain,
+                m_topology,
+                m_data.capacity,
+                &m_data.position[0],
+                &m_data.charge[0],
+                &m_data.id[0]);
+            m_data.n_particles = lattice.m_n_molecules * n_sites;
+        }
+        if (thermalize) {
+            lattice.sample_velocities(
+                m_data.n_local, &m_data.id[0], stride, &m_data.velocity[0]);
+        }
+
+        /*
+         * Constrain the initial positions to the constraint lengths, with
+         * the lattice positions as their own reference, and remove the
+         * velocity components along the constraints. The velocity
+         * correction of the position solver belongs to no step, and is
+         * discarded with the virials of both solvers.
+         */
+        std::vector<cl_uint> cluster(m_data.n_local);
+        std::iota(cluster.begin(), cluster.end(), 0);
+        std::vector<cl_double> virial(m_data.capacity, 0.0);
+        {
+            std::vector<cl_double> position_ref(m_data.position);
+            std::vector<cl_double> velocity_ref(m_data.velocity);
+            Constraints::shake(
+                m_topology,
+                cluster,
+                position_ref,
+                m_data.position,
+                velocity_ref,
+                stride,
+                Params::time_step,
+                virial);
+        }
+        Constraints::rattle(
+            m_topology,
+            cluster,
+            m_data.position,
+            m_data.velocity,
+            stride,
+            Params::time_step,
+            virial);
+
+        if (thermalize) {
+            lattice.thermalize(
+                m_domain,
+                m_data.n_local,
+                (m_data.n_local / n_sites) * m_topology.n_constraints(),
+                stride,
+                &m_data.velocity[0]);
+        }
+
+        /* Find the species of the radial distribution function. */
+        if (Rdf::is_active()) {
+            m_rdf.setup(m_topology, m_data.n_local, &m_data.charge[0]);
+        }
+
+        /* Assign the particle ids owned by the transport correlator. */
+        if (Transport::is_active()) {
+            m_transport.setup(m_data.n_particles);
+        }
+    }
+
+    /*
+     * Setup Model kernel data.
+     */
+    {
+        /*
+         * Create the integration, force, halo, migration, reorder and
+         * constraint kernels.
+         */
+        m_kernels.resize(NumKernels, NULL);
+        m_kernels[KernelIntegratePosition] = cl::Kernel::create(m_program, "integrate_position");
+        m_kernels[KernelIntegrateVelocity] = cl::Kernel::create(m_program, "integrate_velocity");
+        m_kernels[KernelForcesInterior] = cl::Kernel::create(m_program, "forces_interior");
+        m_kernels[KernelForcesBoundary] = cl::Kernel::create(m_program, "forces_boundary");
+        m_kernels[KernelForcesAccumulate] = cl::Kernel::create(m_program, "forces_accumulate");
+        m_kernels[KernelReduceObservables] = cl::Kernel::create(m_program, "reduce_observables");
+        m_kernels[KernelHaloPackLocal] = cl::Kernel::create(m_program, "halo_pack_local");
+        m_kernels[KernelHaloPackGhost] = cl::Kernel::create(m_program, "halo_pack_ghost");
+        m_kernels[KernelMigrateFlag] = cl::Kernel::create(m_program, "migrate_flag");
+        m_kernels[KernelMigrateCompact] = cl::Kernel::create(m_program, "migrate_compact");
+        m_kernels[KernelMigrateMove] = cl::Kernel::create(m_program, "migrate_move");
+        m_kernels[KernelMigrateUnpack] = cl::Kernel::create(m_program, "migrate_unpack");
+        m_kernels[KernelCellBinLocal] = cl::Kernel::create(m_program, "cell_bin_local");
+        m_kernels[KernelCellBinGhost] = cl::Kernel::create(m_program, "cell_bin_ghost");
+        m_kernels[KernelReorderKeys] = cl::Kernel::create(m_program, "reorder_keys");
+        m_kernels[KernelReorderSort] = cl::Kernel::create(m_program, "reorder_sort");
+        m_kernels[KernelReorderGather] = cl::Kernel::create(m_program, "reorder_gather");
+        m_kernels[KernelClusterMap] = cl::Kernel::create(m_program, "cluster_map");
+        m_kernels[KernelClusterBuild] = cl::Kernel::create(m_program, "cluster_build");
+        m_kernels[KernelConstrainPosition] = cl::Kernel::create(m_program, "constrain_position");
+        m_kernels[KernelConstrainVelocity] = cl::Kernel::create(m_program, "constrain_velocity");
+        m_kernels[KernelSettlePosition] = cl::Kernel::create(m_program, "settle_position");
+        m_kernels[KernelSettleVelocity] = cl::Kernel::create(m_program, "settle_velocity");
+        m_kernels[KernelRdfAccumulate] = cl::Kernel::create(m_program, "rdf_accumulate");
+
+        /*
+         * Create the pair table image, read through a sampler with integer
+         * coordinates and no filtering, so each texel is fetched exactly.
+         * The 1d image width is bounded by the device 2d image width.
+         */
+        const size_t max_image_width = cl::Device::get_info_size(
+            m_device, CL_DEVICE_IMAGE2D_MAX_WIDTH);
+        core_assert(m_pair_table.image_width() <= max_image_width,
+            "pair table of " + std::to_string(m_pair_table.m_n_segments) +
+            " segments exceeds the device image width of " +
+            std::to_string(max_image_width) + " texels, use a coarser table");
+        m_images.resize(NumImages, NULL);
+        m_images[ImagePairTable] = cl::Memory::create_image1d(
+            m_context,
+            CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR,
+            m_pair_table.image_format(),
+            m_pair_table.image_width(),
+            (void *) m_pair_table.m_coeff);
+        m_pair_sampler = cl::Sampler::create(
+            m_context,
+            CL_FALSE,
+            CL_ADDRESS_CLAMP_TO_EDGE,
+            CL_FILTER_NEAREST);
+
+        /* Create memory buffers. */
+        m_buffers.resize(NumBuffers, NULL);
+        m_buffers[BufferPosition] = cl::Memory::create_buffer(
+            m_context,
+            CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR,
+            m_data.position.size() * sizeof(m_data.position[0]),
+            (void *) &m_data.position[0]);
+        m_buffers[BufferVelocity] = cl::Memory::create_buffer(
+            m_context,
+            CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR,
+            m_data.velocity.size() * sizeof(m_data.velocity[0]),
+            (void *) &m_data.velocity[0]);
+        m_buffers[BufferForce] = cl::Memory::create_buffer(
+            m_context,
+            CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR,
+            m_data.force.size() * sizeof(m_data.force[0]),
+            (void *) &m_data.force[0]);
+        m_buffers[BufferForceSlow] = cl::Memory::create_buffer(
+            m_context,
+            CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR,
+            m_data.force_slow.size() * sizeof(m_data.force_slow[0]),
+            (void *) &m_data.force_slow[0]);
+        m_buffers[BufferForceBonded] = cl::Memory::create_buffer(
+            m_context,
+            CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR,
+            m_data.force_bonded.size() * sizeof(m_data.force_bonded[0]),
+            (void *) &m_data.force_bonded[0]);
+        m_buffers[BufferEnergy] = cl::Memory::create_buffer(
+            m_context,
+            CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR,
+            m_data.energy.size() * sizeof(m_data.energy[0]),
+            (void *) &m_data.energy[0]);
+        m_buffers[BufferVirial] = cl::Memory::create_buffer(
+            m_context,
+            CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR,
+            m_data.virial.size() * sizeof(m_data.virial[0]),
+            (void *) &m_data.virial[0]);
+        m_buffers[BufferCharge] = cl::Memory::create_buffer(
+            m_context,
+            CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR,
+            m_data.charge.size() * sizeof(m_data.charge[0]),
+            (void *) &m_data.charge[0]);
+        m_buffers[BufferId] = cl::Memory::create_buffer(
+            m_context,
+            CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR,
+            m_data.id.size() * sizeof(m_data.id[0]),
+            (void *) &m_data.id[0]);
+        m_buffers[BufferGhost] = cl::Memory::create_buffer(
+            m_context,
+            CL_MEM_READ_WRITE,
+            4 * Params::max_ghost * sizeof(cl_double),
+            (void *) NULL);
+        m_buffers[BufferHaloSend] = cl::Memory::create_buffer(
+            m_context,
+            CL_MEM_READ_WRITE,
+            2 * 4 * Params::max_halo * sizeof(cl_double),
+            (void *) NULL);
+        m_buffers[BufferHaloCount] = cl::Memory::create_buffer(
+            m_context,
+            CL_MEM_READ_WRITE,
+            m_data.halo_count.size() * sizeof(m_data.halo_count[0]),
+            (void *) NULL);
+        m_buffers[BufferMigrateFlag] = cl::Memory::create_buffer(
+            m_context,
+            CL_MEM_READ_WRITE,
+            m_data.capacity * sizeof(cl_uint),
+            (void *) NULL);
+        m_buffers[BufferMigrateSend] = cl::Memory::create_buffer(
+            m_context,
+            CL_MEM_READ_WRITE,
+            2 * Params::max_migrate * Params::migrate_record_size * sizeof(cl_double),
+            (void *) NULL);
+        m_buffers[BufferMigrateRecv] = cl::Memory::create_buffer(
+            m_context,
+            CL_MEM_READ_WRITE,
+            2 * Params::max_migrate * Params::migrate_record_size * sizeof(cl_double),
+            (void *) NULL);
+        m_buffers[BufferMigrateIndex] = cl::Memory::create_buffer(
+            m_context,
+            CL_MEM_READ_WRITE,
+            2 * 2 * Params::max_migrate * sizeof(cl_uint),
+            (void *) NULL);
+        m_buffers[BufferMigrateCount] = cl::Memory::create_buffer(
+            m_context,
+            CL_MEM_READ_WRITE,
+            m_data.migrate_count.size() * sizeof(m_data.migrate_count[0]),
+            (void *) NULL);
+        m_buffers[BufferCellOverflow] = cl::Memory::create_buffer(
+            m_context,
+            CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR,
+            sizeof(m_data.cell_overflow),
+            (void *) &m_data.cell_overflow);
+        m_buffers[BufferObservables] = cl::Memory::create_buffer(
+            m_context,
+            CL_MEM_READ_WRITE,
+            m_data.observables.size() * sizeof(m_data.observables[0]),
+            (void *) NULL);
+        m_buffers[BufferSortKey] = cl::Memory::create_buffer(
+            m_context,
+            CL_MEM_READ_WRITE,
+            cl::NDRange::Roundup(m_data.capacity, Params::work_group_size) * sizeof(cl_ulong),
+            (void *) NULL);
+        m_buffers[BufferScratch] = cl::Memory::create_buffer(
+            m_context,
+            CL_MEM_READ_WRITE,
+            3 * m_data.capacity * sizeof(cl_ulong),
+            (void *) NULL);
+        m_buffers[BufferConstraintError] = cl::Memory::create_buffer(
+            m_context,
+            CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR,
+            sizeof(m_data.constraint_error),
+            (void *) &m_data.constraint_error);
+        m_buffers[BufferConstraintVirial] = cl::Memory::create_buffer(
+            m_context,
+            CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR,
+            m_data.virial.size() * sizeof(m_data.virial[0]),
+            (void *) &m_data.virial[0]);
+
+        /*
+         * Create the trajectory staging buffer in host accessible memory,
+         * mapped for reading after the frame is copied on the device.
+         */
+        if (Trajectory::is_active() && Params::trajectory_mapped) {
+            m_buffers[BufferFrame] = cl::Memory::create_buffer(
+                m_context,
+                CL_MEM_READ_WRITE | CL_MEM_ALLOC_HOST_PTR,
+                7 * m_data.capacity * sizeof(cl_double),
+                (void *) NULL);
+        }
+
+        /* Create the radial distribution function histogram, zeroed. */
+        if (Rdf::is_active()) {
+            m_buffers[BufferRdfHistogram] = cl::Memory::create_buffer(
+                m_context,
+                CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR,
+                m_rdf.m_histogram.size() * sizeof(cl_ulong),
+                (void *) &m_rdf.m_histogram[0]);
+        }
+
+        /*
+         * Create the molecule buffers, the local index map of the particle
+         * ids and the cluster list, and the constraint buffers. The local
+         * index map is a hash table sized to the particle store, at most
+         * half full, so it does not grow with the global particle count.
+         */
+        if (m_topology.m_n_sites > 1) {
+            cl_uint n_slots = 1;
+            while (n_slots < 2 * m_data.capacity) {
+                n_slots <<= 1;
+            }
+            m_data.index_mask = n_slots - 1;
+            m_buffers[BufferLocalIndex] = cl::Memory::create_buffer(
+                m_context,
+                CL_MEM_READ_WRITE,
+                n_slots * sizeof(cl_uint),
+                (void *) NULL);
+            m_buffers[BufferCluster] = cl::Memory::create_buffer(
+                m_context,
+                CL_MEM_READ_WRITE,
+                m_data.capacity * sizeof(cl_uint),
+                (void *) NULL);
+            m_buffers[BufferClusterCount] = cl::Memory::create_buffer(
+                m_context,
+                CL_MEM_READ_WRITE,
+                sizeof(cl_uint),
+                (void *) NULL);
+        }
+
+        if (m_topology.has_constraints()) {
+            m_buffers[BufferPositionOld] = cl::Memory::create_buffer(
+                m_context,
+                CL_MEM_READ_WRITE,
+                m_data.position.size() * sizeof(m_data.position[0]),
+                (void *) NULL);
+            m_buffers[BufferConstraintSite] = cl::Memory::create_buffer(
+                m_context,
+                CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR,
+                m_topology.m_constraint_site.size() * sizeof(cl_uint),
+                (void *) &m_topology.m_constraint_site[0]);
+            m_buffers[BufferConstraintLength] = cl::Memory::create_buffer(
+                m_context,
+                CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR,
+                m_topology.m_constraint_length.size() * sizeof(cl_double),
+                (void *) &m_topology.m_constraint_length[0]);
+        }
+
+        /* Create the cell grid buffers and the constraint clusters. */
+        setup_cells();
+        build_clusters();
+    }
+
+    /*
+     * Compute the initial fast and slow forces.
+     */
+    compute_forces(true);
+    cl::Queue::finish(m_queue);
+}
+
+/**
+ * Model::~Model
+ * @brief Destroy the OpenCL context and associated objects.
+ */
+Model::~Model()
+{
+    /* Teardown OpenCL data. */
+    {
+        if (m_data.sample_event != NULL) {
+            cl::Event::wait_for_event(m_data.sample_event);
+            cl::Event::release(m_data.sample_event);
+        }
+        if (m_data.frame_event != NULL) {
+            cl::Event::wait_for_event(m_data.frame_event);
+            cl::Event::release(m_data.frame_event);
+        }
+        if (m_data.transport_event != NULL) {
+            cl::Event::wait_for_event(m_data.transport_event);
+            cl::Event::release(m_data.transport_event);
+        }
+        if (m_data.frame_map != NULL) {
+            cl::Queue::enqueue_unmap_mem_object(
+                m_queue, m_buffers[BufferFrame], m_data.frame_map, NULL, NULL);
+            cl::Queue::finish(m_queue);
+        }
+        m_profile.collect();
+        for (auto &it : m_images) {
+            cl::Memory::release(it);
+        }
+        cl::Sampler::release(m_pair_sampler);
+        for (auto &it : m_buffers) {
+            cl::Memory::release(it);
+        }
+        for (auto &it : m_kernels) {
+            cl::Kernel::release(it);
+        }
+        cl::Program::release(m_program);
+        cl::Queue::release(m_halo_queue);
+        cl::Queue::release(m_queue);
+        cl::Device::release(m_device);
+        cl::Context::release(m_context);
+    }
+}
+
+/** ---------------------------------------------------------------------------
+ * Model::execute
+ * @brief Advance the model by one velocity Verlet step. The particle data
+ * stays on the device and the step is enqueued without waiting for the
+ * queues. The host only blocks on the halo exchange. Migration runs every
+ * n_migrate_steps, and in between the particles may drift across the
+ * subdomain faces by up to half the skin, which the halo width covers.
+ *
+ * With a thermostat or a barostat, the scale factors computed at the end of
+ * the previous step are applied by the first half step, and the box is
+ * scaled with the positions.
+ *
+ * With constraints, the positions are constrained after the first half step,
+ * from the positions before it, and the velocities after the second.
+ *
+ * Each call is one inner step of the r-RESPA scheme. The first inner step of
+ * an outer step adds the slow force impulse to its first half step, and the
+ * last one computes the slow forces and adds their impulse to its second
+ * half step. With respa_steps = 1 this is plain velocity Verlet.
+ */
+void Model::execute(void)
+{
+    const cl_uint stride = m_data.capacity;
+    const cl_ulong num_work_items = cl::NDRange::Roundup(
+        m_data.n_local, Params::work_group_size);
+
+    /* Weights of the slow forces in the first and second half steps. */
+    const bool outer_begin = (m_data.step % Params::respa_steps == 0);
+    const bool outer_end = ((m_data.step + 1) % Params::respa_steps == 0);
+    const cl_double slow_scale_begin =
+        outer_begin ? (cl_double) Params::respa_steps : 0.0;
+    const cl_double slow_scale_end =
+        outer_end ? (cl_double) Params::respa_steps : 0.0;
+
+    /* Scale the box and the subdomains with the barostat. */
+    const cl_double velocity_scale = m_ensemble.m_velocity_scale;
+    const cl_double position_scale = m_ensemble.m_position_scale;
+    cl_double4 origin = {{
+        m_domain.m_box_lo[0], m_domain.m_box_lo[1], m_domain.m_box_lo[2], 0.0}};
+    if (position_scale != 1.0) {
+        m_domain.scale_box(position_scale);
+        for (int dim = 0; dim < 3; ++dim) {
+            m_data.lo.s[dim] = m_domain.m_lo[dim];
+            m_data.hi.s[dim] = m_domain.m_hi[dim];
+        }
+        setup_cells();
+        m_pme.set_box(m_domain.m_box_lo, m_domain.m_box_length);
+    }
+
+    /*
+     * Scale the velocities and the positions, update the velocities by half
+     * a step and the positions by a full step. The constraint solver needs
+     * the positions before the update.
+     */
+    {
+        if (m_topology.has_constraints()) {
+            for (cl_uint c = 0; c < 3; ++c) {
+                cl::Queue::enqueue_copy_buffer(
+                    m_queue,
+                    m_buffers[BufferPosition],
+                    m_buffers[BufferPositionOld],
+                    c * stride * sizeof(cl_double),
+                    c * stride * sizeof(cl_double),
+                    m_data.n_local * sizeof(cl_double),
+                    NULL,
+                    NULL);
+            }
+        }
+
+        cl_kernel &kernel = m_kernels[KernelIntegratePosition];
+        cl::Kernel::set_arg(kernel, 0, sizeof(cl_mem), &m_buffers[BufferPosition]);
+        cl::Kernel::set_arg(kernel, 1, sizeof(cl_mem), &m_buffers[BufferVelocity]);
+        cl::Kernel::set_arg(kernel, 2, sizeof(cl_mem), &m_buffers[BufferForce]);
+        cl::Kernel::set_arg(kernel, 3, sizeof(cl_mem), &m_buffers[BufferForceSlow]);
+        cl::Kernel::set_arg(kernel, 4, sizeof(cl_uint), &stride);
+        cl::Kernel::set_arg(kernel, 5, sizeof(cl_uint), &m_data.n_local);
+        cl::Kernel::set_arg(kernel, 6, sizeof(cl_double), &Params::time_step);
+        cl::Kernel::set_arg(kernel, 7, sizeof(cl_double), &slow_scale_begin);
+        cl::Kernel::set_arg(kernel, 8, sizeof(cl_double), &velocity_scale);
+        cl::Kernel::set_arg(kernel, 9, sizeof(cl_double), &position_scale);
+        cl::Kernel::set_arg(kernel, 10, sizeof(cl_double4), &origin);
+
+        cl::Queue::enqueue_nd_range_kernel(
+            m_queue,
+            kernel,
+            cl::NDRange::Null,                      /* global work offset */
+            cl::NDRange(num_work_items),            /* global work size */
+            cl::NDRange(Params::work_group_size),   /* local work size */
+            NULL,
+            NULL);
+    }
+
+    /* Constrain the new positions. */
+    if (m_topology.has_constraints()) {
+        constrain_position();
+    }
+
+    /* Move the particles that left the subdomain to the neighbours. */
+    if (m_data.step % Params::n_migrate_steps == 0) {
+        migrate(0.5 * Params::skin);
+    }
+
+    /* Rebalance the subdomains before the forces are computed. */
+    if (m_data.step > 0 && m_data.step % Params::n_balance_steps == 0) {
+        balance();
+    }
+
+    /* Compute the forces at the new positions, the slow ones at the end. */
+    compute_forces(outer_end);
+
+    /* Accumulate the radial distribution function at the new positions. */
+    if (Rdf::is_active() && (m_data.step + 1) % Params::n_rdf_steps == 0) {
+        accumulate_rdf();
+    }
+
+    /* Update the velocities by the remaining half step. */
+    {
+        const cl_ulong num_work_items = cl::NDRange::Roundup(
+            m_data.n_local, Params::work_group_size);
+
+        cl_kernel &kernel = m_kernels[KernelIntegrateVelocity];
+        cl::Kernel::set_arg(kernel, 0, sizeof(cl_mem), &m_buffers[BufferVelocity]);
+        cl::Kernel::set_arg(kernel, 1, sizeof(cl_mem), &m_buffers[BufferForce]);
+        cl::Kernel::set_arg(kernel, 2, sizeof(cl_mem), &m_buffers[BufferForceSlow]);
+        cl::Kernel::set_arg(kernel, 3, sizeof(cl_uint), &stride);
+        cl::Kernel::set_arg(kernel, 4, sizeof(cl_uint), &m_data.n_local);
+        cl::Kernel::set_arg(kernel, 5, sizeof(cl_double), &Params::time_step);
+        cl::Kernel::set_arg(kernel, 6, sizeof(cl_double), &slow_scale_end);
+
+        cl::Queue::enqueue_nd_range_kernel(
+            m_queue,
+            kernel,
+            cl::NDRange::Null,                      /* global work offset */
+            cl::NDRange(num_work_items),            /* global work size */
+            cl::NDRange(Params::work_group_size),   /* local work size */
+            NULL,
+            NULL);
+    }
+
+    /* Remove the velocity components along the constraints. */
+    if (m_topology.has_constraints()) {
+        constrain_velocity();
+    }
+
+    /* Correlate the last transport sample and read back the next one. */
+    if (Transport::is_active() &&
+        (m_data.step + 1) % Params::n_transport_steps == 0) {
+        sample_transport();
+    }
+
+    /* Compute the thermostat and barostat scale factors of the next step. */
+    if (Ensemble::is_active()) {
+        control();
+    }
+
+    m_data.step++;
+
+    /* Restore the spatial locality of the particle store. */
+    if (m_data.step % Params::n_reorder_steps == 0) {
+        reorder();
+    }
+}
+
+/** ---------------------------------------------------------------------------
+ * Model::migrate
+ * @brief Move the particles that left the subdomain to the neighbouring
+ * processes, in three stages, one per dimension, so particles crossing an
+ * edge or a corner are forwarded along the remaining dimensions.
+ *
+ * Each stage flags the outgoing particles on the device and packs all their
+ * fields into one contiguous message per neighbour. The store is compacted
+ * in place by moving the particles above the new end into the holes left
+ * behind, and the received records are appended at the end. Particles that
+ * drifted further than drift from the subdomain were missed by the halo
+ * exchange, and migration stops with an error. Molecules move whole with
+ * their first site, and the constraint clusters are rebuilt at the end.
+ * Return the number of particles sent by this process.
+ */
+cl_uint Model::migrate(const cl_double drift)
+{
+    cl_uint n_moved = 0;
+    const cl_uint stride = m_data.capacity;
+    const cl_uint max_migrate = Params::max_migrate;
+    const cl_uint max_index = 2 * Params::max_migrate;
+    const size_t record_size = Params::migrate_record_size * sizeof(cl_double);
+
+    for (cl_uint dim = 0; dim < 3; ++dim) {
+        cl_double lo = m_domain.m_lo[dim];
+        cl_double hi = m_domain.m_hi[dim];
+        cl_double shift_lo = m_domain.shift(dim, 0);
+        cl_double shift_hi = m_domain.shift(dim, 1);
+
+        /* Reset the message and compaction counters. */
+        const cl_uint zero = 0;
+        cl::Queue::enqueue_fill_buffer(
+            m_queue,
+            m_buffers[BufferMigrateCount],
+            &zero,
+            sizeof(zero),
+            0,
+            m_data.migrate_count.size() * sizeof(m_data.migrate_count[0]),
+            NULL,
+            NULL);
+
+        /* Flag and pack the outgoing particles with their molecules. */
+        map_local_index();
+        {
+            const cl_ulong num_work_items = cl::NDRange::Roundup(
+                m_data.n_local, Params::work_group_size);
+
+            cl_kernel &kernel = m_kernels[KernelMigrateFlag];
+            cl::Kernel::set_arg(kernel, 0, sizeof(cl_mem), &m_buffers[BufferPosition]);
+            cl::Kernel::set_arg(kernel, 1, sizeof(cl_mem), &m_buffers[BufferVelocity]);
+            cl::Kernel::set_arg(kernel, 2, sizeof(cl_mem), &m_buffers[BufferCharge]);
+            cl::Kernel::set_arg(kernel, 3, sizeof(cl_mem), &m_buffers[BufferId]);
+            cl::Kernel::set_arg(kernel, 4, sizeof(cl_mem), &m_buffers[BufferConstraintVirial]);
+            cl::Kernel::set_arg(kernel, 5, sizeof(cl_mem), &m_buffers[BufferLocalIndex]);
+            cl::Kernel::set_arg(kernel, 6, sizeof(cl_uint), &m_data.index_mask);
+            cl::Kernel::set_arg(kernel, 7, sizeof(cl_uint), &m_topology.m_n_sites);
+            cl::Kernel::set_arg(kernel, 8, sizeof(cl_uint), &stride);
+            cl::Kernel::set_arg(kernel, 9, sizeof(cl_uint), &m_data.n_local);
+            cl::Kernel::set_arg(kernel, 10, sizeof(cl_uint), &dim);
+            cl::Kernel::set_arg(kernel, 11, sizeof(cl_double), &lo);
+            cl::Kernel::set_arg(kernel, 12, sizeof(cl_double), &hi);
+            cl::Kernel::set_arg(kernel, 13, sizeof(cl_double), &shift_lo);
+            cl::Kernel::set_arg(kernel, 14, sizeof(cl_double), &shift_hi);
+            cl::Kernel::set_arg(kernel, 15, sizeof(cl_double), &drift);
+            cl::Kernel::set_arg(kernel, 16, sizeof(cl_mem), &m_buffers[BufferMigrateFlag]);
+            cl::Kernel::set_arg(kernel, 17, sizeof(cl_mem), &m_buffers[BufferMigrateSend]);
+            cl::Kernel::set_arg(kernel, 18, sizeof(cl_mem), &m_buffers[BufferMigrateCount]);
+            cl::Kernel::set_arg(kernel, 19, sizeof(cl_uint), &max_migrate);
+
+            cl::Queue::enqueue_nd_range_kernel(
+                m_queue,
+                kernel,
+                cl::NDRange::Null,                      /* global work offset */
+                cl::NDRange(num_work_items),            /* global work size */
+                cl::NDRange(Params::work_group_size),   /* local work size */
+                NULL,
+                NULL);
+        }
+
+        /* Read the message sizes and the packed messages. */
+        cl::Queue::enqueue_read_buffer(
+            m_queue,
+            m_buffers[BufferMigrateCount],
+            CL_TRUE,
+            0,
+            m_data.migrate_count.size() * sizeof(m_data.migrate_count[0]),
+            (void *) &m_data.migrate_count[0],
+            NULL,
+            NULL);
+        core_assert(m_data.migrate_count[4] == 0,
+            "particle drift exceeds the halo skin");
+
+        for (int side = 0; side < 2; ++side) {
+            core_assert(m_data.migrate_count[side] <= Params::max_migrate,
+                "migration message capacity exceeded");
+            m_data.migrate_send[side].resize(
+                m_data.migrate_count[side] * record_size);
+            if (m_data.migrate_count[side] == 0) {
+                continue;
+            }
+            cl::Queue::enqueue_read_buffer(
+                m_queue,
+                m_buffers[BufferMigrateSend],
+                CL_FALSE,
+                side * Params::max_migrate * record_size,
+                m_data.migrate_send[side].size(),
+                (void *) &m_data.migrate_send[side][0],
+                NULL,
+                NULL);
+        }
+
+        /* Compact the particle store in place. */
+        cl_uint n_send = m_data.migrate_count[0] + m_data.migrate_count[1];
+        cl_uint n_stay = m_data.n_local - n_send;
+        if (n_send > 0) {
+            const cl_ulong num_work_items = cl::NDRange::Roundup(
+                m_data.n_local, Params::work_group_size);
+
+            cl_kernel &kernel = m_kernels[KernelMigrateCompact];
+            cl::Kernel::set_arg(kernel, 0, sizeof(cl_mem), &m_buffers[BufferMigrateFlag]);
+            cl::Kernel::set_arg(kernel, 1, sizeof(cl_uint), &m_data.n_local);
+            cl::Kernel::set_arg(kernel, 2, sizeof(cl_uint), &n_stay);
+            cl::Kernel::set_arg(kernel, 3, sizeof(cl_mem), &m_buffers[BufferMigrateIndex]);
+            cl::Kernel::set_arg(kernel, 4, sizeof(cl_mem), &m_buffers[BufferMigrateCount]);
+            cl::Kernel::set_arg(kernel, 5, sizeof(cl_uint), &max_index);
+
+            cl::Queue::enqueue_nd_range_kernel(
+                m_queue,
+                kernel,
+                cl::NDRange::Null,                      /* global work offset */
+                cl::NDRange(num_work_items),            /* global work size */
+                cl::NDRange(Params::work_group_size),   /* local work size */
+                NULL,
+                NULL);
+
+            cl::Queue::enqueue_read_buffer(
+                m_queue,
+                m_buffers[BufferMigrateCount],
+                CL_TRUE,
+                0,
+                m_data.migrate_count.size() * sizeof(m_data.migrate_count[0]),
+                (void *) &m_data.migrate_count[0],
+                NULL,
+                NULL);
+            core_assert(m_data.migrate_count[2] == m_data.migrate_count[3],
+                "inconsistent migration holes and movers");
+        }
+
+        cl_uint n_moves = (n_send > 0) ? m_data.migrate_count[3] : 0;
+        if (n_moves > 0) {
+            const cl_ulong num_work_items = cl::NDRange::Roundup(
+                n_moves, Params::work_group_size);
+
+            cl_kernel &kernel = m_kernels[KernelMigrateMove];
+            cl::Kernel::set_arg(kernel, 0, sizeof(cl_mem), &m_buffers[BufferPosition]);
+            cl::Kernel::set_arg(kernel, 1, sizeof(cl_mem), &m_buffers[BufferVelocity]);
+            cl::Kernel::set_arg(kernel, 2, sizeof(cl_mem), &m_buffers[BufferCharge]);
+            cl::Kernel::set_arg(kernel, 3, sizeof(cl_mem), &m_buffers[BufferId]);
+            cl::Kernel::set_arg(kernel, 4, sizeof(cl_mem), &m_buffers[BufferConstraintVirial]);
+            cl::Kernel::set_arg(kernel, 5, sizeof(cl_uint), &stride);
+            cl::Kernel::set_arg(kernel, 6, sizeof(cl_mem), &m_buffers[BufferMigrateIndex]);
+            cl::Kernel::set_arg(kernel, 7, sizeof(cl_uint), &n_moves);
+            cl::Kernel::set_arg(kernel, 8, sizeof(cl_uint), &max_index);
+
+            cl::Queue::enqueue_nd_range_kernel(
+                m_queue,
+                kernel,
+                cl::NDRange::Null,                      /* global work offset */
+                cl::NDRange(num_work_items),            /* global work size */
+                cl::NDRange(Params::work_group_size),   /* local work size */
+                NULL,
+                NULL);
+        }
+        cl::Queue::finish(m_queue);
+
+        /* Exchange the messages with the lo and hi neighbours. */
+        m_domain.exchange(dim, m_data.migrate_send, m_data.migrate_recv);
+
+        /*
+         * Append the received records to the particle store. The receive
+         * buffers remain untouched until the next stage has read back its
+         * message sizes, so the writes can be non-blocking.
+         */
+        cl_uint n_recv = 0;
+        for (int side = 0; side < 2; ++side) {
+            if (m_data.migrate_recv[side].empty()) {
+                continue;
+            }
+            core_assert(m_data.migrate_recv[side].size() <= Params::max_migrate * record_size,
+                "migration message capacity exceeded");
+            cl::Queue::enqueue_write_buffer(
+                m_queue,
+                m_buffers[BufferMigrateRecv],
+                CL_FALSE,
+                n_recv * record_size,
+                m_data.migrate_recv[side].size(),
+                (void *) &m_data.migrate_recv[side][0],
+                NULL,
+                NULL);
+            n_recv += m_data.migrate_recv[side].size() / record_size;
+        }
+        core_assert(n_stay + n_recv <= m_data.capacity,
+            "particle capacity exceeded");
+
+        if (n_recv > 0) {
+            const cl_ulong num_work_items = cl::NDRange::Roundup(
+                n_recv, Params::work_group_size);
+
+            cl_kernel &kernel = m_kernels[KernelMigrateUnpack];
+            cl::Kernel::set_arg(kernel, 0, sizeof(cl_mem), &m_buffers[BufferPosition]);
+            cl::Kernel::set_arg(kernel, 1, sizeof(cl_mem), &m_buffers[BufferVelocity]);
+            cl::Kernel::set_arg(kernel, 2, sizeof(cl_mem), &m_buffers[BufferCharge]);
+            cl::Kernel::set_arg(kernel, 3, sizeof(cl_mem), &m_buffers[BufferId]);
+            cl::Kernel::set_arg(kernel, 4, sizeof(cl_mem), &m_buffers[BufferConstraintVirial]);
+            cl::Kernel::set_arg(kernel, 5, sizeof(cl_uint), &stride);
+            cl::Kernel::set_arg(kernel, 6, sizeof(cl_uint), &n_stay);
+            cl::Kernel::set_arg(kernel, 7, sizeof(cl_mem), &m_buffers[BufferMigrateRecv]);
+            cl::Kernel::set_arg(kernel, 8, sizeof(cl_uint), &n_recv);
+
+            cl::Queue::enqueue_nd_range_kernel(
+                m_queue,
+                kernel,
+                cl::NDRange::Null,                      /* global work offset */
+                cl::NDRange(num_work_items),            /* global work size */
+                cl::NDRange(Params::work_group_size),   /* local work size */
+                NULL,
+                NULL);
+        }
+        m_data.n_local = n_stay + n_recv;
+        n_moved += n_send;
+    }
+    build_clusters();
+    return n_moved;
+}
+
+/** ---------------------------------------------------------------------------
+ * Model::balance
+ * @brief Rebalance the subdomains when the device work is unevenly spread.
+ *
+ * The force and neighbour times measured by the profile since the last call
+ * give the imbalance. Above the threshold, the grid planes are shifted to
+ * balance the cost along each dimension, weighting each particle by the
+ * time per particle of its process, so faster devices receive larger
+ * subdomains. The particles are then redistributed by migration, repeated
+ * until no particle remains outside its subdomain.
+ */
+void Model::balance(void)
+{
+    m_profile.collect();
+    cl_double time = m_profile.total();
+    m_profile.reset();
+
+    cl_double imbalance = Balance::imbalance(m_domain, time);
+    if (imbalance < Params::balance_threshold) {
+        return;
+    }
+
+    /* Read the particle positions and compute the new grid planes. */
+    const cl_uint stride = m_data.capacity;
+    for (int dim = 0; dim < 3; ++dim) {
+        cl::Queue::enqueue_read_buffer(
+            m_queue,
+            m_buffers[BufferPosition],
+            CL_FALSE,
+            dim * stride * sizeof(m_data.position[0]),
+            m_data.n_local * sizeof(m_data.position[0]),
+            (void *) &m_data.position[dim * stride],
+            NULL,
+            NULL);
+    }
+    cl::Queue::finish(m_queue);
+
+    cl_double weight = time / (cl_double) std::max(m_data.n_local, 1u);
+    std::vector<cl_double> planes[3];
+    Balance::compute_planes(
+        m_domain, m_data.position, stride, m_data.n_local, weight, planes);
+
+    /* Update the subdomain bounds and the cell grid. */
+    m_domain.set_planes(planes);
+    for (int dim = 0; dim < 3; ++dim) {
+        m_data.lo.s[dim] = m_domain.m_lo[dim];
+        m_data.hi.s[dim] = m_domain.m_hi[dim];
+    }
+    setup_cells();
+
+    /* Redistribute the particles. */
+    cl_uint n_moved;
+    do {
+        cl_uint n_sent = migrate(std::numeric_limits<cl_double>::max());
+        MPI_Allreduce(
+            &n_sent, &n_moved, 1, MPI_UNSIGNED, MPI_SUM, m_domain.m_comm);
+    } while (n_moved > 0);
+
+    if (m_domain.is_master()) {
+        std::cout << core::str_format(
+            "balance: step %lu, imbalance %lf\n", m_data.step, imbalance);
+    }
+}
+
+/** ---------------------------------------------------------------------------
+ * Model::setup_cells
+ * @brief Setup the cell grid spanning the subdomain and one layer of ghost
+ * cells on each side. The cell width is at least the cutoff radius, so the
+ * neighbours of a particle lie in the 27 adjacent cells, and the ghost layer
+ * holds every ghost within a cutoff distance of the subdomain. The cell
+ * buffers are only recreated when the number of cells changes.
+ */
+void Model::setup_cells(void)
+{
+    const cl_uint n_cell_total = m_data.n_cell_total;
+    m_data.n_cell_total = 1;
+    for (int dim = 0; dim < 3; ++dim) {
+        cl_double width = m_domain.m_hi[dim] - m_domain.m_lo[dim];
+        cl_int n_inner = std::max((cl_int) (width / Params::r_cut), 1);
+        m_data.cell_width.s[dim] = width / (cl_double) n_inner;
+        m_data.cell_lo.s[dim] = m_domain.m_lo[dim] - m_data.cell_width.s[dim];
+        m_data.n_cells.s[dim] = n_inner + 2;
+        m_data.n_cell_total *= m_data.n_cells.s[dim];
+        core_assert(m_data.n_cells.s[dim] <= 1024,
+            "cell grid exceeds the Morton key range");
+    }
+    m_data.cell_lo.s[3] = 0.0;
+    m_data.cell_width.s[3] = 1.0;
+    m_data.n_cells.s[3] = 1;
+    if (m_buffers[BufferCellCount] != NULL &&
+        m_data.n_cell_total == n_cell_total) {
+        return;
+    }
+
+    const size_t count_size = m_data.n_cell_total * sizeof(cl_uint);
+    const size_t list_size = Params::max_cell * count_size;
+    cl::Memory::release(m_buffers[BufferCellCount]);
+    cl::Memory::release(m_buffers[BufferCellList]);
+    cl::Memory::release(m_buffers[BufferGhostCellCount]);
+    cl::Memory::release(m_buffers[BufferGhostCellList]);
+    m_buffers[BufferCellCount] = cl::Memory::create_buffer(
+        m_context, CL_MEM_READ_WRITE, count_size, (void *) NULL);
+    m_buffers[BufferCellList] = cl::Memory::create_buffer(
+        m_context, CL_MEM_READ_WRITE, list_size, (void *) NULL);
+    m_buffers[BufferGhostCellCount] = cl::Memory::create_buffer(
+        m_context, CL_MEM_READ_WRITE, count_size, (void *) NULL);
+    m_buffers[BufferGhostCellList] = cl::Memory::create_buffer(
+        m_context, CL_MEM_READ_WRITE, list_size, (void *) NULL);
+}
+
+/**
+ * Model::reorder
+ * @brief Sort the local particles by the Morton key of their cell and permute
+ * every particle array in the same order. Particles close in space become
+ * close in memory, which keeps the force kernel accesses coalesced as the
+ * simulation evolves. The local cell bins are not remapped, since the next
+ * force evaluation bins the particles again, and the constraint clusters
+ * are rebuilt.
+ */
+void Model::reorder(void)
+{
+    const cl_uint stride = m_data.capacity;
+    const cl_ulong num_work_items = cl::NDRange::Roundup(
+        m_data.n_local, Params::work_group_size);
+
+    /* Bitonic sort length, the next power of two. */
+    cl_uint n_sort = 1;
+    while (n_sort < m_data.n_local) {
+        n_sort <<= 1;
+    }
+    const cl_ulong num_sort_items = cl::NDRange::Roundup(
+        n_sort, Params::work_group_size);
+    core_assert(num_sort_items <= cl::NDRange::Roundup(
+        m_data.capacity, Params::work_group_size), "sort capacity exceeded");
+
+    /* Compute the sort keys. */
+    {
+        cl_kernel &kernel = m_kernels[KernelReorderKeys];
+        cl::Kernel::set_arg(kernel, 0, sizeof(cl_mem), &m_buffers[BufferPosition]);
+        cl::Kernel::set_arg(kernel, 1, sizeof(cl_uint), &stride);
+        cl::Kernel::set_arg(kernel, 2, sizeof(cl_uint), &m_data.n_local);
+        cl::Kernel::set_arg(kernel, 3, sizeof(cl_uint), &n_sort);
+        cl::Kernel::set_arg(kernel, 4, sizeof(cl_mem), &m_buffers[BufferSortKey]);
+        cl::Kernel::set_arg(kernel, 5, sizeof(cl_double4), &m_data.cell_lo);
+        cl::Kernel::set_arg(kernel, 6, sizeof(cl_double4), &m_data.cell_width);
+        cl::Kernel::set_arg(kernel, 7, sizeof(cl_int4), &m_data.n_cells);
+
+        cl::Queue::enqueue_nd_range_kernel(
+            m_queue,
+            kernel,
+            cl::NDRange::Null,                      /* global work offset */
+            cl::NDRange(num_sort_items),            /* global work size */
+            cl::NDRange(Params::work_group_size),   /* local work size */
+            NULL,
+            NULL);
+    }
+
+    /* Sort the keys with a bitonic sort network. */
+    {
+        cl_kernel &kernel = m_kernels[KernelReorderSort];
+        cl::Kernel::set_arg(kernel, 0, sizeof(cl_mem), &m_buffers[BufferSortKey]);
+        cl::Kernel::set_arg(kernel, 1, sizeof(cl_uint), &n_sort);
+        for (cl_uint k = 2; k <= n_sort; k <<= 1) {
+            for (cl_uint j = k >> 1; j > 0; j >>= 1) {
+                cl::Kernel::set_arg(kernel, 2, sizeof(cl_uint), &j);
+                cl::Kernel::set_arg(kernel, 3, sizeof(cl_uint), &k);
+                cl::Queue::enqueue_nd_range_kernel(
+                    m_queue,
+                    kernel,
+                    cl::NDRange::Null,                      /* global work offset */
+                    cl::NDRange(num_sort_items),            /* global work size */
+                    cl::NDRange(Params::work_group_size),   /* local work size */
+                    NULL,
+                    NULL);
+            }
+        }
+    }
+
+    /* Permute every particle array through the scratch buffer. */
+    {
+        struct {
+            cl_mem &buffer;
+            cl_uint n_components;
+        } arrays[] = {
+            {m_buffers[BufferPosition], 3},
+            {m_buffers[BufferVelocity], 3},
+            {m_buffers[BufferForce], 3},
+            {m_buffers[BufferForceSlow], 3},
+            {m_buffers[BufferEnergy], 1},
+            {m_buffers[BufferVirial], 1},
+            {m_buffers[BufferCharge], 1},
+            {m_buffers[BufferId], 1},
+        };
+
+        cl_kernel &kernel = m_kernels[KernelReorderGather];
+        for (auto &it : arrays) {
+            cl::Kernel::set_arg(kernel, 0, sizeof(cl_mem), &it.buffer);
+            cl::Kernel::set_arg(kernel, 1, sizeof(cl_mem), &m_buffers[BufferScratch]);
+            cl::Kernel::set_arg(kernel, 2, sizeof(cl_uint), &stride);
+            cl::Kernel::set_arg(kernel, 3, sizeof(cl_uint), &it.n_components);
+            cl::Kernel::set_arg(kernel, 4, sizeof(cl_mem), &m_buffers[BufferSortKey]);
+            cl::Kernel::set_arg(kernel, 5, sizeof(cl_uint), &m_data.n_local);
+
+            cl::Queue::enqueue_nd_range_kernel(
+                m_queue,
+                kernel,
+                cl::NDRange::Null,                      /* global work offset */
+                cl::NDRange(num_work_items),            /* global work size */
+                cl::NDRange(Params::work_group_size),   /* local work size */
+                NULL,
+                NULL);
+
+            for (cl_uint c = 0; c < it.n_components; ++c) {
+                cl::Queue::enqueue_copy_buffer(
+                    m_queue,
+                    m_buffers[BufferScratch],
+                    it.buffer,
+                    c * stride * sizeof(cl_ulong),
+                    c * stride * sizeof(cl_ulong),
+                    m_data.n_local * sizeof(cl_ulong),
+                    NULL,
+                    NULL);
+            }
+        }
+    }
+
+    build_clusters();
+}
+
+/** ---------------------------------------------------------------------------
+ * Model::map_local_index
+ * @brief Map the id of each local particle to its index in the particle
+ * store, so the sites of a molecule are found from their ids. The map is a
+ * hash table with linear probing over the local particles only. Single-site
+ * molecules need no map.
+ */
+void Model::map_local_index(void)
+{
+    if (m_topology.m_n_sites == 1) {
+        return;
+    }
+
+    const cl_ulong num_work_items = cl::NDRange::Roundup(
+        std::max(m_data.n_local, 1u), Params::work_group_size);
+
+    /* Clear the hash table slots. */
+    const cl_uint empty = 0xFFFFFFFF;
+    cl::Queue::enqueue_fill_buffer(
+        m_queue,
+        m_buffers[BufferLocalIndex],
+        &empty,
+        sizeof(empty),
+        0,
+        (m_data.index_mask + 1) * sizeof(cl_uint),
+        NULL,
+        NULL);
+
+    cl_kernel &kernel = m_kernels[KernelClusterMap];
+    cl::Kernel::set_arg(kernel, 0, sizeof(cl_mem), &m_buffers[BufferId]);
+    cl::Kernel::set_arg(kernel, 1, sizeof(cl_uint), &m_data.n_local);
+    cl::Kernel::set_arg(kernel, 2, sizeof(cl_uint), &m_data.index_mask);
+    cl::Kernel::set_arg(kernel, 3, sizeof(cl_mem), &m_buffers[BufferLocalIndex]);
+
+    cl::Queue::enqueue_nd_range_kernel(
+        m_queue,
+        kernel,
+        cl::NDRange::Null,                      /* global work offset */
+        cl::NDRange(num_work_items),            /* global work size */
+        cl::NDRange(Params::work_group_size),   /* local work size */
+        NULL,
+        NULL);
+}
+
+/**
+ * Model::build_clusters
+ * @brief Rebuild the cluster list, the local indices of the sites of each
+ * local molecule, after the particle store changed order. Molecules are
+ * always whole on a process, so there is one cluster per n_sites local
+ * particles. The local bonded terms are rebuilt on the host from the ids.
+ */
+void Model::build_clusters(void)
+{
+    const cl_uint n_sites = m_topology.m_n_sites;
+    core_assert(m_data.n_local % n_sites == 0, "incomplete local molecule");
+    m_data.n_clusters = m_data.n_local / n_sites;
+    if (n_sites == 1) {
+        return;
+    }
+
+    map_local_index();
+    {
+        const cl_uint zero = 0;
+        cl::Queue::enqueue_fill_buffer(
+            m_queue,
+            m_buffers[BufferClusterCount],
+            &zero,
+            sizeof(zero),
+            0,
+            sizeof(cl_uint),
+            NULL,
+            NULL);
+
+        const cl_ulong num_work_items = cl::NDRange::Roundup(
+            std::max(m_data.n_local, 1u), Params::work_group_size);
+
+        cl_kernel &kernel = m_kernels[KernelClusterBuild];
+        cl::Kernel::set_arg(kernel, 0, sizeof(cl_mem), &m_buffers[BufferId]);
+        cl::Kernel::set_arg(kernel, 1, sizeof(cl_uint), &m_data.n_local);
+        cl::Kernel::set_arg(kernel, 2, sizeof(cl_uint), &n_sites);
+        cl::Kernel::set_arg(kernel, 3, sizeof(cl_uint), &m_data.index_mask);
+        cl::Kernel::set_arg(kernel, 4, sizeof(cl_mem), &m_buffers[BufferLocalIndex]);
+        cl::Kernel::set_arg(kernel, 5, sizeof(cl_mem), &m_buffers[BufferCluster]);
+        cl::Kernel::set_arg(kernel, 6, sizeof(cl_mem), &m_buffers[BufferClusterCount]);
+
+        cl::Queue::enqueue_nd_range_kernel(
+            m_queue,
+            kernel,
+            cl::NDRange::Null,                      /* global work offset */
+            cl::NDRange(num_work_items),            /* global work size */
+            cl::NDRange(Params::work_group_size),   /* local work size */
+            NULL,
+            NULL);
+    }
+
+    if (m_bonded.is_active()) {
+        cl::Queue::enqueue_read_buffer(
+            m_queue,
+            m_buffers[BufferId],
+            CL_TRUE,
+            0,
+            m_data.n_local * sizeof(m_data.id[0]),
+            (void *) &m_data.id[0],
+            NULL,
+            NULL);
+        m_bonded.build(m_data.id, m_data.n_local);
+    }
+}
+
+/**
+ * Model::constrain_position
+ * @brief Constrain the positions of each cluster after the first half step,
+ * one cluster per work-item. Rigid 3-site molecules are solved by SETTLE,
+ * other molecules by SHAKE. The virial of the constraint forces of this
+ * stage is stored for each site, and migrates with it, until the velocity
+ * stage adds it to the virial the force computation has reset.
+ */
+void Model::constrain_position(void)
+{
+    if (m_data.n_clusters == 0) {
+        return;
+    }
+
+    const cl_uint stride = m_data.capacity;
+    const cl_uint n_constraints = m_topology.n_constraints();
+    const cl_uint max_iter = Params::constraint_max_iter;
+    const cl_ulong num_work_items = cl::NDRange::Roundup(
+        m_data.n_clusters, Params::work_group_size);
+
+    cl_kernel kernel;
+    if (m_topology.m_settle) {
+        kernel = m_kernels[KernelSettlePosition];
+        cl::Kernel::set_arg(kernel, 0, sizeof(cl_mem), &m_buffers[BufferPositionOld]);
+        cl::Kernel::set_arg(kernel, 1, sizeof(cl_mem), &m_buffers[BufferPosition]);
+        cl::Kernel::set_arg(kernel, 2, sizeof(cl_mem), &m_buffers[BufferVelocity]);
+        cl::Kernel::set_arg(kernel, 3, sizeof(cl_uint), &stride);
+        cl::Kernel::set_arg(kernel, 4, sizeof(cl_mem), &m_buffers[BufferCluster]);
+        cl::Kernel::set_arg(kernel, 5, sizeof(cl_uint), &m_data.n_clusters);
+        cl::Kernel::set_arg(kernel, 6, sizeof(cl_double), &m_topology.m_settle_ra);
+        cl::Kernel::set_arg(kernel, 7, sizeof(cl_double), &m_topology.m_settle_rb);
+        cl::Kernel::set_arg(kernel, 8, sizeof(cl_double), &m_topology.m_settle_rc);
+        cl::Kernel::set_arg(kernel, 9, sizeof(cl_double), &Params::time_step);
+        cl::Kernel::set_arg(kernel, 10, sizeof(cl_mem), &m_buffers[BufferConstraintVirial]);
+    } else {
+        kernel = m_kernels[KernelConstrainPosition];
+        cl::Kernel::set_arg(kernel, 0, sizeof(cl_mem), &m_buffers[BufferPositionOld]);
+        cl::Kernel::set_arg(kernel, 1, sizeof(cl_mem), &m_buffers[BufferPosition]);
+        cl::Kernel::set_arg(kernel, 2, sizeof(cl_mem), &m_buffers[BufferVelocity]);
+        cl::Kernel::set_arg(kernel, 3, sizeof(cl_uint), &stride);
+        cl::Kernel::set_arg(kernel, 4, sizeof(cl_mem), &m_buffers[BufferCluster]);
+        cl::Kernel::set_arg(kernel, 5, sizeof(cl_uint), &m_data.n_clusters);
+        cl::Kernel::set_arg(kernel, 6, sizeof(cl_uint), &m_topology.m_n_sites);
+        cl::Kernel::set_arg(kernel, 7, sizeof(cl_mem), &m_buffers[BufferConstraintSite]);
+        cl::Kernel::set_arg(kernel, 8, sizeof(cl_mem), &m_buffers[BufferConstraintLength]);
+        cl::Kernel::set_arg(kernel, 9, sizeof(cl_uint), &n_constraints);
+        cl::Kernel::set_arg(kernel, 10, sizeof(cl_double), &Params::constraint_tolerance);
+        cl::Kernel::set_arg(kernel, 11, sizeof(cl_uint), &max_iter);
+        cl::Kernel::set_arg(kernel, 12, sizeof(cl_double), &Params::time_step);
+        cl::Kernel::set_arg(kernel, 13, sizeof(cl_mem), &m_buffers[BufferConstraintVirial]);
+        cl::Kernel::set_arg(kernel, 14, sizeof(cl_mem), &m_buffers[BufferConstraintError]);
+    }
+
+    cl::Queue::enqueue_nd_range_kernel(
+        m_queue,
+        kernel,
+        cl::NDRange::Null,                      /* global work offset */
+        cl::NDRange(num_work_items),            /* global work size */
+        cl::NDRange(Params::work_group_size),   /* local work size */
+        NULL,
+        NULL);
+}
+
+/**
+ * Model::constrain_velocity
+ * @brief Remove the velocity components along the constraints after the
+ * second half step, and add the virial of the constraint forces of both
+ * stages to the virial of each site.
+ */
+void Model::constrain_velocity(void)
+{
+    if (m_data.n_clusters == 0) {
+        return;
+    }
+
+    const cl_uint stride = m_data.capacity;
+    const cl_uint n_constraints = m_topology.n_constraints();
+    const cl_uint max_iter = Params::constraint_max_iter;
+    const cl_ulong num_work_items = cl::NDRange::Roundup(
+        m_data.n_clusters, Params::work_group_size);
+
+    cl_kernel kernel;
+    if (m_topology.m_settle) {
+        kernel = m_kernels[KernelSettleVelocity];
+        cl::Kernel::set_arg(kernel, 0, sizeof(cl_mem), &m_buffers[BufferPosition]);
+        cl::Kernel::set_arg(kernel, 1, sizeof(cl_mem), &m_buffers[BufferVelocity]);
+        cl::Kernel::set_arg(kernel, 2, sizeof(cl_uint), &stride);
+        cl::Kernel::set_arg(kernel, 3, sizeof(cl_mem), &m_buffers[BufferCluster]);
+        cl::Kernel::set_arg(kernel, 4, sizeof(cl_uint), &m_data.n_clusters);
+        cl::Kernel::set_arg(kernel, 5, sizeof(cl_double), &Params::time_step);
+        cl::Kernel::set_arg(kernel, 6, sizeof(cl_mem), &m_buffers[BufferConstraintVirial]);
+        cl::Kernel::set_arg(kernel, 7, sizeof(cl_mem), &m_buffers[BufferVirial]);
+    } else {
+        kernel = m_kernels[KernelConstrainVelocity];
+        cl::Kernel::set_arg(kernel, 0, sizeof(cl_mem), &m_buffers[BufferPosition]);
+        cl::Kernel::set_arg(kernel, 1, sizeof(cl_mem), &m_buffers[BufferVelocity]);
+        cl::Kernel::set_arg(kernel, 2, sizeof(cl_uint), &stride);
+        cl::Kernel::set_arg(kernel, 3, sizeof(cl_mem), &m_buffers[BufferCluster]);
+        cl::Kernel::set_arg(kernel, 4, sizeof(cl_uint), &m_data.n_clusters);
+        cl::Kernel::set_arg(kernel, 5, sizeof(cl_uint), &m_topology.m_n_sites);
+        cl::Kernel::set_arg(kernel, 6, sizeof(cl_mem), &m_buffers[BufferConstraintSite]);
+        cl::Kernel::set_arg(kernel, 7, sizeof(cl_mem), &m_buffers[BufferConstraintLength]);
+        cl::Kernel::set_arg(kernel, 8, sizeof(cl_uint), &n_constraints);
+        cl::Kernel::set_arg(kernel, 9, sizeof(cl_double), &Params::constraint_tolerance);
+        cl::Kernel::set_arg(kernel, 10, sizeof(cl_uint), &max_iter);
+        cl::Kernel::set_arg(kernel, 11, sizeof(cl_double), &Params::time_step);
+        cl::Kernel::set_arg(kernel, 12, sizeof(cl_mem), &m_buffers[BufferConstraintVirial]);
+        cl::Kernel::set_arg(kernel, 13, sizeof(cl_mem), &m_buffers[BufferVirial]);
+        cl::Kernel::set_arg(kernel, 14, sizeof(cl_mem), &m_buffers[BufferConstraintError]);
+    }
+
+    cl::Queue::enqueue_nd_range_kernel(
+        m_queue,
+        kernel,
+        cl::NDRange::Null,                      /* global work offset */
+        cl::NDRange(num_work_items),            /* global work size */
+        cl::NDRange(Params::work_group_size),   /* local work size */
+        NULL,
+        NULL);
+}
+
+/** ---------------------------------------------------------------------------
+ * Model::compute_forces
+ * @brief Compute the forces on the local particles. The local particles are
+ * binned in the cell grid and the interior forces are enqueued on the compute
+ * queue before the halo exchange, so they overlap with the ghost packing and
+ * the MPI messages. The ghosts are binned on the halo queue and the boundary
+ * forces wait for them to arrive. The reciprocal space and bonded forces are
+ * computed on the host while the device computes the boundary forces.
+ *
+ * The short range and bonded forces are the fast forces, summed in the force
+ * buffer. The reciprocal space forces are the slow forces, computed only if
+ * slow is set, and kept in their own buffer until the next evaluation.
+ */
+void Model::compute_forces(const bool slow)
+{
+    const cl_uint stride = m_data.capacity;
+    const cl_uint max_cell = Params::max_cell;
+    const cl_double4 pair_grid = m_pair_table.grid();
+    const cl_ulong num_work_items = cl::NDRange::Roundup(
+        m_data.n_local, Params::work_group_size);
+
+    /* Mark the point where the positions are up to date. */
+    cl_event position_ready;
+    cl::Queue::enqueue_marker_with_waitlist(m_queue, NULL, &position_ready);
+
+    /* Bin the local particles in the cell grid. */
+    {
+        const cl_uint zero = 0;
+        cl::Queue::enqueue_fill_buffer(
+            m_queue,
+            m_buffers[BufferCellCount],
+            &zero,
+            sizeof(zero),
+            0,
+            m_data.n_cell_total * sizeof(cl_uint),
+            NULL,
+            NULL);
+
+        cl_kernel &kernel = m_kernels[KernelCellBinLocal];
+        cl::Kernel::set_arg(kernel, 0, sizeof(cl_mem), &m_buffers[BufferPosition]);
+        cl::Kernel::set_arg(kernel, 1, sizeof(cl_uint), &stride);
+        cl::Kernel::set_arg(kernel, 2, sizeof(cl_uint), &m_data.n_local);
+        cl::Kernel::set_arg(kernel, 3, sizeof(cl_mem), &m_buffers[BufferCellCount]);
+        cl::Kernel::set_arg(kernel, 4, sizeof(cl_mem), &m_buffers[BufferCellList]);
+        cl::Kernel::set_arg(kernel, 5, sizeof(cl_uint), &max_cell);
+        cl::Kernel::set_arg(kernel, 6, sizeof(cl_double4), &m_data.cell_lo);
+        cl::Kernel::set_arg(kernel, 7, sizeof(cl_double4), &m_data.cell_width);
+        cl::Kernel::set_arg(kernel, 8, sizeof(cl_int4), &m_data.n_cells);
+        cl::Kernel::set_arg(kernel, 9, sizeof(cl_mem), &m_buffers[BufferCellOverflow]);
+
+        cl_event event;
+        cl::Queue::enqueue_nd_range_kernel(
+            m_queue,
+            kernel,
+            cl::NDRange::Null,                      /* global work offset */
+            cl::NDRange(num_work_items),            /* global work size */
+            cl::NDRange(Params::work_group_size),   /* local work size */
+            NULL,
+            &event);
+        m_profile.record(Profile::Neighbour, event);
+    }
+
+    /* Compute the interior forces. */
+    {
+        cl_kernel &kernel = m_kernels[KernelForcesInterior];
+        cl::Kernel::set_arg(kernel, 0, sizeof(cl_mem), &m_buffers[BufferPosition]);
+        cl::Kernel::set_arg(kernel, 1, sizeof(cl_mem), &m_buffers[BufferCharge]);
+        cl::Kernel::set_arg(kernel, 2, sizeof(cl_mem), &m_buffers[BufferId]);
+        cl::Kernel::set_arg(kernel, 3, sizeof(cl_uint), &m_topology.m_n_sites);
+        cl::Kernel::set_arg(kernel, 4, sizeof(cl_mem), &m_buffers[BufferForce]);
+        cl::Kernel::set_arg(kernel, 5, sizeof(cl_mem), &m_buffers[BufferEnergy]);
+        cl::Kernel::set_arg(kernel, 6, sizeof(cl_mem), &m_buffers[BufferVirial]);
+        cl::Kernel::set_arg(kernel, 7, sizeof(cl_uint), &stride);
+        cl::Kernel::set_arg(kernel, 8, sizeof(cl_uint), &m_data.n_local);
+        cl::Kernel::set_arg(kernel, 9, sizeof(cl_double4), &m_data.lo);
+        cl::Kernel::set_arg(kernel, 10, sizeof(cl_double4), &m_data.hi);
+        cl::Kernel::set_arg(kernel, 11, sizeof(cl_double), &Params::r_cut);
+        cl::Kernel::set_arg(kernel, 12, sizeof(cl_double), &Params::r_halo);
+        cl::Kernel::set_arg(kernel, 13, sizeof(cl_double), &Params::ewald_alpha);
+        cl::Kernel::set_arg(kernel, 14, sizeof(cl_mem), &m_buffers[BufferCellCount]);
+        cl::Kernel::set_arg(kernel, 15, sizeof(cl_mem), &m_buffers[BufferCellList]);
+        cl::Kernel::set_arg(kernel, 16, sizeof(cl_uint), &max_cell);
+        cl::Kernel::set_arg(kernel, 17, sizeof(cl_double4), &m_data.cell_lo);
+        cl::Kernel::set_arg(kernel, 18, sizeof(cl_double4), &m_data.cell_width);
+        cl::Kernel::set_arg(kernel, 19, sizeof(cl_int4), &m_data.n_cells);
+        cl::Kernel::set_arg(kernel, 20, sizeof(cl_mem), &m_images[ImagePairTable]);
+        cl::Kernel::set_arg(kernel, 21, sizeof(cl_sampler), &m_pair_sampler);
+        cl::Kernel::set_arg(kernel, 22, sizeof(cl_double4), &pair_grid);
+
+        cl_event event;
+        cl::Queue::enqueue_nd_range_kernel(
+            m_queue,
+            kernel,
+            cl::NDRange::Null,                      /* global work offset */
+            cl::NDRange(num_work_items),            /* global work size */
+            cl::NDRange(Params::work_group_size),   /* local work size */
+            NULL,
+            &event);
+        m_profile.record(Profile::Force, event);
+        cl::Queue::flush(m_queue);
+    }
+
+    /*
+     * Read the positions and charges for the reciprocal space sum, and the
+     * positions for the bonded forces. The reads go on the halo queue and
+     * complete with the first halo stage.
+     */
+    const std::vector<cl_event> wait_list{position_ready};
+    if (slow || m_bonded.is_active()) {
+        for (int dim = 0; dim < 3; ++dim) {
+            cl::Queue::enqueue_read_buffer(
+                m_halo_queue,
+                m_buffers[BufferPosition],
+                CL_FALSE,
+                dim * stride * sizeof(m_data.position[0]),
+                m_data.n_local * sizeof(m_data.position[0]),
+                (void *) &m_data.position[dim * stride],
+                &wait_list,
+                NULL);
+        }
+    }
+    if (slow) {
+        cl::Queue::enqueue_read_buffer(
+            m_halo_queue,
+            m_buffers[BufferCharge],
+            CL_FALSE,
+            0,
+            m_data.n_local * sizeof(m_data.charge[0]),
+            (void *) &m_data.charge[0],
+            NULL,
+            NULL);
+    }
+
+    /* Exchange the ghost positions while the interior forces run. */
+    halo_exchange(wait_list);
+    cl::Event::release(position_ready);
+
+    /* Bin the ghost particles in the cell grid. */
+    {
+        const cl_uint zero = 0;
+        cl::Queue::enqueue_fill_buffer(
+            m_halo_queue,
+            m_buffers[BufferGhostCellCount],
+            &zero,
+            sizeof(zero),
+            0,
+            m_data.n_cell_total * sizeof(cl_uint),
+            NULL,
+            NULL);
+
+        if (m_data.n_ghost > 0) {
+            const cl_ulong num_ghost_items = cl::NDRange::Roundup(
+                m_data.n_ghost, Params::work_group_size);
+
+            cl_kernel &kernel = m_kernels[KernelCellBinGhost];
+            cl::Kernel::set_arg(kernel, 0, sizeof(cl_mem), &m_buffers[BufferGhost]);
+            cl::Kernel::set_arg(kernel, 1, sizeof(cl_uint), &m_data.n_ghost);
+            cl::Kernel::set_arg(kernel, 2, sizeof(cl_mem), &m_buffers[BufferGhostCellCount]);
+            cl::Kernel::set_arg(kernel, 3, sizeof(cl_mem), &m_buffers[BufferGhostCellList]);
+            cl::Kernel::set_arg(kernel, 4, sizeof(cl_uint), &max_cell);
+            cl::Kernel::set_arg(kernel, 5, sizeof(cl_double4), &m_data.cell_lo);
+            cl::Kernel::set_arg(kernel, 6, sizeof(cl_double4), &m_data.cell_width);
+            cl::Kernel::set_arg(kernel, 7, sizeof(cl_int4), &m_data.n_cells);
+            cl::Kernel::set_arg(kernel, 8, sizeof(cl_mem), &m_buffers[BufferCellOverflow]);
+
+            cl_event event;
+            cl::Queue::enqueue_nd_range_kernel(
+                m_halo_queue,
+                kernel,
+                cl::NDRange::Null,                      /* global work offset */
+                cl::NDRange(num_ghost_items),           /* global work size */
+                cl::NDRange(Params::work_group_size),   /* local work size */
+                NULL,
+                &event);
+            m_profile.record(Profile::Neighbour, event);
+        }
+    }
+
+    /* Compute the boundary forces once the ghost positions are available. */
+    {
+        cl_event ghost_ready;
+        cl::Queue::enqueue_marker_with_waitlist(m_halo_queue, NULL, &ghost_ready);
+        std::vector<cl_event> wait_list{ghost_ready};
+
+        cl_kernel &kernel = m_kernels[KernelForcesBoundary];
+        cl::Kernel::set_arg(kernel, 0, sizeof(cl_mem), &m_buffers[BufferPosition]);
+        cl::Kernel::set_arg(kernel, 1, sizeof(cl_mem), &m_buffers[BufferCharge]);
+        cl::Kernel::set_arg(kernel, 2, sizeof(cl_mem), &m_buffers[BufferId]);
+        cl::Kernel::set_arg(kernel, 3, sizeof(cl_uint), &m_topology.m_n_sites);
+        cl::Kernel::set_arg(kernel, 4, sizeof(cl_mem), &m_buffers[BufferGhost]);
+        cl::Kernel::set_arg(kernel, 5, sizeof(cl_mem), &m_buffers[BufferForce]);
+        cl::Kernel::set_arg(kernel, 6, sizeof(cl_mem), &m_buffers[BufferEnergy]);
+        cl::Kernel::set_arg(kernel, 7, sizeof(cl_mem), &m_buffers[BufferVirial]);
+        cl::Kernel::set_arg(kernel, 8, sizeof(cl_uint), &stride);
+        cl::Kernel::set_arg(kernel, 9, sizeof(cl_uint), &m_data.n_local);
+        cl::Kernel::set_arg(kernel, 10, sizeof(cl_double4), &m_data.lo);
+        cl::Kernel::set_arg(kernel, 11, sizeof(cl_double4), &m_data.hi);
+        cl::Kernel::set_arg(kernel, 12, sizeof(cl_double), &Params::r_cut);
+        cl::Kernel::set_arg(kernel, 13, sizeof(cl_double), &Params::r_halo);
+        cl::Kernel::set_arg(kernel, 14, sizeof(cl_double), &Params::ewald_alpha);
+        cl::Kernel::set_arg(kernel, 15, sizeof(cl_mem), &m_buffers[BufferCellCount]);
+        cl::Kernel::set_arg(kernel, 16, sizeof(cl_mem), &m_buffers[BufferCellList]);
+        cl::Kernel::set_arg(kernel, 17, sizeof(cl_mem), &m_buffers[BufferGhostCellCount]);
+        cl::Kernel::set_arg(kernel, 18, sizeof(cl_mem), &m_buffers[BufferGhostCellList]);
+        cl::Kernel::set_arg(kernel, 19, sizeof(cl_uint), &max_cell);
+        cl::Kernel::set_arg(kernel, 20, sizeof(cl_double4), &m_data.cell_lo);
+        cl::Kernel::set_arg(kernel, 21, sizeof(cl_double4), &m_data.cell_width);
+        cl::Kernel::set_arg(kernel, 22, sizeof(cl_int4), &m_data.n_cells);
+        cl::Kernel::set_arg(kernel, 23, sizeof(cl_mem), &m_images[ImagePairTable]);
+        cl::Kernel::set_arg(kernel, 24, sizeof(cl_sampler), &m_pair_sampler);
+        cl::Kernel::set_arg(kernel, 25, sizeof(cl_double4), &pair_grid);
+
+        cl_event event;
+        cl::Queue::enqueue_nd_range_kernel(
+            m_queue,
+            kernel,
+            cl::NDRange::Null,                      /* global work offset */
+            cl::NDRange(num_work_items),            /* global work size */
+            cl::NDRange(Params::work_group_size),   /* local work size */
+            &wait_list,
+            &event);
+        m_profile.record(Profile::Force, event);
+        cl::Event::release(ghost_ready);
+        cl::Queue::flush(m_queue);
+    }
+
+    /*
+     * Compute the reciprocal space forces on the host into the slow force
+     * buffer. The write completes before the positions of the next step are
+     * read back, so it can be non-blocking.
+     */
+    if (slow) {
+        m_data.pme_energy = m_pme.compute(
+            m_data.position,
+            m_data.charge,
+            stride,
+            m_data.n_local,
+            m_data.force_slow);
+        m_data.pme_virial = m_pme.m_virial;
+
+        for (int dim = 0; dim < 3; ++dim) {
+            cl::Queue::enqueue_write_buffer(
+                m_queue,
+                m_buffers[BufferForceSlow],
+                CL_FALSE,
+                dim * stride * sizeof(m_data.force_slow[0]),
+                m_data.n_local * sizeof(m_data.force_slow[0]),
+                (void *) &m_data.force_slow[dim * stride],
+                NULL,
+                NULL);
+        }
+    }
+
+    /* Compute the bonded forces on the host and add them to the fast forces. */
+    if (m_bonded.is_active()) {
+        for (int dim = 0; dim < 3; ++dim) {
+            std::fill(
+                m_data.force_bonded.begin() + dim * stride,
+                m_data.force_bonded.begin() + dim * stride + m_data.n_local,
+                0.0);
+        }
+        m_data.bonded_energy = m_bonded.compute(
+            m_data.position, stride, m_data.force_bonded);
+        m_data.bonded_virial = m_bonded.m_virial;
+
+        for (int dim = 0; dim < 3; ++dim) {
+            cl::Queue::enqueue_write_buffer(
+                m_queue,
+                m_buffers[BufferForceBonded],
+                CL_FALSE,
+                dim * stride * sizeof(m_data.force_bonded[0]),
+                m_data.n_local * sizeof(m_data.force_bonded[0]),
+                (void *) &m_data.force_bonded[dim * stride],
+                NULL,
+                NULL);
+        }
+
+        cl_kernel &kernel = m_kernels[KernelForcesAccumulate];
+        cl::Kernel::set_arg(kernel, 0, sizeof(cl_mem), &m_buffers[BufferForce]);
+        cl::Kernel::set_arg(kernel, 1, sizeof(cl_mem), &m_buffers[BufferForceBonded]);
+        cl::Kernel::set_arg(kernel, 2, sizeof(cl_uint), &stride);
+        cl::Kernel::set_arg(kernel, 3, sizeof(cl_uint), &m_data.n_local);
+
+        cl::Queue::enqueue_nd_range_kernel(
+            m_queue,
+            kernel,
+            cl::NDRange::Null,                      /* global work offset */
+            cl::NDRange(num_work_items),            /* global work size */
+            cl::NDRange(Params::work_group_size),   /* local work size */
+            NULL,
+            NULL);
+    }
+}
+
+/** ---------------------------------------------------------------------------
+ * Model::halo_exchange
+ * @brief Exchange the ghost positions with the six face neighbours in three
+ * stages, one per dimension. Each stage packs the local particles and the
+ * ghosts received in the previous stages on the device, so edge and corner
+ * ghosts are forwarded without diagonal messages. The received messages are
+ * written directly into the ghost buffer.
+ */
+void Model::halo_exchange(const std::vector<cl_event> &wait_list)
+{
+    const cl_uint stride = m_data.capacity;
+    const cl_uint max_halo = Params::max_halo;
+    const size_t record_size = 4 * sizeof(cl_double);
+
+    m_data.n_ghost = 0;
+    for (cl_uint dim = 0; dim < 3; ++dim) {
+        cl_double lo = m_domain.m_lo[dim];
+        cl_double hi = m_domain.m_hi[dim];
+        cl_double shift_lo = m_domain.shift(dim, 0);
+        cl_double shift_hi = m_domain.shift(dim, 1);
+
+        /* Reset the message counters. */
+        const cl_uint zero = 0;
+        cl::Queue::enqueue_fill_buffer(
+            m_halo_queue,
+            m_buffers[BufferHaloCount],
+            &zero,
+            sizeof(zero),
+            0,
+            m_data.halo_count.size() * sizeof(m_data.halo_count[0]),
+            (dim == 0) ? &wait_list : NULL,
+            NULL);
+
+        /* Pack the local particles near the subdomain faces. */
+        {
+            const cl_ulong num_work_items = cl::NDRange::Roundup(
+                m_data.n_local, Params::work_group_size);
+
+            cl_kernel &kernel = m_kernels[KernelHaloPackLocal];
+            cl::Kernel::set_arg(kernel, 0, sizeof(cl_mem), &m_buffers[BufferPosition]);
+            cl::Kernel::set_arg(kernel, 1, sizeof(cl_mem), &m_buffers[BufferCharge]);
+            cl::Kernel::set_arg(kernel, 2, sizeof(cl_uint), &stride);
+            cl::Kernel::set_arg(kernel, 3, sizeof(cl_uint), &m_data.n_local);
+            cl::Kernel::set_arg(kernel, 4, sizeof(cl_uint), &dim);
+            cl::Kernel::set_arg(kernel, 5, sizeof(cl_double), &lo);
+            cl::Kernel::set_arg(kernel, 6, sizeof(cl_double), &hi);
+            cl::Kernel::set_arg(kernel, 7, sizeof(cl_double), &Params::r_halo);
+            cl::Kernel::set_arg(kernel, 8, sizeof(cl_double), &shift_lo);
+            cl::Kernel::set_arg(kernel, 9, sizeof(cl_double), &shift_hi);
+            cl::Kernel::set_arg(kernel, 10, sizeof(cl_mem), &m_buffers[BufferHaloSend]);
+            cl::Kernel::set_arg(kernel, 11, sizeof(cl_mem), &m_buffers[BufferHaloCount]);
+            cl::Kernel::set_arg(kernel, 12, sizeof(cl_uint), &max_halo);
+
+            cl::Queue::enqueue_nd_range_kernel(
+                m_halo_queue,
+                kernel,
+                cl::NDRange::Null,                      /* global work offset */
+                cl::NDRange(num_work_items),            /* global work size */
+                cl::NDRange(Params::work_group_size),   /* local work size */
+                NULL,
+                NULL);
+        }
+
+        /* Pack the ghosts received along the previous dimensions. */
+        if (m_data.n_ghost > 0) {
+            const cl_ulong num_work_items = cl::NDRange::Roundup(
+                m_data.n_ghost, Params::work_group_size);
+
+            cl_kernel &kernel = m_kernels[KernelHaloPackGhost];
+            cl::Kernel::set_arg(kernel, 0, sizeof(cl_mem), &m_buffers[BufferGhost]);
+            cl::Kernel::set_arg(kernel, 1, sizeof(cl_uint), &m_data.n_ghost);
+            cl::Kernel::set_arg(kernel, 2, sizeof(cl_uint), &dim);
+            cl::Kernel::set_arg(kernel, 3, sizeof(cl_double), &lo);
+            cl::Kernel::set_arg(kernel, 4, sizeof(cl_double), &hi);
+            cl::Kernel::set_arg(kernel, 5, sizeof(cl_double), &Params::r_halo);
+            cl::Kernel::set_arg(kernel, 6, sizeof(cl_double), &shift_lo);
+            cl::Kernel::set_arg(kernel, 7, sizeof(cl_double), &shift_hi);
+            cl::Kernel::set_arg(kernel, 8, sizeof(cl_mem), &m_buffers[BufferHaloSend]);
+            cl::Kernel::set_arg(kernel, 9, sizeof(cl_mem), &m_buffers[BufferHaloCount]);
+            cl::Kernel::set_arg(kernel, 10, sizeof(cl_uint), &max_halo);
+
+            cl::Queue::enqueue_nd_range_kernel(
+                m_halo_queue,
+                kernel,
+                cl::NDRange::Null,                      /* global work offset */
+                cl::NDRange(num_work_items),            /* global work size */
+                cl::NDRange(Params::work_group_size),   /* local work size */
+                NULL,
+                NULL);
+        }
+
+        /* Read the message sizes and the packed messages. */
+        cl::Queue::enqueue_read_buffer(
+            m_halo_queue,
+            m_buffers[BufferHaloCount],
+            CL_TRUE,
+            0,
+            m_data.halo_count.size() * sizeof(m_data.halo_count[0]),
+            (void *) &m_data.halo_count[0],
+            NULL,
+            NULL);
+
+        for (int side = 0; side < 2; ++side) {
+            core_assert(m_data.halo_count[side] <= Params::max_halo,
+                "halo message capacity exceeded");
+            m_data.halo_send[side].resize(
+                m_data.halo_count[side] * record_size);
+            if (m_data.halo_count[side] == 0) {
+                continue;
+            }
+            cl::Queue::enqueue_read_buffer(
+                m_halo_queue,
+                m_buffers[BufferHaloSend],
+                CL_FALSE,
+                side * Params::max_halo * record_size,
+                m_data.halo_send[side].size(),
+                (void *) &m_data.halo_send[side][0],
+                NULL,
+                NULL);
+        }
+        cl::Queue::finish(m_halo_queue);
+
+        /* Exchange the messages with the lo and hi neighbours. */
+        m_domain.exchange(dim, m_data.halo_send, m_data.halo_recv);
+
+        /*
+         * Append the received records to the ghost buffer. The receive
+         * buffers remain untouched until the next stage has read back its
+         * message sizes, so the writes can be non-blocking.
+         */
+        for (int side = 0; side < 2; ++side) {
+            size_t n_recv = m_data.halo_recv[side].size() / record_size;
+            if (n_recv == 0) {
+                continue;
+            }
+            core_assert(m_data.n_ghost + n_recv <= Params::max_ghost,
+                "ghost capacity exceeded");
+            cl::Queue::enqueue_write_buffer(
+                m_halo_queue,
+                m_buffers[BufferGhost],
+                CL_FALSE,
+                m_data.n_ghost * record_size,
+                m_data.halo_recv[side].size(),
+                (void *) &m_data.halo_recv[side][0],
+                NULL,
+                NULL);
+            m_data.n_ghost += n_recv;
+        }
+    }
+}
+
+/** ---------------------------------------------------------------------------
+ * Model::reduce_observables
+ * @brief Enqueue the reduction of the local thermodynamic sums on the device,
+ * one record of partial sums per work-group. The Gaussian noise sums of the
+ * stochastic thermostat are only computed when the noise mask, the number of
+ * unconstrained degrees of freedom of each molecule site, is nonzero.
+ */
+void Model::reduce_observables(const cl_uint noise)
+{
+    const cl_uint stride = m_data.capacity;
+    const cl_ulong num_work_items = cl::NDRange::Roundup(
+        std::max(m_data.n_local, 1u), Params::work_group_size);
+
+    cl_kernel &kernel = m_kernels[KernelReduceObservables];
+    cl::Kernel::set_arg(kernel, 0, sizeof(cl_mem), &m_buffers[BufferVelocity]);
+    cl::Kernel::set_arg(kernel, 1, sizeof(cl_mem), &m_buffers[BufferEnergy]);
+    cl::Kernel::set_arg(kernel, 2, sizeof(cl_mem), &m_buffers[BufferVirial]);
+    cl::Kernel::set_arg(kernel, 3, sizeof(cl_mem), &m_buffers[BufferId]);
+    cl::Kernel::set_arg(kernel, 4, sizeof(cl_uint), &stride);
+    cl::Kernel::set_arg(kernel, 5, sizeof(cl_uint), &m_data.n_local);
+    cl::Kernel::set_arg(kernel, 6, sizeof(cl_uint), &m_topology.m_n_sites);
+    cl::Kernel::set_arg(kernel, 7, sizeof(cl_uint), &noise);
+    cl::Kernel::set_arg(kernel, 8, sizeof(cl_ulong), &Params::noise_seed);
+    cl::Kernel::set_arg(kernel, 9, sizeof(cl_ulong), &m_data.step);
+    cl::Kernel::set_arg(kernel, 10,
+        Thermo::NumPartials * Params::work_group_size * sizeof(cl_double), NULL);
+    cl::Kernel::set_arg(kernel, 11, sizeof(cl_mem), &m_buffers[BufferObservables]);
+
+    cl::Queue::enqueue_nd_range_kernel(
+        m_queue,
+        kernel,
+        cl::NDRange::Null,                      /* global work offset */
+        cl::NDRange(num_work_items),            /* global work size */
+        cl::NDRange(Params::work_group_size),   /* local work size */
+        NULL,
+        NULL);
+}
+
+/**
+ * Model::control
+ * @brief Compute the thermostat and barostat scale factors of the next step.
+ * The thermodynamic sums are reduced on the device, and only the partial
+ * sums of each work-group are read back. The process sums, including the
+ * reciprocal space virial, are combined in a single allreduce.
+ */
+void Model::control(void)
+{
+    const size_t n_groups = cl::NDRange::Roundup(
+        std::max(m_data.n_local, 1u),
+        Params::work_group_size) / Params::work_group_size;
+
+    reduce_observables(Ensemble::has_noise() ? m_topology.site_noise() : 0);
+    cl::Queue::enqueue_read_buffer(
+        m_queue,
+        m_buffers[BufferObservables],
+        CL_TRUE,
+        0,
+        Thermo::NumPartials * n_groups * sizeof(m_data.control[0]),
+        (void *) &m_data.control[0],
+        NULL,
+        NULL);
+
+    Thermo thermo = {(cl_double) m_data.n_local,
+        (cl_double) (m_data.n_clusters * m_topology.n_constraints()),
+        0.0, 0.0, m_data.pme_virial + m_data.bonded_virial, 0.0, 0.0};
+    for (size_t group = 0; group < n_groups; ++group) {
+        const cl_double *partial = &m_data.control[Thermo::NumPartials * group];
+        thermo.kinetic_energy += partial[0];
+        thermo.virial += partial[2];
+        thermo.noise_sum += partial[3];
+        thermo.noise_sq += partial[4];
+    }
+    thermo.reduce(m_domain.m_comm);
+
+    m_ensemble.update(thermo, m_domain.volume());
+}
+
+/** ---------------------------------------------------------------------------
+ * Model::sample
+ * @brief Enqueue the reduction of the local thermodynamic sums on the device,
+ * and read back the partial sums of each work-group without blocking. The
+ * read completes in the background, signalled by the sample event, and the
+ * sample is resolved by observe.
+ */
+void Model::sample(void)
+{
+    core_assert(m_data.sample_event == NULL, "pending sample not observed");
+
+    const size_t n_groups = cl::NDRange::Roundup(
+        std::max(m_data.n_local, 1u),
+        Params::work_group_size) / Params::work_group_size;
+
+    reduce_observables(0);
+    cl::Queue::enqueue_read_buffer(
+        m_queue,
+        m_buffers[BufferCellOverflow],
+        CL_FALSE,
+        0,
+        sizeof(m_data.cell_overflow),
+        (void *) &m_data.cell_overflow,
+        NULL,
+        NULL);
+    cl::Queue::enqueue_read_buffer(
+        m_queue,
+        m_buffers[BufferConstraintError],
+        CL_FALSE,
+        0,
+        sizeof(m_data.constraint_error),
+        (void *) &m_data.constraint_error,
+        NULL,
+        NULL);
+    cl::Queue::enqueue_read_buffer(
+        m_queue,
+        m_buffers[BufferObservables],
+        CL_FALSE,
+        0,
+        Thermo::NumPartials * n_groups * sizeof(m_data.observables[0]),
+        (void *) &m_data.observables[0],
+        NULL,
+        &m_data.sample_event);
+    if (Trajectory::is_active() && m_data.step % Params::n_frame_steps == 0) {
+        sample_frame();
+    }
+    cl::Queue::flush(m_queue);
+
+    /* Write the radial distribution function accumulated so far. */
+    if (Rdf::is_active() &&
+        m_data.step % Params::n_rdf_output_steps == 0 &&
+        m_rdf.m_n_samples > 0) {
+        write_rdf();
+    }
+
+    /* Write the transport correlation functions accumulated so far. */
+    if (Transport::is_active() &&
+        m_data.step % Params::n_transport_output_steps == 0 &&
+        m_transport.m_n_updates > 0) {
+        m_transport.write();
+    }
+
+    m_data.sample_step = m_data.step;
+    m_data.sample_n_local = m_data.n_local;
+    m_data.sample_pme_energy = m_data.pme_energy;
+    m_data.sample_pme_virial = m_data.pme_virial;
+    m_data.sample_bonded_energy = m_data.bonded_energy;
+    m_data.sample_bonded_virial = m_data.bonded_virial;
+    m_data.sample_volume = m_domain.volume();
+}
+
+/**
+ * Model::sample_frame
+ * @brief Enqueue the read back of a trajectory frame without blocking. The
+ * positions, velocities and ids are read into the host frame array, or
+ * copied into the staging buffer on the device and mapped, so the transfer
+ * uses pinned memory. The frame is written by observe.
+ */
+void Model::sample_frame(void)
+{
+    core_assert(m_data.frame_event == NULL, "pending frame not written");
+
+    const size_t size = 3 * m_data.capacity * sizeof(cl_double);
+    const size_t id_size = m_data.capacity * sizeof(cl_ulong);
+    if (Params::trajectory_mapped) {
+        cl::Queue::enqueue_copy_buffer(
+            m_queue,
+            m_buffers[BufferPosition],
+            m_buffers[BufferFrame],
+            0,
+            0,
+            size,
+            NULL,
+            NULL);
+        cl::Queue::enqueue_copy_buffer(
+            m_queue,
+            m_buffers[BufferVelocity],
+            m_buffers[BufferFrame],
+            0,
+            size,
+            size,
+            NULL,
+            NULL);
+        cl::Queue::enqueue_copy_buffer(
+            m_queue,
+            m_buffers[BufferId],
+            m_buffers[BufferFrame],
+            0,
+            2 * size,
+            id_size,
+            NULL,
+            NULL);
+        m_data.frame_map = static_cast<cl_double *>(
+            cl::Queue::enqueue_map_buffer(
+                m_queue,
+                m_buffers[BufferFrame],
+                CL_FALSE,
+                CL_MAP_READ,
+                0,
+                2 * size + id_size,
+                NULL,
+                &m_data.frame_event));
+    } else {
+        cl::Queue::enqueue_read_buffer(
+            m_queue,
+            m_buffers[BufferPosition],
+            CL_FALSE,
+            0,
+            size,
+            (void *) &m_data.frame[0],
+            NULL,
+            NULL);
+        cl::Queue::enqueue_read_buffer(
+            m_queue,
+            m_buffers[BufferVelocity],
+            CL_FALSE,
+            0,
+            size,
+            (void *) &m_data.frame[3 * m_data.capacity],
+            NULL,
+            NULL);
+        cl::Queue::enqueue_read_buffer(
+            m_queue,
+            m_buffers[BufferId],
+            CL_FALSE,
+            0,
+            id_size,
+            (void *) &m_data.frame[6 * m_data.capacity],
+            NULL,
+            &m_data.frame_event);
+    }
+
+    m_data.frame_step = m_data.step;
+    m_data.frame_n_local = m_data.n_local;
+    for (int dim = 0; dim < 3; ++dim) {
+        m_data.frame_box_lo[dim] = m_domain.m_box_lo[dim];
+        m_data.frame_box_hi[dim] = m_domain.m_box_hi[dim];
+    }
+}
+
+/** ---------------------------------------------------------------------------
+ * Model::accumulate_rdf
+ * @brief Add the pair distances at the current positions to the radial
+ * distribution function histogram on the device. The kernel reuses the
+ * local and ghost cell bins of the last force computation, with a stencil
+ * reaching rdf_r_max in the narrowest cell dimension, so a range within
+ * the cutoff visits the same 27 cells as the forces, and a range beyond
+ * it, up to the halo width, visits as many more cells as it needs.
+ */
+void Model::accumulate_rdf(void)
+{
+    const cl_uint stride = m_data.capacity;
+    const cl_uint max_cell = Params::max_cell;
+    const cl_uint n_bins = Params::rdf_bins;
+    const cl_ulong num_work_items = cl::NDRange::Roundup(
+        std::max(m_data.n_local, 1u), Params::work_group_size);
+    const cl_double width = std::min({m_data.cell_width.s[0],
+        m_data.cell_width.s[1], m_data.cell_width.s[2]});
+    const cl_int reach = (cl_int) std::ceil(Params::rdf_r_max / width);
+
+    cl_kernel &kernel = m_kernels[KernelRdfAccumulate];
+    cl::Kernel::set_arg(kernel, 0, sizeof(cl_mem), &m_buffers[BufferPosition]);
+    cl::Kernel::set_arg(kernel, 1, sizeof(cl_mem), &m_buffers[BufferCharge]);
+    cl::Kernel::set_arg(kernel, 2, sizeof(cl_mem), &m_buffers[BufferId]);
+    cl::Kernel::set_arg(kernel, 3, sizeof(cl_uint), &m_topology.m_n_sites);
+    cl::Kernel::set_arg(kernel, 4, sizeof(cl_mem), &m_buffers[BufferGhost]);
+    cl::Kernel::set_arg(kernel, 5, sizeof(cl_uint), &stride);
+    cl::Kernel::set_arg(kernel, 6, sizeof(cl_uint), &m_data.n_local);
+    cl::Kernel::set_arg(kernel, 7, sizeof(cl_double), &Params::rdf_r_max);
+    cl::Kernel::set_arg(kernel, 8, sizeof(cl_uint), &n_bins);
+    cl::Kernel::set_arg(kernel, 9, sizeof(cl_uint), &m_rdf.m_n_species);
+    cl::Kernel::set_arg(kernel, 10, sizeof(cl_double4), &m_rdf.m_species);
+    cl::Kernel::set_arg(kernel, 11, sizeof(cl_int), &reach);
+    cl::Kernel::set_arg(kernel, 12, sizeof(cl_mem), &m_buffers[BufferCellCount]);
+    cl::Kernel::set_arg(kernel, 13, sizeof(cl_mem), &m_buffers[BufferCellList]);
+    cl::Kernel::set_arg(kernel, 14, sizeof(cl_mem), &m_buffers[BufferGhostCellCount]);
+    cl::Kernel::set_arg(kernel, 15, sizeof(cl_mem), &m_buffers[BufferGhostCellList]);
+    cl::Kernel::set_arg(kernel, 16, sizeof(cl_uint), &max_cell);
+    cl::Kernel::set_arg(kernel, 17, sizeof(cl_double4), &m_data.cell_lo);
+    cl::Kernel::set_arg(kernel, 18, sizeof(cl_double4), &m_data.cell_width);
+    cl::Kernel::set_arg(kernel, 19, sizeof(cl_int4), &m_data.n_cells);
+    cl::Kernel::set_arg(kernel, 20,
+        m_rdf.m_histogram.size() * sizeof(cl_uint), NULL);
+    cl::Kernel::set_arg(kernel, 21, sizeof(cl_mem), &m_buffers[BufferRdfHistogram]);
+
+    cl::Queue::enqueue_nd_range_kernel(
+        m_queue,
+        kernel,
+        cl::NDRange::Null,                      /* global work offset */
+        cl::NDRange(num_work_items),            /* global work size */
+        cl::NDRange(Params::work_group_size),   /* local work size */
+        NULL,
+        NULL);
+    m_rdf.sample(m_domain.volume());
+}
+
+/**
+ * Model::write_rdf
+ * @brief Read back the radial distribution function histogram and write
+ * the averages reduced over all processes. This is the only point where
+ * the step loop waits for the histogram, once every n_rdf_output_steps.
+ */
+void Model::write_rdf(void)
+{
+    cl::Queue::enqueue_read_buffer(
+        m_queue,
+        m_buffers[BufferRdfHistogram],
+        CL_TRUE,
+        0,
+        m_rdf.m_histogram.size() * sizeof(cl_ulong),
+        (void *) &m_rdf.m_histogram[0],
+        NULL,
+        NULL);
+    m_rdf.write();
+}
+
+/** ---------------------------------------------------------------------------
+ * Model::sample_transport
+ * @brief Hand the pending transport sample, read back at the previous
+ * transport step and normally complete long before, to the correlator.
+ * Then enqueue the read back of the positions, velocities and ids at the
+ * end of this step without blocking.
+ */
+void Model::sample_transport(void)
+{
+    const cl_uint stride = m_data.capacity;
+    if (m_data.transport_event != NULL) {
+        cl::Event::wait_for_event(m_data.transport_event);
+        cl::Event::release(m_data.transport_event);
+        m_data.transport_event = NULL;
+        m_transport.update(
+            m_data.transport_box_length,
+            m_data.transport_n_local,
+            stride,
+            &m_data.transport[0],
+            &m_data.transport[3 * stride],
+            reinterpret_cast<const cl_ulong *>(&m_data.transport[6 * stride]));
+    }
+
+    const size_t size = 3 * stride * sizeof(cl_double);
+    cl::Queue::enqueue_read_buffer(
+        m_queue,
+        m_buffers[BufferPosition],
+        CL_FALSE,
+        0,
+        size,
+        (void *) &m_data.transport[0],
+        NULL,
+        NULL);
+    cl::Queue::enqueue_read_buffer(
+        m_queue,
+        m_buffers[BufferVelocity],
+        CL_FALSE,
+        0,
+        size,
+        (void *) &m_data.transport[3 * stride],
+        NULL,
+        NULL);
+    cl::Queue::enqueue_read_buffer(
+        m_queue,
+        m_buffers[BufferId],
+        CL_FALSE,
+        0,
+        stride * sizeof(cl_ulong),
+        (void *) &m_data.transport[6 * stride],
+        NULL,
+        &m_data.transport_event);
+    cl::Queue::flush(m_queue);
+
+    m_data.transport_n_local = m_data.n_local;
+    for (int dim = 0; dim < 3; ++dim) {
+        m_data.transport_box_length[dim] = m_domain.m_box_length[dim];
+    }
+}
+
+/**
+ * Model::observe
+ * @brief Resolve the pending sample. Wait for its event, which has normally
+ * completed long before, sum the work-group partials and reduce the global
+ * observables over all processes. Return false if no sample is pending.
+ */
+bool Model::observe(void)
+{
+    if (m_data.sample_event == NULL) {
+        return false;
+    }
+    cl::Event::wait_for_event(m_data.sample_event);
+    cl::Event::release(m_data.sample_event);
+    m_data.sample_event = NULL;
+    core_assert(m_data.cell_overflow == 0, "cell capacity exceeded");
+    core_assert(m_data.constraint_error == 0, "constraints did not converge");
+
+    const size_t n_groups = cl::NDRange::Roundup(
+        std::max(m_data.sample_n_local, 1u),
+        Params::work_group_size) / Params::work_group_size;
+    const cl_uint n_clusters = m_data.sample_n_local / m_topology.m_n_sites;
+    Thermo thermo = {(cl_double) m_data.sample_n_local,
+        (cl_double) (n_clusters * m_topology.n_constraints()),
+        0.0,
+        m_data.sample_pme_energy + m_data.sample_bonded_energy,
+        m_data.sample_pme_virial + m_data.sample_bonded_virial,
+        0.0, 0.0};
+    for (size_t group = 0; group < n_groups; ++group) {
+        const cl_double *partial =
+            &m_data.observables[Thermo::NumPartials * group];
+        thermo.kinetic_energy += partial[0];
+        thermo.potential_energy += partial[1];
+        thermo.virial += partial[2];
+    }
+    thermo.reduce(m_domain.m_comm);
+
+    m_data.n_particles = (cl_ulong) thermo.n_particles;
+    m_data.kinetic_energy = thermo.kinetic_energy;
+    m_data.potential_energy = thermo.potential_energy;
+    m_data.temperature = thermo.temperature();
+    m_data.pressure = thermo.pressure(m_data.sample_volume);
+
+    /* Hand the pending trajectory frame to the writer. */
+    if (m_data.frame_event != NULL) {
+        cl::Event::wait_for_event(m_data.frame_event);
+        cl::Event::release(m_data.frame_event);
+        m_data.frame_event = NULL;
+
+        const cl_double *frame = Params::trajectory_mapped
+            ? m_data.frame_map : &m_data.frame[0];
+        m_trajectory.write(
+            m_data.frame_step,
+            m_data.frame_box_lo,
+            m_data.frame_box_hi,
+            m_data.frame_n_local,
+            m_data.capacity,
+            &frame[0],
+            &frame[3 * m_data.capacity],
+            reinterpret_cast<const cl_ulong *>(&frame[6 * m_data.capacity]));
+
+        if (m_data.frame_map != NULL) {
+            cl::Queue::enqueue_unmap_mem_object(
+                m_queue, m_buffers[BufferFrame], m_data.frame_map, NULL, NULL);
+            m_data.frame_map = NULL;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,259 @@
+/*
+ * model.hpp
+ *
+ * Copyright (c) 2020 Carlos Braga
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the MIT License.
+ *
+ * See accompanying LICENSE.md or https://opensource.org/licenses/MIT.
+ */
+
+#ifndef MODEL_H_
+#define MODEL_H_
+
+#include <vector>
+#include "base.hpp"
+#include "bonded.hpp"
+#include "domain.hpp"
+#include "ensemble.hpp"
+#include "pme.hpp"
+#include "table.hpp"
+#include "profile.hpp"
+#include "rdf.hpp"
+#include "topology.hpp"
+#include "trajectory.hpp"
+#include "transport.hpp"
+
+struct Model {
+    /* ---- Model OpenCL data ---------------------------------------------- */
+    cl_context m_context = NULL;
+    cl_device_id m_device = NULL;
+    cl_command_queue m_queue = NULL;
+    cl_command_queue m_halo_queue = NULL;
+    cl_program m_program = NULL;
+
+    enum {
+        KernelIntegratePosition = 0,
+        KernelIntegrateVelocity,
+        KernelForcesInterior,
+        KernelForcesBoundary,
+        KernelForcesAccumulate,
+        KernelReduceObservables,
+        KernelHaloPackLocal,
+        KernelHaloPackGhost,
+        KernelMigrateFlag,
+        KernelMigrateCompact,
+        KernelMigrateMove,
+        KernelMigrateUnpack,
+        KernelCellBinLocal,
+        KernelCellBinGhost,
+        KernelReorderKeys,
+        KernelReorderSort,
+        KernelReorderGather,
+        KernelClusterMap,
+        KernelClusterBuild,
+        KernelConstrainPosition,
+        KernelConstrainVelocity,
+        KernelSettlePosition,
+        KernelSettleVelocity,
+        KernelRdfAccumulate,
+        NumKernels
+    };
+    std::vector<cl_kernel> m_kernels;
+
+    enum {
+        BufferPosition = 0,
+        BufferVelocity,
+        BufferForce,
+        BufferForceSlow,
+        BufferForceBonded,
+        BufferEnergy,
+        BufferVirial,
+        BufferCharge,
+        BufferId,
+        BufferGhost,
+        BufferHaloSend,
+        BufferHaloCount,
+        BufferMigrateFlag,
+        BufferMigrateSend,
+        BufferMigrateRecv,
+        BufferMigrateIndex,
+        BufferMigrateCount,
+        BufferCellCount,
+        BufferCellList,
+        BufferGhostCellCount,
+        BufferGhostCellList,
+        BufferCellOverflow,
+        BufferObservables,
+        BufferSortKey,
+        BufferScratch,
+        BufferPositionOld,
+        BufferLocalIndex,
+        BufferCluster,
+        BufferClusterCount,
+        BufferConstraintSite,
+        BufferConstraintLength,
+        BufferConstraintError,
+        BufferConstraintVirial,
+        BufferFrame,
+        BufferRdfHistogram,
+        NumBuffers
+    };
+    std::vector<cl_mem> m_buffers;
+
+    enum {
+        ImagePairTable = 0,
+        NumImages
+    };
+    std::vector<cl_mem> m_images;
+    cl_sampler m_pair_sampler = NULL;
+
+    /* ---- Model domain, molecules, pair table, electrostatics, ensemble - */
+    Domain m_domain;
+    Topology m_topology;
+    Bonded m_bonded;
+    PairTable m_pair_table;
+    Pme m_pme;
+    Ensemble m_ensemble;
+    Profile m_profile;
+    Trajectory m_trajectory;
+    Rdf m_rdf;
+    Transport m_transport;
+
+    /* ---- Model data ----------------------------------------------------- */
+    struct Data {
+        /* Particle data in structure of arrays layout with stride capacity. */
+        cl_uint capacity;
+        cl_uint n_local;
+        cl_uint n_ghost;
+        std::vector<cl_double> position;
+        std::vector<cl_double> velocity;
+        std::vector<cl_double> force;
+        std::vector<cl_double> force_slow;
+        std::vector<cl_double> force_bonded;
+        std::vector<cl_double> energy;
+        std::vector<cl_double> virial;
+        std::vector<cl_double> charge;
+        std::vector<cl_ulong> id;
+
+        /* Halo exchange messages. */
+        std::vector<cl_uint> halo_count;
+        std::vector<cl_uchar> halo_send[2];
+        std::vector<cl_uchar> halo_recv[2];
+
+        /* Migration messages. */
+        std::vector<cl_uint> migrate_count;
+        std::vector<cl_uchar> migrate_send[2];
+        std::vector<cl_uchar> migrate_recv[2];
+
+        /* Subdomain bounds. */
+        cl_double4 lo;
+        cl_double4 hi;
+
+        /* Cell grid spanning the subdomain and one layer of ghost cells. */
+        cl_double4 cell_lo;
+        cl_double4 cell_width;
+        cl_int4 n_cells;
+        cl_uint n_cell_total;
+        cl_uint cell_overflow;
+
+        /*
+         * Slot mask of the hash table mapping the ids of the local particles
+         * to their indices in the particle store.
+         */
+        cl_uint index_mask;
+
+        /*
+         * Constraint clusters, one per local molecule, and the number of
+         * clusters whose constraint solver did not converge.
+         */
+        cl_uint n_clusters;
+        cl_uint constraint_error;
+
+        /* Global observables. */
+        cl_ulong step;
+        cl_ulong n_particles;
+        cl_double kinetic_energy;
+        cl_double potential_energy;
+        cl_double temperature;
+        cl_double pressure;
+
+        /*
+         * Local reciprocal and self energy, and reciprocal virial, and the
+         * local bonded energy and virial, of the last force computation.
+         */
+        cl_double pme_energy;
+        cl_double pme_virial;
+        cl_double bonded_energy;
+        cl_double bonded_virial;
+
+        /*
+         * Pending sample, per work-group partial sums of the thermodynamic
+         * quantities read back asynchronously.
+         */
+        std::vector<cl_double> observables;
+        cl_event sample_event;
+        cl_ulong sample_step;
+        cl_uint sample_n_local;
+        cl_double sample_pme_energy;
+        cl_double sample_pme_virial;
+        cl_double sample_bonded_energy;
+        cl_double sample_bonded_virial;
+        cl_double sample_volume;
+
+        /* Per work-group partial sums of the ensemble control. */
+        std::vector<cl_double> control;
+
+        /*
+         * Pending trajectory frame, the positions, velocities and ids in
+         * a block of stride capacity, read back asynchronously into the
+         * host array, or into the mapped staging buffer.
+         */
+        std::vector<cl_double> frame;
+        cl_double *frame_map;
+        cl_event frame_event;
+        cl_ulong frame_step;
+        cl_uint frame_n_local;
+        cl_double frame_box_lo[3];
+        cl_double frame_box_hi[3];
+
+        /*
+         * Pending transport sample, the positions, velocities and ids read
+         * back asynchronously and handed to the correlator at the next
+         * transport step.
+         */
+        std::vector<cl_double> transport;
+        cl_event transport_event;
+        cl_uint transport_n_local;
+        cl_double transport_box_length[3];
+    } m_data;
+
+    /* ---- Model member functions ----------------------------------------- */
+    void execute(void);
+    cl_uint migrate(const cl_double drift);
+    void balance(void);
+    void reorder(void);
+    void map_local_index(void);
+    void build_clusters(void);
+    void constrain_position(void);
+    void constrain_velocity(void);
+    void setup_cells(void);
+    void compute_forces(const bool slow);
+    void halo_exchange(const std::vector<cl_event> &wait_list);
+    void reduce_observables(const cl_uint noise);
+    void control(void);
+    void sample(void);
+    void sample_frame(void);
+    void accumulate_rdf(void);
+    void write_rdf(void);
+    void sample_transport(void);
+    bool observe(void);
+
+    explicit Model(MPI_Comm comm);
+    ~Model();
+    Model(const Model &) = delete;
+    Model &operator=(const Model &) = delete;
+};
+
+#endif /* MODEL_H_ */
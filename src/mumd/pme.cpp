@@ -0,0 +1,833 @@
+/*
+ * pme.cpp
+ *
+ * Copyright (c) 2020 Carlos Braga
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the MIT License.
+ *
+ * See accompanying LICENSE.md or https://opensource.org/licenses/MIT.
+ */
+
+#include "pme.hpp"
+using namespace atto;
+
+/** ---------------------------------------------------------------------------
+ * bspline
+ * @brief Compute the weights theta[j] and derivatives dtheta[j] of the
+ * cardinal B-spline of the specified order at the grid points k0 + j, for a
+ * particle at fractional offset w in [0,1) from grid point k0. The weights
+ * are built by the recursion M_n(u) = (u M_{n-1}(u) + (n-u) M_{n-1}(u-1))/(n-1)
+ * and the derivatives from the spline of order n-1.
+ */
+static core_dispatch void bspline(
+    const cl_double w,
+    const cl_uint order,
+    cl_double *theta,
+    cl_double *dtheta)
+{
+    theta[order - 1] = 0.0;
+    theta[1] = w;
+    theta[0] = 1.0 - w;
+    for (cl_uint k = 3; k < order; ++k) {
+        cl_double div = 1.0 / (cl_double) (k - 1);
+        theta[k - 1] = div * w * theta[k - 2];
+        for (cl_uint j = 1; j < k - 1; ++j) {
+            theta[k - j - 1] = div * ((w + j) * theta[k - j - 2] +
+                                      (k - j - w) * theta[k - j - 1]);
+        }
+        theta[0] = div * (1.0 - w) * theta[0];
+    }
+
+    dtheta[0] = -theta[0];
+    for (cl_uint j = 1; j < order; ++j) {
+        dtheta[j] = theta[j - 1] - theta[j];
+    }
+
+    cl_double div = 1.0 / (cl_double) (order - 1);
+    theta[order - 1] = div * w * theta[order - 2];
+    for (cl_uint j = 1; j < order - 1; ++j) {
+        theta[order - j - 1] = div * ((w + j) * theta[order - j - 2] +
+                                      (order - j - w) * theta[order - j - 1]);
+    }
+    theta[0] = div * (1.0 - w) * theta[0];
+}
+
+/**
+ * bspline_moduli
+ * @brief Compute the squared moduli |b(m)|^-2 of the Euler exponential
+ * spline factors, given by the discrete Fourier transform of the B-spline
+ * sampled at the integer points. Near-zero moduli, where the interpolation
+ * breaks down, are replaced by the average of their neighbours.
+ */
+static std::vector<cl_double> bspline_moduli(
+    const cl_uint order,
+    const cl_uint size)
+{
+    std::vector<cl_double> data(order, 0.0);
+    data[0] = 1.0;
+    for (cl_uint k = 3; k <= order; ++k) {
+        cl_double div = 1.0 / (cl_double) (k - 1);
+        data[k - 1] = 0.0;
+        for (cl_uint j = 1; j < k - 1; ++j) {
+            data[k - j - 1] = div * (j * data[k - j - 2] +
+                                     (k - j) * data[k - j - 1]);
+        }
+        data[0] = div * data[0];
+    }
+
+    std::vector<cl_double> spline(size, 0.0);
+    for (cl_uint k = 1; k <= order && k < size; ++k) {
+        spline[k] = data[k - 1];
+    }
+
+    std::vector<cl_double> moduli(size, 0.0);
+    for (cl_uint m = 0; m < size; ++m) {
+        cl_double sc = 0.0;
+        cl_double ss = 0.0;
+        for (cl_uint k = 0; k < size; ++k) {
+            cl_double arg = 2.0 * M_PI * (cl_double) ((m * k) % size) /
+                (cl_double) size;
+            sc += spline[k] * std::cos(arg);
+            ss += spline[k] * std::sin(arg);
+        }
+        moduli[m] = sc * sc + ss * ss;
+    }
+    for (cl_uint m = 0; m < size; ++m) {
+        if (moduli[m] < 1.0e-7) {
+            moduli[m] = 0.5 * (moduli[(m + size - 1) % size] +
+                               moduli[(m + 1) % size]);
+        }
+    }
+    return moduli;
+}
+
+/**
+ * wrap
+ * @brief Periodic image of an unwrapped grid index in [0, size).
+ */
+static inline cl_int wrap(const cl_int k, const cl_int size)
+{
+    return ((k % size) + size) % size;
+}
+
+/** ---------------------------------------------------------------------------
+ * Pme::Pme
+ * @brief Create the 2-d pencil process grid with its row and column
+ * communicators, and allocate the pencils. The local mesh and its exchange
+ * buffers are sized by the local particles at each step.
+ */
+Pme::Pme(const Domain &domain)
+{
+    /*
+     * Setup the pencil process grid. Processes in the same row share the
+     * z chunk and transpose between x and y pencils. Processes in the same
+     * column share the x chunk and transpose between y and z pencils.
+     */
+    {
+        MPI_Comm_dup(domain.m_comm, &m_comm);
+        MPI_Comm_size(m_comm, &m_n_procs);
+        MPI_Comm_rank(m_comm, &m_proc_id);
+
+        m_dims[0] = m_dims[1] = 0;
+        MPI_Dims_create(m_n_procs, 2, m_dims);
+        m_coords[0] = m_proc_id % m_dims[0];
+        m_coords[1] = m_proc_id / m_dims[0];
+
+        MPI_Comm_split(m_comm, m_coords[1], m_coords[0], &m_row_comm);
+        MPI_Comm_split(m_comm, m_coords[0], m_coords[1], &m_col_comm);
+    }
+
+    /*
+     * Setup the mesh and pencil extents.
+     */
+    {
+        m_order = Params::pme_order;
+        m_alpha = Params::ewald_alpha;
+        m_virial = 0.0;
+        m_size[0] = m_size[1] = m_size[2] = Params::pme_grid;
+        core_assert(math::fft::ispow2(Params::pme_grid),
+            "mesh size is not a power of two");
+        core_assert(m_order >= 3, "B-spline order is too small");
+        core_assert(m_size[0] % m_dims[0] == 0 &&
+                    m_size[1] % m_dims[0] == 0 &&
+                    m_size[1] % m_dims[1] == 0 &&
+                    m_size[2] % m_dims[1] == 0,
+            "mesh is not divisible over the pencil grid");
+
+        m_nx = m_size[0] / m_dims[0];
+        m_ny = m_size[1] / m_dims[0];
+        m_ny2 = m_size[1] / m_dims[1];
+        m_nz = m_size[2] / m_dims[1];
+
+        const size_t n_mesh = m_size[0] * m_size[1] * m_size[2];
+        const size_t n_pencil = n_mesh / m_n_procs;
+        m_pencil_x.resize(n_pencil);
+        m_pencil_y.resize(n_pencil);
+        m_pencil_z.resize(n_pencil);
+        m_send.resize(n_pencil);
+        m_recv.resize(n_pencil);
+        m_influence.resize(n_pencil, 0.0);
+        m_virial_factor.resize(n_pencil, 0.0);
+
+        for (int dim = 0; dim < 3; ++dim) {
+            m_local_lo[dim] = 0;
+            m_local_size[dim] = 0;
+        }
+        m_extents.resize(6 * m_n_procs, 0);
+        m_send_count.resize(m_n_procs, 0);
+        m_send_offset.resize(m_n_procs, 0);
+        m_recv_count.resize(m_n_procs, 0);
+        m_recv_offset.resize(m_n_procs, 0);
+
+        for (int dim = 0; dim < 3; ++dim) {
+            m_moduli[dim] = bspline_moduli(m_order, m_size[dim]);
+            m_plans.emplace_back(m_size[dim]);
+        }
+    }
+
+    set_box(domain.m_box_lo, domain.m_box_length);
+}
+
+/**
+ * Pme::~Pme
+ * @brief Free the pencil communicators.
+ */
+Pme::~Pme()
+{
+    if (m_col_comm != MPI_COMM_NULL) {
+        MPI_Comm_free(&m_col_comm);
+    }
+    if (m_row_comm != MPI_COMM_NULL) {
+        MPI_Comm_free(&m_row_comm);
+    }
+    if (m_comm != MPI_COMM_NULL) {
+        MPI_Comm_free(&m_comm);
+    }
+}
+
+/** ---------------------------------------------------------------------------
+ * Pme::set_box
+ * @brief Set the box bounds and recompute the influence function over the
+ * wave vectors of the local z-pencil,
+ *      C(m) = exp(-pi^2 m^2 / alpha^2) / (pi V m^2 B(m)),
+ * with C(0) = 0 and B(m) the product of the B-spline moduli. The trace of
+ * the reciprocal virial of each wave vector is its energy times the factor
+ * 1 - 2 pi^2 m^2 / alpha^2.
+ */
+void Pme::set_box(const cl_double box_lo[3], const cl_double box_length[3])
+{
+    for (int dim = 0; dim < 3; ++dim) {
+        m_box_lo[dim] = box_lo[dim];
+        m_box_length[dim] = box_length[dim];
+    }
+
+    const cl_double volume =
+        m_box_length[0] * m_box_length[1] * m_box_length[2];
+    const cl_double factor = M_PI * M_PI / (m_alpha * m_alpha);
+    for (cl_uint y = 0; y < m_ny2; ++y) {
+        for (cl_uint x = 0; x < m_nx; ++x) {
+            for (cl_uint z = 0; z < m_size[2]; ++z) {
+                cl_uint m[3] = {
+                    m_coords[0] * m_nx + x, m_coords[1] * m_ny2 + y, z};
+                cl_double m_sq = 0.0;
+                cl_double moduli = 1.0;
+                for (int dim = 0; dim < 3; ++dim) {
+                    cl_double k = (m[dim] <= m_size[dim] / 2)
+                        ? (cl_double) m[dim]
+                        : (cl_double) m[dim] - (cl_double) m_size[dim];
+                    k /= m_box_length[dim];
+                    m_sq += k * k;
+                    moduli *= m_moduli[dim][m[dim]];
+                }
+
+                size_t ix = (y * m_nx + x) * m_size[2] + z;
+                m_influence[ix] = (m_sq > 0.0)
+                    ? std::exp(-factor * m_sq) / (M_PI * volume * m_sq * moduli)
+                    : 0.0;
+                m_virial_factor[ix] = 1.0 - 2.0 * factor * m_sq;
+            }
+        }
+    }
+}
+
+/** ---------------------------------------------------------------------------
+ * Pme::compute
+ * @brief Compute the reciprocal space forces on the local particles and
+ * return the local contribution to the reciprocal and self energies. The
+ * local contribution to the trace of the reciprocal virial is stored in
+ * m_virial. The forces are stored in structure of arrays layout with the
+ * given stride.
+ * The system is assumed to be neutral.
+ */
+cl_double Pme::compute(
+    const std::vector<cl_double> &position,
+    const std::vector<cl_double> &charge,
+    const cl_uint stride,
+    const cl_uint n_local,
+    std::vector<cl_double> &force)
+{
+    /* Spread the charges and sum the local meshes into the x-pencils. */
+    spread(position, charge, stride, n_local);
+    scatter_mesh();
+
+    /* Forward transform, convolution and backward transform. */
+    transform_x(-1);
+    transpose_xy();
+    transform_y(-1);
+    transpose_yz();
+    transform_z(-1);
+
+    cl_double energy = convolve();
+
+    transform_z(1);
+    transpose_zy();
+    transform_y(1);
+    transpose_yx();
+    transform_x(1);
+
+    /* Return the potential to the local mesh and interpolate the forces. */
+    gather_mesh();
+    interpolate(charge, stride, n_local, force);
+
+    /* Self energy of the local charges. */
+    cl_double q_sq = 0.0;
+    for (cl_uint i = 0; i < n_local; ++i) {
+        q_sq += charge[i] * charge[i];
+    }
+    energy -= m_alpha / std::sqrt(M_PI) * q_sq;
+
+    return energy;
+}
+
+/** ---------------------------------------------------------------------------
+ * Pme::spread
+ * @brief Spread the local charges onto the local mesh. The first grid point
+ * of each particle is kept unwrapped, and the local mesh spans the first
+ * grid points of the local particles and the order-1 points past them, so
+ * no index wraps around the box. The mesh is split into slabs of pme_order
+ * planes along z, and the particles are binned by the slab of their first
+ * grid point. A particle spreads onto its slab and the next one, so slabs
+ * of the same parity never write the same planes. Even and odd slabs are
+ * spread in two passes, each parallel over the slabs, without atomics.
+ */
+void Pme::spread(
+    const std::vector<cl_double> &position,
+    const std::vector<cl_double> &charge,
+    const cl_uint stride,
+    const cl_uint n_local)
+{
+    const cl_uint order = m_order;
+    m_index.resize(3 * n_local);
+    m_theta.resize(3 * order * n_local);
+    m_dtheta.resize(3 * order * n_local);
+
+    /* Compute the spline weights of each particle along each dimension. */
+    core_pragma_omp(parallel for schedule(static))
+    for (cl_uint i = 0; i < n_local; ++i) {
+        for (int dim = 0; dim < 3; ++dim) {
+            cl_double u = m_size[dim] *
+                (position[i + dim * stride] - m_box_lo[dim]) /
+                m_box_length[dim];
+            cl_double k0 = std::floor(u);
+
+            m_index[3*i + dim] = (cl_int) k0;
+            bspline(u - k0, order,
+                &m_theta[(3*i + dim) * order],
+                &m_dtheta[(3*i + dim) * order]);
+        }
+    }
+
+    /* Bounds of the local mesh, relative to which the indices are kept. */
+    for (int dim = 0; dim < 3; ++dim) {
+        cl_int lo = (n_local > 0) ? m_index[dim] : 0;
+        cl_int hi = lo;
+        for (cl_uint i = 1; i < n_local; ++i) {
+            lo = std::min(lo, m_index[3*i + dim]);
+            hi = std::max(hi, m_index[3*i + dim]);
+        }
+        m_local_lo[dim] = lo;
+        m_local_size[dim] = (n_local > 0) ? hi - lo + (cl_int) order : 0;
+        for (cl_uint i = 0; i < n_local; ++i) {
+            m_index[3*i + dim] -= lo;
+        }
+    }
+    const cl_int nx = m_local_size[0];
+    const cl_int ny = m_local_size[1];
+    const cl_int nz = m_local_size[2];
+
+    /* Bin the particles in the spreading slabs. */
+    const cl_int n_first = std::max(nz - (cl_int) order + 1, 0);
+    m_slabs.resize((n_first + order - 1) / order);
+    for (auto &slab : m_slabs) {
+        slab.clear();
+    }
+    for (cl_uint i = 0; i < n_local; ++i) {
+        m_slabs[m_index[3*i + 2] / order].push_back(i);
+    }
+
+    /* Spread the charges, one slab parity at a time. */
+    m_local_mesh.assign((size_t) nx * ny * nz, 0.0);
+    const int n_slabs = (int) m_slabs.size();
+    for (int parity = 0; parity < 2; ++parity) {
+        core_pragma_omp(parallel for schedule(dynamic))
+        for (int s = parity; s < n_slabs; s += 2) {
+            for (auto i : m_slabs[s]) {
+                const cl_int *k0 = &m_index[3*i];
+                const cl_double *theta_x = &m_theta[(3*i + 0) * order];
+                const cl_double *theta_y = &m_theta[(3*i + 1) * order];
+                const cl_double *theta_z = &m_theta[(3*i + 2) * order];
+                for (cl_uint jz = 0; jz < order; ++jz) {
+                    for (cl_uint jy = 0; jy < order; ++jy) {
+                        cl_double q = charge[i] * theta_z[jz] * theta_y[jy];
+                        cl_double *row = &m_local_mesh[
+                            ((k0[2] + jz) * ny + k0[1] + jy) * nx + k0[0]];
+                        for (cl_uint jx = 0; jx < order; ++jx) {
+                            row[jx] += q * theta_x[jx];
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+/**
+ * Pme::interpolate
+ * @brief Interpolate the forces on the local particles from the gradient of
+ * the spline weights over the potential of the local mesh.
+ */
+void Pme::interpolate(
+    const std::vector<cl_double> &charge,
+    const cl_uint stride,
+    const cl_uint n_local,
+    std::vector<cl_double> &force)
+{
+    const cl_uint order = m_order;
+    const cl_int nx = m_local_size[0];
+    const cl_int ny = m_local_size[1];
+    const cl_double scale[3] = {
+        m_size[0] / m_box_length[0],
+        m_size[1] / m_box_length[1],
+        m_size[2] / m_box_length[2]};
+
+    core_pragma_omp(parallel for schedule(static))
+    for (cl_uint i = 0; i < n_local; ++i) {
+        const cl_int *k0 = &m_index[3*i];
+        const cl_double *theta_x = &m_theta[(3*i + 0) * order];
+        const cl_double *theta_y = &m_theta[(3*i + 1) * order];
+        const cl_double *theta_z = &m_theta[(3*i + 2) * order];
+        const cl_double *dtheta_x = &m_dtheta[(3*i + 0) * order];
+        const cl_double *dtheta_y = &m_dtheta[(3*i + 1) * order];
+        const cl_double *dtheta_z = &m_dtheta[(3*i + 2) * order];
+
+        cl_double f[3] = {0.0, 0.0, 0.0};
+        for (cl_uint jz = 0; jz < order; ++jz) {
+            for (cl_uint jy = 0; jy < order; ++jy) {
+                const cl_double *row = &m_local_mesh[
+                    ((k0[2] + jz) * ny + k0[1] + jy) * nx + k0[0]];
+                for (cl_uint jx = 0; jx < order; ++jx) {
+                    cl_double phi = row[jx];
+                    f[0] += dtheta_x[jx] * theta_y[jy] * theta_z[jz] * phi;
+                    f[1] += theta_x[jx] * dtheta_y[jy] * theta_z[jz] * phi;
+                    f[2] += theta_x[jx] * theta_y[jy] * dtheta_z[jz] * phi;
+                }
+            }
+        }
+        for (int dim = 0; dim < 3; ++dim) {
+            force[i + dim * stride] = -charge[i] * scale[dim] * f[dim];
+        }
+    }
+}
+
+/**
+ * Pme::convolve
+ * @brief Multiply the transformed charge mesh by the influence function and
+ * return the local part of the reciprocal energy, 1/2 sum C(m) |Q(m)|^2.
+ * The local part of the reciprocal virial trace is accumulated in the same
+ * pass.
+ */
+cl_double Pme::convolve(void)
+{
+    cl_double energy = 0.0;
+    cl_double virial = 0.0;
+    for (size_t ix = 0; ix < m_pencil_z.size(); ++ix) {
+        cl_double e = m_influence[ix] * std::norm(m_pencil_z[ix]);
+        energy += e;
+        virial += e * m_virial_factor[ix];
+        m_pencil_z[ix] *= m_influence[ix];
+    }
+    m_virial = 0.5 * virial;
+    return 0.5 * energy;
+}
+
+/** ---------------------------------------------------------------------------
+ * Pme::exchange_extents
+ * @brief Share the bounds of the local meshes over all processes, and count
+ * the points each process sends to and receives from every x-pencil. Only
+ * the 6 bounds of each process are gathered, so the counts are derived on
+ * both ends of each message without sending the mesh indices.
+ */
+void Pme::exchange_extents(void)
+{
+    const cl_int extent[6] = {
+        m_local_lo[0], m_local_lo[1], m_local_lo[2],
+        m_local_size[0], m_local_size[1], m_local_size[2]};
+    MPI_Allgather(
+        extent, 6, MPI_INT,
+        m_extents.data(), 6, MPI_INT, m_comm);
+
+    int n_send = 0;
+    int n_recv = 0;
+    for (int rank = 0; rank < m_n_procs; ++rank) {
+        overlap_lines(rank, true);
+        m_send_count[rank] = (int) (m_overlap[0].size() * m_overlap[1].size()) *
+            m_local_size[0];
+        m_send_offset[rank] = n_send;
+        n_send += m_send_count[rank];
+
+        overlap_lines(rank, false);
+        m_recv_count[rank] = (int) (m_overlap[0].size() * m_overlap[1].size()) *
+            m_extents[6 * rank + 3];
+        m_recv_offset[rank] = n_recv;
+        n_recv += m_recv_count[rank];
+    }
+    m_mesh_send.resize(n_send);
+    m_mesh_recv.resize(n_recv);
+}
+
+/**
+ * Pme::overlap_lines
+ * @brief List the x-lines of a local mesh held by an x-pencil, as the local
+ * y indices in m_overlap[0] and the local z indices in m_overlap[1]. With
+ * local set, the lines of this process held by the pencil of rank, else the
+ * lines of rank held by the pencil of this process. A line is held by the
+ * pencil whose y and z chunks hold the periodic image of its indices.
+ */
+void Pme::overlap_lines(const int rank, const bool local)
+{
+    const int owner = local ? rank : m_proc_id;
+    const cl_int *extent = &m_extents[6 * (local ? m_proc_id : rank)];
+    const cl_int chunk_lo[2] = {
+        (cl_int) ((owner % m_dims[0]) * m_ny),
+        (cl_int) ((owner / m_dims[0]) * m_nz)};
+    const cl_int chunk_size[2] = {(cl_int) m_ny, (cl_int) m_nz};
+
+    for (int dim = 0; dim < 2; ++dim) {
+        const cl_int lo = extent[dim + 1];
+        const cl_int size = extent[dim + 4];
+        m_overlap[dim].clear();
+        for (cl_int l = 0; l < size; ++l) {
+            cl_int k = wrap(lo + l, (cl_int) m_size[dim + 1]) - chunk_lo[dim];
+            if (k >= 0 && k < chunk_size[dim]) {
+                m_overlap[dim].push_back(l);
+            }
+        }
+    }
+}
+
+/**
+ * Pme::scatter_mesh
+ * @brief Sum the local meshes of all processes into the x-pencils. Each
+ * process sends the x-lines of its local mesh to the pencil holding them,
+ * z-major and y-minor, and the pencil adds each line at the periodic image
+ * of its indices.
+ */
+void Pme::scatter_mesh(void)
+{
+    exchange_extents();
+
+    const cl_int nx = m_local_size[0];
+    const cl_int ny = m_local_size[1];
+    for (int rank = 0; rank < m_n_procs; ++rank) {
+        if (m_send_count[rank] == 0) {
+            continue;
+        }
+        overlap_lines(rank, true);
+        cl_double *send = &m_mesh_send[m_send_offset[rank]];
+        for (auto z : m_overlap[1]) {
+            for (auto y : m_overlap[0]) {
+                std::copy_n(&m_local_mesh[(z * ny + y) * nx], nx, send);
+                send += nx;
+            }
+        }
+    }
+
+    MPI_Alltoallv(
+        m_mesh_send.data(), m_send_count.data(), m_send_offset.data(),
+        MPI_DOUBLE,
+        m_mesh_recv.data(), m_recv_count.data(), m_recv_offset.data(),
+        MPI_DOUBLE,
+        m_comm);
+
+    const cl_int y0 = (m_proc_id % m_dims[0]) * m_ny;
+    const cl_int z0 = (m_proc_id / m_dims[0]) * m_nz;
+    std::fill(m_pencil_x.begin(), m_pencil_x.end(), 0.0);
+    for (int rank = 0; rank < m_n_procs; ++rank) {
+        if (m_recv_count[rank] == 0) {
+            continue;
+        }
+        overlap_lines(rank, false);
+        const cl_int *extent = &m_extents[6 * rank];
+        const cl_double *recv = &m_mesh_recv[m_recv_offset[rank]];
+        for (auto z : m_overlap[1]) {
+            cl_int pz = wrap(extent[2] + z, m_size[2]) - z0;
+            for (auto y : m_overlap[0]) {
+                cl_int py = wrap(extent[1] + y, m_size[1]) - y0;
+                std::complex<cl_double> *line =
+                    &m_pencil_x[(pz * m_ny + py) * m_size[0]];
+                cl_int px = wrap(extent[0], m_size[0]);
+                for (cl_int x = 0; x < extent[3]; ++x) {
+                    line[px] += recv[x];
+                    px = (px + 1 == (cl_int) m_size[0]) ? 0 : px + 1;
+                }
+                recv += extent[3];
+            }
+        }
+    }
+}
+
+/**
+ * Pme::gather_mesh
+ * @brief Return the potential of the x-pencils to the local meshes, the
+ * reverse of scatter_mesh. The potential is real, so only the real parts
+ * are sent.
+ */
+void Pme::gather_mesh(void)
+{
+    const cl_int y0 = (m_proc_id % m_dims[0]) * m_ny;
+    const cl_int z0 = (m_proc_id / m_dims[0]) * m_nz;
+    for (int rank = 0; rank < m_n_procs; ++rank) {
+        if (m_recv_count[rank] == 0) {
+            continue;
+        }
+        overlap_lines(rank, false);
+        const cl_int *extent = &m_extents[6 * rank];
+        cl_double *send = &m_mesh_recv[m_recv_offset[rank]];
+        for (auto z : m_overlap[1]) {
+            cl_int pz = wrap(extent[2] + z, m_size[2]) - z0;
+            for (auto y : m_overlap[0]) {
+                cl_int py = wrap(extent[1] + y, m_size[1]) - y0;
+                const std::complex<cl_double> *line =
+                    &m_pencil_x[(pz * m_ny + py) * m_size[0]];
+                cl_int px = wrap(extent[0], m_size[0]);
+                for (cl_int x = 0; x < extent[3]; ++x) {
+                    send[x] = line[px].real();
+                    px = (px + 1 == (cl_int) m_size[0]) ? 0 : px + 1;
+                }
+                send += extent[3];
+            }
+        }
+    }
+
+    MPI_Alltoallv(
+        m_mesh_recv.data(), m_recv_count.data(), m_recv_offset.data(),
+        MPI_DOUBLE,
+        m_mesh_send.data(), m_send_count.data(), m_send_offset.data(),
+        MPI_DOUBLE,
+        m_comm);
+
+    const cl_int nx = m_local_size[0];
+    const cl_int ny = m_local_size[1];
+    for (int rank = 0; rank < m_n_procs; ++rank) {
+        if (m_send_count[rank] == 0) {
+            continue;
+        }
+        overlap_lines(rank, true);
+        const cl_double *recv = &m_mesh_send[m_send_offset[rank]];
+        for (auto z : m_overlap[1]) {
+            for (auto y : m_overlap[0]) {
+                std::copy_n(recv, nx, &m_local_mesh[(z * ny + y) * nx]);
+                recv += nx;
+            }
+        }
+    }
+}
+
+/** ---------------------------------------------------------------------------
+ * Pme::transform_x
+ * @brief Transform the contiguous lines of the x-pencils.
+ */
+void Pme::transform_x(const int sign)
+{
+    const int n_lines = (int) (m_nz * m_ny);
+    core_pragma_omp(parallel for schedule(static))
+    for (int line = 0; line < n_lines; ++line) {
+        math::fft::transform(
+            m_plans[0], &m_pencil_x[line * m_size[0]], 1, sign);
+    }
+}
+
+/**
+ * Pme::transform_y
+ * @brief Transform the contiguous lines of the y-pencils.
+ */
+void Pme::transform_y(const int sign)
+{
+    const int n_lines = (int) (m_nz * m_nx);
+    core_pragma_omp(parallel for schedule(static))
+    for (int line = 0; line < n_lines; ++line) {
+        math::fft::transform(
+            m_plans[1], &m_pencil_y[line * m_size[1]], 1, sign);
+    }
+}
+
+/**
+ * Pme::transform_z
+ * @brief Transform the contiguous lines of the z-pencils.
+ */
+void Pme::transform_z(const int sign)
+{
+    const int n_lines = (int) (m_ny2 * m_nx);
+    core_pragma_omp(parallel for schedule(static))
+    for (int line = 0; line < n_lines; ++line) {
+        math::fft::transform(
+            m_plans[2], &m_pencil_z[line * m_size[2]], 1, sign);
+    }
+}
+
+/** ---------------------------------------------------------------------------
+ * Pme::transpose_xy
+ * @brief Transpose the x-pencils into y-pencils within the row communicator.
+ * Each process sends the x chunk of process q to process q and receives the
+ * y chunk of process q, for every process q in the row.
+ */
+void Pme::transpose_xy(void)
+{
+    const int n = m_dims[0];
+    const size_t block = m_nz * m_ny * m_nx;
+    for (int q = 0; q < n; ++q) {
+        for (cl_uint z = 0; z < m_nz; ++z) {
+            for (cl_uint y = 0; y < m_ny; ++y) {
+                std::copy_n(
+                    &m_pencil_x[(z * m_ny + y) * m_size[0] + q * m_nx],
+                    m_nx,
+                    &m_send[q * block + (z * m_ny + y) * m_nx]);
+            }
+        }
+    }
+
+    MPI_Alltoall(
+        m_send.data(), (int) (2 * block), MPI_DOUBLE,
+        m_recv.data(), (int) (2 * block), MPI_DOUBLE, m_row_comm);
+
+    for (int q = 0; q < n; ++q) {
+        for (cl_uint z = 0; z < m_nz; ++z) {
+            for (cl_uint y = 0; y < m_ny; ++y) {
+                for (cl_uint x = 0; x < m_nx; ++x) {
+                    m_pencil_y[(z * m_nx + x) * m_size[1] + q * m_ny + y] =
+                        m_recv[q * block + (z * m_ny + y) * m_nx + x];
+                }
+            }
+        }
+    }
+}
+
+/**
+ * Pme::transpose_yx
+ * @brief Transpose the y-pencils back into x-pencils, the inverse of
+ * transpose_xy.
+ */
+void Pme::transpose_yx(void)
+{
+    const int n = m_dims[0];
+    const size_t block = m_nz * m_ny * m_nx;
+    for (int q = 0; q < n; ++q) {
+        for (cl_uint z = 0; z < m_nz; ++z) {
+            for (cl_uint y = 0; y < m_ny; ++y) {
+                for (cl_uint x = 0; x < m_nx; ++x) {
+                    m_send[q * block + (z * m_ny + y) * m_nx + x] =
+                        m_pencil_y[(z * m_nx + x) * m_size[1] + q * m_ny + y];
+                }
+            }
+        }
+    }
+
+    MPI_Alltoall(
+        m_send.data(), (int) (2 * block), MPI_DOUBLE,
+        m_recv.data(), (int) (2 * block), MPI_DOUBLE, m_row_comm);
+
+    for (int q = 0; q < n; ++q) {
+        for (cl_uint z = 0; z < m_nz; ++z) {
+            for (cl_uint y = 0; y < m_ny; ++y) {
+                std::copy_n(
+                    &m_recv[q * block + (z * m_ny + y) * m_nx],
+                    m_nx,
+                    &m_pencil_x[(z * m_ny + y) * m_size[0] + q * m_nx]);
+            }
+        }
+    }
+}
+
+/**
+ * Pme::transpose_yz
+ * @brief Transpose the y-pencils into z-pencils within the column
+ * communicator. Each process sends the y chunk of process q to process q and
+ * receives the z chunk of process q, for every process q in the column.
+ */
+void Pme::transpose_yz(void)
+{
+    const int n = m_dims[1];
+    const size_t block = m_nz * m_nx * m_ny2;
+    for (int q = 0; q < n; ++q) {
+        for (cl_uint z = 0; z < m_nz; ++z) {
+            for (cl_uint x = 0; x < m_nx; ++x) {
+                std::copy_n(
+                    &m_pencil_y[(z * m_nx + x) * m_size[1] + q * m_ny2],
+                    m_ny2,
+                    &m_send[q * block + (z * m_nx + x) * m_ny2]);
+            }
+        }
+    }
+
+    MPI_Alltoall(
+        m_send.data(), (int) (2 * block), MPI_DOUBLE,
+        m_recv.data(), (int) (2 * block), MPI_DOUBLE, m_col_comm);
+
+    for (int q = 0; q < n; ++q) {
+        for (cl_uint z = 0; z < m_nz; ++z) {
+            for (cl_uint x = 0; x < m_nx; ++x) {
+                for (cl_uint y = 0; y < m_ny2; ++y) {
+                    m_pencil_z[(y * m_nx + x) * m_size[2] + q * m_nz + z] =
+                        m_recv[q * block + (z * m_nx + x) * m_ny2 + y];
+                }
+            }
+        }
+    }
+}
+
+/**
+ * Pme::transpose_zy
+ * @brief Transpose the z-pencils back into y-pencils, the inverse of
+ * transpose_yz.
+ */
+void Pme::transpose_zy(void)
+{
+    const int n = m_dims[1];
+    const size_t block = m_nz * m_nx * m_ny2;
+    for (int q = 0; q < n; ++q) {
+        for (cl_uint z = 0; z < m_nz; ++z) {
+            for (cl_uint x = 0; x < m_nx; ++x) {
+                for (cl_uint y = 0; y < m_ny2; ++y) {
+                    m_send[q * block + (z * m_nx + x) * m_ny2 + y] =
+                        m_pencil_z[(y * m_nx + x) * m_size[2] + q * m_nz + z];
+                }
+            }
+        }
+    }
+
+    MPI_Alltoall(
+        m_send.data(), (int) (2 * block), MPI_DOUBLE,
+        m_recv.data(), (int) (2 * block), MPI_DOUBLE, m_col_comm);
+
+    for (int q = 0; q < n; ++q) {
+        for (cl_uint z = 0; z < m_nz; ++z) {
+            for (cl_uint x = 0; x < m_nx; ++x) {
+                std::copy_n(
+                    &m_recv[q * block + (z * m_nx + x) * m_ny2],
+                    m_ny2,
+                    &m_pencil_y[(z * m_nx + x) * m_size[1] + q * m_ny2]);
+            }
+        }
+    }
+}
@@ -0,0 +1,134 @@
+/*
+ * pme.hpp
+ *
+ * Copyright (c) 2020 Carlos Braga
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the MIT License.
+ *
+ * See accompanying LICENSE.md or https://opensource.org/licenses/MIT.
+ */
+
+#ifndef PME_H_
+#define PME_H_
+
+#include <algorithm>
+#include <complex>
+#include <vector>
+#include "base.hpp"
+#include "domain.hpp"
+
+/**
+ * Pme
+ * @brief Reciprocal space part of the smooth particle mesh Ewald sum.
+ *
+ * The charges are spread with B-splines of order pme_order onto a local
+ * mesh, which covers only the grid points of the local particles, the
+ * subdomain and pme_order-1 ghost planes. Each line of the local mesh is
+ * sent to the process holding it in the 2-d grid of x-pencils, where the
+ * contributions are summed. The 3-d transform is done as three batches of
+ * 1-d transforms, one per dimension, with the pencils transposed by
+ * all-to-all messages in the row and column communicators between the
+ * batches. The convolution with the influence function is applied in the
+ * z-pencils. The potential is transformed back and the same lines are
+ * returned to the local meshes to interpolate the forces on the local
+ * particles. Memory and messages per process scale with the subdomain and
+ * the pencil, never with the whole mesh.
+ *
+ * Layout of the pencils, with pencil grid dims (py, pz):
+ *  x-pencil    [nz][ny][Kx],   z in the pz chunk, y in the py chunk
+ *  y-pencil    [nz][nx][Ky],   z in the pz chunk, x in the py chunk
+ *  z-pencil    [ny2][nx][Kz],  y in the pz chunk, x in the py chunk
+ *  local mesh  [nz][ny][nx],   unwrapped grid points from local_lo
+ */
+struct Pme {
+    /* ---- Pencil process grid -------------------------------------------- */
+    MPI_Comm m_comm = MPI_COMM_NULL;
+    MPI_Comm m_row_comm = MPI_COMM_NULL;
+    MPI_Comm m_col_comm = MPI_COMM_NULL;
+    int m_proc_id;
+    int m_n_procs;
+    int m_dims[2];
+    int m_coords[2];
+
+    /* ---- Mesh and pencil extents ---------------------------------------- */
+    cl_uint m_order;
+    cl_uint m_size[3];
+    cl_uint m_nx;
+    cl_uint m_ny;
+    cl_uint m_ny2;
+    cl_uint m_nz;
+    cl_double m_alpha;
+    cl_double m_virial;
+    cl_double m_box_lo[3];
+    cl_double m_box_length[3];
+
+    /* ---- Local mesh and its exchange with the x-pencils ----------------- */
+    cl_int m_local_lo[3];
+    cl_int m_local_size[3];
+    std::vector<cl_double> m_local_mesh;
+    std::vector<cl_int> m_extents;
+    std::vector<cl_int> m_overlap[2];
+    std::vector<int> m_send_count;
+    std::vector<int> m_send_offset;
+    std::vector<int> m_recv_count;
+    std::vector<int> m_recv_offset;
+    std::vector<cl_double> m_mesh_send;
+    std::vector<cl_double> m_mesh_recv;
+
+    /* ---- Pencil data ---------------------------------------------------- */
+    std::vector<std::complex<cl_double>> m_pencil_x;
+    std::vector<std::complex<cl_double>> m_pencil_y;
+    std::vector<std::complex<cl_double>> m_pencil_z;
+    std::vector<std::complex<cl_double>> m_send;
+    std::vector<std::complex<cl_double>> m_recv;
+    std::vector<cl_double> m_influence;
+    std::vector<cl_double> m_virial_factor;
+    std::vector<cl_double> m_moduli[3];
+    std::vector<atto::math::fft::Plan<cl_double>> m_plans;
+
+    /* ---- Per particle spline data --------------------------------------- */
+    std::vector<cl_int> m_index;
+    std::vector<cl_double> m_theta;
+    std::vector<cl_double> m_dtheta;
+    std::vector<std::vector<cl_uint>> m_slabs;
+
+    /* ---- Pme member functions ------------------------------------------- */
+    cl_double compute(
+        const std::vector<cl_double> &position,
+        const std::vector<cl_double> &charge,
+        const cl_uint stride,
+        const cl_uint n_local,
+        std::vector<cl_double> &force);
+    void set_box(const cl_double box_lo[3], const cl_double box_length[3]);
+
+    void spread(
+        const std::vector<cl_double> &position,
+        const std::vector<cl_double> &charge,
+        const cl_uint stride,
+        const cl_uint n_local);
+    void interpolate(
+        const std::vector<cl_double> &charge,
+        const cl_uint stride,
+        const cl_uint n_local,
+        std::vector<cl_double> &force);
+    cl_double convolve(void);
+    void exchange_extents(void);
+    void overlap_lines(const int rank, const bool local);
+    void scatter_mesh(void);
+    void gather_mesh(void);
+    void transform_x(const int sign);
+    void transform_y(const int sign);
+    void transform_z(const int sign);
+    void transpose_xy(void);
+    void transpose_yx(void);
+    void transpose_yz(void);
+    void transpose_zy(void);
+
+    explicit Pme(const Domain &domain);
+    ~Pme();
+    Pme(const Pme &) = delete;
+    Pme &operator=(const Pme &) = delete;
+};
+
+#endif /* PME_H_ */
@@ -0,0 +1,77 @@
+/*
+ * profile.hpp
+ *
+ * Copyright (c) 2020 Carlos Braga
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the MIT License.
+ *
+ * See accompanying LICENSE.md or https://opensource.org/licenses/MIT.
+ */
+
+#ifndef PROFILE_H_
+#define PROFILE_H_
+
+#include <vector>
+#include "base.hpp"
+
+/**
+ * Profile
+ * @brief Instrumentation of the device work per category. Kernel events are
+ * recorded as they are enqueued and only resolved on collect, so recording
+ * never blocks the command queues. The queues must be created with
+ * CL_QUEUE_PROFILING_ENABLE, and pending events must be collected before
+ * the queues are released.
+ */
+struct Profile {
+    enum {
+        Force = 0,
+        Neighbour,
+        NumCategories
+    };
+    std::vector<cl_event> m_events[NumCategories];
+    cl_double m_elapsed[NumCategories];
+
+    /* Record a kernel event in the specified category. */
+    void record(const int category, cl_event event) {
+        m_events[category].push_back(event);
+    }
+
+    /* Wait for the recorded events and accumulate their device time. */
+    void collect(void) {
+        for (int category = 0; category < NumCategories; ++category) {
+            for (auto &event : m_events[category]) {
+                atto::cl::Event::wait_for_event(event);
+                cl_ulong start = atto::cl::Event::get_command_start(event);
+                cl_ulong end = atto::cl::Event::get_command_end(event);
+                m_elapsed[category] += 1.0e-9 * (cl_double) (end - start);
+                atto::cl::Event::release(event);
+            }
+            m_events[category].clear();
+        }
+    }
+
+    /* Total device time over all categories. */
+    cl_double total(void) const {
+        cl_double sum = 0.0;
+        for (int category = 0; category < NumCategories; ++category) {
+            sum += m_elapsed[category];
+        }
+        return sum;
+    }
+
+    /* Reset the accumulated device times. */
+    void reset(void) {
+        for (int category = 0; category < NumCategories; ++category) {
+            m_elapsed[category] = 0.0;
+        }
+    }
+
+    /* Constructor/destructor. */
+    Profile() { reset(); }
+    ~Profile() = default;
+    Profile(const Profile &) = delete;
+    Profile &operator=(const Profile &) = delete;
+};
+
+#endif /* PROFILE_H_ */
@@ -0,0 +1,236 @@
+/*
+ * rdf.cpp
+ *
+ * Copyright (c) 2020 Carlos Braga
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the MIT License.
+ *
+ * See accompanying LICENSE.md or https://opensource.org/licenses/MIT.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include "rdf.hpp"
+using namespace atto;
+
+/** ---------------------------------------------------------------------------
+ * Rdf::Rdf
+ * @brief Create an empty accumulator. The pairs within rdf_r_max are found
+ * in the local and ghost cell bins with a stencil wide enough to reach it,
+ * so a range beyond the cutoff is sampled with more cells. The ghosts only
+ * cover the halo width, and a range beyond it is rejected rather than
+ * sampled with missing pairs.
+ */
+Rdf::Rdf(const Domain &domain)
+{
+    m_comm = domain.m_comm;
+    m_proc_id = domain.m_proc_id;
+    m_n_species = 1;
+    m_species = {{0.0, 0.0, 0.0, 0.0}};
+    m_count.resize(1, 0.0);
+    m_excluded.resize(1, 0.0);
+    m_n_samples = 0;
+    m_inv_volume = 0.0;
+
+    if (is_active()) {
+        core_assert(Params::rdf_r_max <= Params::r_halo,
+            "rdf range exceeds the halo width, increase the skin");
+    }
+}
+
+/** ---------------------------------------------------------------------------
+ * Rdf::setup
+ * @brief Find the species, the distinct charges of the particles over all
+ * processes in ascending order, and count the particles of each species.
+ * Without partial functions all the particles are of a single species.
+ *
+ * Every molecule has the sites of the topology, so the ordered pairs of
+ * sites within the same molecule, which are never counted, are found per
+ * pair of species from the site charges.
+ */
+void Rdf::setup(
+    const Topology &topology,
+    const cl_uint n_local,
+    const cl_double *charge)
+{
+    std::vector<cl_double> species;
+    if (Params::rdf_partial) {
+        /* Gather the distinct local charges, padded with NaN. */
+        std::vector<cl_double> local;
+        for (cl_uint i = 0; i < n_local; ++i) {
+            if (std::find(local.begin(), local.end(), charge[i]) ==
+                local.end()) {
+                local.push_back(charge[i]);
+                core_assert(local.size() <= MaxSpecies,
+                    "too many species for the partial rdf");
+            }
+        }
+        local.resize(MaxSpecies, std::numeric_limits<cl_double>::quiet_NaN());
+
+        int n_procs;
+        MPI_Comm_size(m_comm, &n_procs);
+        std::vector<cl_double> all(n_procs * MaxSpecies);
+        MPI_Allgather(
+            &local[0], MaxSpecies, MPI_DOUBLE,
+            &all[0], MaxSpecies, MPI_DOUBLE, m_comm);
+        for (auto &q : all) {
+            if (!std::isnan(q) &&
+                std::find(species.begin(), species.end(), q) == species.end()) {
+                species.push_back(q);
+            }
+        }
+        std::sort(species.begin(), species.end());
+        core_assert(species.size() <= MaxSpecies,
+            "too many species for the partial rdf");
+    }
+
+    m_n_species = std::max((cl_uint) species.size(), 1u);
+    for (cl_uint k = 0; k < MaxSpecies; ++k) {
+        m_species.s[k] = k < species.size() ? species[k] : 0.0;
+    }
+
+    /* Count the particles of each species over all processes. */
+    std::vector<cl_double> count(m_n_species, 0.0);
+    for (cl_uint i = 0; i < n_local; ++i) {
+        count[species_index(charge[i])] += 1.0;
+    }
+    m_count.resize(m_n_species);
+    MPI_Allreduce(
+        &count[0], &m_count[0], m_n_species, MPI_DOUBLE, MPI_SUM, m_comm);
+
+    /* Count the intramolecular ordered pairs of each pair of species. */
+    const cl_uint n_sites = topology.m_n_sites;
+    cl_double n_molecules = 0.0;
+    for (auto &n : m_count) {
+        n_molecules += n;
+    }
+    n_molecules /= (cl_double) n_sites;
+
+    std::vector<cl_double> sites(m_n_species, 0.0);
+    if (n_sites > 1) {
+        for (auto &q : topology.m_site_charge) {
+            sites[species_index(q)] += 1.0;
+        }
+    }
+    m_excluded.assign(n_pairs(), 0.0);
+    cl_uint p = 0;
+    for (cl_uint a = 0; a < m_n_species; ++a) {
+        for (cl_uint b = a; b < m_n_species; ++b, ++p) {
+            m_excluded[p] = n_molecules * ((a == b)
+                ? sites[a] * (sites[a] - 1.0)
+                : 2.0 * sites[a] * sites[b]);
+        }
+    }
+
+    m_histogram.assign(n_pairs() * Params::rdf_bins, 0);
+    m_total.assign(m_histogram.size(), 0);
+}
+
+/**
+ * Rdf::species_index
+ * @brief Return the index of the species of charge q, the first species if
+ * the charge is not one of them, as the rdf_species kernel function does.
+ */
+cl_uint Rdf::species_index(const cl_double q) const
+{
+    for (cl_uint k = 1; k < m_n_species; ++k) {
+        if (q == m_species.s[k]) {
+            return k;
+        }
+    }
+    return 0;
+}
+
+/**
+ * Rdf::sample
+ * @brief Record a sample accumulated on the device at the box volume. The
+ * ideal gas reference of each bin is proportional to the number density,
+ * so the inverse volumes are summed over the samples.
+ */
+void Rdf::sample(const cl_double volume)
+{
+    m_n_samples++;
+    m_inv_volume += 1.0 / volume;
+}
+
+/** ---------------------------------------------------------------------------
+ * Rdf::write
+ * @brief Reduce the histograms, read back from the device, on the master
+ * and write the averages. Each line holds the bin centre, the total g(r)
+ * and, with partial functions, g_ab(r) of each pair a <= b of species.
+ *
+ * The histograms count ordered pairs. The ideal gas reference of a bin of
+ * volume V_k is N_a (N_a - 1) V_k / V for a pair of the same species, and
+ * 2 N_a N_b V_k / V for a pair of different species, less the ordered
+ * pairs within the same molecule, which the histograms leave out.
+ */
+void Rdf::write(void)
+{
+    MPI_Reduce(
+        &m_histogram[0], &m_total[0], m_histogram.size(),
+        MPI_UINT64_T, MPI_SUM, Params::master_id, m_comm);
+    if (m_proc_id != Params::master_id || m_n_samples == 0) {
+        return;
+    }
+
+    const cl_uint n_bins = Params::rdf_bins;
+    const cl_double dr = Params::rdf_r_max / (cl_double) n_bins;
+    cl_double n_total = 0.0;
+    for (auto &n : m_count) {
+        n_total += n;
+    }
+    cl_double n_excluded = 0.0;
+    for (auto &n : m_excluded) {
+        n_excluded += n;
+    }
+    const cl_double n_total_pair = n_total * (n_total - 1.0) - n_excluded;
+
+    core::FileOut file(Params::rdf_file);
+    file.printf("# samples %llu species", (unsigned long long) m_n_samples);
+    for (cl_uint a = 0; a < m_n_species; ++a) {
+        file.printf(" %.17g", m_species.s[a]);
+    }
+    file.printf("\n# r g");
+    if (m_n_species > 1) {
+        for (cl_uint a = 0; a < m_n_species; ++a) {
+            for (cl_uint b = a; b < m_n_species; ++b) {
+                file.printf(" g_%u%u", a, b);
+            }
+        }
+    }
+    file.printf("\n");
+
+    for (cl_uint k = 0; k < n_bins; ++k) {
+        const cl_double r_lo = k * dr;
+        const cl_double r_hi = r_lo + dr;
+        const cl_double shell = (4.0 * M_PI / 3.0) *
+            (r_hi * r_hi * r_hi - r_lo * r_lo * r_lo);
+        const cl_double ideal = m_inv_volume * shell;
+
+        cl_double sum = 0.0;
+        for (cl_uint p = 0; p < n_pairs(); ++p) {
+            sum += (cl_double) m_total[p * n_bins + k];
+        }
+        file.printf("%.8e %.8e", r_lo + 0.5 * dr, n_total_pair > 0.0
+            ? sum / (ideal * n_total_pair)
+            : 0.0);
+
+        if (m_n_species > 1) {
+            cl_uint p = 0;
+            for (cl_uint a = 0; a < m_n_species; ++a) {
+                for (cl_uint b = a; b < m_n_species; ++b, ++p) {
+                    const cl_double n_pair = ((a == b)
+                        ? m_count[a] * (m_count[a] - 1.0)
+                        : 2.0 * m_count[a] * m_count[b]) - m_excluded[p];
+                    file.printf(" %.8e", n_pair > 0.0
+                        ? (cl_double) m_total[p * n_bins + k] / (ideal * n_pair)
+                        : 0.0);
+                }
+            }
+        }
+        file.printf("\n");
+    }
+    file.close();
+}
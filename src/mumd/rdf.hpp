@@ -0,0 +1,76 @@
+/*
+ * rdf.hpp
+ *
+ * Copyright (c) 2020 Carlos Braga
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the MIT License.
+ *
+ * See accompanying LICENSE.md or https://opensource.org/licenses/MIT.
+ */
+
+#ifndef RDF_H_
+#define RDF_H_
+
+#include <vector>
+#include "base.hpp"
+#include "domain.hpp"
+#include "topology.hpp"
+
+/**
+ * Rdf
+ * @brief Radial distribution function accumulated on the device. Every
+ * n_rdf_steps the distances of all pairs within rdf_r_max are binned by
+ * the rdf_accumulate kernel into a histogram of ordered pairs, which stays
+ * on the device for the whole run. The histograms are only read back and
+ * reduced over the processes on the master every n_rdf_output_steps, and
+ * the file is rewritten with the average over all samples so far.
+ *
+ * The kernel widens its cell stencil to reach rdf_r_max, so the range may
+ * exceed the cutoff, but the ghosts only extend r_halo beyond each
+ * subdomain. A range beyond the halo width is not supported, and the skin
+ * must be increased to sample it.
+ *
+ * Partial functions are computed for each unordered pair of species. The
+ * ghosts carry only their charge, so the species are the distinct particle
+ * charges, up to MaxSpecies of them. Pairs of sites of the same molecule
+ * are not counted, and neither are they in the ideal gas reference.
+ */
+struct Rdf {
+    /* ---- Species and their global number of particles ------------------- */
+    enum : cl_uint {
+        MaxSpecies = 4
+    };
+    MPI_Comm m_comm = MPI_COMM_NULL;
+    int m_proc_id;
+    cl_uint m_n_species;
+    cl_double4 m_species;
+    std::vector<cl_double> m_count;
+    std::vector<cl_double> m_excluded;
+
+    /* ---- Accumulated samples -------------------------------------------- */
+    cl_ulong m_n_samples;
+    cl_double m_inv_volume;
+    std::vector<cl_ulong> m_histogram;
+    std::vector<cl_ulong> m_total;
+
+    /* ---- Rdf member functions ------------------------------------------- */
+    static bool is_active(void) { return Params::rdf_file[0] != '\0'; }
+    cl_uint n_pairs(void) const {
+        return m_n_species * (m_n_species + 1) / 2;
+    }
+    cl_uint species_index(const cl_double q) const;
+    void setup(
+        const Topology &topology,
+        const cl_uint n_local,
+        const cl_double *charge);
+    void sample(const cl_double volume);
+    void write(void);
+
+    explicit Rdf(const Domain &domain);
+    ~Rdf() = default;
+    Rdf(const Rdf &) = delete;
+    Rdf &operator=(const Rdf &) = delete;
+};
+
+#endif /* RDF_H_ */
@@ -0,0 +1,165 @@
+/*
+ * table.cpp
+ *
+ * Copyright (c) 2020 Carlos Braga
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the MIT License.
+ *
+ * See accompanying LICENSE.md or https://opensource.org/licenses/MIT.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include "table.hpp"
+using namespace atto;
+
+/** ---------------------------------------------------------------------------
+ * PairTable::PairTable
+ * @brief Create the pair table of the model, read from pair_table_file, or
+ * the Lennard-Jones potential sampled at pair_table_size + 1 knots from
+ * pair_table_r_min to the cutoff radius.
+ */
+PairTable::PairTable()
+{
+    m_n_segments = 0;
+    m_s_min = m_s_max = m_inv_h = 0.0;
+
+    if (Params::pair_table_file[0] != '\0') {
+        read(Params::pair_table_file);
+        return;
+    }
+
+    const cl_uint n_knots = Params::pair_table_size + 1;
+    const cl_double s_min = Params::pair_table_r_min * Params::pair_table_r_min;
+    const cl_double s_max = Params::r_cut * Params::r_cut;
+    const cl_double h = (s_max - s_min) / (cl_double) (n_knots - 1);
+
+    std::vector<cl_double> energy(n_knots);
+    std::vector<cl_double> force(n_knots);
+    for (cl_uint k = 0; k < n_knots; ++k) {
+        cl_double sr2 = 1.0 / (s_min + k * h);
+        cl_double sr6 = sr2 * sr2 * sr2;
+        energy[k] = 4.0 * sr6 * (sr6 - 1.0);
+        force[k] = 24.0 * sr2 * sr6 * (2.0 * sr6 - 1.0);
+    }
+    tabulate(s_min, s_max, energy, force);
+}
+
+/**
+ * PairTable::~PairTable
+ * @brief Free the aligned coefficient array.
+ */
+PairTable::~PairTable()
+{
+    core::align_free(m_coeff);
+}
+
+/** ---------------------------------------------------------------------------
+ * PairTable::tabulate
+ * @brief Build the Hermite coefficients of each segment from the energy and
+ * the scaled force f = F / r at the uniform knots s_min + k h.
+ */
+void PairTable::tabulate(
+    const cl_double s_min,
+    const cl_double s_max,
+    const std::vector<cl_double> &energy,
+    const std::vector<cl_double> &force)
+{
+    core_assert(energy.size() == force.size() && energy.size() > 1,
+        "invalid pair table knots");
+    core_assert(s_max > s_min, "invalid pair table range");
+
+    m_n_segments = (cl_uint) energy.size() - 1;
+    m_s_min = s_min;
+    m_s_max = s_max;
+    m_inv_h = (cl_double) m_n_segments / (s_max - s_min);
+
+    core::align_free(m_coeff);
+    m_coeff = static_cast<cl_double *>(
+        core::align_alloc(4 * m_n_segments * sizeof(cl_double), 32));
+
+    const cl_double h = 1.0 / m_inv_h;
+    for (cl_uint k = 0; k < m_n_segments; ++k) {
+        cl_double u0 = energy[k];
+        cl_double u1 = energy[k + 1];
+        cl_double d0 = -0.5 * h * force[k];
+        cl_double d1 = -0.5 * h * force[k + 1];
+        cl_double *c = &m_coeff[4 * k];
+        c[0] = u0;
+        c[1] = d0;
+        c[2] = 3.0 * (u1 - u0) - 2.0 * d0 - d1;
+        c[3] = 2.0 * (u0 - u1) + d0 + d1;
+    }
+}
+
+/**
+ * PairTable::read
+ * @brief Read a pair table from a text file with one knot per line, the
+ * distance r, the energy U and the force F = -dU/dr. Lines starting with #
+ * are comments. The knots must be uniformly spaced in r^2, as in the RSQ
+ * tables of LAMMPS, and must reach the cutoff radius.
+ */
+void PairTable::read(const char *filename)
+{
+    std::vector<std::string> lines;
+    {
+        core::FileIn fp(filename);
+        fp.readlines(lines, std::numeric_limits<size_t>::max(), '\n', '#');
+    }
+
+    std::vector<cl_double> s;
+    std::vector<cl_double> energy;
+    std::vector<cl_double> force;
+    for (auto &line : lines) {
+        cl_double r, u, f;
+        if (std::sscanf(line.c_str(), "%lf %lf %lf", &r, &u, &f) != 3) {
+            continue;
+        }
+        core_assert(r > 0.0, "invalid pair table distance");
+        s.push_back(r * r);
+        energy.push_back(u);
+        force.push_back(f / r);
+    }
+    core_assert(s.size() > 1, "empty pair table");
+
+    const cl_double h = (s.back() - s.front()) / (cl_double) (s.size() - 1);
+    for (size_t k = 1; k < s.size(); ++k) {
+        core_assert(std::fabs(s[k] - s[k - 1] - h) <= 1.0e-6 * h,
+            "pair table knots are not uniform in r^2");
+    }
+    core_assert(s.back() >= Params::r_cut * Params::r_cut * (1.0 - 1.0e-12),
+        "pair table does not reach the cutoff radius");
+
+    tabulate(s.front(), s.back(), energy, force);
+}
+
+/** ---------------------------------------------------------------------------
+ * PairTable::compute
+ * @brief Interpolate the scaled forces and the energies at n squared
+ * distances. Each lane locates its segment independently, so the loop
+ * vectorizes with gathered segment loads.
+ */
+void PairTable::compute(
+    const cl_double *r_sq,
+    const cl_uint n,
+    cl_double *force,
+    cl_double *energy) const
+{
+    const cl_double s_min = m_s_min;
+    const cl_double inv_h = m_inv_h;
+    const cl_int max_segment = (cl_int) m_n_segments - 1;
+    const cl_double *coeff = m_coeff;
+
+    core_pragma_omp(simd)
+    for (cl_uint i = 0; i < n; ++i) {
+        cl_double x = (r_sq[i] - s_min) * inv_h;
+        cl_int k = std::min(std::max((cl_int) std::floor(x), 0), max_segment);
+        cl_double t = x - (cl_double) k;
+        const cl_double *c = &coeff[4 * k];
+        energy[i] = c[0] + t * (c[1] + t * (c[2] + t * c[3]));
+        force[i] = -2.0 * inv_h * (c[1] + t * (2.0 * c[2] + t * 3.0 * c[3]));
+    }
+}
@@ -0,0 +1,74 @@
+/*
+ * table.hpp
+ *
+ * Copyright (c) 2020 Carlos Braga
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the MIT License.
+ *
+ * See accompanying LICENSE.md or https://opensource.org/licenses/MIT.
+ */
+
+#ifndef TABLE_H_
+#define TABLE_H_
+
+#include <vector>
+#include "base.hpp"
+
+/**
+ * PairTable
+ * @brief Tabulated pair potential, interpolated by cubic Hermite splines in
+ * s = r^2 on a uniform grid of n_segments segments of width h.
+ *
+ * The knots hold the energy U and the scaled force f = F / r, so that the
+ * force vector on particle i is f r_ij. Since dU/ds = -f / 2, each segment
+ * k is the cubic in t = (s - s_k) / h,
+ *  U(t) = c0 + c1 t + c2 t^2 + c3 t^3,
+ *  f(t) = -2 (c1 + 2 c2 t + 3 c3 t^2) / h,
+ * which matches the energy and the force at both knots, and the force is
+ * the exact derivative of the interpolated energy. Below the first knot the
+ * first segment is extrapolated.
+ *
+ * The four coefficients of a segment are stored contiguously on a 32-byte
+ * boundary, so one aligned 256-bit load fetches a segment on the host. The
+ * device reads the same array from a 1-d image of 32-bit RGBA texels, two
+ * texels per segment, reinterpreted as doubles, through the texture cache.
+ */
+struct PairTable {
+    /* ---- Table grid and aligned segment coefficients -------------------- */
+    cl_uint m_n_segments;
+    cl_double m_s_min;
+    cl_double m_s_max;
+    cl_double m_inv_h;
+    cl_double *m_coeff = nullptr;
+
+    /* ---- PairTable member functions ------------------------------------- */
+    void tabulate(
+        const cl_double s_min,
+        const cl_double s_max,
+        const std::vector<cl_double> &energy,
+        const std::vector<cl_double> &force);
+    void read(const char *filename);
+    void compute(
+        const cl_double *r_sq,
+        const cl_uint n,
+        cl_double *force,
+        cl_double *energy) const;
+
+    cl_double4 grid(void) const {
+        cl_double4 grid = {{m_s_min, m_inv_h, (cl_double) m_n_segments, 0.0}};
+        return grid;
+    }
+    cl_image_format image_format(void) const {
+        cl_image_format format = {CL_RGBA, CL_UNSIGNED_INT32};
+        return format;
+    }
+    size_t image_width(void) const { return 2 * (size_t) m_n_segments; }
+
+    PairTable();
+    ~PairTable();
+    PairTable(const PairTable &) = delete;
+    PairTable &operator=(const PairTable &) = delete;
+};
+
+#endif /* TABLE_H_ */
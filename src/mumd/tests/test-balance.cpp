@@ -0,0 +1,30 @@
+/*
+ * test-balance.cpp
+ *
+ * Copyright (c) 2020 Carlos Braga
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the MIT License.
+ *
+ * See accompanying LICENSE.md or https://opensource.org/licenses/MIT.
+ */
+
+#include "Catch2/catch.hpp"
+
+#include "test-balance.hpp"
+
+/** ---------------------------------------------------------------------------
+ * test_balance
+ * @brief Load balancer test client. The load is piled near either box
+ * bound or inside it, so the clamp sets most planes a halo width apart,
+ * where the plane differences round below r_halo without the margin.
+ */
+TEST_CASE("Balance") {
+    SECTION("Balance-clamp") {
+        test_balance_clamp(0.0, 40.0, 8, 1.0);
+        test_balance_clamp(0.0, 40.0, 8, 39.0);
+        test_balance_clamp(-20.0, 20.0, 8, 0.3);
+        test_balance_clamp(-17.3, 23.1, 11, 5.0);
+        test_balance_clamp(0.0, 8.0 * Params::r_halo + 1.0e-6, 8, 3.0);
+    }
+}
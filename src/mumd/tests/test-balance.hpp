@@ -0,0 +1,52 @@
+/*
+ * test-balance.hpp
+ *
+ * Copyright (c) 2020 Carlos Braga
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the MIT License.
+ *
+ * See accompanying LICENSE.md or https://opensource.org/licenses/MIT.
+ */
+
+#ifndef TEST_MUMD_BALANCE_H_
+#define TEST_MUMD_BALANCE_H_
+
+#include <vector>
+#include "balance.hpp"
+
+/**
+ * test_balance_clamp
+ * @brief Relax the uniform planes of n_domains subdomains spanning [lo, hi]
+ * towards a load profile with all the load at x_peak, as compute_planes
+ * does, and clamp them. Every subdomain must pass the width check of
+ * Domain::set_planes and the outer planes must be unchanged.
+ */
+static inline void test_balance_clamp(
+    const cl_double lo,
+    const cl_double hi,
+    const int n_domains,
+    const cl_double x_peak)
+{
+    const int n_planes = n_domains + 1;
+    std::vector<cl_double> planes(n_planes);
+    for (int k = 0; k < n_planes; ++k) {
+        planes[k] = lo + (hi - lo) * (cl_double) k / (cl_double) n_domains;
+    }
+    planes.back() = hi;
+
+    for (int iter = 0; iter < 64; ++iter) {
+        for (int k = 1; k < n_planes - 1; ++k) {
+            planes[k] += Params::balance_relax * (x_peak - planes[k]);
+        }
+        Balance::clamp_planes(planes);
+
+        REQUIRE(planes.front() == lo);
+        REQUIRE(planes.back() == hi);
+        for (int k = 0; k < n_domains; ++k) {
+            REQUIRE(planes[k + 1] - planes[k] >= Params::r_halo);
+        }
+    }
+}
+
+#endif /* TEST_MUMD_BALANCE_H_ */
@@ -0,0 +1,61 @@
+/*
+ * test-bonded.cpp
+ *
+ * Copyright (c) 2020 Carlos Braga
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the MIT License.
+ *
+ * See accompanying LICENSE.md or https://opensource.org/licenses/MIT.
+ */
+
+#include "Catch2/catch.hpp"
+
+#include "test-bonded.hpp"
+
+/** ---------------------------------------------------------------------------
+ * test_bonded
+ * @brief Bonded forces test client.
+ */
+TEST_CASE("Bonded") {
+    Topology topology;
+    dihedral_topology(topology, 2.5, 3.0, 0.3);
+    Bonded bonded(topology);
+    bonded.build({0, 1, 2, 3}, 4);
+
+    SECTION("Dihedral-gradient") {
+        const cl_double r[4][3] = {
+            {0.1, 0.9, 0.2},
+            {0.0, 0.0, 0.0},
+            {1.0, 0.1, -0.1},
+            {1.3, 0.4, 0.8}};
+        test_dihedral_gradient(bonded, r);
+    }
+
+    SECTION("Dihedral-collinear-ijk") {
+        const cl_double r[4][3] = {
+            {0.0, 0.0, 0.0},
+            {1.0, 0.0, 0.0},
+            {2.0, 0.0, 0.0},
+            {2.5, 1.0, 0.3}};
+        test_dihedral_collinear(bonded, r);
+    }
+
+    SECTION("Dihedral-collinear-jkl") {
+        const cl_double r[4][3] = {
+            {0.5, 1.0, -0.3},
+            {1.0, 0.0, 0.0},
+            {2.0, 0.0, 0.0},
+            {3.0, 0.0, 0.0}};
+        test_dihedral_collinear(bonded, r);
+    }
+
+    SECTION("Dihedral-collinear-all") {
+        const cl_double r[4][3] = {
+            {0.0, 0.0, 0.0},
+            {1.0, 1.0, 1.0},
+            {2.0, 2.0, 2.0},
+            {3.0, 3.0, 3.0}};
+        test_dihedral_collinear(bonded, r);
+    }
+}
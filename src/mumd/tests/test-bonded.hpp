@@ -0,0 +1,126 @@
+/*
+ * test-bonded.hpp
+ *
+ * Copyright (c) 2020 Carlos Braga
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the MIT License.
+ *
+ * See accompanying LICENSE.md or https://opensource.org/licenses/MIT.
+ */
+
+#ifndef TEST_MUMD_BONDED_H_
+#define TEST_MUMD_BONDED_H_
+
+#include <cmath>
+#include <vector>
+#include "bonded.hpp"
+
+/**
+ * dihedral_topology
+ * @brief Replace the molecule template with a single 4-site dihedral term.
+ */
+static inline void dihedral_topology(
+    Topology &topology,
+    const cl_double k,
+    const cl_double n,
+    const cl_double phi0)
+{
+    topology.m_n_sites = 4;
+    topology.m_site_position.assign(3 * 4, 0.0);
+    topology.m_site_charge.assign(4, 0.0);
+    topology.m_constraint_site.clear();
+    topology.m_constraint_length.clear();
+    topology.m_settle = false;
+    topology.m_bond_site.clear();
+    topology.m_bond_param.clear();
+    topology.m_angle_site.clear();
+    topology.m_angle_param.clear();
+    topology.m_dihedral_site = {0, 1, 2, 3};
+    topology.m_dihedral_param = {k, n, phi0};
+}
+
+/**
+ * dihedral_compute
+ * @brief Compute the energy and forces of the 4 sites at r, stored in
+ * the layout of the particle arrays with stride 4.
+ */
+static inline cl_double dihedral_compute(
+    Bonded &bonded,
+    const cl_double r[4][3],
+    std::vector<cl_double> &force)
+{
+    const cl_uint stride = 4;
+    std::vector<cl_double> position(3 * stride);
+    for (cl_uint i = 0; i < 4; ++i) {
+        for (cl_uint d = 0; d < 3; ++d) {
+            position[i + d * stride] = r[i][d];
+        }
+    }
+    force.assign(3 * stride, 0.0);
+    return bonded.compute(position, stride, force);
+}
+
+/**
+ * test_dihedral_gradient
+ * @brief Check the forces against the central difference of the energy,
+ * and that they sum to zero.
+ */
+static inline void test_dihedral_gradient(
+    Bonded &bonded,
+    const cl_double r[4][3])
+{
+    std::vector<cl_double> force;
+    dihedral_compute(bonded, r, force);
+
+    const cl_double h = 1.0e-6;
+    for (cl_uint i = 0; i < 4; ++i) {
+        for (cl_uint d = 0; d < 3; ++d) {
+            cl_double r_h[4][3];
+            std::copy(&r[0][0], &r[0][0] + 12, &r_h[0][0]);
+            std::vector<cl_double> unused;
+
+            r_h[i][d] = r[i][d] + h;
+            cl_double u_plus = dihedral_compute(bonded, r_h, unused);
+            r_h[i][d] = r[i][d] - h;
+            cl_double u_minus = dihedral_compute(bonded, r_h, unused);
+
+            cl_double f = -(u_plus - u_minus) / (2.0 * h);
+            REQUIRE(std::fabs(force[i + d * 4] - f) < 1.0e-6);
+        }
+    }
+
+    for (cl_uint d = 0; d < 3; ++d) {
+        cl_double sum = 0.0;
+        for (cl_uint i = 0; i < 4; ++i) {
+            sum += force[i + d * 4];
+        }
+        REQUIRE(std::fabs(sum) < 1.0e-10);
+    }
+}
+
+/**
+ * test_dihedral_collinear
+ * @brief Check that collinear sites give a finite energy and force, with
+ * zero net force.
+ */
+static inline void test_dihedral_collinear(
+    Bonded &bonded,
+    const cl_double r[4][3])
+{
+    std::vector<cl_double> force;
+    cl_double energy = dihedral_compute(bonded, r, force);
+    REQUIRE(std::isfinite(energy));
+
+    for (cl_uint d = 0; d < 3; ++d) {
+        cl_double sum = 0.0;
+        for (cl_uint i = 0; i < 4; ++i) {
+            REQUIRE(std::isfinite(force[i + d * 4]));
+            sum += force[i + d * 4];
+        }
+        REQUIRE(std::fabs(sum) < 1.0e-10);
+    }
+    REQUIRE(std::isfinite(bonded.m_virial));
+}
+
+#endif /* TEST_MUMD_BONDED_H_ */
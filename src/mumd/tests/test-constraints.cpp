@@ -0,0 +1,36 @@
+/*
+ * test-constraints.cpp
+ *
+ * Copyright (c) 2020 Carlos Braga
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the MIT License.
+ *
+ * See accompanying LICENSE.md or https://opensource.org/licenses/MIT.
+ */
+
+#include "Catch2/catch.hpp"
+
+#include "test-constraints.hpp"
+
+/** ---------------------------------------------------------------------------
+ * test_constraints
+ * @brief Host constraint solvers test client. The cluster counts cover a
+ * single partial SETTLE batch, whole batches and a trailing partial batch.
+ */
+TEST_CASE("Constraints") {
+    Topology topology;
+    water_topology(topology);
+
+    SECTION("Settle-shake") {
+        test_settle_shake(topology, 3, 0.002, 1);
+        test_settle_shake(topology, 2 * Constraints::settle_batch, 0.002, 2);
+        test_settle_shake(topology, 29, 0.01, 3);
+    }
+
+    SECTION("Settle-rattle") {
+        test_settle_rattle(topology, 3, 0.002, 4);
+        test_settle_rattle(topology, 2 * Constraints::settle_batch, 0.002, 5);
+        test_settle_rattle(topology, 29, 0.01, 6);
+    }
+}
@@ -0,0 +1,254 @@
+/*
+ * test-constraints.hpp
+ *
+ * Copyright (c) 2020 Carlos Braga
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the MIT License.
+ *
+ * See accompanying LICENSE.md or https://opensource.org/licenses/MIT.
+ */
+
+#ifndef TEST_MUMD_CONSTRAINTS_H_
+#define TEST_MUMD_CONSTRAINTS_H_
+
+#include <cmath>
+#include <random>
+#include <vector>
+#include "constraints.hpp"
+
+/**
+ * water_topology
+ * @brief Replace the molecule template with the rigid water molecule, as
+ * built by the Topology constructor for MoleculeWater.
+ */
+static inline void water_topology(Topology &topology)
+{
+    const cl_double d = Params::water_bond;
+    const cl_double s = std::sin(0.5 * Params::water_angle);
+    const cl_double c = std::cos(0.5 * Params::water_angle);
+    topology.m_n_sites = 3;
+    topology.m_site_position = {
+        0.0,    0.0,    0.0,
+        d * s,  d * c,  0.0,
+       -d * s,  d * c,  0.0};
+    topology.m_site_charge = {-2.0, 1.0, 1.0};
+    topology.m_constraint_site = {0, 1, 0, 2, 1, 2};
+    topology.m_constraint_length = {d, d, 2.0 * d * s};
+    topology.m_settle = true;
+    topology.m_settle_rc = d * s;
+    topology.m_settle_ra = 2.0 * d * c / 3.0;
+    topology.m_settle_rb = d * c - topology.m_settle_ra;
+    topology.m_bond_site.clear();
+    topology.m_bond_param.clear();
+    topology.m_angle_site.clear();
+    topology.m_angle_param.clear();
+    topology.m_dihedral_site.clear();
+    topology.m_dihedral_param.clear();
+}
+
+/**
+ * WaterClusters
+ * @brief Randomly oriented rigid water molecules, with the sites of each
+ * cluster scattered over the particle arrays, and a random velocity per
+ * site. The positions are advanced by one unconstrained step of size dt.
+ */
+struct WaterClusters {
+    cl_uint stride;
+    std::vector<cl_uint> cluster;
+    std::vector<cl_double> position_old;
+    std::vector<cl_double> position;
+    std::vector<cl_double> velocity;
+
+    WaterClusters(
+        const Topology &topology,
+        const cl_uint n_clusters,
+        const cl_double dt,
+        const unsigned seed) {
+        std::mt19937 engine(seed);
+        std::uniform_real_distribution<cl_double> uniform(-1.0, 1.0);
+
+        /* Interleave the clusters and pad the arrays past the particles. */
+        const cl_uint n_particles = 3 * n_clusters;
+        stride = n_particles + 5;
+        for (cl_uint k = 0; k < n_clusters; ++k) {
+            for (cl_uint site = 0; site < 3; ++site) {
+                cluster.push_back(site * n_clusters + (n_clusters - 1 - k));
+            }
+        }
+        position_old.assign(3 * stride, 0.0);
+        velocity.assign(3 * stride, 0.0);
+
+        for (cl_uint k = 0; k < n_clusters; ++k) {
+            /* Random rotation from a normalized quaternion. */
+            cl_double q[4];
+            cl_double q_sq = 0.0;
+            for (cl_uint i = 0; i < 4; ++i) {
+                q[i] = uniform(engine);
+                q_sq += q[i] * q[i];
+            }
+            for (cl_uint i = 0; i < 4; ++i) {
+                q[i] /= std::sqrt(q_sq);
+            }
+            const cl_double w = q[0], x = q[1], y = q[2], z = q[3];
+            const cl_double rot[3][3] = {
+                {1.0 - 2.0*(y*y + z*z), 2.0*(x*y - w*z), 2.0*(x*z + w*y)},
+                {2.0*(x*y + w*z), 1.0 - 2.0*(x*x + z*z), 2.0*(y*z - w*x)},
+                {2.0*(x*z - w*y), 2.0*(y*z + w*x), 1.0 - 2.0*(x*x + y*y)}};
+
+            cl_double origin[3];
+            for (cl_uint d = 0; d < 3; ++d) {
+                origin[d] = 10.0 * uniform(engine);
+            }
+            for (cl_uint site = 0; site < 3; ++site) {
+                const cl_double *p = &topology.m_site_position[3 * site];
+                cl_uint ix = cluster[3 * k + site];
+                for (cl_uint d = 0; d < 3; ++d) {
+                    position_old[ix + d * stride] = origin[d] +
+                        rot[d][0] * p[0] + rot[d][1] * p[1] + rot[d][2] * p[2];
+                    velocity[ix + d * stride] = uniform(engine);
+                }
+            }
+        }
+
+        position = position_old;
+        for (cl_uint i = 0; i < 3 * stride; ++i) {
+            position[i] += dt * velocity[i];
+        }
+    }
+};
+
+/**
+ * require_close
+ * @brief Check that two arrays agree within an absolute tolerance.
+ */
+static inline void require_close(
+    const std::vector<cl_double> &a,
+    const std::vector<cl_double> &b,
+    const cl_double tolerance)
+{
+    REQUIRE(a.size() == b.size());
+    for (size_t i = 0; i < a.size(); ++i) {
+        REQUIRE(std::fabs(a[i] - b[i]) < tolerance);
+    }
+}
+
+/**
+ * test_settle_shake
+ * @brief Check that SETTLE positions, velocities and virials match
+ * converged SHAKE on the same perturbed clusters, and that the constraints
+ * hold.
+ */
+static inline void test_settle_shake(
+    Topology &topology,
+    const cl_uint n_clusters,
+    const cl_double dt,
+    const unsigned seed)
+{
+    WaterClusters settle(topology, n_clusters, dt, seed);
+    WaterClusters shake(topology, n_clusters, dt, seed);
+    std::vector<cl_double> settle_virial(settle.stride, 0.0);
+    std::vector<cl_double> shake_virial(shake.stride, 0.0);
+
+    topology.m_settle = true;
+    Constraints::shake(
+        topology,
+        settle.cluster,
+        settle.position_old,
+        settle.position,
+        settle.velocity,
+        settle.stride,
+        dt,
+        settle_virial);
+
+    topology.m_settle = false;
+    Constraints::shake(
+        topology,
+        shake.cluster,
+        shake.position_old,
+        shake.position,
+        shake.velocity,
+        shake.stride,
+        dt,
+        shake_virial);
+    topology.m_settle = true;
+
+    require_close(settle.position, shake.position, 1.0e-8);
+    require_close(settle.velocity, shake.velocity, 1.0e-8 / dt);
+    require_close(settle_virial, shake_virial, 1.0e-6 / (dt * dt));
+
+    for (cl_uint k = 0; k < n_clusters; ++k) {
+        for (cl_uint c = 0; c < topology.n_constraints(); ++c) {
+            cl_uint a = settle.cluster[3*k + topology.m_constraint_site[2*c]];
+            cl_uint b = settle.cluster[3*k + topology.m_constraint_site[2*c+1]];
+            cl_double dr_sq = 0.0;
+            for (cl_uint d = 0; d < 3; ++d) {
+                cl_double dr = settle.position[b + d * settle.stride] -
+                    settle.position[a + d * settle.stride];
+                dr_sq += dr * dr;
+            }
+            REQUIRE(std::fabs(std::sqrt(dr_sq) -
+                topology.m_constraint_length[c]) < 1.0e-8);
+        }
+    }
+}
+
+/**
+ * test_settle_rattle
+ * @brief Check that SETTLE velocities and virials match converged RATTLE
+ * on the same rigid clusters, and that the relative velocities are normal
+ * to the bonds.
+ */
+static inline void test_settle_rattle(
+    Topology &topology,
+    const cl_uint n_clusters,
+    const cl_double dt,
+    const unsigned seed)
+{
+    /* Rigid clusters at the old positions, with random velocities. */
+    WaterClusters settle(topology, n_clusters, dt, seed);
+    WaterClusters rattle(topology, n_clusters, dt, seed);
+    std::vector<cl_double> settle_virial(settle.stride, 0.0);
+    std::vector<cl_double> rattle_virial(rattle.stride, 0.0);
+
+    topology.m_settle = true;
+    Constraints::rattle(
+        topology,
+        settle.cluster,
+        settle.position_old,
+        settle.velocity,
+        settle.stride,
+        dt,
+        settle_virial);
+
+    topology.m_settle = false;
+    Constraints::rattle(
+        topology,
+        rattle.cluster,
+        rattle.position_old,
+        rattle.velocity,
+        rattle.stride,
+        dt,
+        rattle_virial);
+    topology.m_settle = true;
+
+    require_close(settle.velocity, rattle.velocity, 1.0e-8);
+    require_close(settle_virial, rattle_virial, 1.0e-6);
+
+    for (cl_uint k = 0; k < n_clusters; ++k) {
+        for (cl_uint c = 0; c < topology.n_constraints(); ++c) {
+            cl_uint a = settle.cluster[3*k + topology.m_constraint_site[2*c]];
+            cl_uint b = settle.cluster[3*k + topology.m_constraint_site[2*c+1]];
+            cl_double dr_dv = 0.0;
+            for (cl_uint d = 0; d < 3; ++d) {
+                cl_uint ia = a + d * settle.stride;
+                cl_uint ib = b + d * settle.stride;
+                dr_dv += (settle.position_old[ib] - settle.position_old[ia]) *
+                    (settle.velocity[ib] - settle.velocity[ia]);
+            }
+            REQUIRE(std::fabs(dr_dv) < 1.0e-8);
+        }
+    }
+}
+
+#endif /* TEST_MUMD_CONSTRAINTS_H_ */
@@ -0,0 +1,37 @@
+/*
+ * test-table.cpp
+ *
+ * Copyright (c) 2020 Carlos Braga
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the MIT License.
+ *
+ * See accompanying LICENSE.md or https://opensource.org/licenses/MIT.
+ */
+
+#include "Catch2/catch.hpp"
+
+#include "test-table.hpp"
+
+/** ---------------------------------------------------------------------------
+ * test_table
+ * @brief Host pair table test client, on the Lennard-Jones table the model
+ * builds without a table file. The odd sample counts leave a remainder in
+ * the vectorized interpolation loop.
+ */
+TEST_CASE("Table") {
+    PairTable table;
+    REQUIRE(table.m_n_segments == Params::pair_table_size);
+
+    SECTION("Table-knots") {
+        test_table_knots(table);
+    }
+
+    SECTION("Table-analytic") {
+        test_table_analytic(table, 10007, 1);
+    }
+
+    SECTION("Table-derivative") {
+        test_table_derivative(table, 10007, 2);
+    }
+}
@@ -0,0 +1,142 @@
+/*
+ * test-table.hpp
+ *
+ * Copyright (c) 2020 Carlos Braga
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the MIT License.
+ *
+ * See accompanying LICENSE.md or https://opensource.org/licenses/MIT.
+ */
+
+#ifndef TEST_MUMD_TABLE_H_
+#define TEST_MUMD_TABLE_H_
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+#include "table.hpp"
+
+/**
+ * lj_pair
+ * @brief Lennard-Jones energy and scaled force f = F / r at s = r^2.
+ */
+static inline void lj_pair(const cl_double s, cl_double &u, cl_double &f)
+{
+    cl_double sr2 = 1.0 / s;
+    cl_double sr6 = sr2 * sr2 * sr2;
+    u = 4.0 * sr6 * (sr6 - 1.0);
+    f = 24.0 * sr2 * sr6 * (2.0 * sr6 - 1.0);
+}
+
+/**
+ * table_samples
+ * @brief Return n squared distances with r uniform in the range of the
+ * table, r_min to the cutoff radius.
+ */
+static inline std::vector<cl_double> table_samples(
+    const cl_uint n,
+    const unsigned seed)
+{
+    std::mt19937 engine(seed);
+    std::uniform_real_distribution<cl_double> uniform(
+        Params::pair_table_r_min, Params::r_cut);
+    std::vector<cl_double> r_sq(n);
+    for (auto &s : r_sq) {
+        cl_double r = uniform(engine);
+        s = r * r;
+    }
+    return r_sq;
+}
+
+/**
+ * test_table_knots
+ * @brief Check that the table reproduces the Lennard-Jones energy and
+ * scaled force at the knots.
+ */
+static inline void test_table_knots(const PairTable &table)
+{
+    const cl_uint n = table.m_n_segments;
+    const cl_double h = (table.m_s_max - table.m_s_min) / (cl_double) n;
+    std::vector<cl_double> r_sq(n);
+    for (cl_uint k = 0; k < n; ++k) {
+        r_sq[k] = table.m_s_min + k * h;
+    }
+    std::vector<cl_double> force(n);
+    std::vector<cl_double> energy(n);
+    table.compute(&r_sq[0], n, &force[0], &energy[0]);
+
+    for (cl_uint k = 0; k < n; ++k) {
+        cl_double u, f;
+        lj_pair(r_sq[k], u, f);
+        REQUIRE(std::fabs(energy[k] - u) <= 1.0e-10 * std::fmax(1.0, u));
+        REQUIRE(std::fabs(force[k] - f) <= 1.0e-10 * std::fmax(1.0, f));
+    }
+}
+
+/**
+ * test_table_analytic
+ * @brief Check the interpolated energy and scaled force against the
+ * Lennard-Jones potential between the knots. The cubic Hermite error is
+ * fourth order in the knot spacing for the energy, and third order for the
+ * force.
+ */
+static inline void test_table_analytic(
+    const PairTable &table,
+    const cl_uint n,
+    const unsigned seed)
+{
+    std::vector<cl_double> r_sq = table_samples(n, seed);
+    std::vector<cl_double> force(n);
+    std::vector<cl_double> energy(n);
+    table.compute(&r_sq[0], n, &force[0], &energy[0]);
+
+    for (cl_uint i = 0; i < n; ++i) {
+        cl_double u, f;
+        lj_pair(r_sq[i], u, f);
+        REQUIRE(std::fabs(energy[i] - u) <= 1.0e-7 * std::fmax(1.0, u));
+        REQUIRE(std::fabs(force[i] - f) <= 1.0e-5 * std::fmax(1.0, f));
+    }
+}
+
+/**
+ * test_table_derivative
+ * @brief Check that the scaled force is the derivative of the tabulated
+ * energy, f = -2 dU/ds, by a central difference inside each segment.
+ */
+static inline void test_table_derivative(
+    const PairTable &table,
+    const cl_uint n,
+    const unsigned seed)
+{
+    const cl_double h = 1.0 / table.m_inv_h;
+    const cl_double eps = 1.0e-3 * h;
+
+    /* Keep the samples and their differences inside one segment. */
+    std::vector<cl_double> r_sq = table_samples(n, seed);
+    for (auto &s : r_sq) {
+        cl_double x = (s - table.m_s_min) * table.m_inv_h;
+        cl_double t = std::min(std::max(x - std::floor(x), 0.1), 0.9);
+        s = table.m_s_min + (std::floor(x) + t) * h;
+    }
+    std::vector<cl_double> r_sq_lo(n);
+    std::vector<cl_double> r_sq_hi(n);
+    for (cl_uint i = 0; i < n; ++i) {
+        r_sq_lo[i] = r_sq[i] - eps;
+        r_sq_hi[i] = r_sq[i] + eps;
+    }
+
+    std::vector<cl_double> force(n), force_lo(n), force_hi(n);
+    std::vector<cl_double> energy(n), energy_lo(n), energy_hi(n);
+    table.compute(&r_sq[0], n, &force[0], &energy[0]);
+    table.compute(&r_sq_lo[0], n, &force_lo[0], &energy_lo[0]);
+    table.compute(&r_sq_hi[0], n, &force_hi[0], &energy_hi[0]);
+
+    for (cl_uint i = 0; i < n; ++i) {
+        cl_double f = -(energy_hi[i] - energy_lo[i]) / eps;
+        REQUIRE(std::fabs(force[i] - f) <= 1.0e-8 * std::fmax(1.0, f));
+    }
+}
+
+#endif /* TEST_MUMD_TABLE_H_ */
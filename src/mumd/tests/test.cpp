@@ -0,0 +1,20 @@
+/*
+ * test.cpp
+ *
+ * Copyright (c) 2020 Carlos Braga
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the MIT License.
+ *
+ * See accompanying LICENSE.md or https://opensource.org/licenses/MIT.
+ */
+
+#if 1
+#define CATCH_CONFIG_MAIN       /* provide main() automatically */
+#else
+#define CATCH_CONFIG_RUNNER     /* provide main() yourself */
+#endif
+#include "Catch2/catch.hpp"
+
+TEST_CASE("Empty") {}
+
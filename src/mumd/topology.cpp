@@ -0,0 +1,109 @@
+/*
+ * topology.cpp
+ *
+ * Copyright (c) 2020 Carlos Braga
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the MIT License.
+ *
+ * See accompanying LICENSE.md or https://opensource.org/licenses/MIT.
+ */
+
+#include <cmath>
+#include "topology.hpp"
+using namespace atto;
+
+/** ---------------------------------------------------------------------------
+ * Topology::Topology
+ * @brief Create the molecule template of the model.
+ *
+ * MoleculeAtom is a single charged site. MoleculeWater is a rigid 3-site
+ * molecule, an apex site of charge -2q and two base sites of charge +q, at
+ * distance water_bond from the apex and water_angle apart. The apex is site
+ * 0 and the molecule lies in the xy-plane with its bisector along y.
+ * MoleculeChain is a neutral flexible chain of chain_length sites, with
+ * harmonic bonds and angles and a threefold dihedral, in the all-trans
+ * zig-zag conformation along x.
+ */
+Topology::Topology()
+{
+    m_settle = false;
+    m_settle_ra = m_settle_rb = m_settle_rc = 0.0;
+
+    if (Params::molecule == Params::MoleculeAtom) {
+        m_n_sites = 1;
+        m_site_position = {0.0, 0.0, 0.0};
+        m_site_charge = {Params::charge};
+    } else if (Params::molecule == Params::MoleculeWater) {
+        const cl_double d = Params::water_bond;
+        const cl_double s = std::sin(0.5 * Params::water_angle);
+        const cl_double c = std::cos(0.5 * Params::water_angle);
+        m_n_sites = 3;
+        m_site_position = {
+            0.0,    0.0,    0.0,
+            d * s,  d * c,  0.0,
+           -d * s,  d * c,  0.0};
+        m_site_charge = {-2.0 * Params::charge, Params::charge, Params::charge};
+        m_constraint_site = {0, 1, 0, 2, 1, 2};
+        m_constraint_length = {d, d, 2.0 * d * s};
+
+        /* Canonical SETTLE geometry with unit site masses. */
+        m_settle = true;
+        m_settle_rc = d * s;
+        m_settle_ra = 2.0 * d * c / 3.0;
+        m_settle_rb = d * c - m_settle_ra;
+    } else if (Params::molecule == Params::MoleculeChain) {
+        const cl_double d = Params::chain_bond;
+        const cl_double s = std::sin(0.5 * Params::chain_angle);
+        const cl_double c = std::cos(0.5 * Params::chain_angle);
+        m_n_sites = Params::chain_length;
+        for (cl_uint site = 0; site < m_n_sites; ++site) {
+            m_site_position.push_back(d * s * site);
+            m_site_position.push_back(d * c * (site % 2));
+            m_site_position.push_back(0.0);
+            m_site_charge.push_back(0.0);
+        }
+        for (cl_uint site = 0; site + 1 < m_n_sites; ++site) {
+            m_bond_site.insert(m_bond_site.end(), {site, site + 1});
+            m_bond_param.insert(m_bond_param.end(), {Params::bond_k, d});
+        }
+        for (cl_uint site = 0; site + 2 < m_n_sites; ++site) {
+            m_angle_site.insert(m_angle_site.end(), {site, site + 1, site + 2});
+            m_angle_param.insert(m_angle_param.end(),
+                {Params::angle_k, Params::chain_angle});
+        }
+        for (cl_uint site = 0; site + 3 < m_n_sites; ++site) {
+            m_dihedral_site.insert(m_dihedral_site.end(),
+                {site, site + 1, site + 2, site + 3});
+            m_dihedral_param.insert(m_dihedral_param.end(),
+                {Params::dihedral_k, (cl_double) Params::dihedral_n, 0.0});
+        }
+    } else {
+        core_throw("invalid molecule model");
+    }
+
+    core_assert(m_n_sites <= Params::max_sites, "too many molecule sites");
+}
+
+/**
+ * Topology::site_noise
+ * @brief Return the number of unconstrained degrees of freedom of each site,
+ * packed in two bits per site. Each constraint removes one degree of freedom
+ * from its second site, so the Gaussian noise of the stochastic thermostat
+ * is drawn for 3 n_sites - n_constraints degrees of freedom per molecule.
+ */
+cl_uint Topology::site_noise(void) const
+{
+    cl_uint mask = 0;
+    for (cl_uint site = 0; site < m_n_sites; ++site) {
+        cl_uint n_dof = 3;
+        for (cl_uint k = 0; k < n_constraints(); ++k) {
+            if (m_constraint_site[2*k + 1] == site) {
+                core_assert(n_dof > 0, "overconstrained site");
+                --n_dof;
+            }
+        }
+        mask |= n_dof << (2 * site);
+    }
+    return mask;
+}
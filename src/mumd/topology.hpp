@@ -0,0 +1,83 @@
+/*
+ * topology.hpp
+ *
+ * Copyright (c) 2020 Carlos Braga
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the MIT License.
+ *
+ * See accompanying LICENSE.md or https://opensource.org/licenses/MIT.
+ */
+
+#ifndef TOPOLOGY_H_
+#define TOPOLOGY_H_
+
+#include <vector>
+#include "base.hpp"
+
+/**
+ * Topology
+ * @brief Template of the molecule replicated on every lattice site. A
+ * molecule of n_sites sites has consecutive particle ids, starting at
+ * molecule * n_sites, so the site of a particle is id % n_sites and the
+ * other sites of its molecule are found from the id alone.
+ *
+ * Constraints are stored as flat arrays of site index pairs and lengths.
+ * Each molecule is an independent cluster of constraints. A rigid 3-site
+ * molecule with unit masses is solved analytically by SETTLE, with the
+ * canonical geometry given by ra, rb and rc, Miyamoto and Kollman (1992):
+ *  ra  distance from the centre of mass to the apex site,
+ *  rb  distance from the centre of mass to the base of the triangle,
+ *  rc  half the base length.
+ *
+ * Bonded terms are stored as flat arrays of site indices, two per bond,
+ * three per angle with the apex in the middle and four per dihedral, with
+ * their parameters:
+ *  bond        (k, r0)         U = k (r - r0)^2 / 2
+ *  angle       (k, theta0)     U = k (theta - theta0)^2 / 2
+ *  dihedral    (k, n, phi0)    U = k (1 + cos(n phi - phi0))
+ */
+struct Topology {
+    /* ---- Molecule sites ------------------------------------------------- */
+    cl_uint m_n_sites;
+    std::vector<cl_double> m_site_position;
+    std::vector<cl_double> m_site_charge;
+
+    /* ---- Constraints ---------------------------------------------------- */
+    std::vector<cl_uint> m_constraint_site;
+    std::vector<cl_double> m_constraint_length;
+    bool m_settle;
+    cl_double m_settle_ra;
+    cl_double m_settle_rb;
+    cl_double m_settle_rc;
+
+    /* ---- Bonded terms --------------------------------------------------- */
+    std::vector<cl_uint> m_bond_site;
+    std::vector<cl_double> m_bond_param;
+    std::vector<cl_uint> m_angle_site;
+    std::vector<cl_double> m_angle_param;
+    std::vector<cl_uint> m_dihedral_site;
+    std::vector<cl_double> m_dihedral_param;
+
+    /* ---- Topology member functions -------------------------------------- */
+    cl_uint n_constraints(void) const {
+        return (cl_uint) m_constraint_length.size();
+    }
+    bool has_constraints(void) const { return n_constraints() > 0; }
+    cl_uint n_bonds(void) const { return (cl_uint) m_bond_site.size() / 2; }
+    cl_uint n_angles(void) const { return (cl_uint) m_angle_site.size() / 3; }
+    cl_uint n_dihedrals(void) const {
+        return (cl_uint) m_dihedral_site.size() / 4;
+    }
+    bool has_bonded(void) const {
+        return n_bonds() + n_angles() + n_dihedrals() > 0;
+    }
+    cl_uint site_noise(void) const;
+
+    Topology();
+    ~Topology() = default;
+    Topology(const Topology &) = delete;
+    Topology &operator=(const Topology &) = delete;
+};
+
+#endif /* TOPOLOGY_H_ */
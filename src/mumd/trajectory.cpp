@@ -0,0 +1,255 @@
+/*
+ * trajectory.cpp
+ *
+ * Copyright (c) 2020 Carlos Braga
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the MIT License.
+ *
+ * See accompanying LICENSE.md or https://opensource.org/licenses/MIT.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include "trajectory.hpp"
+using namespace atto;
+
+static_assert(sizeof(FrameHeader) == 104, "unexpected frame header layout");
+
+/** ---------------------------------------------------------------------------
+ * Trajectory::Trajectory
+ * @brief Create the trajectory writer. The master process opens the file
+ * and starts the writer thread.
+ */
+Trajectory::Trajectory(const Domain &domain)
+{
+    m_comm = domain.m_comm;
+    m_proc_id = domain.m_proc_id;
+    m_n_procs = domain.m_n_procs;
+    m_record_size = Params::trajectory_velocity ? 7 : 4;
+    m_next = 0;
+    m_done = false;
+    for (auto &frame : m_frames) {
+        frame.step = 0;
+        frame.pending = false;
+    }
+
+    if (is_active() && domain.is_master()) {
+        m_counts.resize(m_n_procs, 0);
+        m_displs.resize(m_n_procs, 0);
+        m_file.open(Params::trajectory_file, core::File::Binary);
+        m_thread = std::thread(&Trajectory::run, this);
+    }
+}
+
+/**
+ * Trajectory::~Trajectory
+ * @brief Write the pending frames, stop the writer thread and close the
+ * file.
+ */
+Trajectory::~Trajectory()
+{
+    if (m_thread.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_done = true;
+        }
+        m_cond.notify_all();
+        m_thread.join();
+        m_file.close();
+    }
+}
+
+/** ---------------------------------------------------------------------------
+ * Trajectory::write
+ * @brief Pack the local records of a frame and gather them on the master,
+ * into the next frame buffer once the writer thread has released it. The
+ * frame is then handed to the writer thread.
+ */
+void Trajectory::write(
+    const cl_ulong step,
+    const cl_double box_lo[3],
+    const cl_double box_hi[3],
+    const cl_uint n_local,
+    const cl_uint stride,
+    const cl_double *position,
+    const cl_double *velocity,
+    const cl_ulong *id)
+{
+    const bool is_master = (m_proc_id == Params::master_id);
+
+    /* Pack the local records. */
+    m_send.resize(n_local * m_record_size);
+    for (cl_uint i = 0; i < n_local; ++i) {
+        cl_double *record = &m_send[i * m_record_size];
+        std::memcpy(&record[0], &id[i], sizeof(cl_double));
+        for (cl_uint c = 0; c < 3; ++c) {
+            record[1 + c] = position[i + c * stride];
+        }
+        if (Params::trajectory_velocity) {
+            for (cl_uint c = 0; c < 3; ++c) {
+                record[4 + c] = velocity[i + c * stride];
+            }
+        }
+    }
+
+    /* Gather the record counts and wait for a free frame buffer. */
+    int count = (int) m_send.size();
+    MPI_Gather(
+        &count, 1, MPI_INT,
+        is_master ? &m_counts[0] : NULL, 1, MPI_INT,
+        Params::master_id, m_comm);
+
+    Frame *frame = NULL;
+    if (is_master) {
+        frame = &m_frames[m_next];
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_cond.wait(lock, [frame] () { return !frame->pending; });
+        lock.unlock();
+
+        int total = 0;
+        for (int proc = 0; proc < m_n_procs; ++proc) {
+            m_displs[proc] = total;
+            total += m_counts[proc];
+        }
+        frame->records.resize(total);
+        frame->step = step;
+        for (int dim = 0; dim < 3; ++dim) {
+            frame->box_lo[dim] = box_lo[dim];
+            frame->box_hi[dim] = box_hi[dim];
+        }
+    }
+
+    /* Aggregate the records directly into the frame buffer. */
+    MPI_Gatherv(
+        m_send.empty() ? NULL : &m_send[0], count, MPI_DOUBLE,
+        is_master ? frame->records.data() : NULL,
+        is_master ? &m_counts[0] : NULL,
+        is_master ? &m_displs[0] : NULL,
+        MPI_DOUBLE, Params::master_id, m_comm);
+
+    /* Hand the frame to the writer thread. */
+    if (is_master) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            frame->pending = true;
+        }
+        m_cond.notify_all();
+        m_next ^= 1;
+    }
+}
+
+/** ---------------------------------------------------------------------------
+ * Trajectory::run
+ * @brief Writer thread loop. Encode and write the pending frames in order,
+ * and release each buffer after its frame is written. Stop when no frame
+ * is pending after the writer was closed.
+ */
+void Trajectory::run(void)
+{
+    cl_uint next = 0;
+    while (true) {
+        Frame &frame = m_frames[next];
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_cond.wait(lock, [this, &frame] () {
+                return frame.pending || m_done;
+            });
+            if (!frame.pending) {
+                break;
+            }
+        }
+
+        encode(frame);
+        core_assert(m_file.write(&m_buffer[0], m_buffer.size()),
+            "failed to write trajectory frame");
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            frame.pending = false;
+        }
+        m_cond.notify_all();
+        next ^= 1;
+    }
+}
+
+/**
+ * Trajectory::encode
+ * @brief Encode a frame in the buffer, with the particles placed in id
+ * order. Quantized positions are wrapped in the periodic box, and the
+ * velocities are scaled by the largest velocity component of the frame.
+ */
+void Trajectory::encode(const Frame &frame)
+{
+    const cl_uint record_size = m_record_size;
+    const size_t n_particles = frame.records.size() / record_size;
+    const bool velocity = Params::trajectory_velocity;
+    const bool quantize = Params::trajectory_quantize;
+    const size_t value_size = quantize ? sizeof(cl_ushort) : sizeof(cl_double);
+    const size_t n_values = 3 * n_particles * (velocity ? 2 : 1);
+    const size_t payload_size = (n_values * value_size + 7) & ~((size_t) 7);
+
+    FrameHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, "MUMDFRM1", sizeof(header.magic));
+    header.header_size = sizeof(FrameHeader);
+    header.flags = (velocity ? FrameHeader::FlagVelocity : 0) |
+                   (quantize ? FrameHeader::FlagQuantized : 0);
+    header.frame_size = sizeof(FrameHeader) + payload_size;
+    header.step = frame.step;
+    header.n_particles = n_particles;
+    header.time_step = Params::time_step;
+    for (int dim = 0; dim < 3; ++dim) {
+        header.box_lo[dim] = frame.box_lo[dim];
+        header.box_hi[dim] = frame.box_hi[dim];
+    }
+
+    /* Velocity quantization range. */
+    header.velocity_range = 0.0;
+    if (velocity && quantize) {
+        for (size_t k = 0; k < n_particles; ++k) {
+            const cl_double *record = &frame.records[k * record_size];
+            for (int c = 0; c < 3; ++c) {
+                header.velocity_range = std::max(
+                    header.velocity_range, std::fabs(record[4 + c]));
+            }
+        }
+    }
+
+    m_buffer.assign(header.frame_size, 0);
+    std::memcpy(&m_buffer[0], &header, sizeof(header));
+    cl_uchar *payload = &m_buffer[sizeof(header)];
+    cl_double *pos = reinterpret_cast<cl_double *>(payload);
+    cl_double *vel = pos + 3 * n_particles;
+    cl_ushort *pos_q = reinterpret_cast<cl_ushort *>(payload);
+    cl_short *vel_q = reinterpret_cast<cl_short *>(pos_q + 3 * n_particles);
+    const cl_double vel_scale = header.velocity_range > 0.0
+        ? 32767.0 / header.velocity_range : 0.0;
+
+    for (size_t k = 0; k < n_particles; ++k) {
+        const cl_double *record = &frame.records[k * record_size];
+        cl_ulong id;
+        std::memcpy(&id, &record[0], sizeof(id));
+        core_assert(id < n_particles, "invalid particle id");
+
+        for (int c = 0; c < 3; ++c) {
+            if (quantize) {
+                const cl_double length = frame.box_hi[c] - frame.box_lo[c];
+                cl_double x = (record[1 + c] - frame.box_lo[c]) / length;
+                x -= std::floor(x);
+                pos_q[3 * id + c] = (cl_ushort) std::min(
+                    65535.0, std::floor(x * 65536.0));
+                if (velocity) {
+                    vel_q[3 * id + c] = (cl_short) std::lround(
+                        record[4 + c] * vel_scale);
+                }
+            } else {
+                pos[3 * id + c] = record[1 + c];
+                if (velocity) {
+                    vel[3 * id + c] = record[4 + c];
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,110 @@
+/*
+ * trajectory.hpp
+ *
+ * Copyright (c) 2020 Carlos Braga
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the MIT License.
+ *
+ * See accompanying LICENSE.md or https://opensource.org/licenses/MIT.
+ */
+
+#ifndef TRAJECTORY_H_
+#define TRAJECTORY_H_
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "base.hpp"
+#include "domain.hpp"
+
+/**
+ * FrameHeader
+ * @brief Header of a trajectory frame. Each frame is self-describing, so a
+ * reader needs no other metadata and can skip frames by frame_size. The
+ * header is followed by the positions and, with FlagVelocity, the
+ * velocities of all particles in id order, three components per particle:
+ *  double      full precision values, or with FlagQuantized,
+ *  uint16      positions wrapped in the box, x = lo + (q + 1/2) L / 65536,
+ *  int16       velocities, v = q velocity_range / 32767.
+ * The payload is padded to a multiple of 8 bytes. All fields are little
+ * endian.
+ */
+struct FrameHeader {
+    char magic[8];
+    cl_uint header_size;
+    cl_uint flags;
+    cl_ulong frame_size;
+    cl_ulong step;
+    cl_ulong n_particles;
+    cl_double time_step;
+    cl_double box_lo[3];
+    cl_double box_hi[3];
+    cl_double velocity_range;
+
+    enum : cl_uint {
+        FlagVelocity = 1,
+        FlagQuantized = 2
+    };
+};
+
+/**
+ * Trajectory
+ * @brief Binary trajectory writer. The local records of each frame are
+ * aggregated on the master process with a single gather, directly into
+ * one of two frame buffers. A writer thread on the master encodes and
+ * writes the frames, so the step loop only waits for the disk when both
+ * buffers are still pending. The writer thread makes no MPI calls.
+ *
+ * A local record holds the id bits and the position, and optionally the
+ * velocity, of a particle as consecutive doubles.
+ */
+struct Trajectory {
+    /* ---- Aggregation over the processes --------------------------------- */
+    MPI_Comm m_comm = MPI_COMM_NULL;
+    int m_proc_id;
+    int m_n_procs;
+    cl_uint m_record_size;
+    std::vector<cl_double> m_send;
+    std::vector<int> m_counts;
+    std::vector<int> m_displs;
+
+    /* ---- Double-buffered frames and the writer thread ------------------- */
+    struct Frame {
+        cl_ulong step;
+        cl_double box_lo[3];
+        cl_double box_hi[3];
+        std::vector<cl_double> records;
+        bool pending;
+    };
+    Frame m_frames[2];
+    cl_uint m_next;
+    bool m_done;
+    std::mutex m_mutex;
+    std::condition_variable m_cond;
+    std::thread m_thread;
+    atto::core::FileOut m_file;
+    std::vector<cl_uchar> m_buffer;
+
+    /* ---- Trajectory member functions ------------------------------------ */
+    static bool is_active(void) { return Params::trajectory_file[0] != '\0'; }
+    void write(
+        const cl_ulong step,
+        const cl_double box_lo[3],
+        const cl_double box_hi[3],
+        const cl_uint n_local,
+        const cl_uint stride,
+        const cl_double *position,
+        const cl_double *velocity,
+        const cl_ulong *id);
+    void run(void);
+    void encode(const Frame &frame);
+
+    explicit Trajectory(const Domain &domain);
+    ~Trajectory();
+    Trajectory(const Trajectory &) = delete;
+    Trajectory &operator=(const Trajectory &) = delete;
+};
+
+#endif /* TRAJECTORY_H_ */
@@ -0,0 +1,271 @@
+/*
+ * transport.cpp
+ *
+ * Copyright (c) 2020 Carlos Braga
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the MIT License.
+ *
+ * See accompanying LICENSE.md or https://opensource.org/licenses/MIT.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include "transport.hpp"
+using namespace atto;
+
+/** ---------------------------------------------------------------------------
+ * Transport::Transport
+ * @brief Create an empty correlator. The ids owned by the process are set
+ * once the number of particles is known.
+ */
+Transport::Transport(const Domain &domain)
+{
+    m_comm = domain.m_comm;
+    m_proc_id = domain.m_proc_id;
+    m_n_procs = domain.m_n_procs;
+    m_n_particles = 0;
+    m_block_size = 1;
+    m_first = 0;
+    m_n_block = 0;
+    m_n_updates = 0;
+}
+
+/**
+ * Transport::setup
+ * @brief Assign the block of ids owned by the process and allocate the
+ * correlator levels.
+ */
+void Transport::setup(const cl_ulong n_particles)
+{
+    m_n_particles = n_particles;
+    m_block_size = std::max(
+        (n_particles + m_n_procs - 1) / (cl_ulong) m_n_procs, (cl_ulong) 1);
+    m_first = std::min((cl_ulong) m_proc_id * m_block_size, n_particles);
+    m_n_block = std::min(m_block_size, n_particles - m_first);
+
+    m_send_counts.resize(m_n_procs, 0);
+    m_send_displs.resize(m_n_procs, 0);
+    m_recv_counts.resize(m_n_procs, 0);
+    m_recv_displs.resize(m_n_procs, 0);
+
+    const cl_ulong n = 3 * m_n_block;
+    const cl_ulong n_points = Params::transport_points;
+    m_wrapped.assign(n, 0.0);
+    m_position.assign(n, 0.0);
+    m_velocity.assign(n, 0.0);
+    m_levels.resize(Params::transport_levels);
+    for (auto &level : m_levels) {
+        level.position.assign(n_points * n, 0.0);
+        level.velocity.assign(n_points * n, 0.0);
+        level.velocity_sum.assign(n, 0.0);
+        level.n_values = 0;
+        level.n_sum = 0;
+        level.msd.assign(n_points, 0.0);
+        level.vacf.assign(n_points, 0.0);
+        level.count.assign(n_points, 0);
+    }
+}
+
+/** ---------------------------------------------------------------------------
+ * Transport::update
+ * @brief Send the local positions and velocities to the owners of their
+ * ids, unwrap the positions of the owned particles and add them to the
+ * correlator. Each record holds the id bits, the position and the velocity
+ * of a particle as consecutive doubles.
+ */
+void Transport::update(
+    const cl_double box_length[3],
+    const cl_uint n_local,
+    const cl_uint stride,
+    const cl_double *position,
+    const cl_double *velocity,
+    const cl_ulong *id)
+{
+    const int record_size = 7;
+
+    /* Pack the local records in the order of their owners. */
+    std::fill(m_send_counts.begin(), m_send_counts.end(), 0);
+    for (cl_uint i = 0; i < n_local; ++i) {
+        m_send_counts[id[i] / m_block_size] += record_size;
+    }
+    std::vector<int> offset(m_n_procs, 0);
+    for (int proc = 1; proc < m_n_procs; ++proc) {
+        offset[proc] = offset[proc - 1] + m_send_counts[proc - 1];
+    }
+    m_send_displs = offset;
+
+    m_send.resize(n_local * record_size);
+    for (cl_uint i = 0; i < n_local; ++i) {
+        cl_double *record = &m_send[offset[id[i] / m_block_size]];
+        offset[id[i] / m_block_size] += record_size;
+        std::memcpy(&record[0], &id[i], sizeof(cl_double));
+        for (cl_uint c = 0; c < 3; ++c) {
+            record[1 + c] = position[i + c * stride];
+            record[4 + c] = velocity[i + c * stride];
+        }
+    }
+
+    /* Exchange the records with the owners. */
+    MPI_Alltoall(
+        &m_send_counts[0], 1, MPI_INT,
+        &m_recv_counts[0], 1, MPI_INT, m_comm);
+    int total = 0;
+    for (int proc = 0; proc < m_n_procs; ++proc) {
+        m_recv_displs[proc] = total;
+        total += m_recv_counts[proc];
+    }
+    core_assert(total == (int) m_n_block * record_size,
+        "transport records do not match the owned ids");
+    m_recv.resize(total);
+    MPI_Alltoallv(
+        m_send.empty() ? NULL : &m_send[0],
+        &m_send_counts[0], &m_send_displs[0], MPI_DOUBLE,
+        m_recv.empty() ? NULL : &m_recv[0],
+        &m_recv_counts[0], &m_recv_displs[0], MPI_DOUBLE, m_comm);
+
+    /*
+     * Unwrap the positions with the minimum image of the displacement
+     * since the last update, which must be less than half the box.
+     */
+    const cl_ulong n_block = m_n_block;
+    const bool first = (m_n_updates == 0);
+    core_pragma_omp(parallel for schedule(static))
+    for (cl_ulong k = 0; k < n_block; ++k) {
+        const cl_double *record = &m_recv[k * record_size];
+        cl_ulong ix;
+        std::memcpy(&ix, &record[0], sizeof(ix));
+        ix -= m_first;
+        for (cl_ulong c = 0; c < 3; ++c) {
+            const cl_double x = record[1 + c];
+            cl_double &wrapped = m_wrapped[ix + c * n_block];
+            cl_double &unwrapped = m_position[ix + c * n_block];
+            if (first) {
+                unwrapped = x;
+            } else {
+                cl_double dx = x - wrapped;
+                dx -= box_length[c] * std::round(dx / box_length[c]);
+                unwrapped += dx;
+            }
+            wrapped = x;
+            m_velocity[ix + c * n_block] = record[4 + c];
+        }
+    }
+    m_n_updates++;
+
+    correlate(0, m_position.data(), m_velocity.data());
+}
+
+/**
+ * Transport::correlate
+ * @brief Add the values to a correlator level, accumulate the squared
+ * displacements and the velocity products of each lag the level covers,
+ * and pass the block averages to the next level every transport_factor
+ * values.
+ */
+void Transport::correlate(
+    const cl_uint level,
+    const cl_double *position,
+    const cl_double *velocity)
+{
+    Level &lv = m_levels[level];
+    const cl_ulong n = 3 * m_n_block;
+    const cl_ulong n_points = Params::transport_points;
+    const cl_ulong slot = lv.n_values % n_points;
+    std::copy(position, position + n, lv.position.begin() + slot * n);
+    std::copy(velocity, velocity + n, lv.velocity.begin() + slot * n);
+    lv.n_values++;
+
+    const cl_double *r_now = lv.position.data() + slot * n;
+    const cl_double *v_now = lv.velocity.data() + slot * n;
+    const cl_ulong k_begin = (level == 0)
+        ? 0 : n_points / Params::transport_factor;
+    const cl_ulong k_end = std::min(lv.n_values, n_points);
+    for (cl_ulong k = k_begin; k < k_end; ++k) {
+        const cl_ulong old = (slot + n_points - k) % n_points;
+        const cl_double *r_old = lv.position.data() + old * n;
+        const cl_double *v_old = lv.velocity.data() + old * n;
+        cl_double msd = 0.0;
+        cl_double vacf = 0.0;
+        core_pragma_omp(parallel for simd reduction(+:msd,vacf))
+        for (cl_ulong j = 0; j < n; ++j) {
+            const cl_double dr = r_now[j] - r_old[j];
+            msd += dr * dr;
+            vacf += v_now[j] * v_old[j];
+        }
+        lv.msd[k] += msd;
+        lv.vacf[k] += vacf;
+        lv.count[k]++;
+    }
+
+    /* Coarsen the values into the next level. */
+    if (level + 1 < m_levels.size()) {
+        cl_double *v_sum = lv.velocity_sum.data();
+        core_pragma_omp(parallel for simd)
+        for (cl_ulong j = 0; j < n; ++j) {
+            v_sum[j] += v_now[j];
+        }
+        if (++lv.n_sum == Params::transport_factor) {
+            const cl_double scale = 1.0 / (cl_double) Params::transport_factor;
+            core_pragma_omp(parallel for simd)
+            for (cl_ulong j = 0; j < n; ++j) {
+                v_sum[j] *= scale;
+            }
+            correlate(level + 1, r_now, v_sum);
+            std::fill(lv.velocity_sum.begin(), lv.velocity_sum.end(), 0.0);
+            lv.n_sum = 0;
+        }
+    }
+}
+
+/** ---------------------------------------------------------------------------
+ * Transport::write
+ * @brief Reduce the correlator sums on the master and write the mean
+ * squared displacement and the velocity autocorrelation, per particle, at
+ * each lag time.
+ */
+void Transport::write(void)
+{
+    const cl_ulong n_points = Params::transport_points;
+    const cl_ulong n_levels = m_levels.size();
+    std::vector<cl_double> sums(2 * n_levels * n_points, 0.0);
+    std::vector<cl_double> total(sums.size(), 0.0);
+    for (cl_ulong l = 0; l < n_levels; ++l) {
+        for (cl_ulong k = 0; k < n_points; ++k) {
+            sums[2 * (l * n_points + k) + 0] = m_levels[l].msd[k];
+            sums[2 * (l * n_points + k) + 1] = m_levels[l].vacf[k];
+        }
+    }
+    MPI_Reduce(
+        &sums[0], &total[0], sums.size(),
+        MPI_DOUBLE, MPI_SUM, Params::master_id, m_comm);
+    if (m_proc_id != Params::master_id) {
+        return;
+    }
+
+    core::FileOut file(Params::transport_file);
+    file.printf("# updates %llu particles %llu\n# t msd vacf\n",
+        (unsigned long long) m_n_updates,
+        (unsigned long long) m_n_particles);
+
+    const cl_double dt = Params::n_transport_steps * Params::time_step;
+    cl_double spacing = 1.0;
+    for (cl_ulong l = 0; l < n_levels; ++l) {
+        const cl_ulong k_begin = (l == 0)
+            ? 0 : n_points / Params::transport_factor;
+        for (cl_ulong k = k_begin; k < n_points; ++k) {
+            const cl_ulong count = m_levels[l].count[k];
+            if (count == 0) {
+                continue;
+            }
+            const cl_double norm = 1.0 / ((cl_double) m_n_particles * count);
+            file.printf("%.8e %.8e %.8e\n",
+                (cl_double) k * spacing * dt,
+                total[2 * (l * n_points + k) + 0] * norm,
+                total[2 * (l * n_points + k) + 1] * norm);
+        }
+        spacing *= (cl_double) Params::transport_factor;
+    }
+    file.close();
+}
@@ -0,0 +1,100 @@
+/*
+ * transport.hpp
+ *
+ * Copyright (c) 2020 Carlos Braga
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the MIT License.
+ *
+ * See accompanying LICENSE.md or https://opensource.org/licenses/MIT.
+ */
+
+#ifndef TRANSPORT_H_
+#define TRANSPORT_H_
+
+#include <vector>
+#include "base.hpp"
+#include "domain.hpp"
+
+/**
+ * Transport
+ * @brief Streaming mean squared displacement and velocity autocorrelation
+ * with a multiple-tau correlator. Each process owns the correlator of a
+ * fixed block of particle ids, independent of the subdomains. Every
+ * n_transport_steps the local positions and velocities are sent to the
+ * owners of their ids with a single all-to-all, and the owners unwrap the
+ * positions with the minimum image of their displacement since the last
+ * update.
+ *
+ * Level l of the correlator holds the last transport_points values at a
+ * spacing of transport_factor^l updates, in a ring of blocks of 3 n_block
+ * components. The positions passed to the next level are the ones at the
+ * end of each block of transport_factor values, so the displacements are
+ * exact at every lag, and the velocities are the block averages. Level 0
+ * correlates lags 0 to transport_points - 1, and the higher levels only
+ * the lags not covered by the level below. The memory is proportional to
+ * the number of particles times the number of levels, the logarithm of the
+ * longest lag, rather than to the length of the run.
+ *
+ * The sums of each lag run over the components of the owned particles in
+ * vectorized loops. The partial sums of the processes are reduced on the
+ * master only when the correlation functions are written.
+ */
+struct Transport {
+    /* ---- Ownership of the particle ids ---------------------------------- */
+    MPI_Comm m_comm = MPI_COMM_NULL;
+    int m_proc_id;
+    int m_n_procs;
+    cl_ulong m_n_particles;
+    cl_ulong m_block_size;
+    cl_ulong m_first;
+    cl_ulong m_n_block;
+    std::vector<cl_double> m_send;
+    std::vector<cl_double> m_recv;
+    std::vector<int> m_send_counts;
+    std::vector<int> m_send_displs;
+    std::vector<int> m_recv_counts;
+    std::vector<int> m_recv_displs;
+
+    /* ---- Unwrapped positions and velocities of the owned particles ------ */
+    std::vector<cl_double> m_wrapped;
+    std::vector<cl_double> m_position;
+    std::vector<cl_double> m_velocity;
+    cl_ulong m_n_updates;
+
+    /* ---- Multiple-tau correlator levels --------------------------------- */
+    struct Level {
+        std::vector<cl_double> position;
+        std::vector<cl_double> velocity;
+        std::vector<cl_double> velocity_sum;
+        cl_ulong n_values;
+        cl_ulong n_sum;
+        std::vector<cl_double> msd;
+        std::vector<cl_double> vacf;
+        std::vector<cl_ulong> count;
+    };
+    std::vector<Level> m_levels;
+
+    /* ---- Transport member functions ------------------------------------- */
+    static bool is_active(void) { return Params::transport_file[0] != '\0'; }
+    void setup(const cl_ulong n_particles);
+    void update(
+        const cl_double box_length[3],
+        const cl_uint n_local,
+        const cl_uint stride,
+        const cl_double *position,
+        const cl_double *velocity,
+        const cl_ulong *id);
+    void correlate(
+        const cl_uint level,
+        const cl_double *position,
+        const cl_double *velocity);
+    void write(void);
+
+    explicit Transport(const Domain &domain);
+    ~Transport() = default;
+    Transport(const Transport &) = delete;
+    Transport &operator=(const Transport &) = delete;
+};
+
+#endif /* TRANSPORT_H_ */